@@ -0,0 +1,372 @@
+#include "CrashIndex.h"
+
+#include <QFile>
+#include <QPair>
+#include <QDebug>
+
+#include <algorithm>
+
+static const char DUMP_HEADER[] = "MEGAprivate ERROR DUMP";
+static const char COMMENT_SEPARATOR[] = "------------------------------";
+
+typedef QPair<int, int> Range;
+typedef QPair<int, QString> KeyCount;
+
+static bool countGreater(const KeyCount &a, const KeyCount &b)
+{
+    if (a.first != b.first)
+    {
+        return a.first > b.first;
+    }
+    return a.second < b.second;
+}
+
+static QStringList sortedKeys(QList<KeyCount> counts)
+{
+    std::sort(counts.begin(), counts.end(), countGreater);
+    QStringList keys;
+    for (int i = 0; i < counts.size(); i++)
+    {
+        keys.append(counts[i].second);
+    }
+    return keys;
+}
+
+static bool isHexDigit(QChar c)
+{
+    ushort u = c.unicode();
+    return (u >= '0' && u <= '9') || (u >= 'a' && u <= 'f') || (u >= 'A' && u <= 'F');
+}
+
+CrashIndex::CrashIndex()
+{
+}
+
+QList<CrashReport> CrashIndex::parseFile(const QString &path)
+{
+    QList<CrashReport> result;
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly) || !file.size())
+    {
+        return result;
+    }
+
+    uchar *data = file.map(0, file.size());
+    if (!data)
+    {
+        return result;
+    }
+
+    //The mapped file is scanned without copying it
+    QByteArray contents = QByteArray::fromRawData((const char *)data, file.size());
+    QByteArray header(DUMP_HEADER);
+    QList<Range> parts;
+    int start = 0;
+    while (start <= contents.size())
+    {
+        int end = contents.indexOf(header, start);
+        if (end < 0)
+        {
+            end = contents.size();
+        }
+
+        if (end > start)
+        {
+            parts.append(Range(start, end));
+        }
+        start = end + header.size();
+    }
+
+    QList<QList<Range> > partLines;
+    for (int i = 0; i < parts.size(); i++)
+    {
+        QList<Range> lines;
+        int pos = parts[i].first;
+        int partEnd = parts[i].second;
+        forever
+        {
+            int lineEnd = contents.indexOf('\n', pos);
+            if (lineEnd < 0 || lineEnd > partEnd)
+            {
+                lineEnd = partEnd;
+            }
+
+            int end = lineEnd;
+            if (lineEnd < partEnd && end > pos && contents.at(end - 1) == '\r')
+            {
+                end--;
+            }
+            lines.append(Range(pos, end));
+
+            if (lineEnd >= partEnd)
+            {
+                break;
+            }
+            pos = lineEnd + 1;
+        }
+        partLines.append(lines);
+    }
+
+    //The last part is incomplete unless the previous one is just a few lines
+    if (partLines.size() >= 2 && partLines[partLines.size() - 2].size() < 3)
+    {
+        partLines.removeLast();
+    }
+
+    for (int j = 0; j < partLines.size() - 1; j++)
+    {
+        const QList<Range> &lines = partLines[j];
+        QStringList text;
+        for (int i = 0; i < lines.size(); i++)
+        {
+            text.append(QString::fromUtf8(contents.constData() + lines[i].first, lines[i].second - lines[i].first));
+        }
+
+        int first = 0;
+        while (first < text.size() && !text[first].startsWith(QString::fromUtf8("Application: ")))
+        {
+            first++;
+        }
+
+        int numLines = text.size() - first;
+        if ((numLines < 5) || (!text[first + 1].startsWith(QString::fromUtf8("Version"))))
+        {
+            continue;
+        }
+
+        int locationIndex = 0;
+        if (text[first + 3].startsWith(QString::fromUtf8("Operating")))
+        {
+            locationIndex = 5;
+        }
+        if (text[first + 4].startsWith(QString::fromUtf8("System")))
+        {
+            locationIndex = 8;
+        }
+
+        if (!locationIndex || numLines <= locationIndex)
+        {
+            continue;
+        }
+
+        //User comments are logged and removed from the report
+        int reportEnd = text.size();
+        for (int i = first + locationIndex; i < text.size(); i++)
+        {
+            if (text[i].contains(QString::fromUtf8(COMMENT_SEPARATOR)))
+            {
+                reportEnd = i;
+                int k = i + 1;
+                while (k < text.size() && !text[k].contains(QString::fromUtf8(COMMENT_SEPARATOR)))
+                {
+                    k++;
+                }
+
+                QString comment;
+                if (k != text.size())
+                {
+                    for (int l = i + 1; l < k; l++)
+                    {
+                        comment.append(text[l]);
+                    }
+                    comment = comment.trimmed();
+                }
+
+                if (comment.size() > 3)
+                {
+                    comment.append(QString::fromUtf8("\n\nCrash report:\n"));
+                    comment.append(QStringList(text.mid(first, reportEnd - first)).join(QString::fromUtf8("\n")));
+                    qDebug() << QString::fromUtf8("User comment: %1\n\n").arg(comment);
+                }
+                break;
+            }
+        }
+
+        CrashReport report;
+        report.file = path;
+        report.offset = lines[first].first;
+        report.length = ((reportEnd == text.size()) ? parts[j].second : lines[reportEnd - 1].second) - lines[first].first;
+        report.version = text[first + 1];
+        report.location = normalizeLine(text[first + locationIndex]);
+
+        QStringList frames;
+        for (int i = first + locationIndex + 1; i < reportEnd && frames.size() < STACK_SIGNATURE_FRAMES; i++)
+        {
+            //Newer reports end with the stall statistics of the GUI thread
+            if (text[i].startsWith(QString::fromUtf8("Stall statistics: ")))
+            {
+                break;
+            }
+
+            QString frame = normalizeLine(text[i]);
+            if (frame.size() && frame != QString::fromUtf8("Stacktrace:"))
+            {
+                frames.append(frame);
+            }
+        }
+        report.signature = frames.join(QString::fromUtf8("\n"));
+        result.append(report);
+    }
+
+    file.unmap(data);
+    return result;
+}
+
+void CrashIndex::addReports(CrashIndex &index, const QList<CrashReport> &reports)
+{
+    for (int i = 0; i < reports.size(); i++)
+    {
+        const CrashReport &report = reports[i];
+        VersionGroup &version = index.versionIndex[report.version];
+        version.count++;
+        LocationGroup &location = version.locations[report.location];
+        location.count++;
+        location.signatures[report.signature].append(index.reports.size());
+        index.reports.append(report);
+    }
+}
+
+void CrashIndex::merge(const CrashIndex &other)
+{
+    addReports(*this, other.reports);
+}
+
+//Absolute addresses change between runs, offsets inside functions don't
+QString CrashIndex::normalizeLine(const QString &line)
+{
+    QString result;
+    result.reserve(line.size());
+    int i = 0;
+    while (i < line.size())
+    {
+        if (line.at(i) == QLatin1Char('0') && (i + 1) < line.size() && line.at(i + 1) == QLatin1Char('x')
+                && (!i || (!line.at(i - 1).isLetterOrNumber() && line.at(i - 1) != QLatin1Char('+'))))
+        {
+            int j = i + 2;
+            while (j < line.size() && isHexDigit(line.at(j)))
+            {
+                j++;
+            }
+
+            if (j > (i + 2))
+            {
+                result.append(QString::fromUtf8("0x?"));
+                i = j;
+                continue;
+            }
+        }
+
+        result.append(line.at(i));
+        i++;
+    }
+    return result.trimmed();
+}
+
+int CrashIndex::size() const
+{
+    return reports.size();
+}
+
+QStringList CrashIndex::versions() const
+{
+    QList<KeyCount> counts;
+    for (QHash<QString, VersionGroup>::const_iterator it = versionIndex.begin(); it != versionIndex.end(); ++it)
+    {
+        counts.append(KeyCount(it.value().count, it.key()));
+    }
+    return sortedKeys(counts);
+}
+
+int CrashIndex::versionCount(const QString &version) const
+{
+    QHash<QString, VersionGroup>::const_iterator it = versionIndex.find(version);
+    return (it != versionIndex.end()) ? it.value().count : 0;
+}
+
+QStringList CrashIndex::locations(const QString &version) const
+{
+    QList<KeyCount> counts;
+    QHash<QString, VersionGroup>::const_iterator it = versionIndex.find(version);
+    if (it != versionIndex.end())
+    {
+        const QHash<QString, LocationGroup> &locations = it.value().locations;
+        for (QHash<QString, LocationGroup>::const_iterator lit = locations.begin(); lit != locations.end(); ++lit)
+        {
+            counts.append(KeyCount(lit.value().count, lit.key()));
+        }
+    }
+    return sortedKeys(counts);
+}
+
+int CrashIndex::locationCount(const QString &version, const QString &location) const
+{
+    QHash<QString, VersionGroup>::const_iterator it = versionIndex.find(version);
+    if (it == versionIndex.end())
+    {
+        return 0;
+    }
+
+    QHash<QString, LocationGroup>::const_iterator lit = it.value().locations.find(location);
+    return (lit != it.value().locations.end()) ? lit.value().count : 0;
+}
+
+QStringList CrashIndex::signatures(const QString &version, const QString &location) const
+{
+    QList<KeyCount> counts;
+    QHash<QString, VersionGroup>::const_iterator it = versionIndex.find(version);
+    if (it != versionIndex.end())
+    {
+        QHash<QString, LocationGroup>::const_iterator lit = it.value().locations.find(location);
+        if (lit != it.value().locations.end())
+        {
+            const QHash<QString, QList<int> > &signatures = lit.value().signatures;
+            for (QHash<QString, QList<int> >::const_iterator sit = signatures.begin(); sit != signatures.end(); ++sit)
+            {
+                counts.append(KeyCount(sit.value().size(), sit.key()));
+            }
+        }
+    }
+    return sortedKeys(counts);
+}
+
+QList<int> CrashIndex::reportIds(const QString &version, const QString &location, const QString &signature) const
+{
+    QHash<QString, VersionGroup>::const_iterator it = versionIndex.find(version);
+    if (it == versionIndex.end())
+    {
+        return QList<int>();
+    }
+
+    QHash<QString, LocationGroup>::const_iterator lit = it.value().locations.find(location);
+    if (lit == it.value().locations.end())
+    {
+        return QList<int>();
+    }
+    return lit.value().signatures.value(signature);
+}
+
+QString CrashIndex::reportText(int id) const
+{
+    if (id < 0 || id >= reports.size() || reports[id].length <= 0)
+    {
+        return QString();
+    }
+
+    const CrashReport &report = reports[id];
+    QFile file(report.file);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return QString();
+    }
+
+    uchar *data = file.map(report.offset, report.length);
+    if (!data)
+    {
+        return QString();
+    }
+
+    QString text = QString::fromUtf8((const char *)data, report.length);
+    file.unmap(data);
+    text.replace(QString::fromUtf8("\r\n"), QString::fromUtf8("\n"));
+    return text;
+}
@@ -0,0 +1,62 @@
+#ifndef CRASHINDEX_H
+#define CRASHINDEX_H
+
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QList>
+
+//Position of a crash report inside a crash file, the text is read on demand
+struct CrashReport
+{
+    QString file;
+    qint64 offset;
+    int length;
+    QString version;
+    QString location;
+    QString signature;
+};
+
+//Crash reports grouped by version, normalized crash location and stack signature
+class CrashIndex
+{
+public:
+    static const int STACK_SIGNATURE_FRAMES = 8;
+
+    CrashIndex();
+
+    //Map and reduce steps used by QtConcurrent::mappedReduced
+    static QList<CrashReport> parseFile(const QString &path);
+    static void addReports(CrashIndex &index, const QList<CrashReport> &reports);
+    static QString normalizeLine(const QString &line);
+    void merge(const CrashIndex &other);
+
+    int size() const;
+    QStringList versions() const;
+    int versionCount(const QString &version) const;
+    QStringList locations(const QString &version) const;
+    int locationCount(const QString &version, const QString &location) const;
+    QStringList signatures(const QString &version, const QString &location) const;
+    QList<int> reportIds(const QString &version, const QString &location, const QString &signature) const;
+    QString reportText(int id) const;
+
+protected:
+    struct LocationGroup
+    {
+        LocationGroup() : count(0) {}
+        int count;
+        QHash<QString, QList<int> > signatures;
+    };
+
+    struct VersionGroup
+    {
+        VersionGroup() : count(0) {}
+        int count;
+        QHash<QString, LocationGroup> locations;
+    };
+
+    QList<CrashReport> reports;
+    QHash<QString, VersionGroup> versionIndex;
+};
+
+#endif // CRASHINDEX_H
@@ -9,17 +9,45 @@ CONFIG(release, debug|release) {
 
 QT       += core gui
 
-greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+greaterThan(QT_MAJOR_VERSION, 4): QT += widgets concurrent
 
 TARGET = MEGACrashAnalyzer
 TEMPLATE = app
 
 HEADERS += \
-    MainWindow.h
+    MainWindow.h \
+    CrashIndex.h \
+    SymbolTable.h \
+    Symbolizer.h
 
 SOURCES += \
     MEGACrashAnalyzer.cpp \
-    MainWindow.cpp
+    MainWindow.cpp \
+    CrashIndex.cpp \
+    SymbolTable.cpp \
+    Symbolizer.cpp
 
 FORMS += \
     MainWindow.ui
+
+#DWARF reader used to symbolize crash reports
+unix:!macx {
+  BREAKPAD = $$PWD/../MEGASync/google_breakpad
+  SOURCES += $$BREAKPAD/common/linux/dump_symbols.cc
+  SOURCES += $$BREAKPAD/common/linux/elf_symbols_to_module.cc
+  SOURCES += $$BREAKPAD/common/linux/elfutils.cc
+  SOURCES += $$BREAKPAD/common/linux/file_id.cc
+  SOURCES += $$BREAKPAD/common/linux/linux_libc_support.cc
+  SOURCES += $$BREAKPAD/common/linux/memory_mapped_file.cc
+  SOURCES += $$BREAKPAD/common/dwarf/bytereader.cc
+  SOURCES += $$BREAKPAD/common/dwarf/dwarf2diehandler.cc
+  SOURCES += $$BREAKPAD/common/dwarf/dwarf2reader.cc
+  SOURCES += $$BREAKPAD/common/dwarf_cfi_to_module.cc
+  SOURCES += $$BREAKPAD/common/dwarf_cu_to_module.cc
+  SOURCES += $$BREAKPAD/common/dwarf_line_to_module.cc
+  SOURCES += $$BREAKPAD/common/language.cc
+  SOURCES += $$BREAKPAD/common/module.cc
+
+  DEFINES += NO_STABS_SUPPORT
+  INCLUDEPATH += $$BREAKPAD
+}
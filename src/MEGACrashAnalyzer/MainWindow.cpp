@@ -1,22 +1,30 @@
 #include "MainWindow.h"
 #include "ui_MainWindow.h"
+#include "Symbolizer.h"
 
 #include <QString>
 #include <QDesktopServices>
 #include <QFileDialog>
 #include <QMessageBox>
-#include <QDebug>
-#include <QMultiMap>
+#include <QtCore>
+
+#if QT_VERSION >= 0x050000
+#include <QtConcurrent/QtConcurrent>
+#endif
 
 MainWindow::MainWindow(QWidget *parent) :
     QMainWindow(parent),
     ui(new Ui::MainWindow)
 {
     ui->setupUi(this);
+    connect(&indexWatcher, SIGNAL(finished()), this, SLOT(onCrashesParsed()));
+    connect(&symbolWatcher, SIGNAL(finished()), this, SLOT(onSymbolsResolved()));
 }
 
 MainWindow::~MainWindow()
 {
+    indexWatcher.waitForFinished();
+    symbolWatcher.waitForFinished();
     delete ui;
 }
 
@@ -38,136 +46,58 @@ void MainWindow::on_bSourceFolder_clicked()
     }
 }
 
+void MainWindow::on_bSymbolsFolder_clicked()
+{
+#if QT_VERSION < 0x050000
+    QString defaultPath = QDesktopServices::storageLocation(QDesktopServices::DocumentsLocation);
+    QString cachePath = QDesktopServices::storageLocation(QDesktopServices::DataLocation);
+#else
+    QString defaultPath = QStandardPaths::standardLocations(QStandardPaths::DocumentsLocation)[0];
+    QString cachePath = QStandardPaths::writableLocation(QStandardPaths::DataLocation);
+#endif
+
+    QString path =  QFileDialog::getExistingDirectory(this, tr("Select folder with debug binaries"),
+                                                      defaultPath,
+                                                      QFileDialog::ShowDirsOnly
+                                                      | QFileDialog::DontResolveSymlinks);
+    if (path.length())
+    {
+        //Symbol tables are cached, binaries are only parsed the first time
+        ui->bSourceFolder->setEnabled(false);
+        ui->bSymbolsFolder->setEnabled(false);
+        symbolWatcher.setFuture(QtConcurrent::run(Symbolizer::symbolize, crashIndex, path,
+                                                  QDir(cachePath).filePath(QString::fromUtf8("symbols"))));
+    }
+}
+
 void MainWindow::parseCrashes(QString folder)
 {
     QDir dir(folder);
     QFileInfoList fiList = dir.entryInfoList(QDir::Files | QDir::NoDotAndDotDot, QDir::Time);
+    QStringList files;
     for (int i = 0; i < fiList.size(); i++)
     {
-        QFile file(fiList[i].absoluteFilePath());
-        if (!file.open(QIODevice::ReadOnly))
-        {
-            continue;
-        }
-
-        QString fileContents = QString::fromUtf8(file.readAll());
-        fileContents.replace(QString::fromUtf8("\r\n"), QString::fromUtf8("\n"));
-        QStringList crashReports = fileContents.split(QString::fromUtf8("MEGAprivate ERROR DUMP"), QString::SkipEmptyParts);
-        if ((crashReports.size() - 2) >= 0
-                && crashReports[crashReports.size() - 2].split(QString::fromUtf8("\n")).size() < 3)
-        {
-            crashReports.removeLast();
-        }
-
-        for (int j = 0; j < crashReports.size() - 1; j++)
-        {
-            QString crashReport = crashReports[j];
-            file.close();
-
-            QStringList lines = crashReport.split(QString::fromUtf8("\n"));
-            while (lines.size() && !lines.at(0).startsWith(QString::fromUtf8("Application: ")))
-            {
-                lines.removeAt(0);
-            }
-
-            if ((lines.size() < 5)
-                    || (!lines.at(0).startsWith(QString::fromUtf8("Application: ")))
-                    || (!lines.at(1).startsWith(QString::fromUtf8("Version"))))
-            {
-                continue;
-            }
-
-            int locationIndex = 0;
-            if (lines.at(3).startsWith(QString::fromUtf8("Operating")))
-            {
-                locationIndex = 5;
-            }
-            if (lines.at(4).startsWith(QString::fromUtf8("System")))
-            {
-                locationIndex = 8;
-            }
-
-            if (!locationIndex || lines.size() <= locationIndex)
-            {
-                continue;
-            }
-
-            QHash<QString, QStringList> &version = reports[lines.at(1)];
-            if (!reports.contains(lines.at(1)))
-            {
-                reports.insert(lines.at(1), QHash<QString, QStringList>());
-            }
-
-            if (!version.contains(lines.at(locationIndex)))
-            {
-                version.insert(lines.at(locationIndex), QStringList());
-            }
+        files.append(fiList[i].absoluteFilePath());
+    }
 
-            QStringList &fullReports = version[lines.at(locationIndex)];
-            for (int i = locationIndex; i < lines.size(); i++)
-            {
-                if (lines.at(i).contains("------------------------------"))
-                {
-                    int init = i;
-                    int j = i + 1;
-                    while (j < lines.size() && !lines.at(j).contains("------------------------------"))
-                    {
-                        j++;
-                    }
-
-                    QString comment;
-                    if (j != lines.size())
-                    {
-                        i++;
-                        while (i < j)
-                        {
-                            comment.append(lines.at(i));
-                            i++;
-                        }
-                        comment = comment.trimmed();
-                    }
-
-                    while (lines.size() > init)
-                    {
-                        lines.removeAt(lines.size() - 1);
-                    }
-
-                    if (comment.size() > 3)
-                    {
-                        comment.append(QString::fromUtf8("\n\nCrash report:\n"));
-                        comment.append(lines.join("\n"));
-                        //QMessageBox::warning(this, tr("Crash analyzer"), comment);
-                        qDebug() << QString::fromUtf8("User comment: %1\n\n").arg(comment);
-                    }
-
-                    break;
-                }
-            }
+    //Files are parsed in parallel, reports are indexed in the order of the files
+    ui->bSourceFolder->setEnabled(false);
+    ui->bSymbolsFolder->setEnabled(false);
+    indexWatcher.setFuture(QtConcurrent::mappedReduced(files, CrashIndex::parseFile, CrashIndex::addReports,
+                                                       QtConcurrent::OrderedReduce));
+}
 
-            crashReport = lines.join(QString::fromUtf8("\n"));
-            fullReports.append(crashReport);
-        }
-    }
+void MainWindow::onCrashesParsed()
+{
+    crashIndex.merge(indexWatcher.result());
+    ui->bSourceFolder->setEnabled(true);
+    ui->bSymbolsFolder->setEnabled(true);
 
-    QStringList versions = reports.keys();
+    QStringList versions = crashIndex.versions();
     ui->cVersion->clear();
     if (versions.size())
     {
-        QMultiMap<int, QString> sortedMap;
-        for (int i=0; i < versions.size(); i++)
-        {
-            QHash<QString, QStringList> &hVersion = reports[versions.at(i)];
-            QStringList crashLocations = hVersion.keys();
-            int acum = 0;
-            for (int j = 0; j < crashLocations.size(); j++)
-            {
-                acum += hVersion.value(crashLocations[j]).size();
-            }
-            sortedMap.insert(acum, versions.at(i));
-        }
-        QStringList sortedVersions = sortedMap.values();
-        std::reverse(sortedVersions.begin(), sortedVersions.end());
-        ui->cVersion->addItems(sortedVersions);
+        ui->cVersion->addItems(versions);
         ui->cVersion->setCurrentIndex(0);
     }
     else
@@ -176,29 +106,23 @@ void MainWindow::parseCrashes(QString folder)
     }
 }
 
+void MainWindow::onSymbolsResolved()
+{
+    frameSymbols = symbolWatcher.result();
+    ui->bSourceFolder->setEnabled(true);
+    ui->bSymbolsFolder->setEnabled(true);
+    on_sReports_valueChanged(ui->sReports->value());
+}
+
 void MainWindow::on_cVersion_currentIndexChanged(const QString &version)
 {
-    QHash<QString, QStringList> &hVersion = reports[version];
-    QStringList crashLocations = hVersion.keys();
+    QStringList crashLocations = crashIndex.locations(version);
     ui->cLocation->clear();
     if (crashLocations.size())
     {
-        QMultiMap<int, QString> sortedMap;
-        for (int i=0; i< crashLocations.size(); i++)
-        {
-            sortedMap.insert(hVersion.value(crashLocations.at(i)).size(), crashLocations.at(i));
-        }
-        QStringList sortedLocations = sortedMap.values();
-        std::reverse(sortedLocations.begin(), sortedLocations.end());
-        ui->cLocation->addItems(sortedLocations);
+        ui->cLocation->addItems(crashLocations);
         ui->cLocation->setCurrentIndex(0);
-
-        int acum = 0;
-        for (int i = 0; i < crashLocations.size(); i++)
-        {
-            acum += hVersion.value(crashLocations[i]).size();
-        }
-        ui->eVersion->setText(QString::number(acum));
+        ui->eVersion->setText(QString::number(crashIndex.versionCount(version)));
     }
     else
     {
@@ -209,15 +133,47 @@ void MainWindow::on_cVersion_currentIndexChanged(const QString &version)
 
 void MainWindow::on_cLocation_currentIndexChanged(const QString &location)
 {
-    QHash<QString, QStringList> &hVersion = reports[ui->cVersion->currentText()];
-    QStringList fullReports = hVersion.value(location);
-    ui->eLocation->setText(QString::number(fullReports.size()));
-    if (fullReports.size())
+    QString version = ui->cVersion->currentText();
+    QStringList stackSignatures = crashIndex.signatures(version, location);
+    ui->eLocation->setText(QString::number(crashIndex.locationCount(version, location)));
+    ui->cSignature->clear();
+    if (stackSignatures.size())
+    {
+        //Stack signatures are shown by their top frame
+        for (int i = 0; i < stackSignatures.size(); i++)
+        {
+            QString label = stackSignatures[i].section(QString::fromUtf8("\n"), 0, 0);
+            if (label.isEmpty())
+            {
+                label = tr("No stack trace");
+            }
+            ui->cSignature->addItem(label, stackSignatures[i]);
+            ui->cSignature->setItemData(i, stackSignatures[i], Qt::ToolTipRole);
+        }
+        ui->cSignature->setCurrentIndex(0);
+    }
+    else
+    {
+        ui->cSignature->addItem(tr("Stack signature"));
+    }
+}
+
+void MainWindow::on_cSignature_currentIndexChanged(int index)
+{
+    currentReports.clear();
+    if (index >= 0 && ui->cSignature->itemData(index).isValid())
+    {
+        currentReports = crashIndex.reportIds(ui->cVersion->currentText(), ui->cLocation->currentText(),
+                                              ui->cSignature->itemData(index).toString());
+    }
+
+    ui->eSignature->setText(QString::number(currentReports.size()));
+    if (currentReports.size())
     {
         ui->sReports->setMinimum(1);
-        ui->sReports->setMaximum(fullReports.size());
+        ui->sReports->setMaximum(currentReports.size());
         ui->sReports->setValue(1);
-        ui->eReport->setText(fullReports[0]);
+        showReport(currentReports[0]);
     }
     else
     {
@@ -230,14 +186,31 @@ void MainWindow::on_cLocation_currentIndexChanged(const QString &location)
 
 void MainWindow::on_sReports_valueChanged(int selected)
 {
-    if (selected > 0)
+    if (selected > 0 && selected <= currentReports.size())
     {
-        QHash<QString, QStringList> &hVersion = reports[ui->cVersion->currentText()];
-        QStringList fullReports = hVersion.value(ui->cLocation->currentText());
-        ui->eReport->setText(fullReports[selected-1]);
+        showReport(currentReports[selected - 1]);
     }
     else
     {
         ui->eReport->clear();
     }
 }
+
+void MainWindow::showReport(int id)
+{
+    QString report = crashIndex.reportText(id);
+    if (frameSymbols.size())
+    {
+        QStringList lines = report.split(QString::fromUtf8("\n"));
+        for (int i = 0; i < lines.size(); i++)
+        {
+            QHash<QString, QString>::const_iterator it = frameSymbols.find(lines[i].trimmed());
+            if (it != frameSymbols.end())
+            {
+                lines[i].append(QString::fromUtf8("\n        at ") + it.value());
+            }
+        }
+        report = lines.join(QString::fromUtf8("\n"));
+    }
+    ui->eReport->setText(report);
+}
@@ -2,8 +2,10 @@
 #define MAINWINDOW_H
 
 #include <QMainWindow>
-#include <QHash>
 #include <QString>
+#include <QFutureWatcher>
+#include "CrashIndex.h"
+#include <QHash>
 
 namespace Ui {
 class MainWindow;
@@ -19,14 +21,23 @@ public:
 
 private slots:
     void on_bSourceFolder_clicked();
+    void on_bSymbolsFolder_clicked();
     void on_cVersion_currentIndexChanged(const QString &version);
     void on_cLocation_currentIndexChanged(const QString &location);
+    void on_cSignature_currentIndexChanged(int index);
     void on_sReports_valueChanged(int selected);
+    void onCrashesParsed();
+    void onSymbolsResolved();
 
 private:
     Ui::MainWindow *ui;
-    QHash<QString, QHash<QString, QStringList> > reports;
+    CrashIndex crashIndex;
+    QFutureWatcher<CrashIndex> indexWatcher;
+    QList<int> currentReports;
+    QFutureWatcher<QHash<QString, QString> > symbolWatcher;
+    QHash<QString, QString> frameSymbols;
     void parseCrashes(QString folder);
+    void showReport(int id);
 };
 
 #endif // MAINWINDOW_H
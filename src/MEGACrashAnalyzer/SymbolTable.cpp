@@ -0,0 +1,255 @@
+#include "SymbolTable.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QDataStream>
+
+#include <algorithm>
+
+#ifdef Q_OS_LINUX
+#include <string>
+#include <vector>
+#include "common/linux/dump_symbols.h"
+#include "common/module.h"
+#endif
+
+static const quint32 SYMBOL_CACHE_MAGIC = 0x4D534331; //"MSC1"
+
+SymbolTable::SymbolTable()
+{
+    executable = false;
+}
+
+bool SymbolTable::compareAddress(const Entry &a, const Entry &b)
+{
+    return a.address < b.address;
+}
+
+bool SymbolTable::build(const QString &binaryPath)
+{
+#ifdef Q_OS_LINUX
+    QFile binary(binaryPath);
+    if (!binary.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+    QByteArray header = binary.read(18);
+    binary.close();
+
+    //Only ET_EXEC binaries are loaded at the addresses of their symbols
+    if (header.size() < 18 || !header.startsWith("\x7f" "ELF"))
+    {
+        return false;
+    }
+    int type = (header[5] == 2) ? (((uchar)header[16] << 8) | (uchar)header[17])
+                                : (((uchar)header[17] << 8) | (uchar)header[16]);
+    executable = (type == 2);
+
+    google_breakpad::Module *module = NULL;
+    std::vector<std::string> debugDirs;
+    debugDirs.push_back(QFileInfo(binaryPath).absolutePath().toUtf8().constData());
+    if (!google_breakpad::ReadSymbolData(binaryPath.toUtf8().constData(), debugDirs,
+                                         google_breakpad::DumpOptions(google_breakpad::NO_CFI, true), &module))
+    {
+        return false;
+    }
+
+    std::vector<google_breakpad::Module::Function *> moduleFunctions;
+    module->GetFunctions(&moduleFunctions, moduleFunctions.end());
+    QHash<QString, int> fileIndices;
+    for (unsigned int i = 0; i < moduleFunctions.size(); i++)
+    {
+        google_breakpad::Module::Function *function = moduleFunctions[i];
+        QString name = QString::fromUtf8(function->name.c_str());
+        int functionIndex = functions.size();
+        functions.append(name);
+
+        //Frames are matched by the full demangled name or without parameters
+        functionAddresses.insert(name, function->address);
+        int parameters = name.indexOf(QLatin1Char('('));
+        if (parameters > 0 && !functionAddresses.contains(name.left(parameters)))
+        {
+            functionAddresses.insert(name.left(parameters), function->address);
+        }
+
+        Entry entry;
+        entry.function = functionIndex;
+        if (function->lines.empty())
+        {
+            entry.address = function->address;
+            entry.size = (quint32)function->size;
+            entry.file = -1;
+            entry.line = 0;
+            entries.append(entry);
+            continue;
+        }
+
+        for (unsigned int j = 0; j < function->lines.size(); j++)
+        {
+            const google_breakpad::Module::Line &line = function->lines[j];
+            QString fileName = QString::fromUtf8(line.file->name.c_str());
+            QHash<QString, int>::iterator it = fileIndices.find(fileName);
+            if (it == fileIndices.end())
+            {
+                it = fileIndices.insert(fileName, files.size());
+                files.append(fileName);
+            }
+
+            entry.address = line.address;
+            entry.size = (quint32)line.size;
+            entry.file = it.value();
+            entry.line = line.number;
+            entries.append(entry);
+        }
+    }
+
+    //Binaries without debug info only have their dynamic symbols
+    std::vector<google_breakpad::Module::Extern *> externs;
+    module->GetExterns(&externs, externs.end());
+    for (unsigned int i = 0; i < externs.size(); i++)
+    {
+        QString name = QString::fromUtf8(externs[i]->name.c_str());
+        if (!functionAddresses.contains(name))
+        {
+            functionAddresses.insert(name, externs[i]->address);
+        }
+
+        if (moduleFunctions.empty())
+        {
+            Entry entry;
+            entry.address = externs[i]->address;
+            entry.size = 0;
+            entry.function = functions.size();
+            entry.file = -1;
+            entry.line = 0;
+            functions.append(name);
+            entries.append(entry);
+        }
+    }
+    delete module;
+
+    std::sort(entries.begin(), entries.end(), compareAddress);
+    return true;
+#else
+    Q_UNUSED(binaryPath);
+    return false;
+#endif
+}
+
+bool SymbolTable::load(const QString &cachePath)
+{
+    QFile file(cachePath);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+
+    QDataStream stream(&file);
+    quint32 magic;
+    quint8 isExecutable;
+    quint32 numEntries;
+    stream >> magic;
+    if (magic != SYMBOL_CACHE_MAGIC)
+    {
+        return false;
+    }
+
+    stream >> isExecutable >> functions >> files >> functionAddresses >> numEntries;
+    if (stream.status() != QDataStream::Ok)
+    {
+        return false;
+    }
+
+    entries.resize(numEntries);
+    for (unsigned int i = 0; i < numEntries; i++)
+    {
+        Entry &entry = entries[i];
+        stream >> entry.address >> entry.size >> entry.function >> entry.file >> entry.line;
+        if (entry.function < 0 || entry.function >= functions.size() || entry.file >= files.size())
+        {
+            entries.clear();
+            return false;
+        }
+    }
+    executable = isExecutable;
+    return stream.status() == QDataStream::Ok;
+}
+
+bool SymbolTable::save(const QString &cachePath) const
+{
+    QString tmpPath = cachePath + QString::fromUtf8(".tmp");
+    QFile file(tmpPath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        return false;
+    }
+
+    QDataStream stream(&file);
+    stream << SYMBOL_CACHE_MAGIC << (quint8)executable << functions << files << functionAddresses
+           << (quint32)entries.size();
+    for (int i = 0; i < entries.size(); i++)
+    {
+        const Entry &entry = entries[i];
+        stream << entry.address << entry.size << entry.function << entry.file << entry.line;
+    }
+    file.close();
+
+    if (stream.status() != QDataStream::Ok)
+    {
+        QFile::remove(tmpPath);
+        return false;
+    }
+
+    QFile::remove(cachePath);
+    return QFile::rename(tmpPath, cachePath);
+}
+
+bool SymbolTable::isEmpty() const
+{
+    return entries.isEmpty();
+}
+
+bool SymbolTable::isExecutable() const
+{
+    return executable;
+}
+
+bool SymbolTable::functionAddress(const QString &name, quint64 *address) const
+{
+    QHash<QString, quint64>::const_iterator it = functionAddresses.find(name);
+    if (it == functionAddresses.end())
+    {
+        return false;
+    }
+
+    *address = it.value();
+    return true;
+}
+
+QString SymbolTable::lookup(quint64 address) const
+{
+    Entry key;
+    key.address = address;
+    QVector<Entry>::const_iterator it = std::upper_bound(entries.begin(), entries.end(), key, compareAddress);
+    if (it == entries.begin())
+    {
+        return QString();
+    }
+
+    --it;
+    if (it->size && (address >= (it->address + it->size)))
+    {
+        return QString();
+    }
+
+    QString result = functions.at(it->function);
+    if (it->file >= 0)
+    {
+        result.append(QString::fromUtf8(" (%1:%2)").arg(files.at(it->file)).arg(it->line));
+    }
+    else if (!it->size)
+    {
+        result.append(QString::fromUtf8("+0x%1").arg(address - it->address, 0, 16));
+    }
+    return result;
+}
@@ -0,0 +1,43 @@
+#ifndef SYMBOLTABLE_H
+#define SYMBOLTABLE_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QHash>
+
+//Sorted address -> function/line table of a binary, built from its DWARF data
+class SymbolTable
+{
+public:
+    SymbolTable();
+
+    bool build(const QString &binaryPath);
+    bool load(const QString &cachePath);
+    bool save(const QString &cachePath) const;
+
+    bool isEmpty() const;
+    bool isExecutable() const;
+    bool functionAddress(const QString &name, quint64 *address) const;
+    QString lookup(quint64 address) const;
+
+protected:
+    struct Entry
+    {
+        quint64 address;
+        quint32 size;
+        qint32 function;
+        qint32 file;
+        qint32 line;
+    };
+
+    static bool compareAddress(const Entry &a, const Entry &b);
+
+    QVector<Entry> entries;
+    QStringList functions;
+    QStringList files;
+    QHash<QString, quint64> functionAddresses;
+    bool executable;
+};
+
+#endif // SYMBOLTABLE_H
@@ -0,0 +1,238 @@
+#include "Symbolizer.h"
+
+#include <QtCore>
+
+#if QT_VERSION >= 0x050000
+#include <QtConcurrent/QtConcurrent>
+#endif
+
+#ifdef __GNUC__
+#include <cxxabi.h>
+#include <cstdlib>
+#endif
+
+struct ReportFrames
+{
+    typedef QList<StackFrame> result_type;
+
+    ReportFrames(const CrashIndex *index) : index(index) {}
+
+    QList<StackFrame> operator()(int id) const
+    {
+        return Symbolizer::parseFrames(index->reportText(id));
+    }
+
+    const CrashIndex *index;
+};
+
+struct TableLoader
+{
+    typedef SymbolTable result_type;
+
+    TableLoader(QString cacheFolder) : cacheFolder(cacheFolder) {}
+
+    SymbolTable operator()(const QString &binaryPath) const
+    {
+        return Symbolizer::loadTable(binaryPath, cacheFolder);
+    }
+
+    QString cacheFolder;
+};
+
+struct FrameResolver
+{
+    typedef QString result_type;
+
+    FrameResolver(const QHash<QString, SymbolTable> *tables) : tables(tables) {}
+
+    QString operator()(const StackFrame &frame) const
+    {
+        QHash<QString, SymbolTable>::const_iterator it = tables->find(frame.module);
+        if (it == tables->end())
+        {
+            return QString();
+        }
+        return Symbolizer::resolve(frame, it.value());
+    }
+
+    const QHash<QString, SymbolTable> *tables;
+};
+
+static void collectFrames(QHash<QString, StackFrame> &frames, const QList<StackFrame> &reportFrames)
+{
+    for (int i = 0; i < reportFrames.size(); i++)
+    {
+        if (!frames.contains(reportFrames[i].line))
+        {
+            frames.insert(reportFrames[i].line, reportFrames[i]);
+        }
+    }
+}
+
+static QString demangle(const QString &symbol)
+{
+#ifdef __GNUC__
+    int status = 0;
+    char *demangled = abi::__cxa_demangle(symbol.toUtf8().constData(), NULL, NULL, &status);
+    if (demangled)
+    {
+        QString result = QString::fromUtf8(demangled);
+        free(demangled);
+        return result;
+    }
+#endif
+    return symbol;
+}
+
+//Frames are collected from all reports, then each distinct frame is resolved once
+QHash<QString, QString> Symbolizer::symbolize(CrashIndex index, QString binaryFolder, QString cacheFolder)
+{
+    QList<int> ids;
+    for (int i = 0; i < index.size(); i++)
+    {
+        ids.append(i);
+    }
+
+    QHash<QString, StackFrame> frames = QtConcurrent::blockingMappedReduced<QHash<QString, StackFrame> >(
+                ids, ReportFrames(&index), collectFrames);
+
+    QSet<QString> moduleNames;
+    for (QHash<QString, StackFrame>::const_iterator it = frames.begin(); it != frames.end(); ++it)
+    {
+        moduleNames.insert(it.value().module);
+    }
+
+    QDir dir(binaryFolder);
+    QStringList modules;
+    QStringList binaries;
+    for (QSet<QString>::const_iterator it = moduleNames.begin(); it != moduleNames.end(); ++it)
+    {
+        QString binaryPath = dir.filePath(*it);
+        if (it->size() && QFileInfo(binaryPath).isFile())
+        {
+            modules.append(*it);
+            binaries.append(binaryPath);
+        }
+    }
+
+    QList<SymbolTable> loadedTables = QtConcurrent::blockingMapped<QList<SymbolTable> >(binaries, TableLoader(cacheFolder));
+    QHash<QString, SymbolTable> tables;
+    for (int i = 0; i < loadedTables.size(); i++)
+    {
+        if (!loadedTables[i].isEmpty())
+        {
+            tables.insert(modules[i], loadedTables[i]);
+        }
+    }
+
+    QHash<QString, QString> symbols;
+    if (tables.isEmpty())
+    {
+        return symbols;
+    }
+
+    QList<StackFrame> uniqueFrames = frames.values();
+    QStringList resolved = QtConcurrent::blockingMapped<QStringList>(uniqueFrames, FrameResolver(&tables));
+    for (int i = 0; i < resolved.size(); i++)
+    {
+        if (!resolved[i].isEmpty())
+        {
+            symbols.insert(uniqueFrames[i].line, resolved[i]);
+        }
+    }
+    return symbols;
+}
+
+//Frames look like "path(symbol+0xoffset) [0xaddress]"
+QList<StackFrame> Symbolizer::parseFrames(const QString &report)
+{
+    QList<StackFrame> frames;
+    QRegExp frameExp(QString::fromUtf8("^(.+)\\(([^()]*)\\)\\s*\\[0x([0-9a-fA-F]+)\\]$"));
+    QStringList lines = report.split(QString::fromUtf8("\n"));
+    for (int i = 0; i < lines.size(); i++)
+    {
+        QString line = lines[i].trimmed();
+        if (frameExp.indexIn(line) < 0)
+        {
+            continue;
+        }
+
+        StackFrame frame;
+        frame.line = line;
+        frame.module = QFileInfo(frameExp.cap(1).trimmed()).fileName();
+        frame.symbol = frameExp.cap(2);
+        frame.offset = 0;
+        int plus = frame.symbol.lastIndexOf(QLatin1Char('+'));
+        if (plus >= 0)
+        {
+            frame.offset = frame.symbol.mid(plus + 1).toULongLong(NULL, 0);
+            frame.symbol = frame.symbol.left(plus);
+        }
+        frame.address = frameExp.cap(3).toULongLong(NULL, 16);
+        frames.append(frame);
+    }
+    return frames;
+}
+
+SymbolTable Symbolizer::loadTable(const QString &binaryPath, const QString &cacheFolder)
+{
+    QFileInfo info(binaryPath);
+    QString cachePath = QDir(cacheFolder).filePath(QString::fromUtf8("%1.%2.%3.symcache")
+                                                   .arg(info.fileName())
+                                                   .arg(info.size())
+                                                   .arg(info.lastModified().toTime_t()));
+
+    SymbolTable table;
+    if (table.load(cachePath))
+    {
+        return table;
+    }
+
+    table = SymbolTable();
+    if (table.build(binaryPath))
+    {
+        QDir().mkpath(cacheFolder);
+        table.save(cachePath);
+    }
+    return table;
+}
+
+QString Symbolizer::resolve(const StackFrame &frame, const SymbolTable &table)
+{
+    quint64 address;
+    if (frame.symbol.size())
+    {
+        //Symbols are mangled in the reports and demangled in the tables
+        QString name = demangle(frame.symbol);
+        quint64 functionAddress;
+        if (table.functionAddress(frame.symbol, &functionAddress)
+                || table.functionAddress(name, &functionAddress)
+                || table.functionAddress(name.left(name.indexOf(QLatin1Char('('))), &functionAddress))
+        {
+            address = functionAddress + frame.offset;
+        }
+        else if (table.isExecutable())
+        {
+            address = frame.address;
+        }
+        else
+        {
+            return QString();
+        }
+    }
+    else if (frame.offset)
+    {
+        //Offset from the load address of the module
+        address = frame.offset;
+    }
+    else if (table.isExecutable())
+    {
+        address = frame.address;
+    }
+    else
+    {
+        return QString();
+    }
+
+    return table.lookup(address);
+}
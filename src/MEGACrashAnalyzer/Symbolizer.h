@@ -0,0 +1,31 @@
+#ifndef SYMBOLIZER_H
+#define SYMBOLIZER_H
+
+#include <QString>
+#include <QHash>
+#include <QList>
+#include "CrashIndex.h"
+#include "SymbolTable.h"
+
+//Frame of a stack trace written by backtrace_symbols
+struct StackFrame
+{
+    QString line;
+    QString module;
+    QString symbol;
+    quint64 offset;
+    quint64 address;
+};
+
+//Resolves the frames of crash reports with the binaries of a folder.
+//Symbol tables are cached, so each binary is only parsed once
+class Symbolizer
+{
+public:
+    static QHash<QString, QString> symbolize(CrashIndex index, QString binaryFolder, QString cacheFolder);
+    static QList<StackFrame> parseFrames(const QString &report);
+    static SymbolTable loadTable(const QString &binaryPath, const QString &cacheFolder);
+    static QString resolve(const StackFrame &frame, const SymbolTable &table);
+};
+
+#endif // SYMBOLIZER_H
@@ -44,6 +44,12 @@ debug {
     DEFINES += LOG_TO_LOGGER
 }
 
+#Build with "qmake CONFIG+=callback_replay" to replay traces saved with --record-callbacks:
+#MEGAsync --replay-callbacks <trace> [--realtime]
+callback_replay {
+    DEFINES += CALLBACK_REPLAY
+}
+
 CONFIG += USE_LIBUV
 CONFIG += USE_MEGAAPI
 
@@ -59,8 +65,10 @@ INCLUDEPATH += $$PWD
 
 DEFINES += QT_NO_CAST_FROM_ASCII QT_NO_CAST_TO_ASCII
 
-SOURCES += MegaApplication.cpp
-HEADERS += MegaApplication.h
+SOURCES += MegaApplication.cpp \
+    MegaDaemon.cpp
+HEADERS += MegaApplication.h \
+    MegaDaemon.h
 
 TRANSLATIONS = \
     gui/translations/MEGASyncStrings_ar.ts \
@@ -120,3 +128,7 @@ macx {
     QMAKE_CXXFLAGS += -fvisibility=hidden -fvisibility-inlines-hidden
     QMAKE_LFLAGS += -F /System/Library/Frameworks/Security.framework/
 }
+
+benchmark {
+    include(benchmark/benchmark.pri)
+}
@@ -1,10 +1,19 @@
 #include "MegaApplication.h"
+#include "MegaDaemon.h"
 #include "gui/CrashReportDialog.h"
 #include "gui/MegaProxyStyle.h"
 #include "gui/ConfirmSSLexception.h"
 #include "control/Utilities.h"
 #include "control/CrashHandler.h"
 #include "control/ExportProcessor.h"
+#include "control/DebrisAccountant.h"
+#include "control/DebrisPruner.h"
+#include "control/NodeSearchIndex.h"
+#include "control/StreamingCache.h"
+#include "control/MetricsCollector.h"
+#include "control/StallWatchdog.h"
+#include "control/SamplingProfiler.h"
+#include "control/CallbackTrace.h"
 #include "platform/Platform.h"
 #include "qtlockedfile/qtlockedfile.h"
 
@@ -92,8 +101,19 @@ void msgHandler(QtMsgType type, const char *msg)
     }
 #endif
 
+#ifndef MEGASYNC_BENCHMARK
 int main(int argc, char *argv[])
 {
+    if (MegaDaemon::isHeadless(argc, argv))
+    {
+        MegaDaemon daemon(argc, argv);
+        qInstallMsgHandler(msgHandler);
+#if QT_VERSION >= 0x050000
+        qInstallMessageHandler(messageHandler);
+#endif
+        return daemon.run();
+    }
+
 #ifdef Q_OS_LINUX
     QApplication::setDesktopSettingsAware(false);
 #endif
@@ -261,6 +281,12 @@ int main(int argc, char *argv[])
     //}
 
     app.initialize();
+#ifdef CALLBACK_REPLAY
+    if (app.startCallbackReplay())
+    {
+        return app.exec();
+    }
+#endif
     app.start();
     return app.exec();
 
@@ -301,6 +327,7 @@ int main(int argc, char *argv[])
     QT_TRANSLATE_NOOP("MegaError", "Unknown error");
 #endif
 }
+#endif
 
 MegaApplication::MegaApplication(int &argc, char **argv) :
     QApplication(argc, argv)
@@ -344,10 +371,42 @@ MegaApplication::MegaApplication(int &argc, char **argv) :
 
     MegaApi::setLoggerObject(logger);
 
+    callbackRecorder = NULL;
+    replayRealTime = false;
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp("--record-callbacks", argv[i]) && (i + 1) < argc)
+        {
+            recordCallbacksPath = QFileInfo(QString::fromLocal8Bit(argv[++i])).absoluteFilePath();
+        }
+#ifdef CALLBACK_REPLAY
+        else if (!strcmp("--replay-callbacks", argv[i]) && (i + 1) < argc)
+        {
+            replayCallbacksPath = QFileInfo(QString::fromLocal8Bit(argv[++i])).absoluteFilePath();
+        }
+        else if (!strcmp("--realtime", argv[i]))
+        {
+            replayRealTime = true;
+        }
+#endif
+    }
+
     //Set QApplication fields
     setOrganizationName(QString::fromAscii("Mega Limited"));
     setOrganizationDomain(QString::fromAscii("mega.co.nz"));
-    setApplicationName(QString::fromAscii("MEGAsync"));
+    QString applicationName = QString::fromAscii("MEGAsync");
+#ifdef CALLBACK_REPLAY
+    //Replays use their own data folder and lock, so the account isn't loaded
+    //and they can run while the normal instance is running
+    if (!replayCallbacksPath.isEmpty())
+    {
+        applicationName = QString::fromAscii("MEGAsync replay");
+    }
+#endif
+#ifdef MEGASYNC_BENCHMARK
+    applicationName = QString::fromAscii("MEGAsync benchmark");
+#endif
+    setApplicationName(applicationName);
     setApplicationVersion(QString::number(Preferences::VERSION_CODE));
     appPath = QDir::toNativeSeparators(QCoreApplication::applicationFilePath());
     appDirPath = QDir::toNativeSeparators(QCoreApplication::applicationDirPath());
@@ -368,6 +427,10 @@ MegaApplication::MegaApplication(int &argc, char **argv) :
 
     updateAvailable = false;
     networkConnectivity = true;
+    networkMonitorActive = false;
+    trayState = TRAY_STATE_NONE;
+    trayUpdateAvailable = false;
+    syncStateKnown = false;
     lastStartedDownload = 0;
     lastStartedUpload = 0;
     trayIcon = NULL;
@@ -378,6 +441,10 @@ MegaApplication::MegaApplication(int &argc, char **argv) :
     megaApiGuest = NULL;
     delegateListener = NULL;
     delegateGuestListener = NULL;
+    currentProxySettings = NULL;
+    lastGuestActivity = 0;
+    activeLinkProcessors = 0;
+    publicKeyPinning = true;
     httpServer = NULL;
     totalDownloadSize = totalUploadSize = 0;
     totalDownloadedSize = totalUploadedSize = 0;
@@ -438,9 +505,48 @@ MegaApplication::~MegaApplication()
 
 }
 
+#ifdef CALLBACK_REPLAY
+bool MegaApplication::startCallbackReplay()
+{
+    if (replayCallbacksPath.isEmpty() || appfinished)
+    {
+        return false;
+    }
+
+    //The data folder of replays has a fake account, so the listener code takes the
+    //same paths as with a logged in user. The MegaApi is never logged in and
+    //answers like a stub
+    QString replayEmail = QString::fromAscii("replay@localhost");
+    if (!preferences->logged())
+    {
+        preferences->setEmail(replayEmail);
+    }
+    else if (preferences->email() != replayEmail)
+    {
+        MegaApi::log(MegaApi::LOG_LEVEL_ERROR, "Callbacks can't be replayed with a real account");
+        return false;
+    }
+
+    //GUI elements and components created after the login
+    changeLanguage(preferences->language());
+    if (!infoDialog)
+    {
+        infoDialog = new InfoDialog(this);
+        syncStateKnown = false;
+    }
+    DebrisAccountant::instance()->initialize(megaApi);
+    NodeSearchIndex::instance()->initialize(megaApi);
+
+    CallbackReplayer *replayer = new CallbackReplayer(this, replayCallbacksPath, replayRealTime);
+    connect(replayer, SIGNAL(finished()), this, SLOT(quit()));
+    QTimer::singleShot(0, replayer, SLOT(start()));
+    return true;
+}
+#endif
+
 void MegaApplication::initialize()
 {
-    if (megaApi || megaApiGuest)
+    if (megaApi)
     {
         return;
     }
@@ -496,30 +602,35 @@ void MegaApplication::initialize()
 #else
     megaApi = new MegaApi(Preferences::CLIENT_KEY, basePath.toUtf8().constData(), Preferences::USER_AGENT, MacXPlatform::fd);
 #endif
-    megaApiGuest = new MegaApi(Preferences::CLIENT_KEY, basePath.toUtf8().constData(), Preferences::USER_AGENT);
 
     megaApi->setDownloadMethod(preferences->transferDownloadMethod());
-    megaApiGuest->setDownloadMethod(preferences->transferDownloadMethod());
     megaApi->setUploadMethod(preferences->transferUploadMethod());
-    megaApiGuest->setUploadMethod(preferences->transferUploadMethod());
     setUseHttpsOnly(preferences->usingHttpsOnly());
 
     megaApi->setDefaultFilePermissions(preferences->filePermissionsValue());
-    megaApiGuest->setDefaultFilePermissions(preferences->filePermissionsValue());
     megaApi->setDefaultFolderPermissions(preferences->folderPermissionsValue());
-    megaApiGuest->setDefaultFolderPermissions(preferences->folderPermissionsValue());
 
+    publicKeyPinning = !preferences->SSLcertificateException();
     megaApi->retrySSLerrors(true);
-    megaApiGuest->retrySSLerrors(true);
-    megaApi->setPublicKeyPinning(!preferences->SSLcertificateException());
-    megaApiGuest->setPublicKeyPinning(!preferences->SSLcertificateException());
+    megaApi->setPublicKeyPinning(publicKeyPinning);
 
     delegateListener = new MEGASyncDelegateListener(megaApi, this);
     megaApi->addListener(delegateListener);
-    delegateGuestListener = new MEGASyncDelegateListener(megaApiGuest, this);
-    megaApiGuest->addListener(delegateGuestListener);
+    if (!recordCallbacksPath.isEmpty())
+    {
+        callbackRecorder = new CallbackRecorder(recordCallbacksPath);
+        if (callbackRecorder->isOpen())
+        {
+            megaApi->addListener(callbackRecorder);
+        }
+        else
+        {
+            delete callbackRecorder;
+            callbackRecorder = NULL;
+        }
+    }
     uploader = new MegaUploader(megaApi);
-    downloader = new MegaDownloader(megaApi, megaApiGuest);
+    downloader = new MegaDownloader(megaApi);
     scanningTimer = new QTimer();
     scanningTimer->setSingleShot(false);
     scanningTimer->setInterval(500);
@@ -527,7 +638,8 @@ void MegaApplication::initialize()
     connect(scanningTimer, SIGNAL(timeout()), this, SLOT(scanningAnimationStep()));
 
     //Start the HTTP server
-    httpServer = new HTTPServer(megaApiGuest, Preferences::HTTPS_PORT, true);
+    httpServer = new HTTPServer(Preferences::HTTPS_PORT, true, this);
+    connect(httpServer, SIGNAL(onInfoMessage(QString)), this, SLOT(showInfoMessage(QString)));
     connect(httpServer, SIGNAL(onLinkReceived(QString)), this, SLOT(externalDownload(QString)), Qt::QueuedConnection);
     connect(httpServer, SIGNAL(onExternalDownloadRequested(QQueue<mega::MegaNode *>)), this, SLOT(externalDownload(QQueue<mega::MegaNode *>)));
     connect(httpServer, SIGNAL(onExternalDownloadRequestFinished()), this, SLOT(processDownloads()), Qt::QueuedConnection);
@@ -579,6 +691,7 @@ void MegaApplication::initialize()
     trayIcon = new QSystemTrayIcon();
 #endif
 
+    loadTrayIcons();
     connect(trayIcon, SIGNAL(messageClicked()), this, SLOT(onMessageClicked()));
     connect(trayIcon, SIGNAL(activated(QSystemTrayIcon::ActivationReason)),
             this, SLOT(trayIconActivated(QSystemTrayIcon::ActivationReason)));
@@ -621,6 +734,9 @@ void MegaApplication::initialize()
     periodicTasksTimer = new QTimer();
     periodicTasksTimer->start(Preferences::STATE_REFRESH_INTERVAL_MS);
     connect(periodicTasksTimer, SIGNAL(timeout()), this, SLOT(periodicTasks()));
+    networkMonitorActive = Platform::startNetworkMonitor(this);
+    MetricsCollector::instance()->start(megaApi, dataPath);
+    StallWatchdog::instance()->startMonitoring(preferences->stallThresholdMs(), preferences->stallDumpThresholdMs());
 
     infoDialogTimer = new QTimer();
     infoDialogTimer->setSingleShot(true);
@@ -688,6 +804,9 @@ void MegaApplication::changeLanguage(QString languageCode)
         delete newTranslator;
     }
 
+    //The tooltip has to be translated again
+    trayState = TRAY_STATE_NONE;
+
     if (notificator)
     {
         createTrayMenu();
@@ -709,13 +828,7 @@ void MegaApplication::updateTrayIcon()
         return;
     }
 
-    QString tooltip;
-    QString icon;
-
-#ifdef __APPLE__
-    QString icon_white;
-#endif
-
+    int state;
     if (infoOverQuota)
     {
         if (preferences->usedStorage() < preferences->totalStorage())
@@ -731,22 +844,8 @@ void MegaApplication::updateTrayIcon()
             }
         }
 
-        tooltip = QCoreApplication::applicationName()
-                + QString::fromAscii(" ")
-                + Preferences::VERSION_STRING
-                + QString::fromAscii("\n")
-                + tr("Over quota");
-
-#ifndef __APPLE__
-    #ifdef _WIN32
-        icon = QString::fromUtf8("://images/warning_ico.ico");
-    #else
-        icon = QString::fromUtf8("://images/22_warning.png");
-    #endif
-#else
-        icon = QString::fromUtf8("://images/icon_overquota_mac.png");
-        icon_white = QString::fromUtf8("://images/icon_overquota_mac_white.png");
-
+        state = TRAY_STATE_OVERQUOTA;
+#ifdef __APPLE__
         if (scanningTimer->isActive())
         {
             scanningTimer->stop();
@@ -755,22 +854,8 @@ void MegaApplication::updateTrayIcon()
     }
     else if (paused)
     {
-        tooltip = QCoreApplication::applicationName()
-                + QString::fromAscii(" ")
-                + Preferences::VERSION_STRING
-                + QString::fromAscii("\n")
-                + tr("Paused");
-
-#ifndef __APPLE__
-    #ifdef _WIN32
-        icon = QString::fromUtf8("://images/tray_pause.ico");
-    #else
-        icon = QString::fromUtf8("://images/22_paused.png");
-    #endif
-#else
-        icon = QString::fromUtf8("://images/icon_paused_mac.png");
-        icon_white = QString::fromUtf8("://images/icon_paused_mac_white.png");
-
+        state = TRAY_STATE_PAUSED;
+#ifdef __APPLE__
         if (scanningTimer->isActive())
         {
             scanningTimer->stop();
@@ -780,44 +865,23 @@ void MegaApplication::updateTrayIcon()
     else if (indexing || waiting
              || megaApi->getNumPendingUploads()
              || megaApi->getNumPendingDownloads()
-             || megaApiGuest->getNumPendingUploads()
-             || megaApiGuest->getNumPendingDownloads())
+             || (megaApiGuest && (megaApiGuest->getNumPendingUploads()
+                                  || megaApiGuest->getNumPendingDownloads())))
     {
         if (indexing)
         {
-            tooltip = QCoreApplication::applicationName()
-                    + QString::fromAscii(" ")
-                    + Preferences::VERSION_STRING
-                    + QString::fromAscii("\n")
-                    + tr("Scanning");
+            state = TRAY_STATE_SCANNING;
         }
         else if (waiting || (bwOverquotaTimestamp > QDateTime::currentMSecsSinceEpoch() / 1000))
         {
-            tooltip = QCoreApplication::applicationName()
-                    + QString::fromAscii(" ")
-                    + Preferences::VERSION_STRING
-                    + QString::fromAscii("\n")
-                    + tr("Waiting");
+            state = TRAY_STATE_WAITING;
         }
         else
         {
-            tooltip = QCoreApplication::applicationName()
-                    + QString::fromAscii(" ")
-                    + Preferences::VERSION_STRING
-                    + QString::fromAscii("\n")
-                    + tr("Syncing");
+            state = TRAY_STATE_SYNCING;
         }
 
-#ifndef __APPLE__
-    #ifdef _WIN32
-        icon = QString::fromUtf8("://images/tray_sync.ico");
-    #else
-        icon = QString::fromUtf8("://images/22_synching.png");
-    #endif
-#else
-        icon = QString::fromUtf8("://images/icon_syncing_mac.png");
-        icon_white = QString::fromUtf8("://images/icon_syncing_mac_white.png");
-
+#ifdef __APPLE__
         if (!scanningTimer->isActive())
         {
             scanningAnimationIndex = 1;
@@ -827,22 +891,8 @@ void MegaApplication::updateTrayIcon()
     }
     else
     {
-        tooltip = QCoreApplication::applicationName()
-                + QString::fromAscii(" ")
-                + Preferences::VERSION_STRING
-                + QString::fromAscii("\n")
-                + tr("Up to date");
-
-#ifndef __APPLE__
-    #ifdef _WIN32
-        icon = QString::fromUtf8("://images/app_ico.ico");
-    #else
-        icon = QString::fromUtf8("://images/22_uptodate.png");
-    #endif
-#else
-        icon = QString::fromUtf8("://images/icon_synced_mac.png");
-        icon_white = QString::fromUtf8("://images/icon_synced_mac_white.png");
-
+        state = TRAY_STATE_UP_TO_DATE;
+#ifdef __APPLE__
         if (scanningTimer->isActive())
         {
             scanningTimer->stop();
@@ -857,43 +907,161 @@ void MegaApplication::updateTrayIcon()
     if (!networkConnectivity)
     {
         //Override the current state
-        tooltip = QCoreApplication::applicationName()
-                + QString::fromAscii(" ")
-                + Preferences::VERSION_STRING
-                + QString::fromAscii("\n")
-                + tr("No Internet connection");
+        state = TRAY_STATE_NO_CONNECTION;
+    }
+
+    //Only touch the tray icon when the state changes
+    if (state == trayState && updateAvailable == trayUpdateAvailable)
+    {
+        return;
+    }
+
+    trayUpdateAvailable = updateAvailable;
+    setTrayIcon(state);
+}
 
+void MegaApplication::loadTrayIcons()
+{
+    trayIcons.clear();
+#ifdef __APPLE__
+    trayIconsWhite.clear();
+#endif
+
+    for (int i = 0; i < NUM_TRAY_STATES; i++)
+    {
+        QString icon;
+#ifdef __APPLE__
+        QString icon_white;
+#endif
+        switch (i)
+        {
+            case TRAY_STATE_OVERQUOTA:
+#ifndef __APPLE__
+    #ifdef _WIN32
+                icon = QString::fromUtf8("://images/warning_ico.ico");
+    #else
+                icon = QString::fromUtf8("://images/22_warning.png");
+    #endif
+#else
+                icon = QString::fromUtf8("://images/icon_overquota_mac.png");
+                icon_white = QString::fromUtf8("://images/icon_overquota_mac_white.png");
+#endif
+                break;
+            case TRAY_STATE_PAUSED:
+#ifndef __APPLE__
+    #ifdef _WIN32
+                icon = QString::fromUtf8("://images/tray_pause.ico");
+    #else
+                icon = QString::fromUtf8("://images/22_paused.png");
+    #endif
+#else
+                icon = QString::fromUtf8("://images/icon_paused_mac.png");
+                icon_white = QString::fromUtf8("://images/icon_paused_mac_white.png");
+#endif
+                break;
+            case TRAY_STATE_UP_TO_DATE:
+#ifndef __APPLE__
+    #ifdef _WIN32
+                icon = QString::fromUtf8("://images/app_ico.ico");
+    #else
+                icon = QString::fromUtf8("://images/22_uptodate.png");
+    #endif
+#else
+                icon = QString::fromUtf8("://images/icon_synced_mac.png");
+                icon_white = QString::fromUtf8("://images/icon_synced_mac_white.png");
+#endif
+                break;
+            case TRAY_STATE_NO_CONNECTION:
+#ifndef __APPLE__
+    #ifdef _WIN32
+                icon = QString::fromUtf8("://images/login_ico.ico");
+    #else
+                icon = QString::fromUtf8("://images/22_logging.png");
+    #endif
+#else
+                icon = QString::fromUtf8("://images/icon_logging_mac.png");
+                icon_white = QString::fromUtf8("://images/icon_logging_mac_white.png");
+#endif
+                break;
+            default:
 #ifndef __APPLE__
     #ifdef _WIN32
-        icon = QString::fromUtf8("://images/login_ico.ico");
+                icon = QString::fromUtf8("://images/tray_sync.ico");
     #else
-        icon = QString::fromUtf8("://images/22_logging.png");
+                icon = QString::fromUtf8("://images/22_synching.png");
     #endif
 #else
-        icon = QString::fromUtf8("://images/icon_logging_mac.png");
-        icon_white = QString::fromUtf8("://images/icon_logging_mac_white.png");
+                icon = QString::fromUtf8("://images/icon_syncing_mac.png");
+                icon_white = QString::fromUtf8("://images/icon_syncing_mac_white.png");
+#endif
+                break;
+        }
+
+        trayIcons.append(QIcon(icon));
+#ifdef __APPLE__
+        trayIconsWhite.append(QIcon(icon_white));
 #endif
     }
+}
 
-    if (updateAvailable)
+void MegaApplication::setTrayIcon(int state)
+{
+    QString tooltip = QCoreApplication::applicationName()
+            + QString::fromAscii(" ")
+            + Preferences::VERSION_STRING
+            + QString::fromAscii("\n");
+
+    switch (state)
+    {
+        case TRAY_STATE_OVERQUOTA:
+            tooltip += tr("Over quota");
+            break;
+        case TRAY_STATE_PAUSED:
+            tooltip += tr("Paused");
+            break;
+        case TRAY_STATE_SCANNING:
+            tooltip += tr("Scanning");
+            break;
+        case TRAY_STATE_WAITING:
+            tooltip += tr("Waiting");
+            break;
+        case TRAY_STATE_SYNCING:
+            tooltip += tr("Syncing");
+            break;
+        case TRAY_STATE_UP_TO_DATE:
+            tooltip += tr("Up to date");
+            break;
+        case TRAY_STATE_NO_CONNECTION:
+            tooltip += tr("No Internet connection");
+            break;
+        case TRAY_STATE_LOGGING_IN:
+            tooltip += tr("Logging in");
+            break;
+        case TRAY_STATE_STARTING:
+            tooltip += tr("Starting");
+            break;
+        default:
+            return;
+    }
+
+    if (updateAvailable && state != TRAY_STATE_LOGGING_IN && state != TRAY_STATE_STARTING)
     {
         tooltip += QString::fromAscii("\n")
                 + tr("Update available!");
     }
 
-    if (!icon.isEmpty())
+    if (trayIcons.size() != NUM_TRAY_STATES)
     {
+        loadTrayIcons();
+    }
+
 #ifndef __APPLE__
-        trayIcon->setIcon(QIcon(icon));
+    trayIcon->setIcon(trayIcons.at(state));
 #else
-        trayIcon->setIcon(QIcon(icon), QIcon(icon_white));
+    trayIcon->setIcon(trayIcons.at(state), trayIconsWhite.at(state));
 #endif
-    }
-
-    if (!tooltip.isEmpty())
-    {
-        trayIcon->setToolTip(tooltip);
-    }
+    trayIcon->setToolTip(tooltip);
+    trayState = state;
 }
 
 void MegaApplication::start()
@@ -921,23 +1089,14 @@ void MegaApplication::start()
         trayIcon->setContextMenu(initialMenu);
     }
 
-#ifndef __APPLE__
-    #ifdef _WIN32
-        trayIcon->setIcon(QIcon(QString::fromAscii("://images/tray_sync.ico")));
-    #else
-        trayIcon->setIcon(QIcon(QString::fromAscii("://images/22_synching.png")));
-    #endif
-#else
-    trayIcon->setIcon(QIcon(QString::fromAscii("://images/icon_syncing_mac.png")),
-                      QIcon(QString::fromAscii("://images/icon_syncing_mac_white.png")));
-
+    setTrayIcon(TRAY_STATE_LOGGING_IN);
+#ifdef __APPLE__
     if (!scanningTimer->isActive())
     {
         scanningAnimationIndex = 1;
         scanningTimer->start();
     }
 #endif
-    trayIcon->setToolTip(QCoreApplication::applicationName() + QString::fromAscii(" ") + Preferences::VERSION_STRING + QString::fromAscii("\n") + tr("Logging in"));
     trayIcon->show();
 
     if (!preferences->lastExecutionTime())
@@ -981,6 +1140,7 @@ void MegaApplication::start()
         if (!infoDialog)
         {
             infoDialog = new InfoDialog(this);
+            syncStateKnown = false;
         }
 
         if (!preferences->isFirstStartDone())
@@ -1098,11 +1258,14 @@ void MegaApplication::loggedIn()
     if (!infoDialog)
     {
         infoDialog = new InfoDialog(this);
+        syncStateKnown = false;
     }
 
     //Set the upload limit
     setUploadLimit(preferences->uploadLimitKB());
     Platform::startShellDispatcher(this);
+    DebrisAccountant::instance()->initialize(megaApi);
+    NodeSearchIndex::instance()->initialize(megaApi);
 }
 
 void MegaApplication::startSyncs()
@@ -1193,9 +1356,85 @@ void MegaApplication::processDownloadQueue(QString path)
         return;
     }
 
+    for (int i = 0; i < downloadQueue.size(); i++)
+    {
+        if (downloadQueue[i]->isPublic())
+        {
+            getMegaApiGuest();
+            break;
+        }
+    }
+
     downloader->processDownloadQueue(&downloadQueue, path);
 }
 
+//Public links are handled by a second MegaApi object with its own threads and
+//caches. It's created the first time it's needed and released when it's idle
+MegaApi *MegaApplication::getMegaApiGuest()
+{
+    lastGuestActivity = QDateTime::currentMSecsSinceEpoch();
+    if (megaApiGuest || appfinished)
+    {
+        return megaApiGuest;
+    }
+
+    MegaApi::log(MegaApi::LOG_LEVEL_INFO, "Creating guest MegaApi");
+    QString basePath = QDir::toNativeSeparators(QDir::currentPath()+QString::fromAscii("/"));
+    megaApiGuest = new MegaApi(Preferences::CLIENT_KEY, basePath.toUtf8().constData(), Preferences::USER_AGENT);
+    megaApiGuest->setDownloadMethod(preferences->transferDownloadMethod());
+    megaApiGuest->setUploadMethod(preferences->transferUploadMethod());
+    megaApiGuest->useHttpsOnly(preferences->usingHttpsOnly());
+    megaApiGuest->setDefaultFilePermissions(preferences->filePermissionsValue());
+    megaApiGuest->setDefaultFolderPermissions(preferences->folderPermissionsValue());
+    megaApiGuest->retrySSLerrors(true);
+    megaApiGuest->setPublicKeyPinning(publicKeyPinning);
+
+    int uploadLimit = preferences->uploadLimitKB();
+    megaApiGuest->setUploadLimit((uploadLimit < 0) ? -1 : uploadLimit * 1024);
+    if (currentProxySettings)
+    {
+        megaApiGuest->setProxySettings(currentProxySettings);
+    }
+    if (paused)
+    {
+        megaApiGuest->pauseTransfers(true);
+    }
+
+    delegateGuestListener = new MEGASyncDelegateListener(megaApiGuest, this);
+    megaApiGuest->addListener(delegateGuestListener);
+    downloader->setMegaApiGuest(megaApiGuest);
+    return megaApiGuest;
+}
+
+void MegaApplication::releaseIdleMegaApiGuest()
+{
+    if (!megaApiGuest)
+    {
+        return;
+    }
+
+    long long now = QDateTime::currentMSecsSinceEpoch();
+    if (megaApiGuest->getNumPendingDownloads() || megaApiGuest->getNumPendingUploads()
+            || pendingLinks.size() || activeLinkProcessors || importDialog)
+    {
+        lastGuestActivity = now;
+        return;
+    }
+
+    if ((now - lastGuestActivity) < Preferences::GUEST_API_IDLE_TIMEOUT_MS)
+    {
+        return;
+    }
+
+    MegaApi::log(MegaApi::LOG_LEVEL_INFO, "Releasing idle guest MegaApi");
+    downloader->setMegaApiGuest(NULL);
+    megaApiGuest->removeListener(delegateGuestListener);
+    delete delegateGuestListener;
+    delegateGuestListener = NULL;
+    delete megaApiGuest;
+    megaApiGuest = NULL;
+}
+
 void MegaApplication::unityFix()
 {
     static QMenu *dummyMenu = NULL;
@@ -1318,7 +1557,7 @@ void MegaApplication::rebootApplication(bool update)
 
     reboot = true;
     if (update && (megaApi->getNumPendingDownloads() || megaApi->getNumPendingUploads() || megaApi->isWaiting()
-                   || megaApiGuest->getNumPendingDownloads() || megaApiGuest->isWaiting()))
+                   || (megaApiGuest && (megaApiGuest->getNumPendingDownloads() || megaApiGuest->isWaiting()))))
     {
         if (!updateBlocked)
         {
@@ -1405,7 +1644,10 @@ void MegaApplication::pauseTransfers(bool pause)
     }
 
     megaApi->pauseTransfers(pause);
-    megaApiGuest->pauseTransfers(pause);
+    if (megaApiGuest)
+    {
+        megaApiGuest->pauseTransfers(pause);
+    }
 }
 
 void MegaApplication::checkNetworkInterfaces()
@@ -1576,7 +1818,10 @@ void MegaApplication::checkNetworkInterfaces()
     {
         MegaApi::log(MegaApi::LOG_LEVEL_INFO, "Reconnecting due to local network changes");
         megaApi->retryPendingConnections(true, true);
-        megaApiGuest->retryPendingConnections(true, true);
+        if (megaApiGuest)
+        {
+            megaApiGuest->retryPendingConnections(true, true);
+        }
         activeNetworkInterfaces = newNetworkInterfaces;
         lastActiveTime = QDateTime::currentMSecsSinceEpoch();
     }
@@ -1586,28 +1831,52 @@ void MegaApplication::checkNetworkInterfaces()
     }
 }
 
-void MegaApplication::periodicTasks()
+void MegaApplication::onNetworkChanged()
 {
-    if (appfinished)
+    if (appfinished || !megaApi)
     {
         return;
     }
 
+    MegaApi::log(MegaApi::LOG_LEVEL_DEBUG, "Network change notified by the system");
     checkNetworkInterfaces();
+}
+
+void MegaApplication::periodicTasks()
+{
+    if (appfinished)
+    {
+        return;
+    }
 
+    //If the system notifies network changes, the interfaces aren't polled
     static int counter = 0;
+    if (!networkMonitorActive)
+    {
+        checkNetworkInterfaces();
+    }
+
     if (megaApi)
     {
         if (!(++counter % 6))
         {
             networkConfigurationManager.updateConfigurations();
             megaApi->update();
-            megaApiGuest->update();
+            if (megaApiGuest)
+            {
+                megaApiGuest->update();
+            }
         }
 
         megaApi->updateStats();
-        megaApiGuest->updateStats();
+        if (megaApiGuest)
+        {
+            megaApiGuest->updateStats();
+        }
+        releaseIdleMegaApiGuest();
         onGlobalSyncStateChanged(megaApi);
+        DebrisAccountant::instance()->checkFullScan();
+        DebrisPruner::instance()->check(megaApi);
 
         if (isLinux)
         {
@@ -1624,6 +1893,8 @@ void MegaApplication::periodicTasks()
 void MegaApplication::cleanAll()
 {
     appfinished = true;
+    StallWatchdog::instance()->stopMonitoring();
+    SamplingProfiler::instance()->stop(dataPath + QDir::separator() + QString::fromAscii("MEGAsync.folded"));
 
 #ifndef DEBUG
     CrashHandler::instance()->Disable();
@@ -1637,6 +1908,13 @@ void MegaApplication::cleanAll()
     periodicTasksTimer->stop();
     stopUpdateTask();
     Platform::stopShellDispatcher();
+    Platform::stopNetworkMonitor();
+    MetricsCollector::instance()->stop();
+    DebrisPruner::instance()->cancel();
+    DebrisAccountant::instance()->save();
+    DebrisAccountant::instance()->reset();
+    NodeSearchIndex::instance()->reset();
+    StreamingCache::instance()->shutdown();
     for (int i = 0; i < preferences->getNumSyncedFolders(); i++)
     {
         Platform::notifyItemChange(preferences->getLocalFolder(i));
@@ -1656,6 +1934,12 @@ void MegaApplication::cleanAll()
     delegateListener = NULL;
     delete delegateGuestListener;
     delegateGuestListener = NULL;
+    if (callbackRecorder)
+    {
+        megaApi->removeListener(callbackRecorder);
+        delete callbackRecorder;
+        callbackRecorder = NULL;
+    }
 
     // Ensure that there aren't objects deleted with deleteLater()
     // that may try to access megaApi or megaApiGuest after
@@ -1664,6 +1948,7 @@ void MegaApplication::cleanAll()
 
     delete megaApi;
     delete megaApiGuest;
+    delete currentProxySettings;
 
     preferences->setLastExit(QDateTime::currentMSecsSinceEpoch());
     trayIcon->deleteLater();
@@ -1745,7 +2030,10 @@ void MegaApplication::showInfoDialog()
     if (isLinux && showStatusAction && megaApi)
     {
         megaApi->retryPendingConnections();
-        megaApiGuest->retryPendingConnections();
+        if (megaApiGuest)
+        {
+            megaApiGuest->retryPendingConnections();
+        }
     }
 
     if (bwOverquotaTimestamp > QDateTime::currentMSecsSinceEpoch() / 1000)
@@ -2126,6 +2414,7 @@ void MegaApplication::unlink()
 
     //Reset fields that will be initialized again upon login
     Platform::stopShellDispatcher();
+    StreamingCache::instance()->clear();
     megaApi->logout();
 }
 
@@ -2237,12 +2526,18 @@ void MegaApplication::setUploadLimit(int limit)
     if (limit < 0)
     {
         megaApi->setUploadLimit(-1);
-        megaApiGuest->setUploadLimit(-1);
+        if (megaApiGuest)
+        {
+            megaApiGuest->setUploadLimit(-1);
+        }
     }
     else
     {
         megaApi->setUploadLimit(limit * 1024);
-        megaApiGuest->setUploadLimit(limit * 1024);
+        if (megaApiGuest)
+        {
+            megaApiGuest->setUploadLimit(limit * 1024);
+        }
     }
 }
 
@@ -2254,7 +2549,10 @@ void MegaApplication::setUseHttpsOnly(bool httpsOnly)
     }
 
     megaApi->useHttpsOnly(httpsOnly);
-    megaApiGuest->useHttpsOnly(httpsOnly);
+    if (megaApiGuest)
+    {
+        megaApiGuest->useHttpsOnly(httpsOnly);
+    }
 }
 
 void MegaApplication::startUpdateTask()
@@ -2362,11 +2660,17 @@ void MegaApplication::applyProxySettings()
     }
 
     megaApi->setProxySettings(proxySettings);
-    megaApiGuest->setProxySettings(proxySettings);
-    delete proxySettings;
     QNetworkProxy::setApplicationProxy(proxy);
     megaApi->retryPendingConnections(true, true);
-    megaApiGuest->retryPendingConnections(true, true);
+    if (megaApiGuest)
+    {
+        megaApiGuest->setProxySettings(proxySettings);
+        megaApiGuest->retryPendingConnections(true, true);
+    }
+
+    //Kept to configure the guest MegaApi when it's created
+    delete currentProxySettings;
+    currentProxySettings = proxySettings;
 }
 
 void MegaApplication::showUpdatedMessage()
@@ -2512,6 +2816,41 @@ void MegaApplication::toggleLogging()
     }
 }
 
+void MegaApplication::toggleProfiling()
+{
+    if (appfinished)
+    {
+        return;
+    }
+
+    SamplingProfiler *profiler = SamplingProfiler::instance();
+    if (profiler->isRunning())
+    {
+#if QT_VERSION < 0x050000
+        QString desktopPath = QDesktopServices::storageLocation(QDesktopServices::DesktopLocation);
+#else
+        QString desktopPath = QStandardPaths::standardLocations(QStandardPaths::DesktopLocation)[0];
+#endif
+        QString profilePath = desktopPath + QDir::separator() + QString::fromAscii("MEGAsync.folded");
+        if (profiler->stop(profilePath))
+        {
+            showInfoMessage(tr("Profiling disabled. The profile has been saved in your desktop (MEGAsync.folded)"));
+        }
+        else
+        {
+            showErrorMessage(tr("Profiling disabled. The profile couldn't be saved"));
+        }
+    }
+    else if (profiler->start(preferences->profilerFrequencyHz()))
+    {
+        showInfoMessage(tr("Profiling enabled"));
+    }
+    else
+    {
+        showErrorMessage(tr("Profiling isn't available"));
+    }
+}
+
 #if (QT_VERSION == 0x050500) && defined(_WIN32)
 bool MegaApplication::eventFilter(QObject *o, QEvent *ev)
 {
@@ -2588,7 +2927,9 @@ void MegaApplication::importLinks()
     pasteMegaLinksDialog = NULL;
 
     //Send links to the link processor
-    LinkProcessor *linkProcessor = new LinkProcessor(megaApi, megaApiGuest, linkList);
+    LinkProcessor *linkProcessor = new LinkProcessor(megaApi, getMegaApiGuest(), linkList);
+    activeLinkProcessors++;
+    connect(linkProcessor, SIGNAL(destroyed()), this, SLOT(onLinkProcessorDestroyed()));
 
     //Open the import dialog
     importDialog = new ImportMegaLinksDialog(megaApi, preferences, linkProcessor);
@@ -2875,22 +3216,9 @@ void MegaApplication::createTrayIcon()
     trayIcon->setContextMenu(&emptyMenu);
 #endif
 
-    trayIcon->setToolTip(QCoreApplication::applicationName()
-                     + QString::fromAscii(" ")
-                     + Preferences::VERSION_STRING
-                     + QString::fromAscii("\n")
-                     + tr("Starting"));
-
-#ifndef __APPLE__
-    #ifdef _WIN32
-        trayIcon->setIcon(QIcon(QString::fromAscii("://images/tray_sync.ico")));
-    #else
-        trayIcon->setIcon(QIcon(QString::fromAscii("://images/22_synching.png")));
-    #endif
-#else
-    trayIcon->setIcon(QIcon(QString::fromAscii("://images/icon_syncing_mac.png")),
-                      QIcon(QString::fromAscii("://images/icon_syncing_mac_white.png")));
+    setTrayIcon(TRAY_STATE_STARTING);
 
+#ifdef __APPLE__
     if (!scanningTimer->isActive())
     {
         scanningAnimationIndex = 1;
@@ -3136,7 +3464,7 @@ void MegaApplication::externalDownload(QString megaLink)
     }
 
     pendingLinks.append(megaLink);
-    megaApiGuest->getPublicNode(megaLink.toUtf8().constData());
+    getMegaApiGuest()->getPublicNode(megaLink.toUtf8().constData());
 }
 
 void MegaApplication::internalDownload(long long handle)
@@ -3182,6 +3510,11 @@ void MegaApplication::onLinkImportFinished()
     linkProcessor->deleteLater();
 }
 
+void MegaApplication::onLinkProcessorDestroyed()
+{
+    activeLinkProcessors--;
+}
+
 void MegaApplication::onRequestLinksFinished()
 {
     if (appfinished)
@@ -3336,7 +3669,10 @@ void MegaApplication::trayIconActivated(QSystemTrayIcon::ActivationReason reason
     }
 
     megaApi->retryPendingConnections();
-    megaApiGuest->retryPendingConnections();
+    if (megaApiGuest)
+    {
+        megaApiGuest->retryPendingConnections();
+    }
 
     if (reason == QSystemTrayIcon::Trigger || reason == QSystemTrayIcon::Context)
     {
@@ -3550,7 +3886,10 @@ void MegaApplication::changeProxy()
     {
         proxyOnly = !megaApi->isFilesystemAvailable() || !preferences->logged();
         megaApi->retryPendingConnections();
-        megaApiGuest->retryPendingConnections();
+        if (megaApiGuest)
+        {
+            megaApiGuest->retryPendingConnections();
+        }
     }
 
     if (settingsDialog)
@@ -4095,7 +4434,10 @@ void MegaApplication::onRequestFinish(MegaApi*, MegaRequest *request, MegaError*
                     {
                         // Retry
                         megaApi->retryPendingConnections();
-                        megaApiGuest->retryPendingConnections();
+                        if (megaApiGuest)
+                        {
+                            megaApiGuest->retryPendingConnections();
+                        }
                         delete sslKeyPinningError;
                         sslKeyPinningError = NULL;
                         return;
@@ -4107,7 +4449,10 @@ void MegaApplication::onRequestFinish(MegaApi*, MegaRequest *request, MegaError*
                     if (!ex || !result)
                     {
                         megaApi->retryPendingConnections();
-                        megaApiGuest->retryPendingConnections();
+                        if (megaApiGuest)
+                        {
+                            megaApiGuest->retryPendingConnections();
+                        }
                         delete sslKeyPinningError;
                         sslKeyPinningError = NULL;
                         return;
@@ -4118,10 +4463,14 @@ void MegaApplication::onRequestFinish(MegaApi*, MegaRequest *request, MegaError*
                         preferences->setSSLcertificateException(true);
                     }
 
+                    publicKeyPinning = false;
                     megaApi->setPublicKeyPinning(false);
-                    megaApiGuest->setPublicKeyPinning(false);
                     megaApi->retryPendingConnections(true);
-                    megaApiGuest->retryPendingConnections(true);
+                    if (megaApiGuest)
+                    {
+                        megaApiGuest->setPublicKeyPinning(false);
+                        megaApiGuest->retryPendingConnections(true);
+                    }
                     delete sslKeyPinningError;
                     sslKeyPinningError = NULL;
                 }
@@ -4149,6 +4498,9 @@ void MegaApplication::onRequestFinish(MegaApi*, MegaRequest *request, MegaError*
 
         if (preferences && preferences->logged())
         {
+            DebrisAccountant::instance()->reset();
+            NodeSearchIndex::instance()->reset();
+            StreamingCache::instance()->clear();
             preferences->unlink();
             closeDialogs();
             periodicTasks();
@@ -4594,6 +4946,8 @@ void MegaApplication::onTransferFinish(MegaApi* , MegaTransfer *transfer, MegaEr
     }
 
     //Update statics
+    MetricsCollector::instance()->transferFinished(transfer->getType(), transfer->getDeltaSize(),
+                                                   e->getErrorCode() == MegaError::API_OK);
     if (transfer->getType()==MegaTransfer::TYPE_DOWNLOAD)
     {
         totalDownloadedSize += transfer->getDeltaSize();
@@ -4719,7 +5073,7 @@ void MegaApplication::onTransferFinish(MegaApi* , MegaTransfer *transfer, MegaEr
 
     //If there are no pending transfers, reset the statics and update the state of the tray icon
     if (!megaApi->getNumPendingDownloads() && !megaApi->getNumPendingUploads()
-            && !megaApiGuest->getNumPendingDownloads())
+            && (!megaApiGuest || !megaApiGuest->getNumPendingDownloads()))
     {
         if (totalUploadSize || totalDownloadSize)
         {
@@ -4741,6 +5095,7 @@ void MegaApplication::onTransferUpdate(MegaApi *, MegaTransfer *transfer)
     }
 
     //Update statics
+    MetricsCollector::instance()->transferUpdated(transfer->getType(), transfer->getDeltaSize(), transfer->getSpeed());
     if (transfer->getType() == MegaTransfer::TYPE_DOWNLOAD)
     {
         downloadSpeed = transfer->getSpeed();
@@ -4839,11 +5194,18 @@ void MegaApplication::onNodesUpdate(MegaApi* , MegaNodeList *nodes)
         return;
     }
 
+    NodeSearchIndex::instance()->nodesUpdated(nodes);
+
     bool externalNodes = 0;
     bool nodesRemoved = false;
+    bool remoteDebrisChanged = false;
     long long usedStorage = preferences->usedStorage();
     MegaApi::log(MegaApi::LOG_LEVEL_INFO, QString::fromUtf8("%1 updated files/folders").arg(nodes->size()).toUtf8().constData());
 
+    //Synced folders are read once for all the nodes
+    QHash<MegaHandle, QList<int> > syncIndexes;
+    QVector<SyncRecord> syncRecords = preferences->getSyncRecords(&syncIndexes);
+
     //Check all modified nodes
     QString localPath;
     for (int i = 0; i < nodes->size(); i++)
@@ -4851,43 +5213,48 @@ void MegaApplication::onNodesUpdate(MegaApi* , MegaNodeList *nodes)
         localPath.clear();
         MegaNode *node = nodes->get(i);
 
-        for (int i = 0; i < preferences->getNumSyncedFolders(); i++)
+        QList<int> nodeSyncIndexes;
+        if (node->getType() == MegaNode::TYPE_FOLDER)
         {
-            if (!preferences->isFolderActive(i))
+            nodeSyncIndexes = syncIndexes.value(node->getHandle());
+        }
+
+        for (int j = 0; j < nodeSyncIndexes.size(); j++)
+        {
+            int syncIndex = nodeSyncIndexes[j];
+            const SyncRecord &syncRecord = syncRecords.at(syncIndex);
+            if (!syncRecord.active)
             {
                 continue;
             }
 
-            if (node->getType() == MegaNode::TYPE_FOLDER
-                    && (node->getHandle() == preferences->getMegaFolderHandle(i)))
-            {
-                MegaNode *nodeByHandle = megaApi->getNodeByHandle(preferences->getMegaFolderHandle(i));
-                const char *nodePath = megaApi->getNodePath(nodeByHandle);
+            MegaNode *nodeByHandle = megaApi->getNodeByHandle(syncRecord.megaFolderHandle);
+            const char *nodePath = megaApi->getNodePath(nodeByHandle);
 
-                if (!nodePath || preferences->getMegaFolder(i).compare(QString::fromUtf8(nodePath)))
+            if (!nodePath || syncRecord.megaFolder.compare(QString::fromUtf8(nodePath)))
+            {
+                if (nodePath && QString::fromUtf8(nodePath).startsWith(QString::fromUtf8("//bin")))
                 {
-                    if (nodePath && QString::fromUtf8(nodePath).startsWith(QString::fromUtf8("//bin")))
-                    {
-                        showErrorMessage(tr("Your sync \"%1\" has been disabled because the remote folder is in the rubbish bin")
-                                         .arg(preferences->getSyncName(i)));
-                    }
-                    else
-                    {
-                        showErrorMessage(tr("Your sync \"%1\" has been disabled because the remote folder doesn't exist")
-                                         .arg(preferences->getSyncName(i)));
-                    }
-                    Platform::syncFolderRemoved(preferences->getLocalFolder(i), preferences->getSyncName(i));
-                    Platform::notifyItemChange(preferences->getLocalFolder(i));
-                    MegaNode *node = megaApi->getNodeByHandle(preferences->getMegaFolderHandle(i));
-                    megaApi->removeSync(node);
-                    delete node;
-                    preferences->setSyncState(i, false);
-                    openSettings(SettingsDialog::SYNCS_TAB);
+                    showErrorMessage(tr("Your sync \"%1\" has been disabled because the remote folder is in the rubbish bin")
+                                     .arg(syncRecord.name));
                 }
-
-                delete nodeByHandle;
-                delete [] nodePath;
+                else
+                {
+                    showErrorMessage(tr("Your sync \"%1\" has been disabled because the remote folder doesn't exist")
+                                     .arg(syncRecord.name));
+                }
+                Platform::syncFolderRemoved(syncRecord.canonicalLocalFolder, syncRecord.name);
+                Platform::notifyItemChange(syncRecord.canonicalLocalFolder);
+                megaApi->removeSync(nodeByHandle);
+                preferences->setSyncState(syncIndex, false);
+                //Keep the snapshot in sync so later nodes of this batch skip the disabled folder
+                //(syncRecord isn't used after this point, the write can detach the vector)
+                syncRecords[syncIndex].active = false;
+                openSettings(SettingsDialog::SYNCS_TAB);
             }
+
+            delete nodeByHandle;
+            delete [] nodePath;
         }
 
         if (!node->getTag() && !node->isRemoved()
@@ -4903,6 +5270,11 @@ void MegaApplication::onNodesUpdate(MegaApi* , MegaNodeList *nodes)
             nodesRemoved = true;
         }
 
+        if (node->isSyncDeleted() && !node->isRemoved())
+        {
+            remoteDebrisChanged = true;
+        }
+
         if (!node->isRemoved() && node->getTag()
                 && !node->isSyncDeleted()
                 && (node->getType() == MegaNode::TYPE_FILE))
@@ -4959,6 +5331,11 @@ void MegaApplication::onNodesUpdate(MegaApi* , MegaNodeList *nodes)
         }
     }
 
+    if (remoteDebrisChanged)
+    {
+        DebrisAccountant::instance()->remoteDebrisChanged();
+    }
+
     if (nodesRemoved)
     {
         preferences->setUsedStorage(usedStorage);
@@ -5001,12 +5378,42 @@ void MegaApplication::onGlobalSyncStateChanged(MegaApi *)
         return;
     }
 
-    if (megaApi && megaApiGuest)
+    if (megaApi)
     {
         indexing = megaApi->isScanning();
-        waiting = megaApi->isWaiting() || megaApiGuest->isWaiting();
+        waiting = megaApi->isWaiting() || (megaApiGuest && megaApiGuest->isWaiting());
+    }
+
+    GlobalSyncState state;
+    state.paused = paused;
+    state.indexing = indexing;
+    state.waiting = waiting;
+    state.pendingUploads = megaApi->getNumPendingUploads();
+    state.pendingDownloads = megaApi->getNumPendingDownloads();
+    if (megaApiGuest)
+    {
+        state.pendingUploads += megaApiGuest->getNumPendingUploads();
+        state.pendingDownloads += megaApiGuest->getNumPendingDownloads();
+    }
+
+    if (syncStateKnown && state == lastSyncState)
+    {
+        //Nothing changed. Only keep the times of the recent files up to date
+        if (infoDialog && infoDialog->isVisible())
+        {
+            infoDialog->updateRecentFiles();
+        }
+
+        if (!isLinux)
+        {
+            updateTrayIcon();
+        }
+        return;
     }
 
+    lastSyncState = state;
+    syncStateKnown = true;
+
     if (infoDialog)
     {
         infoDialog->setIndexing(indexing);
@@ -5020,16 +5427,14 @@ void MegaApplication::onGlobalSyncStateChanged(MegaApi *)
     MegaApi::log(MegaApi::LOG_LEVEL_INFO, QString::fromUtf8("Current state. Paused = %1   Indexing = %2   Waiting = %3")
                  .arg(paused).arg(indexing).arg(waiting).toUtf8().constData());
 
-    int pendingUploads = megaApi->getNumPendingUploads();
-    int pendingDownloads = megaApi->getNumPendingDownloads() + megaApiGuest->getNumPendingDownloads();
-    if (pendingUploads)
+    if (state.pendingUploads)
     {
-        MegaApi::log(MegaApi::LOG_LEVEL_INFO, QString::fromUtf8("Pending uploads: %1").arg(pendingUploads).toUtf8().constData());
+        MegaApi::log(MegaApi::LOG_LEVEL_INFO, QString::fromUtf8("Pending uploads: %1").arg(state.pendingUploads).toUtf8().constData());
     }
 
-    if (pendingDownloads)
+    if (state.pendingDownloads)
     {
-        MegaApi::log(MegaApi::LOG_LEVEL_INFO, QString::fromUtf8("Pending downloads: %1").arg(pendingDownloads).toUtf8().constData());
+        MegaApi::log(MegaApi::LOG_LEVEL_INFO, QString::fromUtf8("Pending downloads: %1").arg(state.pendingDownloads).toUtf8().constData());
     }
 
     if (!isLinux)
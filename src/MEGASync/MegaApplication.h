@@ -41,10 +41,27 @@
 
 Q_DECLARE_METATYPE(QQueue<QString>)
 
+//Values shown by the tray icon and the status window
+struct GlobalSyncState
+{
+    bool paused;
+    bool indexing;
+    bool waiting;
+    int pendingUploads;
+    int pendingDownloads;
+
+    bool operator==(const GlobalSyncState &other) const
+    {
+        return paused == other.paused && indexing == other.indexing && waiting == other.waiting
+                && pendingUploads == other.pendingUploads && pendingDownloads == other.pendingDownloads;
+    }
+};
+
 class Notificator;
 class MEGASyncDelegateListener;
+class CallbackRecorder;
 
-class MegaApplication : public QApplication, public mega::MegaListener
+class MegaApplication : public QApplication, public mega::MegaListener, public HTTPServerApiProvider
 {
     Q_OBJECT
 
@@ -54,6 +71,9 @@ public:
     ~MegaApplication();
 
     void initialize();
+#ifdef CALLBACK_REPLAY
+    bool startCallbackReplay();
+#endif
     static QString applicationFilePath();
     static QString applicationDirPath();
     static QString applicationDataPath();
@@ -77,10 +97,10 @@ public:
 
 
     mega::MegaApi *getMegaApi() { return megaApi; }
-    mega::MegaApi *getMegaApiGuest() { return megaApiGuest; }
+    mega::MegaApi *getMegaApiGuest();
+    mega::MegaApi *getActiveMegaApiGuest() { return megaApiGuest; }
 
     void unlink();
-    void showInfoMessage(QString message, QString title = tr("MEGAsync"));
     void showWarningMessage(QString message, QString title = tr("MEGAsync"));
     void showErrorMessage(QString message, QString title = tr("MEGAsync"));
     void showNotificationMessage(QString message, QString title = tr("MEGAsync"));
@@ -94,6 +114,7 @@ public:
     void checkForUpdates();
     void showTrayMenu(QPoint *point = NULL);
     void toggleLogging();
+    void toggleProfiling();
 
 #if (QT_VERSION == 0x050500) && defined(_WIN32)
     bool eventFilter(QObject *o, QEvent * ev);
@@ -106,6 +127,7 @@ signals:
     void unityFixSignal();
 
 public slots:
+    void showInfoMessage(QString message, QString title = tr("MEGAsync"));
     void trayIconActivated(QSystemTrayIcon::ActivationReason reason);
     void onMessageClicked();
     void start();
@@ -128,6 +150,7 @@ public slots:
     void internalDownload(long long handle);
     void syncFolder(long long handle);
     void onLinkImportFinished();
+    void onLinkProcessorDestroyed();
     void onRequestLinksFinished();
     void onUpdateCompleted();
     void onUpdateAvailable(bool requested);
@@ -138,6 +161,7 @@ public slots:
     void exitApplication();
     void pauseTransfers(bool pause);
     void checkNetworkInterfaces();
+    void onNetworkChanged();
     void periodicTasks();
     void cleanAll();
     void onDupplicateLink(QString link, QString name, mega::MegaHandle handle);
@@ -160,6 +184,8 @@ public slots:
 
 protected:
     void createTrayIcon();
+    void loadTrayIcons();
+    void setTrayIcon(int state);
     void createTrayMenu();
     void createOverQuotaMenu();
     void createGuestMenu();
@@ -168,6 +194,7 @@ protected:
     void startSyncs();
     void processUploadQueue(mega::MegaHandle nodeHandle);
     void processDownloadQueue(QString path);
+    void releaseIdleMegaApiGuest();
     void unityFix();
     void disableSyncs();
     void restoreSyncs();
@@ -217,6 +244,28 @@ protected:
     QTimer *scanningTimer;
     QTimer *connectivityTimer;
     int scanningAnimationIndex;
+
+    enum {
+        TRAY_STATE_NONE = -1,
+        TRAY_STATE_OVERQUOTA = 0,
+        TRAY_STATE_PAUSED,
+        TRAY_STATE_SCANNING,
+        TRAY_STATE_WAITING,
+        TRAY_STATE_SYNCING,
+        TRAY_STATE_UP_TO_DATE,
+        TRAY_STATE_NO_CONNECTION,
+        TRAY_STATE_LOGGING_IN,
+        TRAY_STATE_STARTING,
+        NUM_TRAY_STATES
+    };
+    int trayState;
+    bool trayUpdateAvailable;
+    QList<QIcon> trayIcons;
+#ifdef __APPLE__
+    QList<QIcon> trayIconsWhite;
+#endif
+    GlobalSyncState lastSyncState;
+    bool syncStateKnown;
     SetupWizard *setupWizard;
     SettingsDialog *settingsDialog;
     InfoDialog *infoDialog;
@@ -243,6 +292,14 @@ protected:
     UpgradeDialog *bwOverquotaDialog;
     mega::QTMegaListener *delegateListener;
     mega::QTMegaListener *delegateGuestListener;
+    CallbackRecorder *callbackRecorder;
+    QString recordCallbacksPath;
+    QString replayCallbacksPath;
+    bool replayRealTime;
+    mega::MegaProxy *currentProxySettings;
+    long long lastGuestActivity;
+    int activeLinkProcessors;
+    bool publicKeyPinning;
     QMap<int, QString> uploadLocalPaths;
     MegaUploader *uploader;
     MegaDownloader *downloader;
@@ -288,6 +345,7 @@ protected:
     bool isFirstSyncDone;
     bool isFirstFileSynced;
     bool networkConnectivity;
+    bool networkMonitorActive;
 };
 
 class MEGASyncDelegateListener: public mega::QTMegaListener
@@ -0,0 +1,807 @@
+#include "MegaDaemon.h"
+#include "MegaApplication.h"
+#include "control/CrashHandler.h"
+#include "control/Utilities.h"
+#include "control/ExportProcessor.h"
+#include "platform/Platform.h"
+#include "qtlockedfile/qtlockedfile.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QNetworkProxy>
+
+#if QT_VERSION >= 0x050000
+#include <QStandardPaths>
+#else
+#include <QDesktopServices>
+#endif
+
+#include <cmath>
+
+#ifndef WIN32
+#include <unistd.h>
+#endif
+
+using namespace mega;
+using namespace std;
+
+MegaDaemon::MegaDaemon(int &argc, char **argv) :
+    QCoreApplication(argc, argv)
+{
+    megaApi = NULL;
+    delegateListener = NULL;
+    httpServer = NULL;
+    uploader = NULL;
+    downloader = NULL;
+    commandServer = NULL;
+    periodicTasksTimer = NULL;
+    preferences = NULL;
+    state = STATE_NOT_LOGGED;
+    paused = false;
+    finished = false;
+
+    //Servers usually collect the standard output of their services
+    logger = new MegaSyncLogger();
+    logger->sendLogsToStdout(true);
+    MegaApi::setLogLevel(MegaApi::LOG_LEVEL_INFO);
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp("--debug", argv[i]))
+        {
+            MegaApi::setLogLevel(MegaApi::LOG_LEVEL_MAX);
+        }
+    }
+    MegaApi::setLoggerObject(logger);
+
+    //The same names as MegaApplication, to share the settings and the data folder
+    setOrganizationName(QString::fromAscii("Mega Limited"));
+    setOrganizationDomain(QString::fromAscii("mega.co.nz"));
+    setApplicationName(QString::fromAscii("MEGAsync"));
+    setApplicationVersion(QString::number(Preferences::VERSION_CODE));
+
+#if QT_VERSION < 0x050000
+    dataPath = QDesktopServices::storageLocation(QDesktopServices::DataLocation);
+#else
+    dataPath = QStandardPaths::standardLocations(QStandardPaths::DataLocation)[0];
+#endif
+
+    QDir currentDir(dataPath);
+    if (!currentDir.exists())
+    {
+        currentDir.mkpath(QString::fromAscii("."));
+    }
+    QDir::setCurrent(dataPath);
+}
+
+MegaDaemon::~MegaDaemon()
+{
+
+}
+
+bool MegaDaemon::isHeadless(int argc, char *argv[])
+{
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp("--headless", argv[i]))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+int MegaDaemon::run()
+{
+    QString crashPath = QDir::current().filePath(QString::fromAscii("crashDumps"));
+    QDir crashDir(crashPath);
+    if (!crashDir.exists())
+    {
+        crashDir.mkpath(QString::fromAscii("."));
+    }
+
+#ifndef DEBUG
+    CrashHandler::instance()->Init(QDir::toNativeSeparators(crashPath));
+#endif
+
+    //The daemon and the graphical application can't use the same data folder at once
+    QtLockedFile singleInstanceChecker(QDir::current().filePath(QString::fromAscii("megasync.lock")));
+    singleInstanceChecker.open(QtLockedFile::ReadWrite);
+    if (!singleInstanceChecker.lock(QtLockedFile::WriteLock, false))
+    {
+        MegaApi::log(MegaApi::LOG_LEVEL_WARNING, "MEGAsync is already started");
+        return 0;
+    }
+
+    initialize();
+    start();
+    return exec();
+}
+
+void MegaDaemon::initialize()
+{
+    preferences = Preferences::instance();
+    preferences->initialize();
+    if (preferences->error())
+    {
+        MegaApi::log(MegaApi::LOG_LEVEL_ERROR, "The configuration is corrupt");
+    }
+
+    QString basePath = QDir::toNativeSeparators(QDir::currentPath() + QString::fromAscii("/"));
+    megaApi = new MegaApi(Preferences::CLIENT_KEY, basePath.toUtf8().constData(), Preferences::USER_AGENT);
+    megaApi->setDownloadMethod(preferences->transferDownloadMethod());
+    megaApi->setUploadMethod(preferences->transferUploadMethod());
+    megaApi->useHttpsOnly(preferences->usingHttpsOnly());
+    megaApi->setDefaultFilePermissions(preferences->filePermissionsValue());
+    megaApi->setDefaultFolderPermissions(preferences->folderPermissionsValue());
+    megaApi->retrySSLerrors(true);
+    megaApi->setPublicKeyPinning(!preferences->SSLcertificateException());
+
+    int uploadLimit = preferences->uploadLimitKB();
+    megaApi->setUploadLimit((uploadLimit < 0) ? -1 : uploadLimit * 1024);
+
+    //The delegate listener resumes the syncs once the nodes are fetched
+    delegateListener = new MEGASyncDelegateListener(megaApi, this);
+    megaApi->addListener(delegateListener);
+    uploader = new MegaUploader(megaApi);
+    downloader = new MegaDownloader(megaApi);
+
+    //The web client and the file manager use the same servers as with MegaApplication
+    httpServer = new HTTPServer(Preferences::HTTPS_PORT, true, this);
+    connect(httpServer, SIGNAL(onLinkReceived(QString)), this, SLOT(externalDownload(QString)), Qt::QueuedConnection);
+    connect(httpServer, SIGNAL(onExternalDownloadRequested(QQueue<mega::MegaNode *>)), this, SLOT(externalDownload(QQueue<mega::MegaNode *>)));
+    connect(httpServer, SIGNAL(onSyncRequested(long long)), this, SLOT(syncFolder(long long)), Qt::QueuedConnection);
+    connect(httpServer, SIGNAL(onInfoMessage(QString)), this, SLOT(showInfoMessage(QString)));
+
+#if !defined(WIN32) && !defined(__APPLE__)
+    Platform::startShellDispatcher(this, megaApi, dataPath);
+#endif
+
+    commandServer = new QLocalServer(this);
+    QLocalServer::removeServer(socketPath());
+    if (!Utilities::listenForCurrentUser(commandServer, socketPath()))
+    {
+        MegaApi::log(MegaApi::LOG_LEVEL_ERROR, QString::fromUtf8("Unable to listen for commands on %1: %2")
+                     .arg(socketPath()).arg(commandServer->errorString()).toUtf8().constData());
+    }
+    connect(commandServer, SIGNAL(newConnection()), this, SLOT(acceptConnection()));
+
+    periodicTasksTimer = new QTimer(this);
+    periodicTasksTimer->start(Preferences::STATE_REFRESH_INTERVAL_MS);
+    connect(periodicTasksTimer, SIGNAL(timeout()), this, SLOT(periodicTasks()));
+    connect(this, SIGNAL(aboutToQuit()), this, SLOT(cleanAll()));
+}
+
+void MegaDaemon::start()
+{
+    QNetworkProxy proxy(QNetworkProxy::NoProxy);
+    MegaProxy *proxySettings = new MegaProxy();
+    proxySettings->setProxyType(preferences->proxyType());
+    if (preferences->proxyType() == MegaProxy::PROXY_CUSTOM)
+    {
+        QString proxyString = preferences->proxyHostAndPort();
+        if (preferences->proxyProtocol() == Preferences::PROXY_PROTOCOL_SOCKS5H)
+        {
+            proxy.setType(QNetworkProxy::Socks5Proxy);
+            proxyString.insert(0, QString::fromUtf8("socks5h://"));
+        }
+        else
+        {
+            proxy.setType(QNetworkProxy::HttpProxy);
+        }
+        proxySettings->setProxyURL(proxyString.toUtf8().constData());
+        proxy.setHostName(preferences->proxyServer());
+        proxy.setPort(preferences->proxyPort());
+        if (preferences->proxyRequiresAuth())
+        {
+            proxySettings->setCredentials(preferences->getProxyUsername().toUtf8().constData(),
+                                          preferences->getProxyPassword().toUtf8().constData());
+            proxy.setUser(preferences->getProxyUsername());
+            proxy.setPassword(preferences->getProxyPassword());
+        }
+    }
+    megaApi->setProxySettings(proxySettings);
+    delete proxySettings;
+    QNetworkProxy::setApplicationProxy(proxy);
+
+    if (!preferences->logged())
+    {
+        MegaApi::log(MegaApi::LOG_LEVEL_WARNING, "There isn't any session. Use the login command to log in");
+        return;
+    }
+
+    applyAccountSettings();
+    state = STATE_LOGGING_IN;
+    if (preferences->getSession().size())
+    {
+        megaApi->fastLogin(preferences->getSession().toUtf8().constData());
+    }
+    else
+    {
+        megaApi->fastLogin(preferences->email().toUtf8().constData(),
+                   preferences->emailHash().toUtf8().constData(),
+                   preferences->privatePw().toUtf8().constData());
+    }
+}
+
+void MegaDaemon::applyAccountSettings()
+{
+    QStringList exclusions = preferences->getExcludedSyncNames();
+    vector<string> vExclusions;
+    for (int i = 0; i < exclusions.size(); i++)
+    {
+        vExclusions.push_back(exclusions[i].toUtf8().constData());
+    }
+    megaApi->setExcludedNames(&vExclusions);
+    megaApi->setExclusionLowerSizeLimit(preferences->lowerSizeLimit() ?
+            preferences->lowerSizeLimitValue() * pow((float)1024, preferences->lowerSizeLimitUnit()) : 0);
+    megaApi->setExclusionUpperSizeLimit(preferences->upperSizeLimit() ?
+            preferences->upperSizeLimitValue() * pow((float)1024, preferences->upperSizeLimitUnit()) : 0);
+}
+
+void MegaDaemon::cleanAll()
+{
+    if (finished)
+    {
+        return;
+    }
+    finished = true;
+
+    periodicTasksTimer->stop();
+    qDeleteAll(clients);
+    clients.clear();
+    commandServer->close();
+    QLocalServer::removeServer(socketPath());
+
+#if !defined(WIN32) && !defined(__APPLE__)
+    Platform::stopShellDispatcher();
+#endif
+    delete httpServer;
+    httpServer = NULL;
+    delete uploader;
+    uploader = NULL;
+    delete downloader;
+    downloader = NULL;
+
+    megaApi->removeListener(delegateListener);
+    delete delegateListener;
+    delegateListener = NULL;
+    delete megaApi;
+    megaApi = NULL;
+
+    preferences->setLastExit(QDateTime::currentMSecsSinceEpoch());
+    MegaApi::setLoggerObject(NULL);
+    delete logger;
+    logger = NULL;
+}
+
+QString MegaDaemon::socketPath()
+{
+#ifdef WIN32
+    return Utilities::getUserPipeName(QString::fromAscii("MEGAsync.daemon"));
+#else
+    return QDir(dataPath).filePath(QString::fromAscii("daemon.socket"));
+#endif
+}
+
+void MegaDaemon::periodicTasks()
+{
+    if (state != STATE_READY)
+    {
+        return;
+    }
+
+    megaApi->updateStats();
+}
+
+void MegaDaemon::onRequestFinish(MegaApi *, MegaRequest *request, MegaError *e)
+{
+    if (finished)
+    {
+        return;
+    }
+
+    switch (request->getType())
+    {
+    case MegaRequest::TYPE_LOGIN:
+    {
+        if (e->getErrorCode() == MegaError::API_OK)
+        {
+            //Login with the login command
+            if (!loginEmail.isEmpty() && (!preferences->logged() || preferences->email() != loginEmail))
+            {
+                preferences->setEmail(loginEmail);
+                applyAccountSettings();
+            }
+
+            const char *session = megaApi->dumpSession();
+            if (session)
+            {
+                preferences->setSession(QString::fromUtf8(session));
+                delete [] session;
+            }
+
+            state = STATE_FETCHING_NODES;
+            megaApi->fetchNodes();
+        }
+        else
+        {
+            MegaApi::log(MegaApi::LOG_LEVEL_ERROR, QString::fromUtf8("Login error: %1")
+                         .arg(QString::fromUtf8(e->getErrorString())).toUtf8().constData());
+            state = STATE_NOT_LOGGED;
+        }
+        break;
+    }
+    case MegaRequest::TYPE_FETCH_NODES:
+    {
+        if (e->getErrorCode() == MegaError::API_OK)
+        {
+            MegaApi::log(MegaApi::LOG_LEVEL_INFO, "Headless mode ready");
+            state = STATE_READY;
+            megaApi->pauseTransfers(paused);
+        }
+        else
+        {
+            MegaApi::log(MegaApi::LOG_LEVEL_ERROR, QString::fromUtf8("Error fetching nodes: %1")
+                         .arg(QString::fromUtf8(e->getErrorString())).toUtf8().constData());
+            state = STATE_NOT_LOGGED;
+        }
+        break;
+    }
+    case MegaRequest::TYPE_LOGOUT:
+    {
+        //The session was closed from another client
+        if (e->getErrorCode() == MegaError::API_ESID)
+        {
+            MegaApi::log(MegaApi::LOG_LEVEL_ERROR, "The session has been closed");
+            preferences->unlink();
+        }
+        state = STATE_NOT_LOGGED;
+        break;
+    }
+    case MegaRequest::TYPE_GET_PUBLIC_NODE:
+    {
+        //Links received from the web client
+        MegaNode *node = (e->getErrorCode() == MegaError::API_OK) ? request->getPublicMegaNode() : NULL;
+        if (!node)
+        {
+            MegaApi::log(MegaApi::LOG_LEVEL_ERROR, QString::fromUtf8("Error getting a public node: %1")
+                         .arg(QString::fromUtf8(e->getErrorString())).toUtf8().constData());
+            break;
+        }
+
+        QQueue<MegaNode *> downloadQueue;
+        downloadQueue.append(node);
+        externalDownload(downloadQueue);
+        break;
+    }
+    case MegaRequest::TYPE_PAUSE_TRANSFERS:
+    {
+        paused = request->getFlag();
+        break;
+    }
+    case MegaRequest::TYPE_ADD_SYNC:
+    {
+        for (int i = preferences->getNumSyncedFolders() - 1; i >= 0; i--)
+        {
+            if (request->getNodeHandle() != preferences->getMegaFolderHandle(i))
+            {
+                continue;
+            }
+
+            if (e->getErrorCode() == MegaError::API_OK)
+            {
+                preferences->setLocalFingerprint(i, request->getNumber());
+            }
+            else
+            {
+                MegaApi::log(MegaApi::LOG_LEVEL_ERROR, QString::fromUtf8("Sync %1 disabled: %2")
+                             .arg(preferences->getSyncName(i))
+                             .arg(QString::fromUtf8(e->getErrorString())).toUtf8().constData());
+                preferences->setSyncState(i, false);
+            }
+            break;
+        }
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+void MegaDaemon::onTransferStart(MegaApi *, MegaTransfer *transfer)
+{
+    DaemonTransfer info;
+    info.type = transfer->getType();
+    info.name = QString::fromUtf8(transfer->getFileName());
+    info.transferredBytes = transfer->getTransferredBytes();
+    info.totalBytes = transfer->getTotalBytes();
+    info.speed = transfer->getSpeed();
+    transfers.insert(transfer->getTag(), info);
+}
+
+void MegaDaemon::onTransferUpdate(MegaApi *, MegaTransfer *transfer)
+{
+    QMap<int, DaemonTransfer>::iterator it = transfers.find(transfer->getTag());
+    if (it != transfers.end())
+    {
+        it.value().transferredBytes = transfer->getTransferredBytes();
+        it.value().totalBytes = transfer->getTotalBytes();
+        it.value().speed = transfer->getSpeed();
+    }
+}
+
+void MegaDaemon::onTransferFinish(MegaApi *, MegaTransfer *transfer, MegaError *e)
+{
+    transfers.remove(transfer->getTag());
+    if (e->getErrorCode() != MegaError::API_OK)
+    {
+        MegaApi::log(MegaApi::LOG_LEVEL_WARNING, QString::fromUtf8("Transfer failed: %1 (%2)")
+                     .arg(QString::fromUtf8(transfer->getFileName()))
+                     .arg(QString::fromUtf8(e->getErrorString())).toUtf8().constData());
+    }
+}
+
+void MegaDaemon::onSyncFileStateChanged(MegaApi *, MegaSync *, const char *filePath, int)
+{
+    if (finished)
+    {
+        return;
+    }
+
+    Platform::notifyItemChange(QString::fromUtf8(filePath));
+}
+
+MegaApi *MegaDaemon::getMegaApiGuest()
+{
+    return megaApi;
+}
+
+MegaApi *MegaDaemon::getActiveMegaApiGuest()
+{
+    return megaApi;
+}
+
+//Files sent from the file manager go to the default upload folder
+void MegaDaemon::shellUpload(QQueue<QString> newUploadQueue)
+{
+    if (finished || state != STATE_READY)
+    {
+        return;
+    }
+
+    MegaNode *node = preferences->hasDefaultUploadFolder() ? megaApi->getNodeByHandle(preferences->uploadFolder()) : NULL;
+    if (!node || node->isFile())
+    {
+        MegaApi::log(MegaApi::LOG_LEVEL_ERROR, "Upload cancelled: there isn't any default upload folder");
+        delete node;
+        return;
+    }
+
+    while (!newUploadQueue.isEmpty())
+    {
+        uploader->upload(newUploadQueue.dequeue(), node);
+    }
+    delete node;
+}
+
+void MegaDaemon::shellExport(QQueue<QString> newExportQueue)
+{
+    if (finished || state != STATE_READY)
+    {
+        return;
+    }
+
+    ExportProcessor *processor = new ExportProcessor(megaApi, newExportQueue);
+    connect(processor, SIGNAL(onRequestLinksFinished()), this, SLOT(onRequestLinksFinished()));
+    processor->requestLinks();
+}
+
+//There isn't any clipboard, the links are written to the log
+void MegaDaemon::onRequestLinksFinished()
+{
+    ExportProcessor *processor = (ExportProcessor *)QObject::sender();
+    QStringList links = processor->getValidLinks();
+    for (int i = 0; i < links.size(); i++)
+    {
+        MegaApi::log(MegaApi::LOG_LEVEL_INFO, QString::fromUtf8("Public link: %1")
+                     .arg(links[i]).toUtf8().constData());
+    }
+    processor->deleteLater();
+}
+
+//Downloads requested by the web client go to the default download folder
+void MegaDaemon::externalDownload(QQueue<MegaNode *> newDownloadQueue)
+{
+    if (finished || !preferences->logged() || !preferences->hasDefaultDownloadFolder())
+    {
+        MegaApi::log(MegaApi::LOG_LEVEL_ERROR, "Download cancelled: there isn't any default download folder");
+        qDeleteAll(newDownloadQueue);
+        return;
+    }
+
+    downloader->processDownloadQueue(&newDownloadQueue, preferences->downloadFolder());
+}
+
+void MegaDaemon::externalDownload(QString megaLink)
+{
+    if (finished)
+    {
+        return;
+    }
+
+    megaApi->getPublicNode(megaLink.toUtf8().constData());
+}
+
+void MegaDaemon::syncFolder(long long)
+{
+    MegaApi::log(MegaApi::LOG_LEVEL_WARNING, "Sync requested by the web client. Use the addsync command to add it");
+}
+
+void MegaDaemon::showInfoMessage(QString message)
+{
+    MegaApi::log(MegaApi::LOG_LEVEL_INFO, message.toUtf8().constData());
+}
+
+void MegaDaemon::acceptConnection()
+{
+    while (commandServer->hasPendingConnections())
+    {
+        QLocalSocket *client = commandServer->nextPendingConnection();
+        if (!client)
+        {
+            return;
+        }
+
+        connect(client, SIGNAL(readyRead()), this, SLOT(onClientData()));
+        connect(client, SIGNAL(disconnected()), this, SLOT(onClientDisconnected()));
+        clients.append(client);
+    }
+}
+
+void MegaDaemon::onClientData()
+{
+    QLocalSocket *client = qobject_cast<QLocalSocket *>(sender());
+    if (!client)
+    {
+        return;
+    }
+
+    while (client->canReadLine())
+    {
+        QString line = QString::fromUtf8(client->readLine()).trimmed();
+        if (line.isEmpty())
+        {
+            continue;
+        }
+
+        QStringList response = processCommand(line);
+        response.append(QString());
+        client->write(response.join(QString::fromUtf8("\n")).toUtf8() + '\n');
+        client->flush();
+    }
+}
+
+void MegaDaemon::onClientDisconnected()
+{
+    QLocalSocket *client = qobject_cast<QLocalSocket *>(sender());
+    if (!client)
+    {
+        return;
+    }
+
+    clients.removeAll(client);
+    client->deleteLater();
+}
+
+QStringList MegaDaemon::processCommand(QString line)
+{
+    QStringList arguments = line.split(QChar::fromAscii('\t'));
+    QString command = arguments.takeFirst().trimmed().toLower();
+    MegaApi::log(MegaApi::LOG_LEVEL_DEBUG, QString::fromUtf8("Daemon command received: %1")
+                 .arg(command).toUtf8().constData());
+
+    if (command == QString::fromUtf8("status"))
+    {
+        return statusCommand();
+    }
+    else if (command == QString::fromUtf8("login"))
+    {
+        return loginCommand(arguments);
+    }
+    else if (command == QString::fromUtf8("pause"))
+    {
+        return pauseCommand(true);
+    }
+    else if (command == QString::fromUtf8("resume"))
+    {
+        return pauseCommand(false);
+    }
+    else if (command == QString::fromUtf8("syncs"))
+    {
+        return syncsCommand();
+    }
+    else if (command == QString::fromUtf8("addsync"))
+    {
+        return addSyncCommand(arguments);
+    }
+    else if (command == QString::fromUtf8("removesync"))
+    {
+        return removeSyncCommand(arguments);
+    }
+    else if (command == QString::fromUtf8("transfers"))
+    {
+        return transfersCommand();
+    }
+    else if (command == QString::fromUtf8("quit"))
+    {
+        QTimer::singleShot(0, this, SLOT(quit()));
+        return QStringList(QString::fromUtf8("OK"));
+    }
+
+    return QStringList(QString::fromUtf8("ERROR Unknown command: %1").arg(command));
+}
+
+QStringList MegaDaemon::statusCommand()
+{
+    static const char *stateNames[] = {"not logged in", "logging in", "fetching nodes", "ready"};
+
+    QStringList response;
+    response.append(QString::fromUtf8("OK"));
+    response.append(QString::fromUtf8("state: %1").arg(QString::fromUtf8(stateNames[state])));
+    response.append(QString::fromUtf8("version: %1").arg(Preferences::VERSION_STRING));
+    if (preferences->logged())
+    {
+        response.append(QString::fromUtf8("account: %1").arg(preferences->email()));
+        response.append(QString::fromUtf8("syncs: %1").arg(preferences->getNumSyncedFolders()));
+    }
+    response.append(QString::fromUtf8("paused: %1").arg(paused ? 1 : 0));
+    response.append(QString::fromUtf8("uploads: %1").arg(megaApi->getNumPendingUploads()));
+    response.append(QString::fromUtf8("downloads: %1").arg(megaApi->getNumPendingDownloads()));
+    response.append(QString::fromUtf8("waiting: %1").arg(megaApi->isWaiting() ? 1 : 0));
+    return response;
+}
+
+QStringList MegaDaemon::loginCommand(QStringList arguments)
+{
+    if (arguments.size() != 2)
+    {
+        return QStringList(QString::fromUtf8("ERROR Usage: login <email> <password>"));
+    }
+
+    if (state != STATE_NOT_LOGGED)
+    {
+        return QStringList(QString::fromUtf8("ERROR Already logged in"));
+    }
+
+    loginEmail = arguments[0].toLower().trimmed();
+    state = STATE_LOGGING_IN;
+    megaApi->login(loginEmail.toUtf8().constData(), arguments[1].toUtf8().constData());
+    return QStringList(QString::fromUtf8("OK"));
+}
+
+QStringList MegaDaemon::pauseCommand(bool pause)
+{
+    paused = pause;
+    megaApi->pauseTransfers(pause);
+    return QStringList(QString::fromUtf8("OK"));
+}
+
+QStringList MegaDaemon::syncsCommand()
+{
+    if (!preferences->logged())
+    {
+        return QStringList(QString::fromUtf8("ERROR Not logged in"));
+    }
+
+    QStringList response;
+    response.append(QString::fromUtf8("OK"));
+    for (int i = 0; i < preferences->getNumSyncedFolders(); i++)
+    {
+        response.append(QString::fromUtf8("%1\t%2\t%3\t%4")
+                        .arg(i)
+                        .arg(preferences->isFolderActive(i) ? 1 : 0)
+                        .arg(preferences->getLocalFolder(i))
+                        .arg(preferences->getMegaFolder(i)));
+    }
+    return response;
+}
+
+QStringList MegaDaemon::addSyncCommand(QStringList arguments)
+{
+    if (state != STATE_READY)
+    {
+        return QStringList(QString::fromUtf8("ERROR Not ready"));
+    }
+
+    if (arguments.size() != 2)
+    {
+        return QStringList(QString::fromUtf8("ERROR Usage: addsync <local folder> <MEGA folder>"));
+    }
+
+    QFileInfo localInfo(arguments[0]);
+    QString localFolder = QDir::toNativeSeparators(localInfo.canonicalFilePath());
+    if (!localFolder.size() || !localInfo.isDir())
+    {
+        return QStringList(QString::fromUtf8("ERROR The local folder doesn't exist"));
+    }
+
+    for (int i = 0; i < preferences->getNumSyncedFolders(); i++)
+    {
+        QString syncedFolder = preferences->getLocalFolder(i);
+        if (localFolder.startsWith(syncedFolder) || syncedFolder.startsWith(localFolder))
+        {
+            return QStringList(QString::fromUtf8("ERROR The local folder is already synced"));
+        }
+    }
+
+    MegaNode *node = megaApi->getNodeByPath(arguments[1].toUtf8().constData());
+    if (!node || node->isFile())
+    {
+        delete node;
+        return QStringList(QString::fromUtf8("ERROR The MEGA folder doesn't exist"));
+    }
+
+    if (megaApi->getAccess(node) != MegaShare::ACCESS_OWNER && megaApi->getAccess(node) != MegaShare::ACCESS_FULL)
+    {
+        delete node;
+        return QStringList(QString::fromUtf8("ERROR Full access to the MEGA folder is required"));
+    }
+
+    const char *nodePath = megaApi->getNodePath(node);
+    preferences->addSyncedFolder(localFolder, QString::fromUtf8(nodePath), node->getHandle(), localInfo.fileName());
+    delete [] nodePath;
+    megaApi->syncFolder(localFolder.toUtf8().constData(), node);
+    delete node;
+    return QStringList(QString::fromUtf8("OK"));
+}
+
+QStringList MegaDaemon::removeSyncCommand(QStringList arguments)
+{
+    if (arguments.size() != 1)
+    {
+        return QStringList(QString::fromUtf8("ERROR Usage: removesync <id or local folder>"));
+    }
+
+    bool isNumber = false;
+    int syncIndex = arguments[0].toInt(&isNumber);
+    if (!isNumber)
+    {
+        syncIndex = preferences->getSyncIndexByLocalPath(QFileInfo(arguments[0]).absoluteFilePath());
+    }
+
+    if (syncIndex < 0 || syncIndex >= preferences->getNumSyncedFolders())
+    {
+        return QStringList(QString::fromUtf8("ERROR Sync not found"));
+    }
+
+    MegaApi::log(MegaApi::LOG_LEVEL_INFO, QString::fromAscii("Removing sync: %1")
+                 .arg(preferences->getSyncName(syncIndex)).toUtf8().constData());
+    if (preferences->isFolderActive(syncIndex))
+    {
+        MegaNode *node = megaApi->getNodeByHandle(preferences->getMegaFolderHandle(syncIndex));
+        megaApi->removeSync(node);
+        delete node;
+    }
+    Utilities::removeRecursively(preferences->getLocalFolder(syncIndex) + QDir::separator() + QString::fromAscii(MEGA_DEBRIS_FOLDER));
+    preferences->removeSyncedFolder(syncIndex);
+    return QStringList(QString::fromUtf8("OK"));
+}
+
+QStringList MegaDaemon::transfersCommand()
+{
+    QStringList response;
+    response.append(QString::fromUtf8("OK"));
+    for (QMap<int, DaemonTransfer>::const_iterator it = transfers.begin(); it != transfers.end(); ++it)
+    {
+        const DaemonTransfer &transfer = it.value();
+        response.append(QString::fromUtf8("%1\t%2\t%3\t%4\t%5\t%6")
+                        .arg(it.key())
+                        .arg((transfer.type == MegaTransfer::TYPE_UPLOAD) ? QString::fromUtf8("upload") : QString::fromUtf8("download"))
+                        .arg(transfer.transferredBytes)
+                        .arg(transfer.totalBytes)
+                        .arg(transfer.speed)
+                        .arg(transfer.name));
+    }
+    return response;
+}
@@ -0,0 +1,130 @@
+#ifndef MEGADAEMON_H
+#define MEGADAEMON_H
+
+#include <QCoreApplication>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QStringList>
+#include <QTimer>
+#include <QMap>
+#include <QQueue>
+
+#include "control/Preferences.h"
+#include "control/MegaSyncLogger.h"
+#include "control/HTTPServer.h"
+#include "control/MegaUploader.h"
+#include "control/MegaDownloader.h"
+#include "megaapi.h"
+#include "QTMegaListener.h"
+
+//Transfer in progress, as reported by the "transfers" command
+struct DaemonTransfer
+{
+    int type;
+    QString name;
+    long long transferredBytes;
+    long long totalBytes;
+    long long speed;
+};
+
+//Headless version of MEGAsync for computers without a display (started with
+//--headless). It logs in with the session saved by MegaApplication (or with
+//the login command) and runs the syncs and the transfers without creating
+//any widget.
+//
+//The HTTP server for the web client is started too. Downloads requested by
+//the web client go to the default download folder and sync requests are
+//rejected (syncs are added with addsync). On Linux, the shell extension and
+//notification servers are started as well. Uploads from the file manager go
+//to the default upload folder and exported links are written to the log.
+//
+//It's controlled with a local socket in the data folder (daemon.socket),
+//that only the current user can connect to.
+//Clients send one command per line, with arguments separated by tabs.
+//Responses start with "OK" or "ERROR <description>", have one line per
+//item and end with an empty line:
+//  status                          state, account, paused, syncs and transfers
+//  login <email> <password>        log in if there isn't any valid session
+//  pause / resume                  pause or resume all transfers
+//  syncs                           <id> <active> <local folder> <MEGA folder>
+//  addsync <local> <MEGA folder>   start a new sync
+//  removesync <id or local>        stop and remove a sync
+//  transfers                       <tag> <type> <transferred> <total> <speed> <name>
+//  quit                            stop the daemon
+class MegaDaemon : public QCoreApplication, public mega::MegaListener, public HTTPServerApiProvider
+{
+    Q_OBJECT
+
+public:
+    enum {
+        STATE_NOT_LOGGED = 0,
+        STATE_LOGGING_IN,
+        STATE_FETCHING_NODES,
+        STATE_READY
+    };
+
+    MegaDaemon(int &argc, char **argv);
+    ~MegaDaemon();
+
+    static bool isHeadless(int argc, char *argv[]);
+    int run();
+
+    virtual void onRequestFinish(mega::MegaApi* api, mega::MegaRequest *request, mega::MegaError* e);
+    virtual void onTransferStart(mega::MegaApi *api, mega::MegaTransfer *transfer);
+    virtual void onTransferUpdate(mega::MegaApi *api, mega::MegaTransfer *transfer);
+    virtual void onTransferFinish(mega::MegaApi* api, mega::MegaTransfer *transfer, mega::MegaError* e);
+    virtual void onSyncFileStateChanged(mega::MegaApi *api, mega::MegaSync *sync, const char *filePath, int newState);
+
+    //Public nodes are handled with the logged in MegaApi
+    virtual mega::MegaApi *getMegaApiGuest();
+    virtual mega::MegaApi *getActiveMegaApiGuest();
+
+public slots:
+    void shellUpload(QQueue<QString> newUploadQueue);
+    void shellExport(QQueue<QString> newExportQueue);
+    void externalDownload(QQueue<mega::MegaNode *> newDownloadQueue);
+    void externalDownload(QString megaLink);
+    void syncFolder(long long handle);
+    void showInfoMessage(QString message);
+
+private slots:
+    void acceptConnection();
+    void onClientData();
+    void onClientDisconnected();
+    void periodicTasks();
+    void cleanAll();
+    void onRequestLinksFinished();
+
+private:
+    void initialize();
+    void start();
+    void applyAccountSettings();
+    QString socketPath();
+    QStringList processCommand(QString line);
+    QStringList statusCommand();
+    QStringList loginCommand(QStringList arguments);
+    QStringList syncsCommand();
+    QStringList addSyncCommand(QStringList arguments);
+    QStringList removeSyncCommand(QStringList arguments);
+    QStringList transfersCommand();
+    QStringList pauseCommand(bool pause);
+
+    mega::MegaApi *megaApi;
+    mega::QTMegaListener *delegateListener;
+    MegaSyncLogger *logger;
+    Preferences *preferences;
+    HTTPServer *httpServer;
+    MegaUploader *uploader;
+    MegaDownloader *downloader;
+    QLocalServer *commandServer;
+    QList<QLocalSocket *> clients;
+    QMap<int, DaemonTransfer> transfers;
+    QTimer *periodicTasksTimer;
+    QString dataPath;
+    QString loginEmail;
+    int state;
+    bool paused;
+    bool finished;
+};
+
+#endif // MEGADAEMON_H
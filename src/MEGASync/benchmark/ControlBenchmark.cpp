@@ -0,0 +1,433 @@
+#include "ControlBenchmark.h"
+#include "MegaApplication.h"
+#include "control/EncryptedSettings.h"
+#include "control/Preferences.h"
+#include "control/Utilities.h"
+#include "control/HTTPServer.h"
+#include "control/LinkExtractor.h"
+
+#ifdef Q_OS_LINUX
+#include "platform/linux/ExtServer.h"
+#endif
+
+#include <QtTest/QtTest>
+#include <QTemporaryFile>
+#include <QXmlStreamReader>
+
+class BenchmarkSettings : public EncryptedSettings
+{
+public:
+    BenchmarkSettings(QString file) : EncryptedSettings(file) {}
+
+    QString hashKey(QString key)
+    {
+        return hash(key);
+    }
+};
+
+ControlBenchmark::ControlBenchmark() : QObject()
+{
+    settings = NULL;
+    megaApi = NULL;
+}
+
+void ControlBenchmark::initTestCase()
+{
+    workPath = MegaApplication::applicationDataPath() + QString::fromUtf8("/benchmark");
+    Utilities::removeRecursively(workPath);
+    QDir().mkpath(workPath);
+
+    settings = new BenchmarkSettings(workPath + QString::fromUtf8("/benchmark.cfg"));
+    settings->beginGroup(QString::fromUtf8("account"));
+    for (int i = 0; i < 50; i++)
+    {
+        settings->setValue(QString::fromUtf8("key%1").arg(i), QString::fromUtf8("value%1").arg(i));
+    }
+
+    Preferences *preferences = Preferences::instance();
+    preferences->initialize();
+    preferences->setEmail(QString::fromUtf8("benchmark@mega.nz"));
+
+#ifdef Q_OS_LINUX
+    //The application isn't initialized, so the shell extension requests use their own instance
+    QString basePath = workPath + QString::fromUtf8("/");
+    megaApi = new mega::MegaApi(Preferences::CLIENT_KEY, basePath.toUtf8().constData(), Preferences::USER_AGENT);
+#endif
+
+    //Shaped like the answers of the webclient and the SDK
+    json = QString::fromUtf8("{\"u\":\"vTi9gJkPcB0\",\"email\":\"benchmark@mega.nz\",\"name\":\"Benchmark\","
+                             "\"since\":1420070400,\"s\":1,\"flags\":{\"ach\":1,\"mfae\":1},\"storage\":53687091200,"
+                             "\"transfer\":1099511627776,\"h\":\"kJ8wRZ5T\",\"k\":\"bG1zhQmCMMlmXGu9jpBv1aQ\"}");
+
+    createTree(workPath + QString::fromUtf8("/flat"), 1, 0, 2000);
+    createTree(workPath + QString::fromUtf8("/deep"), 4, 4, 8);
+}
+
+void ControlBenchmark::cleanupTestCase()
+{
+    delete megaApi;
+    megaApi = NULL;
+    delete settings;
+    settings = NULL;
+    Utilities::removeRecursively(workPath);
+}
+
+void ControlBenchmark::encryptedSettingsValue()
+{
+    QString key = QString::fromUtf8("key25");
+    QBENCHMARK
+    {
+        settings->value(key);
+    }
+}
+
+void ControlBenchmark::encryptedSettingsSetValue()
+{
+    QString key = QString::fromUtf8("key25");
+    QString value = QString::fromUtf8("value25");
+    QBENCHMARK
+    {
+        settings->setValue(key, value);
+    }
+}
+
+void ControlBenchmark::encryptedSettingsHash()
+{
+    QString key = QString::fromUtf8("uploadLimitKB");
+    QBENCHMARK
+    {
+        settings->hashKey(key);
+    }
+}
+
+void ControlBenchmark::preferencesGetters()
+{
+    Preferences *preferences = Preferences::instance();
+    QBENCHMARK
+    {
+        preferences->logged();
+        preferences->email();
+        preferences->uploadLimitKB();
+        preferences->proxyType();
+        preferences->transferDownloadMethod();
+        preferences->getNumSyncedFolders();
+        preferences->overlayIconsDisabled();
+    }
+}
+
+void ControlBenchmark::extractJSONString()
+{
+    QString name = QString::fromUtf8("k");
+    QBENCHMARK
+    {
+        Utilities::extractJSONString(json, name);
+    }
+}
+
+void ControlBenchmark::extractJSONNumber()
+{
+    QString name = QString::fromUtf8("transfer");
+    QBENCHMARK
+    {
+        Utilities::extractJSONNumber(json, name);
+    }
+}
+
+void ControlBenchmark::getSizeString()
+{
+    QBENCHMARK
+    {
+        Utilities::getSizeString(512);
+        Utilities::getSizeString(3145728);
+        Utilities::getSizeString(53687091200ULL);
+    }
+}
+
+void ControlBenchmark::getTimeString()
+{
+    QBENCHMARK
+    {
+        Utilities::getTimeString(45);
+        Utilities::getTimeString(3725);
+        Utilities::getTimeString(180000);
+    }
+}
+
+void ControlBenchmark::httpRequestParsing_data()
+{
+    QTest::addColumn<QString>("data");
+
+    QString headers = QString::fromUtf8("POST / HTTP/1.1\r\n"
+                                        "Host: localhost.megasync.net:6342\r\n"
+                                        "Connection: keep-alive\r\n"
+                                        "Origin: https://mega.nz\r\n"
+                                        "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36\r\n"
+                                        "Content-Type: text/plain;charset=UTF-8\r\n"
+                                        "Accept: */*\r\n"
+                                        "Accept-Encoding: gzip, deflate\r\n"
+                                        "Content-Length: %1\r\n\r\n%2");
+
+    QString version = QString::fromUtf8("{\"a\":\"v\"}");
+    QTest::newRow("version") << headers.arg(version.size()).arg(version);
+
+    QString download = QString::fromUtf8("{\"a\":\"d\",\"h\":\"kJ8wRZ5T\",\"k\":\"bG1zhQmCMMlmXGu9jpBv1aQ\",\"f\":[");
+    for (int i = 0; i < 100; i++)
+    {
+        download.append(QString::fromUtf8("%1{\"h\":\"%2\",\"p\":\"kJ8wRZ5T\",\"n\":\"file%3.jpg\",\"s\":%4}")
+                        .arg(i ? QString::fromUtf8(",") : QString()).arg(10000000 + i).arg(i).arg(1048576 + i));
+    }
+    download.append(QString::fromUtf8("]}"));
+    QTest::newRow("download") << headers.arg(download.size()).arg(download);
+}
+
+void ControlBenchmark::httpRequestParsing()
+{
+    QFETCH(QString, data);
+
+    QString response;
+    QBENCHMARK
+    {
+        HTTPRequest request;
+        request.data = data;
+        HTTPServer::parseRequest(&request, &response);
+    }
+}
+
+void ControlBenchmark::extServerAnswer_data()
+{
+    QTest::addColumn<QByteArray>("request");
+
+    QTest::newRow("string") << QByteArray("T:0:3:2");
+    //Overlay icons are enabled, so the state is queried to the SDK (the path isn't synced)
+    QTest::newRow("state") << (QByteArray("P:") + workPath.toUtf8() + QByteArray("/flat/file0"));
+}
+
+void ControlBenchmark::extServerAnswer()
+{
+#ifdef Q_OS_LINUX
+    QFETCH(QByteArray, request);
+
+    const char *buf = request.constData();
+    QQueue<QString> uploadQueue;
+    QQueue<QString> exportQueue;
+    QBENCHMARK
+    {
+        ExtServer::GetAnswerToRequest(buf, megaApi, &uploadQueue, &exportQueue);
+    }
+#elif QT_VERSION < 0x050000
+    QSKIP("The shell extension server of this platform doesn't use GetAnswerToRequest", SkipAll);
+#else
+    QSKIP("The shell extension server of this platform doesn't use GetAnswerToRequest");
+#endif
+}
+
+void ControlBenchmark::countFilesAndFolders_data()
+{
+    QTest::addColumn<QString>("path");
+
+    QTest::newRow("flat") << workPath + QString::fromUtf8("/flat");
+    QTest::newRow("deep") << workPath + QString::fromUtf8("/deep");
+}
+
+void ControlBenchmark::countFilesAndFolders()
+{
+    QFETCH(QString, path);
+
+    QBENCHMARK
+    {
+        long numFiles = 0;
+        long numFolders = 0;
+        Utilities::countFilesAndFolders(path, &numFiles, &numFolders, 100000, 100000);
+    }
+}
+
+void ControlBenchmark::getFolderSize_data()
+{
+    countFilesAndFolders_data();
+}
+
+void ControlBenchmark::getFolderSize()
+{
+    QFETCH(QString, path);
+
+    QBENCHMARK
+    {
+        long long size = 0;
+        Utilities::getFolderSize(path, &size);
+    }
+}
+
+void ControlBenchmark::linkExtractor_data()
+{
+    QTest::addColumn<int>("function");
+    QTest::addColumn<QByteArray>("text");
+
+    //64 KB of text, without links and with a link in every line
+    QByteArray line("Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod tempor incididunt ut labore ");
+    QByteArray plain;
+    QByteArray links;
+    for (int i = 0; plain.size() < 65536; i++)
+    {
+        plain.append(line);
+        plain.append('\n');
+        links.append(line);
+        links.append(QString::fromUtf8("https://mega.nz/#!%1!bG1zhQmCMMlmXGu9jpBv1aQkJ8wRZ5TvTi9gJkPcB0x\n")
+                     .arg(10000000 + i).toUtf8());
+    }
+
+    QTest::newRow("extractLinks plain") << 0 << plain;
+    QTest::newRow("extractLinks links") << 0 << links;
+    QTest::newRow("extractLinksFromUtf8 plain") << 1 << plain;
+    QTest::newRow("extractLinksFromUtf8 links") << 1 << links;
+    QTest::newRow("containsLinks plain") << 2 << plain;
+}
+
+void ControlBenchmark::linkExtractor()
+{
+    QFETCH(int, function);
+    QFETCH(QByteArray, text);
+
+    QString string = QString::fromUtf8(text.constData(), text.size());
+    QBENCHMARK
+    {
+        switch (function)
+        {
+        case 0:
+            LinkExtractor::extractLinks(string);
+            break;
+        case 1:
+            LinkExtractor::extractLinksFromUtf8(text);
+            break;
+        default:
+            LinkExtractor::containsLinks(text);
+            break;
+        }
+    }
+}
+
+void ControlBenchmark::createTree(QString path, int depth, int folders, int files)
+{
+    QDir().mkpath(path);
+    for (int i = 0; i < files; i++)
+    {
+        QFile file(path + QString::fromUtf8("/file%1").arg(i));
+        if (file.open(QIODevice::WriteOnly))
+        {
+            file.write(QByteArray(64 + i, 'x'));
+        }
+    }
+
+    if (depth > 1)
+    {
+        for (int i = 0; i < folders; i++)
+        {
+            createTree(path + QString::fromUtf8("/folder%1").arg(i), depth - 1, folders, files);
+        }
+    }
+}
+
+static QString jsonString(QString value)
+{
+    value.replace(QString::fromUtf8("\\"), QString::fromUtf8("\\\\"));
+    value.replace(QString::fromUtf8("\""), QString::fromUtf8("\\\""));
+    return QString::fromUtf8("\"%1\"").arg(value);
+}
+
+//Converts the XML report of QTestLib into JSON, with an entry per benchmark and data row.
+//Values are per iteration, in the unit of the metric (walltime is in milliseconds)
+static bool writeJsonReport(QString xmlPath, QString jsonPath)
+{
+    QFile xmlFile(xmlPath);
+    if (!xmlFile.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+
+    QStringList results;
+    QString function;
+    QXmlStreamReader xml(&xmlFile);
+    while (!xml.atEnd())
+    {
+        if (xml.readNext() != QXmlStreamReader::StartElement)
+        {
+            continue;
+        }
+
+        QXmlStreamAttributes attributes = xml.attributes();
+        if (xml.name() == QString::fromUtf8("TestFunction"))
+        {
+            function = attributes.value(QString::fromUtf8("name")).toString();
+        }
+        else if (xml.name() == QString::fromUtf8("BenchmarkResult"))
+        {
+            results.append(QString::fromUtf8("    {\"name\": %1, \"tag\": %2, \"metric\": %3, \"value\": %4, \"iterations\": %5}")
+                           .arg(jsonString(function))
+                           .arg(jsonString(attributes.value(QString::fromUtf8("tag")).toString()))
+                           .arg(jsonString(attributes.value(QString::fromUtf8("metric")).toString()))
+                           .arg(attributes.value(QString::fromUtf8("value")).toString().toDouble())
+                           .arg(attributes.value(QString::fromUtf8("iterations")).toString().toInt()));
+        }
+    }
+
+    if (xml.hasError())
+    {
+        return false;
+    }
+
+    QString report = QString::fromUtf8("{\n  \"version\": %1,\n  \"qt\": %2,\n  \"timestamp\": %3,\n  \"results\": [\n%4\n  ]\n}\n")
+            .arg(jsonString(Preferences::VERSION_STRING))
+            .arg(jsonString(QString::fromUtf8(qVersion())))
+            .arg(jsonString(QDateTime::currentDateTime().toUTC().toString(Qt::ISODate)))
+            .arg(results.join(QString::fromUtf8(",\n")));
+
+    if (jsonPath.isEmpty())
+    {
+        QTextStream(stdout) << report;
+        return true;
+    }
+
+    QFile jsonFile(jsonPath);
+    if (!jsonFile.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+    {
+        return false;
+    }
+    jsonFile.write(report.toUtf8());
+    return true;
+}
+
+//Usage: MEGAbenchmark [-json <file>] [QTestLib options] [benchmarks]
+//The JSON report goes to stdout when no file is given
+int main(int argc, char *argv[])
+{
+    MegaApplication app(argc, argv);
+
+    QString jsonPath;
+    QStringList arguments;
+    QStringList appArguments = app.arguments();
+    for (int i = 0; i < appArguments.size(); i++)
+    {
+        if (appArguments[i] == QString::fromUtf8("-json") && (i + 1) < appArguments.size())
+        {
+            jsonPath = QFileInfo(appArguments[++i]).absoluteFilePath();
+            continue;
+        }
+        arguments.append(appArguments[i]);
+    }
+
+    QTemporaryFile xmlFile(QDir::tempPath() + QString::fromUtf8("/MEGAbenchmark-XXXXXX.xml"));
+    if (!xmlFile.open())
+    {
+        return 1;
+    }
+    xmlFile.close();
+    arguments << QString::fromUtf8("-xml") << QString::fromUtf8("-o") << xmlFile.fileName();
+
+    ControlBenchmark benchmark;
+    int result = QTest::qExec(&benchmark, arguments);
+    if (!writeJsonReport(xmlFile.fileName(), jsonPath))
+    {
+        QTextStream(stderr) << "Unable to write the benchmark report" << endl;
+        return result ? result : 1;
+    }
+    return result;
+}
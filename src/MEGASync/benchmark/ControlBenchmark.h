@@ -0,0 +1,57 @@
+#ifndef CONTROLBENCHMARK_H
+#define CONTROLBENCHMARK_H
+
+#include <QObject>
+#include <QString>
+#include <QByteArray>
+#include "megaapi.h"
+
+class BenchmarkSettings;
+
+// QTestLib benchmarks of the control layer. They run inside a MegaApplication
+// that uses its own data folder ("MEGAsync benchmark"), so the settings of
+// the real account are never read or modified.
+class ControlBenchmark : public QObject
+{
+    Q_OBJECT
+
+public:
+    ControlBenchmark();
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void encryptedSettingsValue();
+    void encryptedSettingsSetValue();
+    void encryptedSettingsHash();
+    void preferencesGetters();
+
+    void extractJSONString();
+    void extractJSONNumber();
+    void getSizeString();
+    void getTimeString();
+
+    void httpRequestParsing_data();
+    void httpRequestParsing();
+    void extServerAnswer_data();
+    void extServerAnswer();
+
+    void countFilesAndFolders_data();
+    void countFilesAndFolders();
+    void getFolderSize_data();
+    void getFolderSize();
+
+    void linkExtractor_data();
+    void linkExtractor();
+
+private:
+    void createTree(QString path, int depth, int folders, int files);
+
+    QString workPath;
+    QString json;
+    BenchmarkSettings *settings;
+    mega::MegaApi *megaApi;
+};
+
+#endif // CONTROLBENCHMARK_H
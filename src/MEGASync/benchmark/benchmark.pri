@@ -0,0 +1,11 @@
+#Control layer benchmarks, built instead of the application with "qmake CONFIG+=benchmark".
+#Run "MEGAbenchmark -json results.json" to save the results
+
+QT += testlib
+CONFIG += console
+CONFIG -= app_bundle
+DEFINES += MEGASYNC_BENCHMARK
+TARGET = MEGAbenchmark
+
+SOURCES += $$PWD/ControlBenchmark.cpp
+HEADERS += $$PWD/ControlBenchmark.h
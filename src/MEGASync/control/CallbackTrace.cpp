@@ -0,0 +1,748 @@
+#include "CallbackTrace.h"
+#include "MegaApplication.h"
+
+#include <QCoreApplication>
+#include <QTimer>
+#include <QTextStream>
+#include <new>
+#include <stdlib.h>
+
+#ifdef WIN32
+#include <windows.h>
+#elif defined(__APPLE__)
+#include <mach/mach.h>
+#else
+#include <time.h>
+#endif
+
+using namespace mega;
+
+static const char *TYPE_NAMES[] = {"", "onTransferStart", "onTransferUpdate", "onTransferFinish",
+                                   "onTransferTemporaryError", "onNodesUpdate", "onGlobalSyncStateChanged",
+                                   "onSyncFileStateChanged", "onAccountUpdate"};
+
+const char *CallbackTrace::typeName(int type)
+{
+    if (type <= 0 || type >= NUM_TYPES)
+    {
+        return "unknown";
+    }
+    return TYPE_NAMES[type];
+}
+
+CallbackRecorder::CallbackRecorder(QString tracePath)
+    : file(tracePath)
+{
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        MegaApi::log(MegaApi::LOG_LEVEL_ERROR, QString::fromUtf8("Unable to create the callback trace %1")
+                     .arg(tracePath).toUtf8().constData());
+        return;
+    }
+
+    stream.setDevice(&file);
+    stream.setVersion(QDataStream::Qt_4_8);
+    stream << (quint32)CallbackTrace::TRACE_MAGIC << (quint16)CallbackTrace::TRACE_VERSION;
+    clock.start();
+    MegaApi::log(MegaApi::LOG_LEVEL_INFO, QString::fromUtf8("Recording callbacks to %1")
+                 .arg(tracePath).toUtf8().constData());
+}
+
+CallbackRecorder::~CallbackRecorder()
+{
+    mutex.lock();
+    file.close();
+    mutex.unlock();
+}
+
+bool CallbackRecorder::isOpen()
+{
+    return file.isOpen();
+}
+
+void CallbackRecorder::writeHeader(int type)
+{
+    stream << (quint8)type << (qint64)(clock.nsecsElapsed() / 1000);
+}
+
+void CallbackRecorder::writeTransfer(MegaTransfer *transfer)
+{
+    quint8 flags = (transfer->isSyncTransfer() ? 1 : 0) | (transfer->isStreamingTransfer() ? 2 : 0);
+    stream << (qint32)transfer->getTag()
+           << (qint8)transfer->getType()
+           << QByteArray(transfer->getFileName())
+           << QByteArray(transfer->getPath())
+           << (qint64)transfer->getStartTime()
+           << (qint64)transfer->getTransferredBytes()
+           << (qint64)transfer->getTotalBytes()
+           << (qint64)transfer->getSpeed()
+           << (qint64)transfer->getDeltaSize()
+           << (quint64)transfer->getNodeHandle()
+           << (quint64)transfer->getParentHandle()
+           << flags;
+}
+
+void CallbackRecorder::onTransferStart(MegaApi *, MegaTransfer *transfer)
+{
+    QMutexLocker locker(&mutex);
+    writeHeader(CallbackTrace::TRANSFER_START);
+    writeTransfer(transfer);
+}
+
+void CallbackRecorder::onTransferUpdate(MegaApi *, MegaTransfer *transfer)
+{
+    QMutexLocker locker(&mutex);
+    writeHeader(CallbackTrace::TRANSFER_UPDATE);
+    writeTransfer(transfer);
+}
+
+void CallbackRecorder::onTransferFinish(MegaApi *, MegaTransfer *transfer, MegaError *e)
+{
+    QMutexLocker locker(&mutex);
+    writeHeader(CallbackTrace::TRANSFER_FINISH);
+    writeTransfer(transfer);
+    stream << (qint32)e->getErrorCode();
+}
+
+void CallbackRecorder::onTransferTemporaryError(MegaApi *, MegaTransfer *transfer, MegaError *e)
+{
+    QMutexLocker locker(&mutex);
+    writeHeader(CallbackTrace::TRANSFER_TEMPORARY_ERROR);
+    writeTransfer(transfer);
+    stream << (qint32)e->getErrorCode();
+}
+
+void CallbackRecorder::onNodesUpdate(MegaApi *, MegaNodeList *nodes)
+{
+    QMutexLocker locker(&mutex);
+    writeHeader(CallbackTrace::NODES_UPDATE);
+
+    //-1 means that the whole tree was reloaded
+    if (!nodes)
+    {
+        stream << (qint32)-1;
+        return;
+    }
+
+    stream << (qint32)nodes->size();
+    for (int i = 0; i < nodes->size(); i++)
+    {
+        MegaNode *node = nodes->get(i);
+        std::string *attrString = node->getAttrString();
+        std::string localPath = node->getLocalPath();
+        quint8 flags = (node->isRemoved() ? 1 : 0) | (node->isSyncDeleted() ? 2 : 0);
+        stream << (quint64)node->getHandle()
+               << (quint64)node->getParentHandle()
+               << (qint8)node->getType()
+               << QByteArray(node->getName())
+               << (qint64)node->getSize()
+               << (qint64)node->getCreationTime()
+               << (qint64)node->getModificationTime()
+               << (qint32)node->getTag()
+               << (qint32)node->getChanges()
+               << flags
+               << QByteArray(localPath.data(), localPath.size())
+               << (attrString ? QByteArray(attrString->data(), attrString->size()) : QByteArray());
+    }
+}
+
+void CallbackRecorder::onGlobalSyncStateChanged(MegaApi *)
+{
+    QMutexLocker locker(&mutex);
+    writeHeader(CallbackTrace::GLOBAL_SYNC_STATE_CHANGED);
+}
+
+void CallbackRecorder::onSyncFileStateChanged(MegaApi *, MegaSync *, const char *filePath, int newState)
+{
+    QMutexLocker locker(&mutex);
+    writeHeader(CallbackTrace::SYNC_FILE_STATE_CHANGED);
+    stream << QByteArray(filePath) << (qint32)newState;
+}
+
+void CallbackRecorder::onAccountUpdate(MegaApi *)
+{
+    QMutexLocker locker(&mutex);
+    writeHeader(CallbackTrace::ACCOUNT_UPDATE);
+}
+
+TraceTransfer::TraceTransfer()
+{
+    type = MegaTransfer::TYPE_DOWNLOAD;
+    tag = 0;
+    startTime = 0;
+    transferredBytes = 0;
+    totalBytes = 0;
+    speed = 0;
+    deltaSize = 0;
+    nodeHandle = INVALID_HANDLE;
+    parentHandle = INVALID_HANDLE;
+    syncTransfer = false;
+    streamingTransfer = false;
+}
+
+MegaTransfer *TraceTransfer::copy()
+{
+    TraceTransfer *transfer = new TraceTransfer();
+    transfer->type = type;
+    transfer->tag = tag;
+    transfer->fileName = fileName;
+    transfer->path = path;
+    transfer->startTime = startTime;
+    transfer->transferredBytes = transferredBytes;
+    transfer->totalBytes = totalBytes;
+    transfer->speed = speed;
+    transfer->deltaSize = deltaSize;
+    transfer->nodeHandle = nodeHandle;
+    transfer->parentHandle = parentHandle;
+    transfer->syncTransfer = syncTransfer;
+    transfer->streamingTransfer = streamingTransfer;
+    return transfer;
+}
+
+int TraceTransfer::getType()
+{
+    return type;
+}
+
+int TraceTransfer::getTag()
+{
+    return tag;
+}
+
+const char *TraceTransfer::getFileName()
+{
+    return fileName.constData();
+}
+
+const char *TraceTransfer::getPath()
+{
+    return path.constData();
+}
+
+int64_t TraceTransfer::getStartTime()
+{
+    return startTime;
+}
+
+long long TraceTransfer::getTransferredBytes()
+{
+    return transferredBytes;
+}
+
+long long TraceTransfer::getTotalBytes()
+{
+    return totalBytes;
+}
+
+long long TraceTransfer::getSpeed()
+{
+    return speed;
+}
+
+long long TraceTransfer::getDeltaSize()
+{
+    return deltaSize;
+}
+
+MegaHandle TraceTransfer::getNodeHandle()
+{
+    return nodeHandle;
+}
+
+MegaHandle TraceTransfer::getParentHandle()
+{
+    return parentHandle;
+}
+
+MegaNode *TraceTransfer::getPublicMegaNode()
+{
+    return NULL;
+}
+
+bool TraceTransfer::isSyncTransfer()
+{
+    return syncTransfer;
+}
+
+bool TraceTransfer::isStreamingTransfer()
+{
+    return streamingTransfer;
+}
+
+TraceNode::TraceNode()
+{
+    type = MegaNode::TYPE_FILE;
+    handle = INVALID_HANDLE;
+    parentHandle = INVALID_HANDLE;
+    size = 0;
+    creationTime = 0;
+    modificationTime = 0;
+    tag = 0;
+    changes = 0;
+    removed = false;
+    syncDeleted = false;
+}
+
+MegaNode *TraceNode::copy()
+{
+    TraceNode *node = new TraceNode();
+    node->type = type;
+    node->name = name;
+    node->handle = handle;
+    node->parentHandle = parentHandle;
+    node->size = size;
+    node->creationTime = creationTime;
+    node->modificationTime = modificationTime;
+    node->tag = tag;
+    node->changes = changes;
+    node->removed = removed;
+    node->syncDeleted = syncDeleted;
+    node->localPath = localPath;
+    node->attrString = attrString;
+    return node;
+}
+
+int TraceNode::getType()
+{
+    return type;
+}
+
+const char *TraceNode::getName()
+{
+    return name.constData();
+}
+
+MegaHandle TraceNode::getHandle()
+{
+    return handle;
+}
+
+MegaHandle TraceNode::getParentHandle()
+{
+    return parentHandle;
+}
+
+int64_t TraceNode::getSize()
+{
+    return size;
+}
+
+int64_t TraceNode::getCreationTime()
+{
+    return creationTime;
+}
+
+int64_t TraceNode::getModificationTime()
+{
+    return modificationTime;
+}
+
+int TraceNode::getTag()
+{
+    return tag;
+}
+
+int TraceNode::getChanges()
+{
+    return changes;
+}
+
+bool TraceNode::hasChanged(int changeType)
+{
+    return (changes & changeType) != 0;
+}
+
+bool TraceNode::isFile()
+{
+    return type == MegaNode::TYPE_FILE;
+}
+
+bool TraceNode::isFolder()
+{
+    return type != MegaNode::TYPE_FILE && type != MegaNode::TYPE_UNKNOWN;
+}
+
+bool TraceNode::isRemoved()
+{
+    return removed;
+}
+
+bool TraceNode::isSyncDeleted()
+{
+    return syncDeleted;
+}
+
+std::string TraceNode::getLocalPath()
+{
+    return localPath;
+}
+
+std::string *TraceNode::getAttrString()
+{
+    return &attrString;
+}
+
+TraceNodeList::~TraceNodeList()
+{
+    qDeleteAll(nodes);
+}
+
+MegaNodeList *TraceNodeList::copy()
+{
+    TraceNodeList *list = new TraceNodeList();
+    for (int i = 0; i < nodes.size(); i++)
+    {
+        list->nodes.append((TraceNode *)nodes[i]->copy());
+    }
+    return list;
+}
+
+MegaNode *TraceNodeList::get(int i)
+{
+    return (i >= 0 && i < nodes.size()) ? nodes[i] : NULL;
+}
+
+int TraceNodeList::size()
+{
+    return nodes.size();
+}
+
+#ifdef CALLBACK_REPLAY
+
+//Allocations are counted by replacing the global operator new,
+//so only C++ allocations are included (not those done with malloc)
+static QAtomicInt numAllocations;
+
+#if __cplusplus >= 201103L
+void *operator new(std::size_t size)
+#else
+void *operator new(std::size_t size) throw(std::bad_alloc)
+#endif
+{
+    numAllocations.ref();
+    void *p = malloc(size ? size : 1);
+    if (!p)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+#if __cplusplus >= 201103L
+void *operator new[](std::size_t size)
+#else
+void *operator new[](std::size_t size) throw(std::bad_alloc)
+#endif
+{
+    numAllocations.ref();
+    void *p = malloc(size ? size : 1);
+    if (!p)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void *p) throw()
+{
+    free(p);
+}
+
+void operator delete[](void *p) throw()
+{
+    free(p);
+}
+
+static long long threadCpuTimeNs()
+{
+#ifdef WIN32
+    FILETIME creationTime, exitTime, kernelTime, userTime;
+    if (!GetThreadTimes(GetCurrentThread(), &creationTime, &exitTime, &kernelTime, &userTime))
+    {
+        return 0;
+    }
+
+    ULARGE_INTEGER kernel, user;
+    kernel.LowPart = kernelTime.dwLowDateTime;
+    kernel.HighPart = kernelTime.dwHighDateTime;
+    user.LowPart = userTime.dwLowDateTime;
+    user.HighPart = userTime.dwHighDateTime;
+    return (kernel.QuadPart + user.QuadPart) * 100;
+#elif defined(__APPLE__)
+    mach_port_t thread = mach_thread_self();
+    thread_basic_info_data_t info;
+    mach_msg_type_number_t count = THREAD_BASIC_INFO_COUNT;
+    kern_return_t result = thread_info(thread, THREAD_BASIC_INFO, (thread_info_t)&info, &count);
+    mach_port_deallocate(mach_task_self(), thread);
+    if (result != KERN_SUCCESS)
+    {
+        return 0;
+    }
+    return (info.user_time.seconds + info.system_time.seconds) * 1000000000LL
+            + (info.user_time.microseconds + info.system_time.microseconds) * 1000LL;
+#else
+    struct timespec ts;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts))
+    {
+        return 0;
+    }
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+#endif
+}
+
+CallbackReplayer::CallbackReplayer(MegaApplication *app, QString tracePath, bool realTime)
+    : QObject(), file(tracePath), stats(CallbackTrace::NUM_TYPES)
+{
+    this->app = app;
+    this->realTime = realTime;
+    numRecords = 0;
+    pendingType = 0;
+    pendingTime = 0;
+    hasPending = false;
+}
+
+void CallbackReplayer::start()
+{
+    quint32 magic = 0;
+    quint16 version = 0;
+    if (file.open(QIODevice::ReadOnly))
+    {
+        stream.setDevice(&file);
+        stream.setVersion(QDataStream::Qt_4_8);
+        stream >> magic >> version;
+    }
+
+    if (magic != CallbackTrace::TRACE_MAGIC || version != CallbackTrace::TRACE_VERSION)
+    {
+        MegaApi::log(MegaApi::LOG_LEVEL_ERROR, QString::fromUtf8("Invalid callback trace: %1")
+                     .arg(file.fileName()).toUtf8().constData());
+        emit finished();
+        return;
+    }
+
+    MegaApi::log(MegaApi::LOG_LEVEL_INFO, QString::fromUtf8("Replaying callbacks from %1 (%2)")
+                 .arg(file.fileName()).arg(realTime ? QString::fromUtf8("real time") : QString::fromUtf8("full speed"))
+                 .toUtf8().constData());
+    clock.start();
+    replayNext();
+}
+
+void CallbackReplayer::replayNext()
+{
+    while (true)
+    {
+        if (!hasPending)
+        {
+            if (stream.atEnd())
+            {
+                report();
+                emit finished();
+                return;
+            }
+
+            quint8 type;
+            qint64 timestamp;
+            stream >> type >> timestamp;
+            pendingType = type;
+            pendingTime = timestamp;
+            hasPending = true;
+        }
+
+        if (realTime)
+        {
+            qint64 now = clock.nsecsElapsed() / 1000;
+            if (pendingTime > now)
+            {
+                QTimer::singleShot((pendingTime - now + 999) / 1000, this, SLOT(replayNext()));
+                return;
+            }
+        }
+
+        hasPending = false;
+        if (!replayRecord(pendingType))
+        {
+            MegaApi::log(MegaApi::LOG_LEVEL_ERROR, QString::fromUtf8("Corrupt callback trace after %1 records")
+                         .arg(numRecords).toUtf8().constData());
+            report();
+            emit finished();
+            return;
+        }
+        numRecords++;
+    }
+}
+
+void CallbackReplayer::readTransfer(TraceTransfer *transfer)
+{
+    qint32 tag;
+    qint8 type;
+    qint64 startTime, transferredBytes, totalBytes, speed, deltaSize;
+    quint64 nodeHandle, parentHandle;
+    quint8 flags;
+    stream >> tag >> type >> transfer->fileName >> transfer->path
+           >> startTime >> transferredBytes >> totalBytes >> speed >> deltaSize
+           >> nodeHandle >> parentHandle >> flags;
+
+    transfer->tag = tag;
+    transfer->type = type;
+    transfer->startTime = startTime;
+    transfer->transferredBytes = transferredBytes;
+    transfer->totalBytes = totalBytes;
+    transfer->speed = speed;
+    transfer->deltaSize = deltaSize;
+    transfer->nodeHandle = nodeHandle;
+    transfer->parentHandle = parentHandle;
+    transfer->syncTransfer = flags & 1;
+    transfer->streamingTransfer = flags & 2;
+}
+
+//Payloads are read before the measurement starts
+bool CallbackReplayer::replayRecord(int type)
+{
+    if (type <= 0 || type >= CallbackTrace::NUM_TYPES)
+    {
+        return false;
+    }
+
+    MegaApi *megaApi = app->getMegaApi();
+    TraceTransfer transfer;
+    TraceNodeList *nodes = NULL;
+    QByteArray filePath;
+    qint32 errorCode = MegaError::API_OK;
+    qint32 state = 0;
+
+    switch (type)
+    {
+    case CallbackTrace::TRANSFER_START:
+    case CallbackTrace::TRANSFER_UPDATE:
+        readTransfer(&transfer);
+        break;
+    case CallbackTrace::TRANSFER_FINISH:
+    case CallbackTrace::TRANSFER_TEMPORARY_ERROR:
+        readTransfer(&transfer);
+        stream >> errorCode;
+        break;
+    case CallbackTrace::NODES_UPDATE:
+    {
+        qint32 numNodes;
+        stream >> numNodes;
+        if (numNodes < 0)
+        {
+            break;
+        }
+
+        nodes = new TraceNodeList();
+        for (int i = 0; i < numNodes && stream.status() == QDataStream::Ok; i++)
+        {
+            TraceNode *node = new TraceNode();
+            quint64 handle, parentHandle;
+            qint8 nodeType;
+            qint64 size, creationTime, modificationTime;
+            qint32 tag, changes;
+            quint8 flags;
+            QByteArray localPath, attrString;
+            stream >> handle >> parentHandle >> nodeType >> node->name >> size >> creationTime
+                   >> modificationTime >> tag >> changes >> flags >> localPath >> attrString;
+
+            node->handle = handle;
+            node->parentHandle = parentHandle;
+            node->type = nodeType;
+            node->size = size;
+            node->creationTime = creationTime;
+            node->modificationTime = modificationTime;
+            node->tag = tag;
+            node->changes = changes;
+            node->removed = flags & 1;
+            node->syncDeleted = flags & 2;
+            node->localPath = std::string(localPath.constData(), localPath.size());
+            node->attrString = std::string(attrString.constData(), attrString.size());
+            nodes->nodes.append(node);
+        }
+        break;
+    }
+    case CallbackTrace::SYNC_FILE_STATE_CHANGED:
+        stream >> filePath >> state;
+        break;
+    default:
+        break;
+    }
+
+    if (stream.status() != QDataStream::Ok)
+    {
+        delete nodes;
+        return false;
+    }
+
+    MegaError error(errorCode);
+    int allocationsBefore = numAllocations.fetchAndAddRelaxed(0);
+    long long cpuBefore = threadCpuTimeNs();
+    QElapsedTimer timer;
+    timer.start();
+
+    switch (type)
+    {
+    case CallbackTrace::TRANSFER_START:
+        app->onTransferStart(megaApi, &transfer);
+        break;
+    case CallbackTrace::TRANSFER_UPDATE:
+        app->onTransferUpdate(megaApi, &transfer);
+        break;
+    case CallbackTrace::TRANSFER_FINISH:
+        app->onTransferFinish(megaApi, &transfer, &error);
+        break;
+    case CallbackTrace::TRANSFER_TEMPORARY_ERROR:
+        app->onTransferTemporaryError(megaApi, &transfer, &error);
+        break;
+    case CallbackTrace::NODES_UPDATE:
+        app->onNodesUpdate(megaApi, nodes);
+        break;
+    case CallbackTrace::GLOBAL_SYNC_STATE_CHANGED:
+        app->onGlobalSyncStateChanged(megaApi);
+        break;
+    case CallbackTrace::SYNC_FILE_STATE_CHANGED:
+        app->onSyncFileStateChanged(megaApi, NULL, filePath.constData(), state);
+        break;
+    case CallbackTrace::ACCOUNT_UPDATE:
+        app->onAccountUpdate(megaApi);
+        break;
+    }
+
+    long long wallNs = timer.nsecsElapsed();
+
+    //Work posted by the callback keeps the GUI thread busy too
+    QCoreApplication::processEvents();
+
+    CallbackStats &callbackStats = stats[type];
+    callbackStats.count++;
+    callbackStats.wallNs += wallNs;
+    callbackStats.busyNs += timer.nsecsElapsed();
+    callbackStats.cpuNs += threadCpuTimeNs() - cpuBefore;
+    callbackStats.allocations += numAllocations.fetchAndAddRelaxed(0) - allocationsBefore;
+    delete nodes;
+    return true;
+}
+
+void CallbackReplayer::report()
+{
+    QString result = QString::fromUtf8("Replayed %1 callbacks in %2 ms\n").arg(numRecords).arg(clock.elapsed());
+    result += QString::fromUtf8("%1%2%3%4%5%6%7\n").arg(QString::fromUtf8("Callback"), -28)
+            .arg(QString::fromUtf8("Count"), 10).arg(QString::fromUtf8("Wall ms"), 10)
+            .arg(QString::fromUtf8("Busy ms"), 10).arg(QString::fromUtf8("CPU ms"), 10)
+            .arg(QString::fromUtf8("Allocs"), 10).arg(QString::fromUtf8("Busy us/cb"), 12);
+    for (int i = 1; i < CallbackTrace::NUM_TYPES; i++)
+    {
+        const CallbackStats &s = stats[i];
+        if (!s.count)
+        {
+            continue;
+        }
+
+        result += QString::fromUtf8("%1%2%3%4%5%6%7\n").arg(QString::fromUtf8(CallbackTrace::typeName(i)), -28)
+                .arg(s.count, 10).arg(s.wallNs / 1000000, 10).arg(s.busyNs / 1000000, 10)
+                .arg(s.cpuNs / 1000000, 10).arg(s.allocations, 10).arg(s.busyNs / s.count / 1000, 12);
+    }
+
+    MegaApi::log(MegaApi::LOG_LEVEL_INFO, result.toUtf8().constData());
+    QTextStream(stdout) << result;
+}
+
+#endif
@@ -0,0 +1,207 @@
+#ifndef CALLBACKTRACE_H
+#define CALLBACKTRACE_H
+
+#include <QObject>
+#include <QFile>
+#include <QDataStream>
+#include <QMutex>
+#include <QElapsedTimer>
+#include <QVector>
+#include <string>
+#include "megaapi.h"
+
+class MegaApplication;
+
+// Binary trace of the callbacks received from the SDK. Each record is
+// a type, the time since the start of the trace (in microseconds)
+// and the fields of the payload that MegaApplication reads.
+namespace CallbackTrace
+{
+    enum {
+        TRACE_MAGIC = 0x4D435442,
+        TRACE_VERSION = 1
+    };
+
+    enum {
+        TRANSFER_START = 1,
+        TRANSFER_UPDATE,
+        TRANSFER_FINISH,
+        TRANSFER_TEMPORARY_ERROR,
+        NODES_UPDATE,
+        GLOBAL_SYNC_STATE_CHANGED,
+        SYNC_FILE_STATE_CHANGED,
+        ACCOUNT_UPDATE,
+        NUM_TYPES
+    };
+
+    const char *typeName(int type);
+}
+
+// Writes the callbacks of a MegaApi to a trace file. It's registered
+// directly on the MegaApi, so records are written from the SDK thread
+class CallbackRecorder : public mega::MegaListener
+{
+public:
+    CallbackRecorder(QString tracePath);
+    ~CallbackRecorder();
+
+    bool isOpen();
+
+    virtual void onTransferStart(mega::MegaApi *api, mega::MegaTransfer *transfer);
+    virtual void onTransferUpdate(mega::MegaApi *api, mega::MegaTransfer *transfer);
+    virtual void onTransferFinish(mega::MegaApi *api, mega::MegaTransfer *transfer, mega::MegaError *e);
+    virtual void onTransferTemporaryError(mega::MegaApi *api, mega::MegaTransfer *transfer, mega::MegaError *e);
+    virtual void onNodesUpdate(mega::MegaApi *api, mega::MegaNodeList *nodes);
+    virtual void onGlobalSyncStateChanged(mega::MegaApi *api);
+    virtual void onSyncFileStateChanged(mega::MegaApi *api, mega::MegaSync *sync, const char *filePath, int newState);
+    virtual void onAccountUpdate(mega::MegaApi *api);
+
+private:
+    void writeHeader(int type);
+    void writeTransfer(mega::MegaTransfer *transfer);
+
+    QMutex mutex;
+    QFile file;
+    QDataStream stream;
+    QElapsedTimer clock;
+};
+
+// Transfer rebuilt from a trace
+class TraceTransfer : public mega::MegaTransfer
+{
+public:
+    TraceTransfer();
+
+    virtual mega::MegaTransfer *copy();
+    virtual int getType();
+    virtual int getTag();
+    virtual const char *getFileName();
+    virtual const char *getPath();
+    virtual int64_t getStartTime();
+    virtual long long getTransferredBytes();
+    virtual long long getTotalBytes();
+    virtual long long getSpeed();
+    virtual long long getDeltaSize();
+    virtual mega::MegaHandle getNodeHandle();
+    virtual mega::MegaHandle getParentHandle();
+    virtual mega::MegaNode *getPublicMegaNode();
+    virtual bool isSyncTransfer();
+    virtual bool isStreamingTransfer();
+
+    int type;
+    int tag;
+    QByteArray fileName;
+    QByteArray path;
+    long long startTime;
+    long long transferredBytes;
+    long long totalBytes;
+    long long speed;
+    long long deltaSize;
+    mega::MegaHandle nodeHandle;
+    mega::MegaHandle parentHandle;
+    bool syncTransfer;
+    bool streamingTransfer;
+};
+
+// Node rebuilt from a trace
+class TraceNode : public mega::MegaNode
+{
+public:
+    TraceNode();
+
+    virtual mega::MegaNode *copy();
+    virtual int getType();
+    virtual const char *getName();
+    virtual mega::MegaHandle getHandle();
+    virtual mega::MegaHandle getParentHandle();
+    virtual int64_t getSize();
+    virtual int64_t getCreationTime();
+    virtual int64_t getModificationTime();
+    virtual int getTag();
+    virtual int getChanges();
+    virtual bool hasChanged(int changeType);
+    virtual bool isFile();
+    virtual bool isFolder();
+    virtual bool isRemoved();
+    virtual bool isSyncDeleted();
+    virtual std::string getLocalPath();
+    virtual std::string *getAttrString();
+
+    int type;
+    QByteArray name;
+    mega::MegaHandle handle;
+    mega::MegaHandle parentHandle;
+    long long size;
+    long long creationTime;
+    long long modificationTime;
+    int tag;
+    int changes;
+    bool removed;
+    bool syncDeleted;
+    std::string localPath;
+    std::string attrString;
+};
+
+class TraceNodeList : public mega::MegaNodeList
+{
+public:
+    ~TraceNodeList();
+
+    virtual mega::MegaNodeList *copy();
+    virtual mega::MegaNode *get(int i);
+    virtual int size();
+
+    QVector<TraceNode *> nodes;
+};
+
+#ifdef CALLBACK_REPLAY
+// Feeds a trace to the listener code of MegaApplication and reports, per
+// callback type, the CPU time and the time the GUI thread was busy (the
+// callback plus the events it posted) and the C++ allocations done.
+// The application runs with a fake account in its own data folder, so the
+// listener code runs as when logged in, but its MegaApi answers like a stub.
+class CallbackReplayer : public QObject
+{
+    Q_OBJECT
+
+public:
+    CallbackReplayer(MegaApplication *app, QString tracePath, bool realTime);
+
+signals:
+    void finished();
+
+public slots:
+    void start();
+
+private slots:
+    void replayNext();
+
+private:
+    struct CallbackStats
+    {
+        CallbackStats() : count(0), wallNs(0), busyNs(0), cpuNs(0), allocations(0) {}
+        long long count;
+        long long wallNs;
+        long long busyNs;
+        long long cpuNs;
+        long long allocations;
+    };
+
+    bool replayRecord(int type);
+    void readTransfer(TraceTransfer *transfer);
+    void report();
+
+    MegaApplication *app;
+    bool realTime;
+    QFile file;
+    QDataStream stream;
+    QElapsedTimer clock;
+    QVector<CallbackStats> stats;
+    int numRecords;
+    int pendingType;
+    qint64 pendingTime;
+    bool hasPending;
+};
+#endif
+
+#endif // CALLBACKTRACE_H
@@ -17,14 +17,24 @@ using namespace std;
 #include "client/windows/handler/exception_handler.h"
 #endif
 
+//Summary of the stalls of the GUI thread, added to crash reports
+static char stall_summary[256] = "";
+//Context of the dumps written by writeMinidump(), to tell them from crashes
+static int stall_dump_context;
+
 #ifndef WIN32
     #ifndef CREATE_COMPATIBLE_MINIDUMPS
 
     #include <signal.h>
+    #include <pthread.h>
     #include <execinfo.h>
     #include <sys/utsname.h>
 
     string dump_path;
+    string stall_dump_path;
+    string stall_dump_header;
+    pthread_t main_thread;
+    volatile sig_atomic_t stall_dump_written = 0;
 
     // signal handler
     void signal_handler(int sig, siginfo_t *info, void *secret)
@@ -116,6 +126,11 @@ using namespace std;
             oss << "Error getting stacktrace\n";
         }
 
+        if (stall_summary[0])
+        {
+            oss << "Stall statistics: " << stall_summary << "\n";
+        }
+
         write(dump_file, oss.str().c_str(), oss.str().size());
         close(dump_file);
 
@@ -128,6 +143,30 @@ using namespace std;
         signal_handler(0, 0, 0);
     }
 
+    // writes the stack of the main thread, that receives SIGUSR2 during stalls
+    void stall_handler(int)
+    {
+        int dump_file = open(stall_dump_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0400);
+        if (dump_file >= 0)
+        {
+            write(dump_file, stall_dump_header.c_str(), stall_dump_header.size());
+
+            void *stack[64];
+            int size = backtrace(stack, 64);
+            backtrace_symbols_fd(stack, size, dump_file);
+
+            if (stall_summary[0])
+            {
+                static const char label[] = "Stall statistics: ";
+                write(dump_file, label, sizeof(label) - 1);
+                write(dump_file, stall_summary, strlen(stall_summary));
+                write(dump_file, "\n", 1);
+            }
+            close(dump_file);
+        }
+        stall_dump_written = 1;
+    }
+
     #endif
 #endif
 
@@ -166,7 +205,6 @@ bool DumpCallback(const google_breakpad::MinidumpDescriptor &,void *context, boo
 bool DumpCallback(const char* _dump_dir,const char* _minidump_id,void *context, bool success)
 #endif
 {
-    Q_UNUSED(context);
 #if defined(Q_OS_WIN32)
     Q_UNUSED(_dump_dir);
     Q_UNUSED(_minidump_id);
@@ -174,6 +212,12 @@ bool DumpCallback(const char* _dump_dir,const char* _minidump_id,void *context,
     Q_UNUSED(exinfo);
 #endif
 
+    //Dumps requested with writeMinidump() don't come from a crash
+    if (context == &stall_dump_context)
+    {
+        return success;
+    }
+
     CrashHandler::tryReboot();
     return CrashHandlerPrivate::bReportCrashesToSystem ? success : false;
 }
@@ -241,6 +285,27 @@ void CrashHandlerPrivate::InitCrashHandler(const QString& dumpPath)
         sigaction(SIGFPE, &sa, NULL);
         sigaction(SIGABRT, &sa, NULL);
         std::set_new_handler(mega_new_handler);
+
+        //Stall dumps are sent with the crash reports, so they use the same header
+        std::ostringstream stallHeader;
+        stallHeader << "MEGAprivate ERROR DUMP\n";
+        stallHeader << "Application: " << QApplication::applicationName().toStdString() << "\n";
+        stallHeader << "Version code: " << QString::number(Preferences::VERSION_CODE).toStdString() <<
+               "." << QString::number(Preferences::BUILD_ID).toStdString() << "\n";
+        stallHeader << "Module name: " << "megasync (stall)" << "\n";
+        stallHeader << "Stacktrace:\n";
+        stall_dump_header = stallHeader.str();
+
+        //Init is called from the main thread. The first call to backtrace()
+        //loads libgcc, so it's done here instead of in the signal handler
+        main_thread = pthread_self();
+        void *stack[1];
+        backtrace(stack, 1);
+        struct sigaction stallAction;
+        stallAction.sa_handler = stall_handler;
+        sigemptyset(&stallAction.sa_mask);
+        stallAction.sa_flags = SA_RESTART;
+        sigaction(SIGUSR2, &stallAction, NULL);
     #endif
 #endif
 }
@@ -311,9 +376,46 @@ void CrashHandler::setReportCrashesToSystem(bool report)
     d->bReportCrashesToSystem = report;
 }
 
+//Writes the state of the process without terminating it.
+//Can be called from any thread
 bool CrashHandler::writeMinidump()
 {
-    bool res = d->pHandler->WriteMinidump();
+    if (!d)
+    {
+        return false;
+    }
+
+    bool res = false;
+    if (d->pHandler)
+    {
+        //A crash during the dump still reaches the handler with its own context
+#if defined(Q_OS_WIN32)
+        res = google_breakpad::ExceptionHandler::WriteMinidump((const wchar_t*)dumpPath.utf16(),
+                                                               DumpCallback, &stall_dump_context);
+#else
+        res = google_breakpad::ExceptionHandler::WriteMinidump(dumpPath.toStdString(),
+                                                               DumpCallback, &stall_dump_context);
+#endif
+    }
+#if !defined(WIN32) && !defined(CREATE_COMPATIBLE_MINIDUMPS)
+    else if (dumpPath.size())
+    {
+        //Without breakpad, only the stack of the main thread is saved
+        pruneStallDumps(Preferences::MAX_STALL_DUMPS - 1);
+        stall_dump_path = QDir(dumpPath).filePath(QString::fromUtf8("%1.stall")
+                    .arg(QDateTime::currentMSecsSinceEpoch())).toStdString();
+        stall_dump_written = 0;
+        if (!pthread_kill(main_thread, SIGUSR2))
+        {
+            for (int i = 0; i < 20 && !stall_dump_written; i++)
+            {
+                usleep(50000);
+            }
+            res = stall_dump_written;
+        }
+    }
+#endif
+
     if (res) {
         qDebug("BreakpadQt: writeMinidump() successed.");
     } else {
@@ -322,6 +424,12 @@ bool CrashHandler::writeMinidump()
     return res;
 }
 
+void CrashHandler::setStallSummary(QString summary)
+{
+    QByteArray data = summary.toUtf8();
+    qstrncpy(stall_summary, data.constData(), sizeof(stall_summary));
+}
+
 QStringList CrashHandler::getPendingCrashReports()
 {
     Preferences *preferences = Preferences::instance();
@@ -334,7 +442,8 @@ QStringList CrashHandler::getPendingCrashReports()
     for (int i = 0; i < fiList.size(); i++)
     {
         QFile file(fiList[i].absoluteFilePath());
-        if (!file.fileName().endsWith(QString::fromAscii(".dmp")))
+        if (!file.fileName().endsWith(QString::fromAscii(".dmp"))
+                && !file.fileName().endsWith(QString::fromAscii(".stall")))
         {
             continue;
         }
@@ -466,13 +575,28 @@ void CrashHandler::deletePendingCrashReports()
     for (int i = 0; i < fiList.size(); i++)
     {
         QFileInfo fi = fiList[i];
-        if (fi.fileName().endsWith(QString::fromAscii(".dmp")))
+        if (fi.fileName().endsWith(QString::fromAscii(".dmp"))
+                || fi.fileName().endsWith(QString::fromAscii(".stall")))
         {
             QFile::remove(fi.absoluteFilePath());
         }
     }
 }
 
+//Keeps the newest stall dumps. A stall can happen on each run, so
+//they aren't allowed to accumulate until the next crash report
+void CrashHandler::pruneStallDumps(int maxDumps)
+{
+    QDir dir(dumpPath);
+    QStringList filters;
+    filters.append(QString::fromAscii("*.stall"));
+    QFileInfoList fiList = dir.entryInfoList(filters, QDir::Files | QDir::NoDotAndDotDot, QDir::Time);
+    for (int i = qMax(maxDumps, 0); i < fiList.size(); i++)
+    {
+        QFile::remove(fiList[i].absoluteFilePath());
+    }
+}
+
 void CrashHandler::Init( const QString& reportPath )
 {
     this->dumpPath = reportPath;
@@ -22,6 +22,7 @@ public:
     void Disable();
     void setReportCrashesToSystem(bool report);
     bool writeMinidump();
+    void setStallSummary(QString summary);
 
     QStringList getPendingCrashReports();
     void sendPendingCrashReports(QString userMessage);
@@ -33,6 +34,7 @@ private slots:
 
 private:
     void deletePendingCrashReports();
+    void pruneStallDumps(int maxDumps);
 
     CrashHandler();
     ~CrashHandler();
@@ -0,0 +1,612 @@
+#include "DebrisAccountant.h"
+#include "Preferences.h"
+#include "Utilities.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QtCore>
+
+#if QT_VERSION >= 0x050000
+#include <QtConcurrent/QtConcurrent>
+#endif
+
+using namespace mega;
+
+DebrisAccountant *DebrisAccountant::debrisAccountant = NULL;
+
+//Size of each entry of a debris folder. Entries that don't exist anymore get -1
+QHash<QString, long long> scanDebrisEntries(QStringList entries)
+{
+    QHash<QString, long long> sizes;
+    for (int i = 0; i < entries.size(); i++)
+    {
+        QFileInfo info(entries[i]);
+        long long size = -1;
+        if (info.isDir())
+        {
+            size = 0;
+            Utilities::getFolderSize(entries[i], &size);
+        }
+        else if (info.exists())
+        {
+            size = info.size();
+        }
+        sizes[entries[i]] = size;
+    }
+    return sizes;
+}
+
+QHash<QString, long long> scanDebrisFolders(QStringList debrisFolders)
+{
+    QStringList entries;
+    for (int i = 0; i < debrisFolders.size(); i++)
+    {
+        QDir dir(debrisFolders[i]);
+        QFileInfoList entryList = dir.entryInfoList(QDir::AllEntries | QDir::NoDotAndDotDot | QDir::Hidden);
+        for (int j = 0; j < entryList.size(); j++)
+        {
+            entries.append(QDir::toNativeSeparators(entryList[j].absoluteFilePath()));
+        }
+    }
+
+    QHash<QString, long long> sizes = scanDebrisEntries(entries);
+    QMutableHashIterator<QString, long long> it(sizes);
+    while (it.hasNext())
+    {
+        it.next();
+        if (it.value() < 0)
+        {
+            it.remove();
+        }
+    }
+    return sizes;
+}
+
+long long scanRemoteDebris(MegaApi *megaApi)
+{
+    MegaNode *syncDebris = megaApi->getNodeByPath("//bin/SyncDebris");
+    if (!syncDebris)
+    {
+        return 0;
+    }
+
+    long long size = megaApi->getSize(syncDebris);
+    delete syncDebris;
+    return size;
+}
+
+DebrisAccountant *DebrisAccountant::instance()
+{
+    if (!debrisAccountant)
+    {
+        debrisAccountant = new DebrisAccountant();
+    }
+    return DebrisAccountant::debrisAccountant;
+}
+
+DebrisAccountant::DebrisAccountant() : QObject()
+{
+    megaApi = NULL;
+    remoteSize = -1;
+    lastFullScan = 0;
+    localSizeKnown = false;
+    fullScanRunning = false;
+    remoteScanPending = false;
+    initialized = false;
+
+    watcher = new QFileSystemWatcher(this);
+    connect(watcher, SIGNAL(directoryChanged(QString)), this, SLOT(onDirectoryChanged(QString)));
+
+    changeTimer = new QTimer(this);
+    changeTimer->setSingleShot(true);
+    changeTimer->setInterval(Preferences::DEBRIS_CHANGE_DELAY_MS);
+    connect(changeTimer, SIGNAL(timeout()), this, SLOT(processChangedEntries()));
+
+    remoteChangeTimer = new QTimer(this);
+    remoteChangeTimer->setSingleShot(true);
+    remoteChangeTimer->setInterval(Preferences::DEBRIS_CHANGE_DELAY_MS);
+    connect(remoteChangeTimer, SIGNAL(timeout()), this, SLOT(startRemoteScan()));
+
+    connect(&localScanWatcher, SIGNAL(finished()), this, SLOT(onLocalScanFinished()));
+    connect(&remoteScanWatcher, SIGNAL(finished()), this, SLOT(onRemoteScanFinished()));
+}
+
+void DebrisAccountant::initialize(MegaApi *megaApi)
+{
+    Preferences *preferences = Preferences::instance();
+    if (!preferences->logged())
+    {
+        return;
+    }
+
+    reset();
+    this->megaApi = megaApi;
+
+    QStringList sizes = preferences->getLocalDebrisSizes();
+    for (int i = 0; i < sizes.size(); i++)
+    {
+        int separator = sizes[i].indexOf(QChar::fromAscii(':'));
+        if (separator <= 0)
+        {
+            continue;
+        }
+        localSizes[sizes[i].mid(separator + 1)] = sizes[i].left(separator).toLongLong();
+    }
+
+    lastFullScan = preferences->lastDebrisScan();
+    localSizeKnown = (lastFullScan != 0);
+    remoteSize = preferences->remoteDebrisSize();
+    initialized = true;
+
+    //Reconcile the stored sizes with the current contents of the debris folders
+    syncsChanged();
+    checkFullScan();
+}
+
+void DebrisAccountant::reset()
+{
+    initialized = false;
+    changeTimer->stop();
+    remoteChangeTimer->stop();
+
+    //The remote scan uses the MegaApi object, that could be deleted after this
+    remoteScanWatcher.waitForFinished();
+
+    QStringList watchedPaths = watcher->directories();
+    if (watchedPaths.size())
+    {
+        watcher->removePaths(watchedPaths);
+    }
+
+    debrisFolders.clear();
+    localSizes.clear();
+    changedEntries.clear();
+    remoteSize = -1;
+    lastFullScan = 0;
+    localSizeKnown = false;
+    fullScanRunning = false;
+    remoteScanPending = false;
+}
+
+void DebrisAccountant::save()
+{
+    Preferences *preferences = Preferences::instance();
+    if (!initialized || !preferences->logged())
+    {
+        return;
+    }
+
+    if (localSizeKnown)
+    {
+        QStringList sizes;
+        QHashIterator<QString, long long> it(localSizes);
+        while (it.hasNext())
+        {
+            it.next();
+            sizes.append(QString::number(it.value()) + QString::fromAscii(":") + it.key());
+        }
+        preferences->setLocalDebrisSizes(sizes);
+    }
+    preferences->setRemoteDebrisSize(remoteSize);
+}
+
+long long DebrisAccountant::localDebrisSize()
+{
+    if (!initialized || !localSizeKnown)
+    {
+        return -1;
+    }
+
+    long long size = 0;
+    QHashIterator<QString, long long> it(localSizes);
+    while (it.hasNext())
+    {
+        it.next();
+        size += it.value();
+    }
+    return size;
+}
+
+long long DebrisAccountant::remoteDebrisSize()
+{
+    if (!initialized)
+    {
+        return -1;
+    }
+    return remoteSize;
+}
+
+//Size of each entry of the local debris folders, empty if they aren't known yet
+QHash<QString, long long> DebrisAccountant::localDebrisEntries()
+{
+    if (!initialized || !localSizeKnown)
+    {
+        return QHash<QString, long long>();
+    }
+    return localSizes;
+}
+
+QStringList DebrisAccountant::getDebrisFolders()
+{
+    return debrisFolders;
+}
+
+//Called before MEGAsync asks the SDK to move a local item to the debris folder of its sync
+void DebrisAccountant::localItemMovedToDebris(QString localPath)
+{
+    if (!initialized)
+    {
+        return;
+    }
+
+    QString debrisPath = debrisFolderFor(localPath);
+    QFileInfo info(localPath);
+    if (debrisPath.isEmpty() || !info.exists())
+    {
+        return;
+    }
+
+    QString entry = debrisPath + QDir::separator()
+            + QDate::currentDate().toString(QString::fromAscii("yyyy-MM-dd"));
+    if (info.isFile())
+    {
+        localSizes[entry] += info.size();
+        emit debrisSizeChanged();
+    }
+
+    //Folders (and the exact destination of the move) are checked in the background
+    changedEntries.insert(entry);
+    changeTimer->start();
+}
+
+//Called when the SDK moves remote items to SyncDebris. Updates of items that are
+//already there and files inside moved folders can't be told apart from the
+//updated nodes, so the size is recomputed from the SyncDebris node
+void DebrisAccountant::remoteDebrisChanged()
+{
+    if (!initialized)
+    {
+        return;
+    }
+
+    remoteChangeTimer->start();
+}
+
+void DebrisAccountant::remoteItemRemovedFromDebris(long long size)
+{
+    if (!initialized || remoteSize < 0 || size <= 0)
+    {
+        return;
+    }
+
+    remoteSize = (size < remoteSize) ? (remoteSize - size) : 0;
+    emit debrisSizeChanged();
+}
+
+void DebrisAccountant::localDebrisCleared()
+{
+    if (!initialized)
+    {
+        return;
+    }
+
+    localSizes.clear();
+    changedEntries.clear();
+    localSizeKnown = true;
+    save();
+    emit debrisSizeChanged();
+}
+
+void DebrisAccountant::remoteDebrisCleared()
+{
+    if (!initialized)
+    {
+        return;
+    }
+
+    remoteSize = 0;
+    save();
+    emit debrisSizeChanged();
+}
+
+void DebrisAccountant::syncsChanged()
+{
+    if (!initialized)
+    {
+        return;
+    }
+
+    QStringList newDebrisFolders = currentDebrisFolders();
+    for (int i = 0; i < debrisFolders.size(); i++)
+    {
+        QString debrisPath = debrisFolders[i];
+        if (newDebrisFolders.contains(debrisPath))
+        {
+            continue;
+        }
+
+        //Removed sync, forget its debris
+        QString prefix = debrisPath + QDir::separator();
+        QStringList watchedPaths = watcher->directories();
+        for (int j = 0; j < watchedPaths.size(); j++)
+        {
+            if (watchedPaths[j] == debrisPath || watchedPaths[j].startsWith(prefix))
+            {
+                watcher->removePath(watchedPaths[j]);
+            }
+        }
+
+        QMutableHashIterator<QString, long long> it(localSizes);
+        while (it.hasNext())
+        {
+            it.next();
+            if (it.key().startsWith(prefix))
+            {
+                it.remove();
+            }
+        }
+    }
+
+    QStringList previousDebrisFolders = debrisFolders;
+    debrisFolders = newDebrisFolders;
+    for (int i = 0; i < debrisFolders.size(); i++)
+    {
+        if (!previousDebrisFolders.contains(debrisFolders[i]))
+        {
+            watchDebrisFolder(debrisFolders[i]);
+        }
+    }
+    emit debrisSizeChanged();
+}
+
+void DebrisAccountant::checkFullScan()
+{
+    if (!initialized)
+    {
+        return;
+    }
+
+    if (currentDebrisFolders() != debrisFolders)
+    {
+        syncsChanged();
+    }
+    else
+    {
+        //Debris folders are created by the SDK on demand
+        QStringList watchedPaths = watcher->directories();
+        for (int i = 0; i < debrisFolders.size(); i++)
+        {
+            if (!watchedPaths.contains(debrisFolders[i]))
+            {
+                watchDebrisFolder(debrisFolders[i]);
+            }
+        }
+    }
+
+    if (!localSizeKnown || remoteSize < 0
+            || (QDateTime::currentMSecsSinceEpoch() - lastFullScan) > Preferences::DEBRIS_FULL_SCAN_INTERVAL_MS)
+    {
+        startFullScan();
+    }
+}
+
+void DebrisAccountant::onDirectoryChanged(QString path)
+{
+    if (!initialized)
+    {
+        return;
+    }
+
+    path = QDir::toNativeSeparators(path);
+    if (!debrisFolders.contains(path))
+    {
+        //Something has been moved to (or removed from) an entry of a debris folder
+        changedEntries.insert(path);
+        changeTimer->start();
+        return;
+    }
+
+    //An entry has been added to or removed from a debris folder
+    QSet<QString> currentEntries;
+    QDir dir(path);
+    QFileInfoList entries = dir.entryInfoList(QDir::AllEntries | QDir::NoDotAndDotDot | QDir::Hidden);
+    for (int i = 0; i < entries.size(); i++)
+    {
+        QString entryPath = QDir::toNativeSeparators(entries[i].absoluteFilePath());
+        currentEntries.insert(entryPath);
+        if (!localSizes.contains(entryPath))
+        {
+            changedEntries.insert(entryPath);
+            if (entries[i].isDir() && entries[i].fileName() != QString::fromAscii("tmp"))
+            {
+                watcher->addPath(entryPath);
+            }
+        }
+    }
+
+    bool removed = false;
+    QString prefix = path + QDir::separator();
+    QMutableHashIterator<QString, long long> it(localSizes);
+    while (it.hasNext())
+    {
+        it.next();
+        if (it.key().startsWith(prefix) && !currentEntries.contains(it.key()))
+        {
+            it.remove();
+            removed = true;
+        }
+    }
+
+    if (removed)
+    {
+        emit debrisSizeChanged();
+    }
+
+    if (changedEntries.size())
+    {
+        changeTimer->start();
+    }
+}
+
+void DebrisAccountant::processChangedEntries()
+{
+    if (!initialized || changedEntries.isEmpty())
+    {
+        return;
+    }
+
+    if (localScanWatcher.isRunning())
+    {
+        changeTimer->start();
+        return;
+    }
+
+    QStringList entries = changedEntries.toList();
+    changedEntries.clear();
+    fullScanRunning = false;
+    localScanWatcher.setFuture(QtConcurrent::run(scanDebrisEntries, entries));
+}
+
+void DebrisAccountant::onLocalScanFinished()
+{
+    if (!initialized)
+    {
+        return;
+    }
+
+    QHash<QString, long long> sizes = localScanWatcher.result();
+    if (fullScanRunning)
+    {
+        fullScanRunning = false;
+        localSizes = sizes;
+        localSizeKnown = true;
+        lastFullScan = QDateTime::currentMSecsSinceEpoch();
+        Preferences::instance()->setLastDebrisScan(lastFullScan);
+        MegaApi::log(MegaApi::LOG_LEVEL_DEBUG, QString::fromUtf8("Local debris rescanned: %1 bytes")
+                     .arg(localDebrisSize()).toUtf8().constData());
+    }
+    else
+    {
+        QHashIterator<QString, long long> it(sizes);
+        while (it.hasNext())
+        {
+            it.next();
+            if (it.value() < 0)
+            {
+                localSizes.remove(it.key());
+            }
+            else
+            {
+                localSizes[it.key()] = it.value();
+            }
+        }
+    }
+
+    save();
+    emit debrisSizeChanged();
+
+    if (changedEntries.size())
+    {
+        changeTimer->start();
+    }
+}
+
+void DebrisAccountant::onRemoteScanFinished()
+{
+    if (!initialized)
+    {
+        return;
+    }
+
+    remoteSize = remoteScanWatcher.result();
+    save();
+    emit debrisSizeChanged();
+
+    if (remoteScanPending)
+    {
+        startRemoteScan();
+    }
+}
+
+void DebrisAccountant::startRemoteScan()
+{
+    if (!initialized || !megaApi)
+    {
+        return;
+    }
+
+    //Changes during a scan are counted by another one when it finishes
+    if (remoteScanWatcher.isRunning())
+    {
+        remoteScanPending = true;
+        return;
+    }
+
+    remoteScanPending = false;
+    remoteScanWatcher.setFuture(QtConcurrent::run(scanRemoteDebris, megaApi));
+}
+
+void DebrisAccountant::startFullScan()
+{
+    if (!megaApi || localScanWatcher.isRunning() || remoteScanWatcher.isRunning())
+    {
+        return;
+    }
+
+    fullScanRunning = true;
+    localScanWatcher.setFuture(QtConcurrent::run(scanDebrisFolders, debrisFolders));
+    remoteScanWatcher.setFuture(QtConcurrent::run(scanRemoteDebris, megaApi));
+}
+
+void DebrisAccountant::watchDebrisFolder(QString debrisPath)
+{
+    QDir dir(debrisPath);
+    if (!dir.exists())
+    {
+        return;
+    }
+
+    watcher->addPath(debrisPath);
+    QFileInfoList entries = dir.entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot | QDir::Hidden);
+    for (int i = 0; i < entries.size(); i++)
+    {
+        if (entries[i].fileName() != QString::fromAscii("tmp"))
+        {
+            watcher->addPath(QDir::toNativeSeparators(entries[i].absoluteFilePath()));
+        }
+    }
+
+    //Pick up entries that appeared while MEGAsync wasn't watching
+    onDirectoryChanged(debrisPath);
+}
+
+QString DebrisAccountant::debrisFolderFor(QString localPath)
+{
+    localPath = QDir::toNativeSeparators(localPath);
+    for (int i = 0; i < debrisFolders.size(); i++)
+    {
+        QString syncPath = debrisFolders[i].left(debrisFolders[i].size()
+                                                 - QString::fromAscii(MEGA_DEBRIS_FOLDER).size() - 1);
+        if (localPath.startsWith(syncPath + QDir::separator()))
+        {
+            return debrisFolders[i];
+        }
+    }
+    return QString();
+}
+
+QStringList DebrisAccountant::currentDebrisFolders()
+{
+    QStringList folders;
+    QVector<SyncRecord> syncRecords = Preferences::instance()->getSyncRecords();
+    for (int i = 0; i < syncRecords.size(); i++)
+    {
+        QString syncPath = syncRecords.at(i).canonicalLocalFolder;
+        if (!syncPath.isEmpty())
+        {
+            folders.append(QDir::toNativeSeparators(syncPath + QDir::separator() + QString::fromAscii(MEGA_DEBRIS_FOLDER)));
+        }
+    }
+    return folders;
+}
@@ -0,0 +1,83 @@
+#ifndef DEBRISACCOUNTANT_H
+#define DEBRISACCOUNTANT_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QSet>
+#include <QTimer>
+#include <QFileSystemWatcher>
+#include <QFutureWatcher>
+#include "megaapi.h"
+
+// Keeps running totals of the local (.debris) and remote (//bin/SyncDebris)
+// caches so that they don't have to be walked every time they are shown.
+// Sizes are tracked per entry of each .debris folder (one per day), updated
+// from the moves done by MEGAsync itself and from a watch on those folders,
+// persisted in the preferences and verified by an occasional full rescan.
+// The remote size is recomputed from the SyncDebris node when it changes.
+// All methods must be called from the GUI thread.
+class DebrisAccountant : public QObject
+{
+    Q_OBJECT
+
+public:
+    static DebrisAccountant *instance();
+
+    void initialize(mega::MegaApi *megaApi);
+    void reset();
+    void save();
+
+    // -1 if the size isn't known yet
+    long long localDebrisSize();
+    long long remoteDebrisSize();
+    QHash<QString, long long> localDebrisEntries();
+    QStringList getDebrisFolders();
+
+    void localItemMovedToDebris(QString localPath);
+    void remoteDebrisChanged();
+    void remoteItemRemovedFromDebris(long long size);
+    void localDebrisCleared();
+    void remoteDebrisCleared();
+    void syncsChanged();
+    void checkFullScan();
+
+signals:
+    void debrisSizeChanged();
+
+private slots:
+    void onDirectoryChanged(QString path);
+    void processChangedEntries();
+    void onLocalScanFinished();
+    void onRemoteScanFinished();
+    void startRemoteScan();
+
+private:
+    DebrisAccountant();
+
+    void startFullScan();
+    void watchDebrisFolder(QString debrisPath);
+    QString debrisFolderFor(QString localPath);
+    QStringList currentDebrisFolders();
+
+    static DebrisAccountant *debrisAccountant;
+
+    mega::MegaApi *megaApi;
+    QFileSystemWatcher *watcher;
+    QTimer *changeTimer;
+    QTimer *remoteChangeTimer;
+    QFutureWatcher<QHash<QString, long long> > localScanWatcher;
+    QFutureWatcher<long long> remoteScanWatcher;
+    QStringList debrisFolders;
+    QHash<QString, long long> localSizes;
+    QSet<QString> changedEntries;
+    long long remoteSize;
+    long long lastFullScan;
+    bool localSizeKnown;
+    bool fullScanRunning;
+    bool remoteScanPending;
+    bool initialized;
+};
+
+#endif // DEBRISACCOUNTANT_H
@@ -0,0 +1,343 @@
+#include "DebrisPruner.h"
+#include "DebrisAccountant.h"
+#include "Preferences.h"
+#include "Utilities.h"
+#include "platform/Platform.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QDate>
+#include <QDateTime>
+#include <QMap>
+#include <QtCore>
+
+#if QT_VERSION >= 0x050000
+#include <QtConcurrent/QtConcurrent>
+#endif
+
+using namespace mega;
+
+DebrisPruner *DebrisPruner::debrisPruner = NULL;
+
+//Debris folders are named after the day in which the items were moved to them
+//(yyyy-MM-dd, with a time suffix if the folder couldn't be reused)
+QDate debrisFolderDate(QString name)
+{
+    return QDate::fromString(name.left(10), QString::fromAscii("yyyy-MM-dd"));
+}
+
+struct DebrisPrunePlan
+{
+    QStringList localEntries;
+    QHash<QString, long long> localSizes;
+    int maxAgeDays;
+    long long maxSize;
+    long long remoteSize;
+    bool pruneRemote;
+};
+
+DebrisPruneResult pruneDebris(MegaApi *megaApi, QAtomicInt *cancelled, DebrisPrunePlan plan)
+{
+    DebrisPruneResult result;
+    QStringList localEntries = plan.localEntries;
+    int maxAgeDays = plan.maxAgeDays;
+    long long maxSize = plan.maxSize;
+    long long remoteSize = plan.remoteSize;
+    Platform::setBackgroundIOPriority(true);
+
+    for (int i = 0; i < localEntries.size() && !cancelled->fetchAndAddOrdered(0); i++)
+    {
+        QString path = localEntries[i];
+        QFileInfo info(path);
+        if (info.isDir())
+        {
+            Utilities::removeRecursively(path);
+        }
+        else
+        {
+            QFile::remove(path);
+        }
+
+        if (!QFileInfo(path).exists())
+        {
+            result.localBytes += plan.localSizes.value(path);
+            result.localFolders++;
+            MegaApi::log(MegaApi::LOG_LEVEL_DEBUG, QString::fromUtf8("Debris pruned: %1").arg(path).toUtf8().constData());
+        }
+    }
+
+    Platform::setBackgroundIOPriority(false);
+
+    if (!megaApi || !plan.pruneRemote || cancelled->fetchAndAddOrdered(0) || (maxAgeDays <= 0 && maxSize <= 0))
+    {
+        return result;
+    }
+
+    MegaNode *syncDebris = megaApi->getNodeByPath("//bin/SyncDebris");
+    if (!syncDebris)
+    {
+        return result;
+    }
+
+    if (remoteSize < 0)
+    {
+        remoteSize = megaApi->getSize(syncDebris);
+    }
+
+    QDate today = QDate::currentDate();
+    MegaNodeList *children = megaApi->getChildren(syncDebris);
+    for (int i = 0; i < children->size() && !cancelled->fetchAndAddOrdered(0); i++)
+    {
+        MegaNode *child = children->get(i);
+        QDate date = debrisFolderDate(QString::fromUtf8(child->getName()));
+        if (!date.isValid() || date >= today)
+        {
+            continue;
+        }
+
+        if ((maxAgeDays > 0 && date.daysTo(today) > maxAgeDays)
+                || (maxSize > 0 && remoteSize > maxSize))
+        {
+            long long size = megaApi->getSize(child);
+            remoteSize -= size;
+            result.remoteHandles.append(child->getHandle());
+            result.remoteSizes.append(size);
+        }
+    }
+
+    delete children;
+    delete syncDebris;
+    return result;
+}
+
+DebrisPruner *DebrisPruner::instance()
+{
+    if (!debrisPruner)
+    {
+        debrisPruner = new DebrisPruner();
+    }
+    return DebrisPruner::debrisPruner;
+}
+
+DebrisPruner::DebrisPruner() : QObject()
+{
+    lastPrune = 0;
+    lowSpaceDebrisSize = -1;
+    megaApi = NULL;
+    delegateListener = NULL;
+    removedBytes = 0;
+    removedFolders = 0;
+    connect(&pruneWatcher, SIGNAL(finished()), this, SLOT(onPruneFinished()));
+}
+
+void DebrisPruner::check(MegaApi *megaApi)
+{
+    Preferences *preferences = Preferences::instance();
+    DebrisAccountant *debrisAccountant = DebrisAccountant::instance();
+    if (!preferences->logged() || pruneWatcher.isRunning())
+    {
+        return;
+    }
+
+    //The policy is applied using the sizes kept by the accountant
+    long long totalSize = debrisAccountant->localDebrisSize();
+    if (totalSize < 0)
+    {
+        return;
+    }
+
+    if (this->megaApi != megaApi)
+    {
+        delete delegateListener;
+        this->megaApi = megaApi;
+        delegateListener = megaApi ? new QTMegaRequestListener(megaApi, this) : NULL;
+    }
+
+    //Bytes that have to be reclaimed in each volume to have the minimum free space.
+    //Debris folders of syncs in the same volume share the same target
+    QHash<QString, long long> neededSpace;
+    QHash<QString, long long> availableSpaceMB;
+    QHash<QString, QString> folderVolumes;
+    long long minFreeSpace = preferences->debrisMinFreeSpaceMB() * 1024 * 1024;
+    QStringList debrisFolders = debrisAccountant->getDebrisFolders();
+    for (int i = 0; minFreeSpace > 0 && i < debrisFolders.size(); i++)
+    {
+        QString syncPath = QFileInfo(debrisFolders[i]).absolutePath();
+        QString volume = Platform::getVolumeId(syncPath);
+        if (volume.isEmpty())
+        {
+            volume = syncPath;
+        }
+        folderVolumes[QDir::toNativeSeparators(debrisFolders[i])] = volume;
+        if (neededSpace.contains(volume))
+        {
+            continue;
+        }
+
+        long long availableSpace = Platform::getAvailableSpace(syncPath);
+        if (availableSpace >= 0 && availableSpace < minFreeSpace)
+        {
+            neededSpace[volume] = minFreeSpace - availableSpace;
+            availableSpaceMB[volume] = availableSpace / (1024 * 1024);
+        }
+    }
+
+    //The whole policy is applied periodically, low disk space is handled as soon as it is detected
+    long long now = QDateTime::currentMSecsSinceEpoch();
+    bool scheduled = (now - lastPrune) >= Preferences::DEBRIS_PRUNE_INTERVAL_MS;
+    if (!scheduled && neededSpace.isEmpty())
+    {
+        return;
+    }
+
+    //If the last attempt didn't free enough space, wait until the free space,
+    //the debris or the day change instead of planning the same removals again
+    QDate today = QDate::currentDate();
+    if (!scheduled && availableSpaceMB == lowSpaceAvailableMB
+            && totalSize == lowSpaceDebrisSize && today == lowSpaceDate)
+    {
+        return;
+    }
+
+    if (scheduled)
+    {
+        lastPrune = now;
+    }
+
+    lowSpaceAvailableMB = availableSpaceMB;
+    lowSpaceDebrisSize = neededSpace.isEmpty() ? -1 : totalSize;
+    lowSpaceDate = today;
+
+    //Dated entries, from the oldest to the newest. The current day is never pruned
+    QMap<QString, QString> datedEntries;
+    QHash<QString, long long> localSizes = debrisAccountant->localDebrisEntries();
+    QHashIterator<QString, long long> it(localSizes);
+    while (it.hasNext())
+    {
+        it.next();
+        QString name = QFileInfo(it.key()).fileName();
+        QDate date = debrisFolderDate(name);
+        if (date.isValid() && date < today)
+        {
+            datedEntries.insert(name + QString::fromAscii("\n") + it.key(), it.key());
+        }
+    }
+
+    int maxAgeDays = preferences->debrisMaxAgeDays();
+    long long maxSize = preferences->debrisMaxSizeMB() * 1024 * 1024;
+    QStringList localEntries;
+    QMapIterator<QString, QString> entryIt(datedEntries);
+    while (entryIt.hasNext())
+    {
+        entryIt.next();
+        QString path = entryIt.value();
+        QString volume = folderVolumes.value(QDir::toNativeSeparators(QFileInfo(path).absolutePath()));
+        long long size = localSizes.value(path);
+        QDate date = debrisFolderDate(QFileInfo(path).fileName());
+
+        if ((maxAgeDays > 0 && date.daysTo(today) > maxAgeDays)
+                || (maxSize > 0 && totalSize > maxSize)
+                || neededSpace.value(volume) > 0)
+        {
+            localEntries.append(path);
+            totalSize -= size;
+            if (neededSpace.contains(volume))
+            {
+                neededSpace[volume] -= size;
+            }
+        }
+    }
+
+    if (localEntries.isEmpty() && (!scheduled || (maxAgeDays <= 0 && maxSize <= 0)))
+    {
+        return;
+    }
+
+    DebrisPrunePlan plan;
+    plan.localEntries = localEntries;
+    plan.localSizes = localSizes;
+    plan.maxAgeDays = maxAgeDays;
+    plan.maxSize = maxSize;
+    plan.remoteSize = debrisAccountant->remoteDebrisSize();
+    plan.pruneRemote = scheduled;
+
+    cancelled.fetchAndStoreOrdered(0);
+    pruneWatcher.setFuture(QtConcurrent::run(pruneDebris, megaApi, &cancelled, plan));
+}
+
+void DebrisPruner::cancel()
+{
+    cancelled.fetchAndStoreOrdered(1);
+    pruneWatcher.waitForFinished();
+    pendingRemovals.clear();
+    pendingNames.clear();
+    removedBytes = 0;
+    removedFolders = 0;
+}
+
+void DebrisPruner::onRequestFinish(MegaApi *, MegaRequest *request, MegaError *e)
+{
+    if (request->getType() != MegaRequest::TYPE_REMOVE
+            || !pendingRemovals.contains(request->getNodeHandle()))
+    {
+        return;
+    }
+
+    long long size = pendingRemovals.take(request->getNodeHandle());
+    QString name = pendingNames.take(request->getNodeHandle());
+    if (e->getErrorCode() == MegaError::API_OK)
+    {
+        removedBytes += size;
+        removedFolders++;
+        DebrisAccountant::instance()->remoteItemRemovedFromDebris(size);
+        MegaApi::log(MegaApi::LOG_LEVEL_DEBUG, QString::fromUtf8("Remote debris pruned: %1")
+                     .arg(name).toUtf8().constData());
+    }
+    else
+    {
+        MegaApi::log(MegaApi::LOG_LEVEL_WARNING, QString::fromUtf8("Unable to prune remote debris: %1 (%2)")
+                     .arg(name).arg(QString::fromUtf8(e->getErrorString())).toUtf8().constData());
+    }
+
+    if (pendingRemovals.isEmpty() && removedFolders)
+    {
+        MegaApi::log(MegaApi::LOG_LEVEL_INFO, QString::fromUtf8("Remote debris pruned: %1 (%2 items)")
+                     .arg(Utilities::getSizeString(removedBytes)).arg(removedFolders)
+                     .toUtf8().constData());
+        removedBytes = 0;
+        removedFolders = 0;
+    }
+}
+
+void DebrisPruner::onPruneFinished()
+{
+    DebrisPruneResult result = pruneWatcher.result();
+    if (result.localFolders)
+    {
+        MegaApi::log(MegaApi::LOG_LEVEL_INFO, QString::fromUtf8("Local debris pruned: %1 (%2 items)")
+                     .arg(Utilities::getSizeString(result.localBytes)).arg(result.localFolders)
+                     .toUtf8().constData());
+    }
+
+    //Remote removals are asynchronous. They are counted in onRequestFinish
+    for (int i = 0; megaApi && i < result.remoteHandles.size(); i++)
+    {
+        MegaHandle handle = result.remoteHandles[i];
+        if (pendingRemovals.contains(handle))
+        {
+            continue;
+        }
+
+        MegaNode *node = megaApi->getNodeByHandle(handle);
+        if (!node)
+        {
+            continue;
+        }
+
+        pendingRemovals.insert(handle, result.remoteSizes[i]);
+        pendingNames.insert(handle, QString::fromUtf8(node->getName()));
+        megaApi->remove(node, delegateListener);
+        delete node;
+    }
+}
@@ -0,0 +1,65 @@
+#ifndef DEBRISPRUNER_H
+#define DEBRISPRUNER_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QDate>
+#include <QAtomicInt>
+#include <QFutureWatcher>
+#include "megaapi.h"
+#include "QTMegaRequestListener.h"
+
+struct DebrisPruneResult
+{
+    DebrisPruneResult() : localBytes(0), localFolders(0) {}
+
+    long long localBytes;
+    int localFolders;
+
+    //Remote debris folders to remove. They are counted when the removal succeeds
+    QList<mega::MegaHandle> remoteHandles;
+    QList<long long> remoteSizes;
+};
+
+// Background retention policy for the local (.debris) and remote (//bin/SyncDebris)
+// caches: a maximum age, a maximum total size and a minimum of free disk space.
+// The oldest dated debris folders are removed first, at low I/O priority.
+class DebrisPruner : public QObject, public mega::MegaRequestListener
+{
+    Q_OBJECT
+
+public:
+    static DebrisPruner *instance();
+
+    void check(mega::MegaApi *megaApi);
+    void cancel();
+
+    virtual void onRequestFinish(mega::MegaApi* api, mega::MegaRequest *request, mega::MegaError* e);
+
+private slots:
+    void onPruneFinished();
+
+private:
+    DebrisPruner();
+
+    static DebrisPruner *debrisPruner;
+
+    QFutureWatcher<DebrisPruneResult> pruneWatcher;
+    QAtomicInt cancelled;
+    long long lastPrune;
+
+    //State of the last pruning for low disk space. It isn't retried until it changes
+    QHash<QString, long long> lowSpaceAvailableMB;
+    long long lowSpaceDebrisSize;
+    QDate lowSpaceDate;
+    mega::MegaApi *megaApi;
+    mega::QTMegaRequestListener *delegateListener;
+    QHash<mega::MegaHandle, long long> pendingRemovals;
+    QHash<mega::MegaHandle, QString> pendingNames;
+    long long removedBytes;
+    int removedFolders;
+};
+
+#endif // DEBRISPRUNER_H
@@ -1,5 +1,6 @@
 #include "EncryptedSettings.h"
 #include "platform/Platform.h"
+#include "MetricsCollector.h"
 
 EncryptedSettings::EncryptedSettings(QString file) :
     QSettings(file, QSettings::IniFormat)
@@ -13,11 +14,13 @@ EncryptedSettings::EncryptedSettings(QString file) :
 
 void EncryptedSettings::setValue(const QString &key, const QVariant &value)
 {
+    MetricsCollector::instance()->settingsWritten();
     QSettings::setValue(hash(key), encrypt(key, value.toString()));
 }
 
 QVariant EncryptedSettings::value(const QString &key, const QVariant &defaultValue)
 {
+    MetricsCollector::instance()->settingsRead();
     return QVariant(decrypt(key, QSettings::value(hash(key), encrypt(key, defaultValue.toString())).toString()));
 }
 
@@ -0,0 +1,52 @@
+#include "EventLoopHeartbeat.h"
+#include "Preferences.h"
+
+EventLoopHeartbeat *EventLoopHeartbeat::heartbeat = NULL;
+
+EventLoopHeartbeat *EventLoopHeartbeat::instance()
+{
+    if (!heartbeat)
+    {
+        heartbeat = new EventLoopHeartbeat();
+    }
+    return heartbeat;
+}
+
+EventLoopHeartbeat::EventLoopHeartbeat() : QObject()
+{
+    users = 0;
+    connect(&timer, SIGNAL(timeout()), this, SLOT(onTimeout()));
+}
+
+void EventLoopHeartbeat::start()
+{
+    if (users++)
+    {
+        return;
+    }
+
+    clock.start();
+    timer.start(Preferences::EVENT_LOOP_HEARTBEAT_INTERVAL_MS);
+}
+
+void EventLoopHeartbeat::stop()
+{
+    if (!users || --users)
+    {
+        return;
+    }
+
+    timer.stop();
+}
+
+int EventLoopHeartbeat::beats()
+{
+    return counter.fetchAndAddRelaxed(0);
+}
+
+void EventLoopHeartbeat::onTimeout()
+{
+    counter.ref();
+    qint64 lag = clock.restart() - Preferences::EVENT_LOOP_HEARTBEAT_INTERVAL_MS;
+    emit beat(lag > 0 ? lag : 0);
+}
@@ -0,0 +1,43 @@
+#ifndef EVENTLOOPHEARTBEAT_H
+#define EVENTLOOPHEARTBEAT_H
+
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QAtomicInt>
+
+// Periodic timer of the GUI thread shared by the components that watch the
+// responsiveness of the event loop. Each tick increments a counter, that can
+// be read from any thread, and emits the delay of the tick.
+// It runs while at least one component has called start().
+class EventLoopHeartbeat : public QObject
+{
+    Q_OBJECT
+
+public:
+    static EventLoopHeartbeat *instance();
+
+    // Must be called from the GUI thread
+    void start();
+    void stop();
+
+    int beats();
+
+signals:
+    void beat(qint64 lagMs);
+
+private slots:
+    void onTimeout();
+
+private:
+    EventLoopHeartbeat();
+
+    static EventLoopHeartbeat *heartbeat;
+
+    QTimer timer;
+    QElapsedTimer clock;
+    QAtomicInt counter;
+    int users;
+};
+
+#endif // EVENTLOOPHEARTBEAT_H
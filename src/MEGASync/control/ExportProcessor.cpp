@@ -1,76 +1,229 @@
 #include "ExportProcessor.h"
+#include "Preferences.h"
+
+#include <QtCore>
+
+#if QT_VERSION >= 0x050000
+#include <QtConcurrent/QtConcurrent>
+#endif
 
 using namespace mega;
 using namespace std;
 
+string exportLocalPath(QString path)
+{
+#ifdef WIN32
+    if (!path.startsWith(QString::fromAscii("\\\\")))
+    {
+        path.insert(0, QString::fromAscii("\\\\?\\"));
+    }
+
+    return string((const char*)path.utf16(), path.size()*sizeof(wchar_t));
+#else
+    return string((const char*)path.toUtf8().constData());
+#endif
+}
+
+struct ExportFingerprint
+{
+    typedef QString result_type;
+
+    ExportFingerprint(MegaApi *megaApi) : megaApi(megaApi) {}
+
+    QString operator()(const QString &path) const
+    {
+        string tmpPath = exportLocalPath(path);
+        const char *fpLocal = megaApi->getFingerprint(tmpPath.c_str());
+        QString fingerprint = fpLocal ? QString::fromAscii(fpLocal) : QString();
+        delete [] fpLocal;
+        return fingerprint;
+    }
+
+    MegaApi *megaApi;
+};
+
+QList<MegaHandle> resolveExportNodes(MegaApi *megaApi, QStringList fileList)
+{
+    QList<MegaHandle> handles;
+    QStringList unsyncedFiles;
+    QList<int> unsyncedIndices;
+    for (int i = 0; i < fileList.size(); i++)
+    {
+        string tmpPath = exportLocalPath(fileList[i]);
+        MegaNode *node = megaApi->getSyncedNode(&tmpPath);
+        if (node)
+        {
+            handles.append(node->getHandle());
+            delete node;
+        }
+        else
+        {
+            handles.append(INVALID_HANDLE);
+            unsyncedFiles.append(fileList[i]);
+            unsyncedIndices.append(i);
+        }
+    }
+
+    //Fingerprints need to read the whole file, they are computed in parallel
+    QStringList fingerprints = QtConcurrent::blockingMapped<QStringList>(unsyncedFiles, ExportFingerprint(megaApi));
+    for (int i = 0; i < fingerprints.size(); i++)
+    {
+        if (fingerprints[i].isEmpty())
+        {
+            continue;
+        }
+
+        MegaNode *node = megaApi->getNodeByFingerprint(fingerprints[i].toAscii().constData());
+        if (node)
+        {
+            handles[unsyncedIndices[i]] = node->getHandle();
+            delete node;
+        }
+    }
+    return handles;
+}
+
 ExportProcessor::ExportProcessor(MegaApi *megaApi, QStringList fileList) : QObject()
 {
     this->megaApi = megaApi;
     this->fileList = fileList;
 
+    requestsInFlight = 0;
     currentIndex = 0;
     remainingNodes = fileList.size();
     importSuccess = 0;
     importFailed = 0;
 
     delegateListener = new QTMegaRequestListener(megaApi, this);
+    connect(&resolveWatcher, SIGNAL(finished()), this, SLOT(onNodesResolved()));
 }
 
 ExportProcessor::~ExportProcessor()
 {
+    resolveWatcher.waitForFinished();
     delete delegateListener;
 }
 
 void ExportProcessor::requestLinks()
 {
+    if (!fileList.size())
+    {
+        emit onRequestLinksFinished();
+        return;
+    }
+
+    resolveWatcher.setFuture(QtConcurrent::run(resolveExportNodes, megaApi, fileList));
+}
+
+QStringList ExportProcessor::getValidLinks()
+{
+    return validPublicLinks;
+}
+
+void ExportProcessor::onNodesResolved()
+{
+    QList<MegaHandle> handles = resolveWatcher.result();
     for (int i = 0; i < fileList.size(); i++)
     {
-#ifdef WIN32
-        if (!fileList[i].startsWith(QString::fromAscii("\\\\")))
+        publicLinks.append(QString());
+    }
+
+    //Each node is exported once, even if several files refer to it
+    QList<MegaHandle> missingHandles;
+    for (int i = 0; i < handles.size(); i++)
+    {
+        if (!handleIndices.contains(handles[i]))
         {
-            fileList[i].insert(0, QString::fromAscii("\\\\?\\"));
+            if (handles[i] == INVALID_HANDLE)
+            {
+                missingHandles.append(handles[i]);
+            }
+            else
+            {
+                pendingHandles.append(handles[i]);
+            }
         }
+        handleIndices[handles[i]].append(i);
+    }
 
-        string tmpPath((const char*)fileList[i].utf16(), fileList[i].size()*sizeof(wchar_t));
-#else
-        string tmpPath((const char*)fileList[i].toUtf8().constData());
-#endif
+    for (int i = 0; i < missingHandles.size(); i++)
+    {
+        finishLinks(missingHandles[i], QString());
+    }
 
-        MegaNode *node = megaApi->getSyncedNode(&tmpPath);
+    requestNextLinks();
+}
+
+//Keeps a limited number of exportNode requests in flight
+void ExportProcessor::requestNextLinks()
+{
+    while (!pendingHandles.isEmpty() && requestsInFlight < Preferences::MAX_EXPORT_REQUESTS)
+    {
+        MegaHandle handle = pendingHandles.takeFirst();
+        MegaNode *node = megaApi->getNodeByHandle(handle);
         if (!node)
         {
-            const char *fpLocal = megaApi->getFingerprint(tmpPath.c_str());
-            node = megaApi->getNodeByFingerprint(fpLocal);
-            delete [] fpLocal;
+            finishLinks(handle, QString());
+            continue;
         }
+
+        requestsInFlight++;
         megaApi->exportNode(node, delegateListener);
         delete node;
     }
 }
 
-QStringList ExportProcessor::getValidLinks()
+void ExportProcessor::finishLinks(MegaHandle handle, QString link)
 {
-    return validPublicLinks;
-}
-
-void ExportProcessor::onRequestFinish(MegaApi *, MegaRequest *request, MegaError *e)
-{
-    currentIndex++;
-    remainingNodes--;
-    if (e->getErrorCode() != MegaError::API_OK)
+    QList<int> indices = handleIndices.take(handle);
+    if (indices.isEmpty())
     {
-        publicLinks.append(QString());
-        importFailed++;
+        return;
     }
-    else
+
+    for (int i = 0; i < indices.size(); i++)
     {
-        publicLinks.append(QString::fromAscii(request->getLink()));
-        validPublicLinks.append(QString::fromAscii(request->getLink()));
-        importSuccess++;
+        currentIndex++;
+        remainingNodes--;
+        publicLinks[indices[i]] = link;
+        if (link.isEmpty())
+        {
+            importFailed++;
+        }
+        else
+        {
+            importSuccess++;
+        }
     }
 
     if (!remainingNodes)
     {
+        //Links are returned in the same order as the files
+        for (int i = 0; i < publicLinks.size(); i++)
+        {
+            if (!publicLinks[i].isEmpty())
+            {
+                validPublicLinks.append(publicLinks[i]);
+            }
+        }
         emit onRequestLinksFinished();
     }
 }
+
+void ExportProcessor::onRequestFinish(MegaApi *, MegaRequest *request, MegaError *e)
+{
+    if (request->getType() != MegaRequest::TYPE_EXPORT)
+    {
+        return;
+    }
+
+    requestsInFlight--;
+    QString link;
+    if (e->getErrorCode() == MegaError::API_OK && request->getLink())
+    {
+        link = QString::fromAscii(request->getLink());
+    }
+
+    finishLinks(request->getNodeHandle(), link);
+    requestNextLinks();
+}
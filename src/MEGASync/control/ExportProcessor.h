@@ -2,9 +2,15 @@
 #define EXPORTPROCESSOR_H
 
 #include <QStringList>
+#include <QHash>
+#include <QFutureWatcher>
 #include <megaapi.h>
 #include <QTMegaRequestListener.h>
 
+// Gets the public links of local files. Nodes are resolved on a worker
+// thread (fingerprints are computed in parallel), a limited number of
+// exportNode requests is kept in flight and links are returned in the
+// order of the input files
 class ExportProcessor :  public QObject, public mega::MegaRequestListener
 {
     Q_OBJECT
@@ -21,11 +27,21 @@ signals:
 public slots:
     virtual void onRequestFinish(mega::MegaApi* api, mega::MegaRequest *request, mega::MegaError* e);
 
+private slots:
+    void onNodesResolved();
+
 protected:
+    void requestNextLinks();
+    void finishLinks(mega::MegaHandle handle, QString link);
+
     mega::MegaApi *megaApi;
     QStringList fileList;
     QStringList publicLinks;
     QStringList validPublicLinks;
+    QList<mega::MegaHandle> pendingHandles;
+    QHash<mega::MegaHandle, QList<int> > handleIndices;
+    QFutureWatcher<QList<mega::MegaHandle> > resolveWatcher;
+    int requestsInFlight;
     int currentIndex;
     int remainingNodes;
     int importSuccess;
@@ -1,19 +1,20 @@
 #include "HTTPServer.h"
 #include "Preferences.h"
 #include "Utilities.h"
-#include "MegaApplication.h"
 
+#include <QPointer>
+#include <QRegExp>
 #include <iostream>
 
 
 using namespace mega;
 
-HTTPServer::HTTPServer(MegaApi *megaApi, quint16 port, bool sslEnabled)
+HTTPServer::HTTPServer(quint16 port, bool sslEnabled, HTTPServerApiProvider *apiProvider)
     : QTcpServer(), disabled(false)
 {
-    this->megaApi = megaApi;
     this->sslEnabled = sslEnabled;
     this->isFirstWebDownloadDone = false;
+    this->apiProvider = apiProvider;
     listen(QHostAddress::LocalHost, port);
 }
 
@@ -88,73 +89,91 @@ void HTTPServer::readClient()
     }
 
     request->data.append(QString::fromUtf8(socket->readAll().data()));
-    if (request->data.contains(QString::fromUtf8("\r\n\r\n")))
+
+    QString response;
+    int result = parseRequest(request, &response);
+    if (result == REQUEST_REJECTED)
     {
-        QStringList tokens = request->data.split(QString::fromUtf8("\r\n\r\n"));
-        QStringList headers = tokens[0].split(QString::fromUtf8("\r\n"));
-        if (!headers.size() || !headers[0].startsWith(QString::fromAscii("POST")))
-        {
-            rejectRequest(socket, QString::fromUtf8("405 Method Not Allowed"));
-            return;
-        }
+        rejectRequest(socket, response);
+        return;
+    }
 
-        if (!Preferences::HTTPS_ALLOWED_ORIGINS.isEmpty())
-        {
-            bool found = false;
-            for (int i = 0; i < Preferences::HTTPS_ALLOWED_ORIGINS.size(); i++)
-            {                
-                QString check = QString::fromUtf8("Origin: %1").arg(Preferences::HTTPS_ALLOWED_ORIGINS.at(i));
-                for (int j = 0; j < headers.size(); j++)
-                {
-                    if (!headers[j].compare(check, Qt::CaseInsensitive))
-                    {
-                       request->origin = i;
-                       found = true;
-                       break;
-                    }
-                }
+    if (result == REQUEST_COMPLETE)
+    {
+        processRequest(socket, *request);
+
+        requests.remove(socket);
+        delete request;
+    }
+}
+
+int HTTPServer::parseRequest(HTTPRequest *request, QString *response)
+{
+    if (!request->data.contains(QString::fromUtf8("\r\n\r\n")))
+    {
+        return REQUEST_INCOMPLETE;
+    }
+
+    *response = QString::fromUtf8("403 Forbidden");
+    QStringList tokens = request->data.split(QString::fromUtf8("\r\n\r\n"));
+    QStringList headers = tokens[0].split(QString::fromUtf8("\r\n"));
+    if (!headers.size() || !headers[0].startsWith(QString::fromAscii("POST")))
+    {
+        *response = QString::fromUtf8("405 Method Not Allowed");
+        return REQUEST_REJECTED;
+    }
 
-                if (found)
+    if (!Preferences::HTTPS_ALLOWED_ORIGINS.isEmpty())
+    {
+        bool found = false;
+        for (int i = 0; i < Preferences::HTTPS_ALLOWED_ORIGINS.size(); i++)
+        {
+            QString check = QString::fromUtf8("Origin: %1").arg(Preferences::HTTPS_ALLOWED_ORIGINS.at(i));
+            for (int j = 0; j < headers.size(); j++)
+            {
+                if (!headers[j].compare(check, Qt::CaseInsensitive))
                 {
-                    break;
+                   request->origin = i;
+                   found = true;
+                   break;
                 }
             }
 
-            if (!found)
+            if (found)
             {
-                rejectRequest(socket);
-                return;
+                break;
             }
         }
 
-        QString contentLengthId = QString::fromUtf8("Content-length: ");
-        QStringList contentLengthHeader = headers.filter(QRegExp(contentLengthId, Qt::CaseInsensitive));
-        if (!contentLengthHeader.size())
-        {
-            rejectRequest(socket);
-            return;
-        }
-
-        bool ok;
-        request->contentLength = contentLengthHeader[0].mid(contentLengthId.size(), contentLengthHeader[0].size() - contentLengthId.size()).toInt(&ok);
-        if (!ok || request->contentLength < tokens[1].size())
+        if (!found)
         {
-            rejectRequest(socket);
-            return;
+            return REQUEST_REJECTED;
         }
+    }
 
-        if (request->contentLength > tokens[1].size())
-        {
-            return;
-        }
+    QString contentLengthId = QString::fromUtf8("Content-length: ");
+    QStringList contentLengthHeader = headers.filter(QRegExp(contentLengthId, Qt::CaseInsensitive));
+    if (!contentLengthHeader.size())
+    {
+        return REQUEST_REJECTED;
+    }
 
-        request->data = tokens[1];
-        processRequest(socket, *request);
+    bool ok;
+    request->contentLength = contentLengthHeader[0].mid(contentLengthId.size(), contentLengthHeader[0].size() - contentLengthId.size()).toInt(&ok);
+    if (!ok || request->contentLength < tokens[1].size())
+    {
+        return REQUEST_REJECTED;
+    }
 
-        requests.remove(socket);
-        delete request;
+    if (request->contentLength > tokens[1].size())
+    {
+        return REQUEST_INCOMPLETE;
     }
+
+    request->data = tokens[1];
+    return REQUEST_COMPLETE;
 }
+
 void HTTPServer::discardClient()
 {
     QAbstractSocket* socket = (QSslSocket*)sender();
@@ -192,10 +211,12 @@ void HTTPServer::processRequest(QAbstractSocket *socket, HTTPRequest request)
     QString externalDownloadRequestStart = QString::fromUtf8("{\"a\":\"d\",");
     QPointer<QAbstractSocket> safeSocket = socket;
 
+    //The guest MegaApi is only created for requests that need it
     if (request.data == QString::fromUtf8("{\"a\":\"v\"}"))
     {
         MegaApi::log(MegaApi::LOG_LEVEL_DEBUG, "GetVersion command received from the webclient");
-        char *myHandle = megaApi->getMyUserHandle();
+        MegaApi *megaApi = apiProvider->getActiveMegaApiGuest();
+        char *myHandle = megaApi ? megaApi->getMyUserHandle() : NULL;
         if (!myHandle)
         {
             response = QString::fromUtf8("{\"v\":\"%1\"}").arg(Preferences::VERSION_STRING);
@@ -227,12 +248,12 @@ void HTTPServer::processRequest(QAbstractSocket *socket, HTTPRequest request)
 
                 if (preferences->hasDefaultDownloadFolder() && QFile(defaultPath).exists())
                 {
-                    ((MegaApplication *)qApp)->showInfoMessage(tr("Your download has started"));
+                    emit onInfoMessage(tr("Your download has started"));
                 }
 
                 if (!isFirstWebDownloadDone && !Preferences::instance()->isFirstWebDownloadDone())
                 {
-                    megaApi->sendEvent(99503, "MEGAsync first webclient download");
+                    apiProvider->getMegaApiGuest()->sendEvent(99503, "MEGAsync first webclient download");
                     isFirstWebDownloadDone = true;
                 }
             }
@@ -245,11 +266,12 @@ void HTTPServer::processRequest(QAbstractSocket *socket, HTTPRequest request)
         if (parameters.size() == 2)
         {
             QString handle = parameters[1];
-            MegaHandle h = megaApi->base64ToHandle(handle.toUtf8().constData());
-            MegaNode *node = megaApi->getNodeByHandle(h);
+            MegaHandle h = MegaApi::base64ToHandle(handle.toUtf8().constData());
+            MegaApi *megaApi = apiProvider->getActiveMegaApiGuest();
+            MegaNode *node = megaApi ? megaApi->getNodeByHandle(h) : NULL;
             if (!node)
             {
-                if (!megaApi->isLoggedIn())
+                if (!megaApi || !megaApi->isLoggedIn())
                 {
                     response = QString::fromUtf8("-11");
                 }
@@ -300,6 +322,7 @@ void HTTPServer::processRequest(QAbstractSocket *socket, HTTPRequest request)
 
             if (!auth.isEmpty())
             {
+                MegaApi *megaApi = apiProvider->getMegaApiGuest();
                 QQueue<mega::MegaNode *> downloadQueue;
                 int end;
                 bool firstnode = true;
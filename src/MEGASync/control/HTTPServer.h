@@ -20,12 +20,24 @@ public:
     int origin;
 };
 
+//Provides the MegaApi objects used to answer the webclient, so the server
+//works both in MegaApplication and in MegaDaemon
+class HTTPServerApiProvider
+{
+public:
+    virtual ~HTTPServerApiProvider() {}
+    //MegaApi for public nodes, created if it doesn't exist yet
+    virtual mega::MegaApi *getMegaApiGuest() = 0;
+    //MegaApi for public nodes or NULL if it doesn't exist
+    virtual mega::MegaApi *getActiveMegaApiGuest() = 0;
+};
+
 class HTTPServer: public QTcpServer
 {
     Q_OBJECT
 
     public:
-        HTTPServer(mega::MegaApi *megaApi, quint16 port, bool sslEnabled);
+        HTTPServer(quint16 port, bool sslEnabled, HTTPServerApiProvider *apiProvider);
 #if QT_VERSION >= 0x050000
         void incomingConnection(qintptr socket);
 #else
@@ -34,11 +46,22 @@ class HTTPServer: public QTcpServer
         void pause();
         void resume();
 
+        enum {
+            REQUEST_INCOMPLETE = 0,
+            REQUEST_COMPLETE,
+            REQUEST_REJECTED
+        };
+
+        //Parses the headers in request->data. When the request is complete its data
+        //is replaced with the body. For rejected requests, *response is the HTTP status
+        static int parseRequest(HTTPRequest *request, QString *response);
+
     signals:
         void onLinkReceived(QString link);
         void onSyncRequested(long long handle);
         void onExternalDownloadRequested(QQueue<mega::MegaNode*> files);
         void onExternalDownloadRequestFinished();
+        void onInfoMessage(QString message);
 
     private slots:
         void readClient();
@@ -53,7 +76,7 @@ class HTTPServer: public QTcpServer
         bool disabled;
         bool sslEnabled;
         bool isFirstWebDownloadDone;
-        mega::MegaApi *megaApi;
+        HTTPServerApiProvider *apiProvider;
         QMap<QAbstractSocket*, HTTPRequest*> requests;
 };
 
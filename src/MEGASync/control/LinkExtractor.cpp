@@ -0,0 +1,209 @@
+#include "LinkExtractor.h"
+
+#include <QSet>
+
+static const char *LINK_PREFIXES[] = {"https://mega.nz/", "https://mega.co.nz/", "mega://"};
+static const int NUM_LINK_PREFIXES = sizeof(LINK_PREFIXES) / sizeof(LINK_PREFIXES[0]);
+static const char FILE_LINK_PREFIX[] = "https://mega.nz/#!";
+static const char FOLDER_LINK_PREFIX[] = "https://mega.nz/#F!";
+
+static inline int hexValue(char c)
+{
+    if (c >= '0' && c <= '9')
+    {
+        return c - '0';
+    }
+    c |= 0x20;
+    if (c >= 'a' && c <= 'f')
+    {
+        return c - 'a' + 10;
+    }
+    return -1;
+}
+
+static inline bool isHandleChar(char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '-' || c == '_';
+}
+
+static inline bool isKeyChar(char c)
+{
+    return isHandleChar(c) || c == '+' || c == '/';
+}
+
+QStringList LinkExtractor::extractLinks(QString text)
+{
+    return extractLinksFromUtf8(text.toUtf8());
+}
+
+QStringList LinkExtractor::extractLinksFromUtf8(const QByteArray &text)
+{
+    QStringList links;
+    QSet<QByteArray> foundLinks;
+    QByteArray link;
+    const char *data = text.constData();
+    int size = text.size();
+    int pos = 0;
+    while (pos < size)
+    {
+        //All prefixes start with 'h' or 'm' (any case)
+        char c = data[pos] | 0x20;
+        if (c == 'h' || c == 'm')
+        {
+            int end = matchLink(data, pos, size, &link);
+            if (end)
+            {
+                if (!foundLinks.contains(link))
+                {
+                    foundLinks.insert(link);
+                    links.append(QString::fromAscii(link.constData(), link.size()));
+                }
+                pos = end;
+                continue;
+            }
+        }
+        pos++;
+    }
+    return links;
+}
+
+//With fileLinksOnly, folder links are ignored (the same links skipped by the download dialog)
+bool LinkExtractor::containsLinks(const QByteArray &text, bool fileLinksOnly)
+{
+    QByteArray link;
+    const char *data = text.constData();
+    int size = text.size();
+    for (int pos = 0; pos < size; pos++)
+    {
+        char c = data[pos] | 0x20;
+        if ((c == 'h' || c == 'm') && matchLink(data, pos, size, &link)
+                && (!fileLinksOnly || !link.startsWith(FOLDER_LINK_PREFIX)))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool LinkExtractor::isFolderLink(QString link)
+{
+    return link.startsWith(QString::fromAscii(FOLDER_LINK_PREFIX));
+}
+
+//Returns the position after the link starting at pos, or 0 if there isn't any
+int LinkExtractor::matchLink(const char *data, int pos, int size, QByteArray *link)
+{
+    int p = -1;
+    for (int i = 0; i < NUM_LINK_PREFIXES; i++)
+    {
+        int length = qstrlen(LINK_PREFIXES[i]);
+        if ((size - pos) >= length && !qstrnicmp(data + pos, LINK_PREFIXES[i], length))
+        {
+            p = pos + length;
+            break;
+        }
+    }
+
+    if (p < 0)
+    {
+        return 0;
+    }
+
+    //Fragments can be percent-encoded
+    char c;
+    if (p >= size)
+    {
+        return 0;
+    }
+
+    p += decodeChar(data, p, size, &c);
+    if (c != '#' || p >= size)
+    {
+        return 0;
+    }
+
+    p += decodeChar(data, p, size, &c);
+    bool folder = (c == 'F');
+    if (folder)
+    {
+        if (p >= size)
+        {
+            return 0;
+        }
+        p += decodeChar(data, p, size, &c);
+    }
+
+    if (c != '!')
+    {
+        return 0;
+    }
+
+    link->clear();
+    link->append(folder ? FOLDER_LINK_PREFIX : FILE_LINK_PREFIX);
+    for (int i = 0; i < HANDLE_LENGTH; i++)
+    {
+        if (p >= size)
+        {
+            return 0;
+        }
+        p += decodeChar(data, p, size, &c);
+        if (!isHandleChar(c))
+        {
+            return 0;
+        }
+        link->append(c);
+    }
+
+    if (p >= size)
+    {
+        return 0;
+    }
+    p += decodeChar(data, p, size, &c);
+    if (c != '!')
+    {
+        return 0;
+    }
+    link->append(c);
+
+    int keyLength = folder ? FOLDER_KEY_LENGTH : FILE_KEY_LENGTH;
+    for (int i = 0; i < keyLength; i++)
+    {
+        if (p >= size)
+        {
+            return 0;
+        }
+
+        int consumed = decodeChar(data, p, size, &c);
+        p += consumed;
+
+        //Encoded spaces come from keys with '+' characters
+        if (c == ' ' && consumed > 1)
+        {
+            c = '+';
+        }
+
+        if (!isKeyChar(c))
+        {
+            return 0;
+        }
+        link->append(c);
+    }
+    return p;
+}
+
+int LinkExtractor::decodeChar(const char *data, int pos, int size, char *c)
+{
+    if (data[pos] == '%' && (pos + 2) < size)
+    {
+        int high = hexValue(data[pos + 1]);
+        int low = hexValue(data[pos + 2]);
+        if (high >= 0 && low >= 0)
+        {
+            *c = (char)((high << 4) | low);
+            return 3;
+        }
+    }
+
+    *c = data[pos];
+    return 1;
+}
@@ -0,0 +1,29 @@
+#ifndef LINKEXTRACTOR_H
+#define LINKEXTRACTOR_H
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+
+//Finds MEGA file and folder links in a text with a single pass over its
+//UTF-8 bytes. Links are returned in canonical form, without duplicates
+//and in the order in which they appear
+class LinkExtractor
+{
+public:
+    static const int HANDLE_LENGTH = 8;
+    static const int FILE_KEY_LENGTH = 43;
+    static const int FOLDER_KEY_LENGTH = 22;
+
+    static QStringList extractLinks(QString text);
+    static QStringList extractLinksFromUtf8(const QByteArray &text);
+    static bool containsLinks(const QByteArray &text, bool fileLinksOnly = false);
+    static bool isFolderLink(QString link);
+
+private:
+    LinkExtractor() {}
+    static int matchLink(const char *data, int pos, int size, QByteArray *link);
+    static int decodeChar(const char *data, int pos, int size, char *c);
+};
+
+#endif // LINKEXTRACTOR_H
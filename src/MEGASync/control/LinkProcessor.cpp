@@ -1,8 +1,10 @@
 #include "LinkProcessor.h"
 #include "Utilities.h"
+#include "Preferences.h"
 #include <QDir>
 #include <QDateTime>
 #include <QApplication>
+#include <QSet>
 
 using namespace mega;
 
@@ -16,9 +18,25 @@ LinkProcessor::LinkProcessor(MegaApi *megaApi, MegaApi *megaApiGuest, QStringLis
         linkSelected.append(true);
         linkNode.append(NULL);
         linkError.append(MegaError::API_ENOENT);
+        linkAvailable.append(false);
+
+        //Repeated links are resolved only once
+        int firstIndex = uniqueLinks.value(linkList[i], -1);
+        if (firstIndex < 0)
+        {
+            firstIndex = i;
+            uniqueLinks.insert(linkList[i], i);
+            pendingLinks.append(i);
+        }
+        else
+        {
+            duplicateLinks[firstIndex].append(i);
+        }
+        linkFirstIndex.append(firstIndex);
     }
 
     importParentFolder = mega::INVALID_HANDLE;
+    requestsInFlight = 0;
     currentIndex = 0;
     remainingNodes = 0;
     importSuccess = 0;
@@ -51,6 +69,11 @@ int LinkProcessor::getError(int id)
     return linkError[id];
 }
 
+bool LinkProcessor::isLinkInfoAvailable(int id)
+{
+    return linkAvailable[id];
+}
+
 MegaNode *LinkProcessor::getNode(int id)
 {
     return linkNode[id];
@@ -61,34 +84,57 @@ int LinkProcessor::size()
     return linkList.size();
 }
 
+//Requests are started in the same order they are issued, so the link of each
+//request is taken from the issued links instead of matching the link string
+//(the SDK can return it in a different format)
+void LinkProcessor::onRequestStart(MegaApi *, MegaRequest *request)
+{
+    if (request->getType() == MegaRequest::TYPE_GET_PUBLIC_NODE && !issuedLinks.isEmpty())
+    {
+        requestTags.insert(request->getTag(), issuedLinks.takeFirst());
+    }
+}
+
 void LinkProcessor::onRequestFinish(MegaApi *, MegaRequest *request, MegaError *e)
 {
     if (request->getType() == MegaRequest::TYPE_GET_PUBLIC_NODE)
     {
-        if (e->getErrorCode() != MegaError::API_OK)
+        //Responses can arrive in any order, they are matched with their links using the tag
+        int index = -1;
+        if (requestTags.contains(request->getTag()))
         {
-            linkNode[currentIndex] = NULL;
+            index = requestTags.take(request->getTag());
         }
-        else
+        else if (!issuedLinks.isEmpty())
         {
-            linkNode[currentIndex] = request->getPublicMegaNode();
+            index = issuedLinks.takeFirst();
         }
 
-        linkError[currentIndex] = e->getErrorCode();
-        linkSelected[currentIndex] = (linkError[currentIndex] == MegaError::API_OK);
-        if (!linkError[currentIndex])
+        if (requestsInFlight > 0)
         {
-            QString name = QString::fromUtf8(linkNode[currentIndex]->getName());
-            if (!name.compare(QString::fromAscii("NO_KEY")) || !name.compare(QString::fromAscii("DECRYPTION_ERROR")))
+            requestsInFlight--;
+        }
+
+        if (index >= 0 && !linkAvailable[index])
+        {
+            MegaNode *node = NULL;
+            if (e->getErrorCode() == MegaError::API_OK)
             {
-                linkSelected[currentIndex] = false;
+                node = request->getPublicMegaNode();
+            }
+
+            setLinkInfo(index, node, e->getErrorCode());
+            QList<int> duplicates = duplicateLinks.value(index);
+            for (int i = 0; i < duplicates.size(); i++)
+            {
+                setLinkInfo(duplicates[i], node ? node->copy() : NULL, e->getErrorCode());
             }
         }
-        currentIndex++;
-        emit onLinkInfoAvailable(currentIndex-1);
-        if (currentIndex == linkList.size())
+
+        requestNextLinks();
+        if (pendingLinks.isEmpty() && !requestsInFlight)
         {
-            emit onLinkInfoRequestFinish();
+            finishLinkInfoRequests();
         }
     }
     else if (request->getType() == MegaRequest::TYPE_CREATE_FOLDER)
@@ -117,11 +163,55 @@ void LinkProcessor::onRequestFinish(MegaApi *, MegaRequest *request, MegaError *
 }
 
 void LinkProcessor::requestLinkInfo()
+{
+    requestNextLinks();
+}
+
+//Keeps a limited number of requests in flight, the next ones are sent as results arrive
+void LinkProcessor::requestNextLinks()
+{
+    while (!pendingLinks.isEmpty() && requestsInFlight < Preferences::MAX_LINK_INFO_REQUESTS)
+    {
+        int index = pendingLinks.takeFirst();
+        requestsInFlight++;
+        issuedLinks.append(index);
+        megaApiGuest->getPublicNode(linkList[index].toUtf8().constData(), delegateListener);
+    }
+}
+
+//Links without a response are marked as failed, so the batch always finishes
+void LinkProcessor::finishLinkInfoRequests()
 {
     for (int i = 0; i < linkList.size(); i++)
     {
-        megaApiGuest->getPublicNode(linkList[i].toUtf8().constData(), delegateListener);
+        if (!linkAvailable[i])
+        {
+            setLinkInfo(i, NULL, MegaError::API_ENOENT);
+        }
+    }
+
+    issuedLinks.clear();
+    requestTags.clear();
+    emit onLinkInfoRequestFinish();
+}
+
+void LinkProcessor::setLinkInfo(int id, MegaNode *node, int error)
+{
+    linkNode[id] = node;
+    linkError[id] = error;
+    linkSelected[id] = (error == MegaError::API_OK);
+    if (!error && node)
+    {
+        QString name = QString::fromUtf8(node->getName());
+        if (!name.compare(QString::fromAscii("NO_KEY")) || !name.compare(QString::fromAscii("DECRYPTION_ERROR")))
+        {
+            linkSelected[id] = false;
+        }
     }
+
+    linkAvailable[id] = true;
+    currentIndex++;
+    emit onLinkInfoAvailable(id);
 }
 
 void LinkProcessor::importLinks(QString megaPath)
@@ -156,6 +246,7 @@ void LinkProcessor::importLinks(MegaNode *node)
     MegaNodeList *children = megaApi->getChildren(node);
     importParentFolder = node->getHandle();
 
+    QSet<int> importedLinks;
     for (int i = 0; i < linkList.size(); i++)
     {
         if (!linkNode[i])
@@ -165,6 +256,13 @@ void LinkProcessor::importLinks(MegaNode *node)
 
         if (linkNode[i] && linkSelected[i] && !linkError[i])
         {
+            //Repeated links are imported only once
+            if (importedLinks.contains(linkFirstIndex[i]))
+            {
+                continue;
+            }
+            importedLinks.insert(linkFirstIndex[i]);
+
             bool dupplicate = false;
             long long dupplicateHandle;
             const char* name = linkNode[i]->getName();
@@ -201,10 +299,12 @@ MegaHandle LinkProcessor::getImportParentFolder()
 
 void LinkProcessor::downloadLinks(QString localPath)
 {
+    QSet<int> downloadedLinks;
     for (int i = 0; i < linkList.size(); i++)
     {
-        if (linkNode[i] && linkSelected[i])
+        if (linkNode[i] && linkSelected[i] && !downloadedLinks.contains(linkFirstIndex[i]))
         {
+            downloadedLinks.insert(linkFirstIndex[i]);
             QApplication::processEvents();
 
             QDir dir(localPath);
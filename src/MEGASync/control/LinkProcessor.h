@@ -3,6 +3,7 @@
 
 #include <QObject>
 #include <QStringList>
+#include <QHash>
 #include "megaapi.h"
 #include "QTMegaRequestListener.h"
 
@@ -17,6 +18,7 @@ public:
     QString getLink(int id);
     bool isSelected(int id);
     int getError(int id);
+    bool isLinkInfoAvailable(int id);
     mega::MegaNode *getNode(int id);
     int size();
 
@@ -33,12 +35,24 @@ public:
     int getCurrentIndex();
 
 protected:
+    void requestNextLinks();
+    void finishLinkInfoRequests();
+    void setLinkInfo(int id, mega::MegaNode *node, int error);
+
     mega::MegaApi *megaApi;
     mega::MegaApi *megaApiGuest;
     QStringList linkList;
     QList<bool> linkSelected;
     QList<mega::MegaNode *> linkNode;
     QList<int> linkError;
+    QList<bool> linkAvailable;
+    QList<int> linkFirstIndex;
+    QHash<int, QList<int> > duplicateLinks;
+    QHash<QString, int> uniqueLinks;
+    QList<int> pendingLinks;
+    QList<int> issuedLinks;
+    QHash<int, int> requestTags;
+    int requestsInFlight;
     int currentIndex;
     int remainingNodes;
     int importSuccess;
@@ -54,6 +68,7 @@ signals:
     void dupplicateDownload(QString localPath, QString name, mega::MegaHandle handle, QString nodeKey);
 
 public slots:
+    virtual void onRequestStart(mega::MegaApi* api, mega::MegaRequest *request);
     virtual void onRequestFinish(mega::MegaApi* api, mega::MegaRequest *request, mega::MegaError* e);
 };
 
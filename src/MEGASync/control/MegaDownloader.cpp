@@ -16,6 +16,11 @@ MegaDownloader::~MegaDownloader()
 
 }
 
+void MegaDownloader::setMegaApiGuest(MegaApi *megaApiGuest)
+{
+    this->megaApiGuest = megaApiGuest;
+}
+
 void MegaDownloader::download(MegaNode *parent, QString path)
 {
     return download(parent, QFileInfo(path));
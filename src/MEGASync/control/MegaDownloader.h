@@ -18,6 +18,7 @@ public:
     // provide megaApiGuest
     MegaDownloader(mega::MegaApi *megaApi, mega::MegaApi *megaApiGuest = NULL);
     virtual ~MegaDownloader();
+    void setMegaApiGuest(mega::MegaApi *megaApiGuest);
     void processDownloadQueue(QQueue<mega::MegaNode *> *downloadQueue, QString path);
     void download(mega::MegaNode *parent, QString path);
 
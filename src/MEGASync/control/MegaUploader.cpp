@@ -1,6 +1,7 @@
 #include "MegaUploader.h"
 #include <QThread>
 #include "control/Utilities.h"
+#include "control/DebrisAccountant.h"
 #include <QMessageBox>
 #include <QtCore>
 #include <QApplication>
@@ -82,6 +83,7 @@ void MegaUploader::upload(QFileInfo info, MegaNode *parent)
 #else
         QString destPath = QDir::toNativeSeparators(QString::fromUtf8(localPath.data()) + QDir::separator() + info.fileName());
 #endif
+        DebrisAccountant::instance()->localItemMovedToDebris(destPath);
         megaApi->moveToLocalDebris(destPath.toUtf8().constData());
         QtConcurrent::run(Utilities::copyRecursively, currentPath, destPath);
     }
@@ -0,0 +1,360 @@
+#include "MetricsCollector.h"
+#include "EventLoopHeartbeat.h"
+#include "NodeSearchIndex.h"
+#include "Preferences.h"
+#include "Utilities.h"
+#include "platform/Platform.h"
+
+#include <QDir>
+
+using namespace mega;
+
+static const double EXT_REQUEST_BOUNDS[] = {0.0001, 0.0005, 0.001, 0.005, 0.01, 0.05, 0.1, 0.5, 1};
+static const double EVENT_LOOP_LAG_BOUNDS[] = {0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10};
+
+//Shell extension commands handled by ExtServer, the last one is for unknown commands
+static const char EXT_REQUEST_TYPES[] = {'T', 'F', 'L', 'P', 'E', 'I'};
+static const int NUM_EXT_REQUEST_TYPES = sizeof(EXT_REQUEST_TYPES) / sizeof(EXT_REQUEST_TYPES[0]);
+static const char *NOTIFICATION_TYPES[] = {"P", "A", "D"};
+static const int NUM_NOTIFICATION_TYPES = sizeof(NOTIFICATION_TYPES) / sizeof(NOTIFICATION_TYPES[0]);
+static const char *DIRECTION_LABELS[] = {"download", "upload"};
+
+MetricsCollector *MetricsCollector::metricsCollector = NULL;
+
+MetricsHistogram::MetricsHistogram(const double *bounds, int numBounds)
+    : buckets(numBounds + 1, 0)
+{
+    this->bounds = bounds;
+    this->numBounds = numBounds;
+    sum = 0;
+    count = 0;
+}
+
+void MetricsHistogram::observe(double value)
+{
+    int i = 0;
+    while (i < numBounds && value > bounds[i])
+    {
+        i++;
+    }
+    buckets[i]++;
+    sum += value;
+    count++;
+}
+
+void MetricsHistogram::write(QByteArray &out, const char *name, const char *help)
+{
+    out.append("# HELP ").append(name).append(' ').append(help).append('\n');
+    out.append("# TYPE ").append(name).append(" histogram\n");
+
+    long long cumulative = 0;
+    for (int i = 0; i <= numBounds; i++)
+    {
+        cumulative += buckets[i];
+        out.append(name).append("_bucket{le=\"");
+        if (i < numBounds)
+        {
+            out.append(QByteArray::number(bounds[i], 'g', 6));
+        }
+        else
+        {
+            out.append("+Inf");
+        }
+        out.append("\"} ").append(QByteArray::number(cumulative)).append('\n');
+    }
+    out.append(name).append("_sum ").append(QByteArray::number(sum, 'f', 6)).append('\n');
+    out.append(name).append("_count ").append(QByteArray::number(count)).append('\n');
+}
+
+MetricsCollector *MetricsCollector::instance()
+{
+    if (!metricsCollector)
+    {
+        metricsCollector = new MetricsCollector();
+    }
+    return metricsCollector;
+}
+
+MetricsCollector::MetricsCollector()
+    : QObject(),
+      extRequests(NUM_EXT_REQUEST_TYPES + 1, 0),
+      extRequestDuration(EXT_REQUEST_BOUNDS, sizeof(EXT_REQUEST_BOUNDS) / sizeof(EXT_REQUEST_BOUNDS[0])),
+      notifications(NUM_NOTIFICATION_TYPES + 1, 0),
+      eventLoopLag(EVENT_LOOP_LAG_BOUNDS, sizeof(EVENT_LOOP_LAG_BOUNDS) / sizeof(EVENT_LOOP_LAG_BOUNDS[0]))
+{
+    megaApi = NULL;
+    metricsServer = NULL;
+    notificationDeliveries = 0;
+    for (int i = 0; i < NUM_DIRECTIONS; i++)
+    {
+        transferBytes[i] = 0;
+        transferSpeed[i] = 0;
+        transfersSucceeded[i] = 0;
+        transfersFailed[i] = 0;
+    }
+
+    connect(EventLoopHeartbeat::instance(), SIGNAL(beat(qint64)), this, SLOT(onHeartbeat(qint64)));
+}
+
+void MetricsCollector::start(MegaApi *megaApi, QString dataPath)
+{
+    if (metricsServer)
+    {
+        return;
+    }
+
+    this->megaApi = megaApi;
+
+#ifdef WIN32
+    socketPath = Utilities::getUserPipeName(QString::fromAscii("MEGAsync.metrics"));
+#else
+    socketPath = dataPath + QDir::separator() + QString::fromAscii("metrics.socket");
+#endif
+
+    QLocalServer::removeServer(socketPath);
+    metricsServer = new QLocalServer(this);
+    if (!Utilities::listenForCurrentUser(metricsServer, socketPath))
+    {
+        MegaApi::log(MegaApi::LOG_LEVEL_WARNING, QString::fromUtf8("Unable to listen for metrics requests on %1: %2")
+                     .arg(socketPath).arg(metricsServer->errorString()).toUtf8().constData());
+    }
+    connect(metricsServer, SIGNAL(newConnection()), this, SLOT(acceptConnection()));
+
+    EventLoopHeartbeat::instance()->start();
+}
+
+void MetricsCollector::stop()
+{
+    if (!metricsServer)
+    {
+        return;
+    }
+
+    EventLoopHeartbeat::instance()->stop();
+
+    qDeleteAll(clients);
+    clients.clear();
+    metricsServer->close();
+    QLocalServer::removeServer(socketPath);
+    delete metricsServer;
+    metricsServer = NULL;
+    megaApi = NULL;
+}
+
+void MetricsCollector::transferUpdated(int type, long long deltaBytes, long long speed)
+{
+    int direction = (type == MegaTransfer::TYPE_UPLOAD) ? DIRECTION_UPLOAD : DIRECTION_DOWNLOAD;
+    transferBytes[direction] += deltaBytes;
+    transferSpeed[direction] = speed;
+}
+
+void MetricsCollector::transferFinished(int type, long long deltaBytes, bool succeeded)
+{
+    int direction = (type == MegaTransfer::TYPE_UPLOAD) ? DIRECTION_UPLOAD : DIRECTION_DOWNLOAD;
+    transferBytes[direction] += deltaBytes;
+    if (succeeded)
+    {
+        transfersSucceeded[direction]++;
+    }
+    else
+    {
+        transfersFailed[direction]++;
+    }
+
+    if (megaApi && !megaApi->getNumPendingDownloads() && !megaApi->getNumPendingUploads())
+    {
+        transferSpeed[DIRECTION_DOWNLOAD] = transferSpeed[DIRECTION_UPLOAD] = 0;
+    }
+}
+
+void MetricsCollector::extRequestProcessed(char type, qint64 nanoseconds)
+{
+    int i = 0;
+    while (i < NUM_EXT_REQUEST_TYPES && EXT_REQUEST_TYPES[i] != type)
+    {
+        i++;
+    }
+    extRequests[i]++;
+    extRequestDuration.observe(nanoseconds / 1e9);
+}
+
+void MetricsCollector::notificationSent(const char *type, int numClients)
+{
+    int i = 0;
+    while (i < NUM_NOTIFICATION_TYPES && qstrcmp(NOTIFICATION_TYPES[i], type))
+    {
+        i++;
+    }
+    notifications[i]++;
+    notificationDeliveries += numClients;
+}
+
+void MetricsCollector::settingsRead()
+{
+    numSettingsReads.ref();
+}
+
+void MetricsCollector::settingsWritten()
+{
+    numSettingsWrites.ref();
+}
+
+QByteArray MetricsCollector::exposition()
+{
+    QByteArray out;
+    out.reserve(8192);
+
+    out.append("# HELP megasync_transfer_bytes_total Bytes transferred.\n"
+               "# TYPE megasync_transfer_bytes_total counter\n");
+    for (int i = 0; i < NUM_DIRECTIONS; i++)
+    {
+        out.append("megasync_transfer_bytes_total{direction=\"").append(DIRECTION_LABELS[i]).append("\"} ")
+           .append(QByteArray::number(transferBytes[i])).append('\n');
+    }
+
+    out.append("# HELP megasync_transfer_speed_bytes Last speed reported by the SDK, in bytes per second.\n"
+               "# TYPE megasync_transfer_speed_bytes gauge\n");
+    for (int i = 0; i < NUM_DIRECTIONS; i++)
+    {
+        out.append("megasync_transfer_speed_bytes{direction=\"").append(DIRECTION_LABELS[i]).append("\"} ")
+           .append(QByteArray::number(transferSpeed[i])).append('\n');
+    }
+
+    out.append("# HELP megasync_transfers_finished_total Finished transfers.\n"
+               "# TYPE megasync_transfers_finished_total counter\n");
+    for (int i = 0; i < NUM_DIRECTIONS; i++)
+    {
+        out.append("megasync_transfers_finished_total{direction=\"").append(DIRECTION_LABELS[i]).append("\",result=\"ok\"} ")
+           .append(QByteArray::number(transfersSucceeded[i])).append('\n');
+        out.append("megasync_transfers_finished_total{direction=\"").append(DIRECTION_LABELS[i]).append("\",result=\"error\"} ")
+           .append(QByteArray::number(transfersFailed[i])).append('\n');
+    }
+
+    if (megaApi)
+    {
+        out.append("# HELP megasync_pending_transfers Transfers queued or in progress.\n"
+                   "# TYPE megasync_pending_transfers gauge\n");
+        out.append("megasync_pending_transfers{direction=\"download\"} ")
+           .append(QByteArray::number(megaApi->getNumPendingDownloads())).append('\n');
+        out.append("megasync_pending_transfers{direction=\"upload\"} ")
+           .append(QByteArray::number(megaApi->getNumPendingUploads())).append('\n');
+    }
+
+    out.append("# HELP megasync_ext_requests_total Requests received from the shell extension.\n"
+               "# TYPE megasync_ext_requests_total counter\n");
+    for (int i = 0; i <= NUM_EXT_REQUEST_TYPES; i++)
+    {
+        out.append("megasync_ext_requests_total{type=\"");
+        if (i < NUM_EXT_REQUEST_TYPES)
+        {
+            out.append(EXT_REQUEST_TYPES[i]);
+        }
+        else
+        {
+            out.append("other");
+        }
+        out.append("\"} ").append(QByteArray::number(extRequests[i])).append('\n');
+    }
+    extRequestDuration.write(out, "megasync_ext_request_duration_seconds", "Time to answer a shell extension request.");
+
+    out.append("# HELP megasync_notifications_total Notifications sent to the file manager extension.\n"
+               "# TYPE megasync_notifications_total counter\n");
+    for (int i = 0; i <= NUM_NOTIFICATION_TYPES; i++)
+    {
+        out.append("megasync_notifications_total{type=\"")
+           .append((i < NUM_NOTIFICATION_TYPES) ? NOTIFICATION_TYPES[i] : "other")
+           .append("\"} ").append(QByteArray::number(notifications[i])).append('\n');
+    }
+    out.append("# HELP megasync_notification_deliveries_total Notifications written to connected clients.\n"
+               "# TYPE megasync_notification_deliveries_total counter\n"
+               "megasync_notification_deliveries_total ").append(QByteArray::number(notificationDeliveries)).append('\n');
+
+    //QAtomicInt has no portable load() in Qt 4
+    out.append("# HELP megasync_settings_reads_total Values read from the settings file.\n"
+               "# TYPE megasync_settings_reads_total counter\n"
+               "megasync_settings_reads_total ")
+       .append(QByteArray::number((uint)numSettingsReads.fetchAndAddRelaxed(0))).append('\n');
+    out.append("# HELP megasync_settings_writes_total Values written to the settings file.\n"
+               "# TYPE megasync_settings_writes_total counter\n"
+               "megasync_settings_writes_total ")
+       .append(QByteArray::number((uint)numSettingsWrites.fetchAndAddRelaxed(0))).append('\n');
+
+    eventLoopLag.write(out, "megasync_event_loop_lag_seconds", "Delay of a periodic timer of the GUI thread.");
+
+    NodeSearchIndex *searchIndex = NodeSearchIndex::instance();
+    out.append("# HELP megasync_search_index_nodes Nodes in the search index.\n"
+               "# TYPE megasync_search_index_nodes gauge\n"
+               "megasync_search_index_nodes ").append(QByteArray::number(searchIndex->numNodes())).append('\n');
+    out.append("# HELP megasync_search_index_memory_bytes Estimated memory used by the search index.\n"
+               "# TYPE megasync_search_index_memory_bytes gauge\n"
+               "megasync_search_index_memory_bytes ").append(QByteArray::number(searchIndex->memoryUsage())).append('\n');
+
+    long long residentMemory = Platform::getResidentMemory();
+    if (residentMemory >= 0)
+    {
+        out.append("# HELP process_resident_memory_bytes Resident memory size in bytes.\n"
+                   "# TYPE process_resident_memory_bytes gauge\n"
+                   "process_resident_memory_bytes ").append(QByteArray::number(residentMemory)).append('\n');
+    }
+    return out;
+}
+
+void MetricsCollector::acceptConnection()
+{
+    while (metricsServer->hasPendingConnections())
+    {
+        QLocalSocket *client = metricsServer->nextPendingConnection();
+        if (!client)
+        {
+            return;
+        }
+
+        connect(client, SIGNAL(readyRead()), this, SLOT(onClientData()));
+        connect(client, SIGNAL(disconnected()), this, SLOT(onClientDisconnected()));
+        clients.append(client);
+    }
+}
+
+void MetricsCollector::onClientData()
+{
+    QLocalSocket *client = qobject_cast<QLocalSocket *>(sender());
+    if (!client || !client->canReadLine())
+    {
+        return;
+    }
+
+    //Only the request line matters. The rest of the request is discarded
+    QByteArray request = client->readLine();
+    client->readAll();
+    disconnect(client, SIGNAL(readyRead()), this, SLOT(onClientData()));
+
+    QByteArray body = exposition();
+    if (request.startsWith("GET "))
+    {
+        client->write("HTTP/1.0 200 OK\r\n"
+                      "Content-Type: text/plain; version=0.0.4\r\n"
+                      "Content-Length: ");
+        client->write(QByteArray::number(body.size()));
+        client->write("\r\n\r\n");
+    }
+    client->write(body);
+    client->flush();
+    client->disconnectFromServer();
+}
+
+void MetricsCollector::onClientDisconnected()
+{
+    QLocalSocket *client = qobject_cast<QLocalSocket *>(sender());
+    if (!client)
+    {
+        return;
+    }
+
+    clients.removeAll(client);
+    client->deleteLater();
+}
+
+void MetricsCollector::onHeartbeat(qint64 lagMs)
+{
+    eventLoopLag.observe(lagMs / 1000.0);
+}
@@ -0,0 +1,92 @@
+#ifndef METRICSCOLLECTOR_H
+#define METRICSCOLLECTOR_H
+
+#include <QObject>
+#include <QString>
+#include <QByteArray>
+#include <QVector>
+#include <QList>
+#include <QAtomicInt>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include "megaapi.h"
+
+// Cumulative histogram with fixed bucket bounds (in seconds)
+class MetricsHistogram
+{
+public:
+    MetricsHistogram(const double *bounds, int numBounds);
+
+    void observe(double value);
+    void write(QByteArray &out, const char *name, const char *help);
+
+private:
+    const double *bounds;
+    int numBounds;
+    QVector<long long> buckets;
+    double sum;
+    long long count;
+};
+
+// Counters and histograms about transfers, IPC, responsiveness and the search
+// index, served in the Prometheus text format on a local socket
+// (metrics.socket in the data folder) that only the current user can connect to. A client can send an
+// HTTP GET (curl --unix-socket) or just any line.
+// Recording a sample is a few additions, so it's always enabled.
+// All methods must be called from the GUI thread, except settingsRead() and
+// settingsWritten().
+class MetricsCollector : public QObject
+{
+    Q_OBJECT
+
+public:
+    static MetricsCollector *instance();
+
+    void start(mega::MegaApi *megaApi, QString dataPath);
+    void stop();
+
+    void transferUpdated(int type, long long deltaBytes, long long speed);
+    void transferFinished(int type, long long deltaBytes, bool succeeded);
+    void extRequestProcessed(char type, qint64 nanoseconds);
+    void notificationSent(const char *type, int numClients);
+    void settingsRead();
+    void settingsWritten();
+
+    QByteArray exposition();
+
+private slots:
+    void acceptConnection();
+    void onClientData();
+    void onClientDisconnected();
+    void onHeartbeat(qint64 lagMs);
+
+private:
+    MetricsCollector();
+
+    enum {
+        DIRECTION_DOWNLOAD = 0,
+        DIRECTION_UPLOAD = 1,
+        NUM_DIRECTIONS = 2
+    };
+
+    static MetricsCollector *metricsCollector;
+
+    mega::MegaApi *megaApi;
+    QLocalServer *metricsServer;
+    QList<QLocalSocket *> clients;
+    QString socketPath;
+
+    long long transferBytes[NUM_DIRECTIONS];
+    long long transferSpeed[NUM_DIRECTIONS];
+    long long transfersSucceeded[NUM_DIRECTIONS];
+    long long transfersFailed[NUM_DIRECTIONS];
+    QVector<long long> extRequests;
+    MetricsHistogram extRequestDuration;
+    QVector<long long> notifications;
+    long long notificationDeliveries;
+    QAtomicInt numSettingsReads;
+    QAtomicInt numSettingsWrites;
+    MetricsHistogram eventLoopLag;
+};
+
+#endif // METRICSCOLLECTOR_H
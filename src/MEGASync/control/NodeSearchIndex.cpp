@@ -0,0 +1,578 @@
+#include "NodeSearchIndex.h"
+#include "Preferences.h"
+
+#include <QtCore>
+#include <algorithm>
+
+#if QT_VERSION >= 0x050000
+#include <QtConcurrent/QtConcurrent>
+#endif
+
+using namespace mega;
+
+NodeSearchIndex *NodeSearchIndex::searchIndex = NULL;
+
+//Rough per node cost of the index (arrays, hash entry and string headers)
+static const int NODE_MEMORY_OVERHEAD = 96;
+static const int POSTING_LIST_OVERHEAD = 48;
+
+static inline quint64 trigramKey(const QChar *c)
+{
+    return ((quint64)c[0].unicode() << 32) | ((quint64)c[1].unicode() << 16) | (quint64)c[2].unicode();
+}
+
+static QVector<quint64> getTrigrams(const QString &key)
+{
+    QVector<quint64> trigrams;
+    const QChar *data = key.constData();
+    for (int i = 0; (i + 3) <= key.size(); i++)
+    {
+        trigrams.append(trigramKey(data + i));
+    }
+    std::sort(trigrams.begin(), trigrams.end());
+    trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+    return trigrams;
+}
+
+//Keys of the first one and two characters of a name. The length is stored
+//above the bits of a trigram so they never collide with them
+static inline quint64 prefixKey(const QString &key, int length)
+{
+    quint64 value = ((quint64)length << 48) | ((quint64)key.at(0).unicode() << 16);
+    if (length > 1)
+    {
+        value |= (quint64)key.at(1).unicode();
+    }
+    return value;
+}
+
+//Trigrams and prefixes of the name of a node
+static QVector<quint64> getIndexKeys(const QString &key)
+{
+    QVector<quint64> indexKeys = getTrigrams(key);
+    for (int length = 1; length <= 2 && length <= key.size(); length++)
+    {
+        indexKeys.append(prefixKey(key, length));
+    }
+    return indexKeys;
+}
+
+struct SearchCandidate
+{
+    int id;
+    int score;
+    int length;
+};
+
+static bool candidateLessThan(const SearchCandidate &a, const SearchCandidate &b)
+{
+    if (a.score != b.score)
+    {
+        return a.score < b.score;
+    }
+    if (a.length != b.length)
+    {
+        return a.length < b.length;
+    }
+    return a.id < b.id;
+}
+
+//Exact matches first, then prefixes, then matches at the start of a word
+static int matchScore(const QString &key, const QString &query)
+{
+    int pos = key.indexOf(query);
+    if (pos < 0)
+    {
+        return -1;
+    }
+
+    if (!pos)
+    {
+        return (key.size() == query.size()) ? 0 : 1;
+    }
+
+    do
+    {
+        if (!key.at(pos - 1).isLetterOrNumber())
+        {
+            return 2;
+        }
+        pos = key.indexOf(query, pos + 1);
+    } while (pos > 0);
+    return 3;
+}
+
+NodeSearchData buildNodeSearchIndex(MegaApi *megaApi, long long maxMemory, QAtomicInt *cancelled)
+{
+    NodeSearchData data;
+    MegaNode *root = megaApi->getRootNode();
+    if (!root)
+    {
+        return data;
+    }
+
+    QList<MegaNode *> pendingFolders;
+    data.addNode(root->getHandle(), INVALID_HANDLE, QString(), root->getType(), maxMemory);
+    pendingFolders.append(root);
+
+    MegaUserList *contacts = megaApi->getContacts();
+    for (int i = 0; i < contacts->size(); i++)
+    {
+        MegaNodeList *folders = megaApi->getInShares(contacts->get(i));
+        for (int j = 0; j < folders->size(); j++)
+        {
+            MegaNode *folder = folders->get(j);
+            data.addNode(folder->getHandle(), INVALID_HANDLE, QString::fromUtf8(folder->getName()),
+                         folder->getType(), maxMemory);
+            pendingFolders.append(folder->copy());
+        }
+        delete folders;
+    }
+    delete contacts;
+
+    while (pendingFolders.size())
+    {
+        MegaNode *folder = pendingFolders.takeFirst();
+        if (!data.capped && !cancelled->fetchAndAddRelaxed(0))
+        {
+            MegaNodeList *children = megaApi->getChildren(folder);
+            for (int i = 0; i < children->size(); i++)
+            {
+                MegaNode *child = children->get(i);
+                if (!data.addNode(child->getHandle(), folder->getHandle(), QString::fromUtf8(child->getName()),
+                                  child->getType(), maxMemory))
+                {
+                    break;
+                }
+
+                if (child->getType() == MegaNode::TYPE_FOLDER)
+                {
+                    pendingFolders.append(child->copy());
+                }
+            }
+            delete children;
+        }
+        delete folder;
+    }
+    return data;
+}
+
+NodeSearchData::NodeSearchData()
+{
+    memory = 0;
+    capped = false;
+}
+
+static inline long long nodeMemoryCost(const QString &name, int numIndexKeys)
+{
+    return NODE_MEMORY_OVERHEAD + 2 * name.size() * sizeof(QChar) + numIndexKeys * sizeof(int);
+}
+
+static inline bool isIndexed(int type)
+{
+    return type == MegaNode::TYPE_FILE || type == MegaNode::TYPE_FOLDER;
+}
+
+//Returns false if the node doesn't fit in the memory limit. In that case,
+//a previous entry of the node is kept
+bool NodeSearchData::addNode(MegaHandle handle, MegaHandle parent, QString name, int type, long long maxMemory)
+{
+    QString key = name.toLower();
+    QVector<quint64> indexKeys;
+    if (isIndexed(type))
+    {
+        indexKeys = getIndexKeys(key);
+    }
+
+    long long cost = nodeMemoryCost(name, indexKeys.size());
+    long long freedMemory = 0;
+    int previousId = ids.value(handle, -1);
+    if (previousId >= 0)
+    {
+        freedMemory = nodeMemoryCost(names[previousId], isIndexed(types[previousId])
+                                     ? getIndexKeys(keys[previousId]).size() : 0);
+    }
+
+    if ((memory - freedMemory + cost) > maxMemory)
+    {
+        capped = true;
+        return false;
+    }
+
+    if (previousId >= 0)
+    {
+        removeNode(handle);
+    }
+
+    int id;
+    if (freeIds.size())
+    {
+        id = freeIds.last();
+        freeIds.remove(freeIds.size() - 1);
+        handles[id] = handle;
+        parents[id] = parent;
+        names[id] = name;
+        keys[id] = key;
+        types[id] = (char)type;
+    }
+    else
+    {
+        id = handles.size();
+        handles.append(handle);
+        parents.append(parent);
+        names.append(name);
+        keys.append(key);
+        types.append((char)type);
+    }
+
+    ids.insert(handle, id);
+    for (int i = 0; i < indexKeys.size(); i++)
+    {
+        QVector<int> &posting = postings[indexKeys[i]];
+        if (posting.isEmpty())
+        {
+            cost += POSTING_LIST_OVERHEAD;
+        }
+
+        if (posting.isEmpty() || posting.last() < id)
+        {
+            posting.append(id);
+        }
+        else
+        {
+            posting.insert(std::lower_bound(posting.begin(), posting.end(), id), id);
+        }
+    }
+    memory += cost;
+    return true;
+}
+
+//The id of the node is kept in the free list to be reused by the next one
+void NodeSearchData::removeNode(MegaHandle handle)
+{
+    int id = ids.value(handle, -1);
+    if (id < 0)
+    {
+        return;
+    }
+
+    ids.remove(handle);
+    QVector<quint64> indexKeys = getIndexKeys(keys[id]);
+    for (int i = 0; i < indexKeys.size(); i++)
+    {
+        QHash<quint64, QVector<int> >::iterator it = postings.find(indexKeys[i]);
+        if (it == postings.end())
+        {
+            continue;
+        }
+
+        QVector<int>::iterator pos = std::lower_bound(it.value().begin(), it.value().end(), id);
+        if (pos != it.value().end() && *pos == id)
+        {
+            it.value().erase(pos);
+            memory -= sizeof(int);
+        }
+
+        if (it.value().isEmpty())
+        {
+            postings.erase(it);
+            memory -= POSTING_LIST_OVERHEAD;
+        }
+    }
+
+    memory -= NODE_MEMORY_OVERHEAD + 2 * names[id].size() * sizeof(QChar);
+    handles[id] = INVALID_HANDLE;
+    parents[id] = INVALID_HANDLE;
+    names[id].clear();
+    keys[id].clear();
+    freeIds.append(id);
+}
+
+bool NodeSearchData::contains(MegaHandle handle, MegaHandle parent, const QString &name)
+{
+    int id = ids.value(handle, -1);
+    return id >= 0 && parents[id] == parent && names[id] == name;
+}
+
+NodeSearchIndex *NodeSearchIndex::instance()
+{
+    if (!searchIndex)
+    {
+        searchIndex = new NodeSearchIndex();
+    }
+    return NodeSearchIndex::searchIndex;
+}
+
+NodeSearchIndex::NodeSearchIndex() : QObject()
+{
+    megaApi = NULL;
+    ready = false;
+    building = false;
+    connect(&buildWatcher, SIGNAL(finished()), this, SLOT(onIndexBuilt()));
+}
+
+void NodeSearchIndex::initialize(MegaApi *megaApi)
+{
+    reset();
+    this->megaApi = megaApi;
+    building = true;
+    cancelled.fetchAndStoreRelaxed(0);
+    buildWatcher.setFuture(QtConcurrent::run(buildNodeSearchIndex, megaApi,
+                                             Preferences::SEARCH_INDEX_MAX_MEMORY, &cancelled));
+}
+
+void NodeSearchIndex::reset()
+{
+    //The build uses the MegaApi object, that could be deleted after this
+    cancelled.fetchAndStoreRelaxed(1);
+    buildWatcher.waitForFinished();
+
+    building = false;
+    ready = false;
+    megaApi = NULL;
+    data = NodeSearchData();
+    qDeleteAll(pendingUpdates);
+    pendingUpdates.clear();
+}
+
+void NodeSearchIndex::nodesUpdated(MegaNodeList *nodes)
+{
+    if (!nodes || (!ready && !building))
+    {
+        return;
+    }
+
+    for (int i = 0; i < nodes->size(); i++)
+    {
+        if (building)
+        {
+            //The build could have already visited these nodes
+            pendingUpdates.append(nodes->get(i)->copy());
+        }
+        else
+        {
+            applyUpdate(nodes->get(i));
+        }
+    }
+}
+
+bool NodeSearchIndex::isReady()
+{
+    return ready;
+}
+
+long long NodeSearchIndex::memoryUsage()
+{
+    return data.memory;
+}
+
+int NodeSearchIndex::numNodes()
+{
+    return data.ids.size();
+}
+
+//Queries with a '/' also filter by the path of the node, i.e. "photos/2015"
+QList<NodeSearchResult> NodeSearchIndex::search(QString query, int maxResults, bool foldersOnly)
+{
+    QList<NodeSearchResult> results;
+    QString key = query.trimmed().toLower();
+    QString pathFilter;
+    int separator = key.lastIndexOf(QLatin1Char('/'));
+    if (separator >= 0)
+    {
+        pathFilter = key.left(separator);
+        key = key.mid(separator + 1);
+    }
+
+    if (!ready || key.isEmpty() || maxResults <= 0)
+    {
+        return results;
+    }
+
+    QVector<SearchCandidate> candidates;
+    QList<int> ids = findCandidates(key);
+    for (int i = 0; i < ids.size(); i++)
+    {
+        int id = ids[i];
+        int type = data.types[id];
+        if (type != MegaNode::TYPE_FOLDER && (foldersOnly || type != MegaNode::TYPE_FILE))
+        {
+            continue;
+        }
+
+        int score = matchScore(data.keys[id], key);
+        if (score < 0)
+        {
+            continue;
+        }
+
+        SearchCandidate candidate;
+        candidate.id = id;
+        candidate.score = score;
+        candidate.length = data.keys[id].size();
+        candidates.append(candidate);
+    }
+
+    //Only the best candidates are sorted, more are sorted if some of them are discarded
+    int sorted = 0;
+    for (int i = 0; i < candidates.size() && results.size() < maxResults; i++)
+    {
+        if (i == sorted)
+        {
+            sorted = qMin(candidates.size(), sorted + maxResults);
+            std::partial_sort(candidates.begin() + i, candidates.begin() + sorted,
+                              candidates.end(), candidateLessThan);
+        }
+
+        int id = candidates[i].id;
+        QString path = getPath(id);
+        if (path.isNull() || (pathFilter.size() && !path.toLower().contains(pathFilter)))
+        {
+            continue;
+        }
+
+        NodeSearchResult result;
+        result.handle = data.handles[id];
+        result.name = data.names[id];
+        result.path = path;
+        result.type = data.types[id];
+        results.append(result);
+    }
+    return results;
+}
+
+void NodeSearchIndex::onIndexBuilt()
+{
+    if (!building)
+    {
+        return;
+    }
+
+    data = buildWatcher.result();
+    building = false;
+    ready = true;
+
+    for (int i = 0; i < pendingUpdates.size(); i++)
+    {
+        applyUpdate(pendingUpdates[i]);
+    }
+    qDeleteAll(pendingUpdates);
+    pendingUpdates.clear();
+
+    MegaApi::log(MegaApi::LOG_LEVEL_INFO, QString::fromUtf8("Search index ready: %1 nodes, %2 MB%3")
+                 .arg(data.ids.size())
+                 .arg(data.memory / 1048576.0, 0, 'f', 1)
+                 .arg(data.capped ? QString::fromUtf8(" (memory limit reached)") : QString()).toUtf8().constData());
+    emit indexReady();
+}
+
+//Nodes moved out of the indexed folders are removed, their children are skipped
+//in the results until they are moved back or removed
+void NodeSearchIndex::applyUpdate(MegaNode *node)
+{
+    if (node->isRemoved())
+    {
+        data.removeNode(node->getHandle());
+        return;
+    }
+
+    MegaNode *parent = megaApi->getParentNode(node);
+    if (!parent)
+    {
+        //Inshares and roots keep their entries until the next build
+        return;
+    }
+
+    MegaHandle parentHandle = parent->getHandle();
+    delete parent;
+
+    QString name = QString::fromUtf8(node->getName());
+    if (!data.ids.contains(parentHandle))
+    {
+        data.removeNode(node->getHandle());
+    }
+    else if (!data.contains(node->getHandle(), parentHandle, name))
+    {
+        data.addNode(node->getHandle(), parentHandle, name, node->getType(), Preferences::SEARCH_INDEX_MAX_MEMORY);
+    }
+}
+
+//Null if the node isn't connected to the cloud drive or to an inshare anymore
+QString NodeSearchIndex::getPath(int id)
+{
+    QStringList parts;
+    while (data.types[id] != MegaNode::TYPE_ROOT)
+    {
+        parts.prepend(data.names[id]);
+        MegaHandle parent = data.parents[id];
+        if (parent == INVALID_HANDLE)
+        {
+            return parts.join(QString::fromUtf8("/"));
+        }
+
+        id = data.ids.value(parent, -1);
+        if (id < 0)
+        {
+            return QString();
+        }
+    }
+    return QString::fromUtf8("/") + parts.join(QString::fromUtf8("/"));
+}
+
+//Queries shorter than a trigram only match the start of the names, so they
+//are answered from the prefix lists instead of scanning all the names
+QList<int> NodeSearchIndex::findCandidates(const QString &key)
+{
+    QList<int> candidates;
+    if (key.size() < 3)
+    {
+        QHash<quint64, QVector<int> >::const_iterator it = data.postings.constFind(prefixKey(key, key.size()));
+        if (it != data.postings.constEnd())
+        {
+            candidates.reserve(it.value().size());
+            for (int i = 0; i < it.value().size(); i++)
+            {
+                candidates.append(it.value()[i]);
+            }
+        }
+        return candidates;
+    }
+
+    QVector<quint64> trigrams = getTrigrams(key);
+    QList<const QVector<int> *> lists;
+    for (int i = 0; i < trigrams.size(); i++)
+    {
+        QHash<quint64, QVector<int> >::const_iterator it = data.postings.constFind(trigrams[i]);
+        if (it == data.postings.constEnd())
+        {
+            return candidates;
+        }
+
+        //Keep the shortest list first
+        if (lists.size() && it.value().size() < lists[0]->size())
+        {
+            lists.prepend(&it.value());
+        }
+        else
+        {
+            lists.append(&it.value());
+        }
+    }
+
+    const QVector<int> &shortest = *lists[0];
+    for (int i = 0; i < shortest.size(); i++)
+    {
+        int id = shortest[i];
+        bool found = true;
+        for (int j = 1; j < lists.size() && found; j++)
+        {
+            found = std::binary_search(lists[j]->begin(), lists[j]->end(), id);
+        }
+
+        if (found)
+        {
+            candidates.append(id);
+        }
+    }
+    return candidates;
+}
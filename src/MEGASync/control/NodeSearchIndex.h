@@ -0,0 +1,91 @@
+#ifndef NODESEARCHINDEX_H
+#define NODESEARCHINDEX_H
+
+#include <QObject>
+#include <QString>
+#include <QList>
+#include <QVector>
+#include <QHash>
+#include <QFutureWatcher>
+#include <QAtomicInt>
+#include "megaapi.h"
+
+struct NodeSearchResult
+{
+    mega::MegaHandle handle;
+    QString name;
+    QString path;
+    int type;
+};
+
+// Names of the nodes of the account and the lists of nodes that contain
+// each trigram (three consecutive lowercase characters) of them or that
+// start with each one and two character prefix.
+// Those lists are sorted by id. Ids of removed nodes are reused
+class NodeSearchData
+{
+public:
+    NodeSearchData();
+
+    bool addNode(mega::MegaHandle handle, mega::MegaHandle parent, QString name, int type, long long maxMemory);
+    void removeNode(mega::MegaHandle handle);
+    bool contains(mega::MegaHandle handle, mega::MegaHandle parent, const QString &name);
+
+    QVector<mega::MegaHandle> handles;
+    QVector<mega::MegaHandle> parents;
+    QVector<QString> names;
+    QVector<QString> keys;
+    QVector<char> types;
+    QHash<mega::MegaHandle, int> ids;
+    QHash<quint64, QVector<int> > postings;
+    QVector<int> freeIds;
+    long long memory;
+    bool capped;
+};
+
+// In-memory search over the names and paths of the cloud drive. The index
+// is built on a worker thread after fetchNodes and kept up to date with
+// the node updates received in the meantime. Memory use is estimated and
+// capped to Preferences::SEARCH_INDEX_MAX_MEMORY.
+// All methods must be called from the GUI thread.
+class NodeSearchIndex : public QObject
+{
+    Q_OBJECT
+
+public:
+    static NodeSearchIndex *instance();
+
+    void initialize(mega::MegaApi *megaApi);
+    void reset();
+    void nodesUpdated(mega::MegaNodeList *nodes);
+
+    bool isReady();
+    long long memoryUsage();
+    int numNodes();
+    QList<NodeSearchResult> search(QString query, int maxResults, bool foldersOnly);
+
+signals:
+    void indexReady();
+
+private slots:
+    void onIndexBuilt();
+
+private:
+    NodeSearchIndex();
+
+    void applyUpdate(mega::MegaNode *node);
+    QString getPath(int id);
+    QList<int> findCandidates(const QString &key);
+
+    static NodeSearchIndex *searchIndex;
+
+    mega::MegaApi *megaApi;
+    NodeSearchData data;
+    QFutureWatcher<NodeSearchData> buildWatcher;
+    QList<mega::MegaNode *> pendingUpdates;
+    QAtomicInt cancelled;
+    bool ready;
+    bool building;
+};
+
+#endif // NODESEARCHINDEX_H
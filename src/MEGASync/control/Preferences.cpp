@@ -31,10 +31,30 @@ const long long Preferences::MIN_UPDATE_STATS_INTERVAL  = 300000;
 const long long Preferences::MIN_UPDATE_NOTIFICATION_INTERVAL_MS    = 172800000;
 const long long Preferences::MIN_REBOOT_INTERVAL_MS                 = 300000;
 const long long Preferences::MIN_EXTERNAL_NODES_WARNING_MS          = 60000;
+const long long Preferences::DEBRIS_FULL_SCAN_INTERVAL_MS           = 86400000;
+const int Preferences::DEBRIS_CHANGE_DELAY_MS                       = 5000;
+const long long Preferences::DEBRIS_PRUNE_INTERVAL_MS               = 3600000;
+const int Preferences::NETWORK_CHANGE_DELAY_MS                      = 2000;
+const int Preferences::STREAMING_CHUNK_SIZE                         = 1048576;
+const long long Preferences::STREAMING_CACHE_MAX_SIZE               = 536870912;
+const int Preferences::STREAMING_PREFETCH_SECONDS                   = 10;
+const int Preferences::STREAMING_MAX_PREFETCH_CHUNKS                = 8;
+const int Preferences::STREAMING_MAX_PENDING_CHUNKS                 = 4;
+const int Preferences::STREAMING_MAX_LOADED_CHUNKS                  = 8;
+const int Preferences::MAX_LINK_INFO_REQUESTS                       = 8;
+const int Preferences::MAX_EXPORT_REQUESTS                          = 8;
+const int Preferences::LINK_EXTRACTION_ASYNC_SIZE                   = 1048576;
+const long long Preferences::SEARCH_INDEX_MAX_MEMORY                = 268435456;
+const int Preferences::MAX_SEARCH_RESULTS                           = 50;
+const long long Preferences::GUEST_API_IDLE_TIMEOUT_MS              = 300000;
+const int Preferences::EVENT_LOOP_HEARTBEAT_INTERVAL_MS             = 250;
+const int Preferences::MAX_STALL_DUMPS                              = 5;
 
 const unsigned int Preferences::UPDATE_INITIAL_DELAY_SECS           = 60;
 const unsigned int Preferences::UPDATE_RETRY_INTERVAL_SECS          = 7200;
 const unsigned int Preferences::UPDATE_TIMEOUT_SECS                 = 600;
+const int Preferences::MAX_UPDATE_DOWNLOADS                         = 3;
+const int Preferences::UPDATE_DOWNLOAD_CHUNK_SIZE                   = 1048576;
 const unsigned int Preferences::MAX_LOGIN_TIME_MS                   = 40000;
 const unsigned int Preferences::PROXY_TEST_TIMEOUT_MS               = 10000;
 const unsigned int Preferences::MAX_IDLE_TIME_MS                    = 600000;
@@ -113,6 +133,7 @@ const char Preferences::UPDATE_PUBLIC_KEY[] = "EACTzXPE8fdMhm6LizLe1FxV2DncybVh2
 const QString Preferences::CRASH_REPORT_URL                 = QString::fromUtf8("http://g.api.mega.co.nz/hb?crashdump");
 const QString Preferences::UPDATE_FOLDER_NAME               = QString::fromAscii("update");
 const QString Preferences::UPDATE_BACKUP_FOLDER_NAME        = QString::fromAscii("backup");
+const QString Preferences::UPDATE_SIGNATURE_CACHE_NAME      = QString::fromAscii("update.cache");
 const QString Preferences::PROXY_TEST_URL                   = QString::fromUtf8("http://eu.static.mega.co.nz/?");
 const QString Preferences::PROXY_TEST_SUBSTRING             = QString::fromUtf8("<title>MEGA</title>");
 const QString Preferences::syncsGroupKey            = QString::fromAscii("Syncs");
@@ -148,6 +169,7 @@ const QString Preferences::upperSizeLimitKey        = QString::fromAscii("upperS
 const QString Preferences::lowerSizeLimitKey        = QString::fromAscii("lowerSizeLimit");
 
 const QString Preferences::lastCustomStreamingAppKey    = QString::fromAscii("lastCustomStreamingApp");
+const QString Preferences::streamingCacheKeyKey     = QString::fromAscii("streamingCacheKey");
 const QString Preferences::transferDownloadMethodKey    = QString::fromAscii("transferDownloadMethod");
 const QString Preferences::transferUploadMethodKey      = QString::fromAscii("transferUploadMethod");
 
@@ -189,6 +211,12 @@ const QString Preferences::lastExecutionTimeKey     = QString::fromAscii("lastEx
 const QString Preferences::excludedSyncNamesKey     = QString::fromAscii("excludedSyncNames");
 const QString Preferences::lastVersionKey           = QString::fromAscii("lastVersion");
 const QString Preferences::lastStatsRequestKey      = QString::fromAscii("lastStatsRequest");
+const QString Preferences::localDebrisSizesKey      = QString::fromAscii("localDebrisSizes");
+const QString Preferences::remoteDebrisSizeKey      = QString::fromAscii("remoteDebrisSize");
+const QString Preferences::lastDebrisScanKey        = QString::fromAscii("lastDebrisScan");
+const QString Preferences::debrisMaxAgeDaysKey      = QString::fromAscii("debrisMaxAgeDays");
+const QString Preferences::debrisMaxSizeMBKey       = QString::fromAscii("debrisMaxSizeMB");
+const QString Preferences::debrisMinFreeSpaceMBKey  = QString::fromAscii("debrisMinFreeSpaceMB");
 const QString Preferences::lastUpdateTimeKey        = QString::fromAscii("lastUpdateTime");
 const QString Preferences::lastUpdateVersionKey     = QString::fromAscii("lastUpdateVersion");
 const QString Preferences::previousCrashesKey       = QString::fromAscii("previousCrashes");
@@ -205,6 +233,9 @@ const QString Preferences::accountCreationTimeKey   = QString::fromAscii("accoun
 const QString Preferences::hasLoggedInKey           = QString::fromAscii("hasLoggedIn");
 const QString Preferences::useHttpsOnlyKey          = QString::fromAscii("useHttpsOnly");
 const QString Preferences::SSLcertificateExceptionKey  = QString::fromAscii("SSLcertificateException");
+const QString Preferences::stallThresholdMsKey      = QString::fromAscii("stallThresholdMs");
+const QString Preferences::stallDumpThresholdMsKey  = QString::fromAscii("stallDumpThresholdMs");
+const QString Preferences::profilerFrequencyHzKey   = QString::fromAscii("profilerFrequencyHz");
 
 const bool Preferences::defaultShowNotifications    = false;
 const bool Preferences::defaultStartOnStartup       = true;
@@ -213,6 +244,12 @@ const bool Preferences::defaultUpperSizeLimit       = false;
 const bool Preferences::defaultLowerSizeLimit       = false;
 const bool Preferences::defaultUseHttpsOnly         = false;
 const bool Preferences::defaultSSLcertificateException = false;
+const int Preferences::defaultDebrisMaxAgeDays      = 0;
+const long long Preferences::defaultDebrisMaxSizeMB = 0;
+const long long Preferences::defaultDebrisMinFreeSpaceMB = 0;
+const int Preferences::defaultStallThresholdMs      = 1000;
+const int Preferences::defaultStallDumpThresholdMs  = 10000;
+const int Preferences::defaultProfilerFrequencyHz   = 99;
 const int  Preferences::defaultUploadLimitKB        = -1;
 const int Preferences::defaultTransferDownloadMethod      = MegaApi::TRANSFER_METHOD_AUTO;
 const int Preferences::defaultTransferUploadMethod        = MegaApi::TRANSFER_METHOD_AUTO;
@@ -1340,6 +1377,24 @@ void Preferences::setLastCustomStreamingApp(const QString &value)
     mutex.unlock();
 }
 
+QString Preferences::streamingCacheKey()
+{
+    mutex.lock();
+    assert(logged());
+    QString value = settings->value(streamingCacheKeyKey).toString();
+    mutex.unlock();
+    return value;
+}
+
+void Preferences::setStreamingCacheKey(QString value)
+{
+    mutex.lock();
+    assert(logged());
+    settings->setValue(streamingCacheKeyKey, value);
+    settings->sync();
+    mutex.unlock();
+}
+
 void Preferences::setLastExecutionTime(qint64 time)
 {
     mutex.lock();
@@ -1439,7 +1494,7 @@ void Preferences::setImportFolder(long long value)
 int Preferences::getNumSyncedFolders()
 {
     mutex.lock();
-    int value = localFolders.length();
+    int value = syncRecords.size();
     mutex.unlock();
     return value;
 }
@@ -1447,13 +1502,13 @@ int Preferences::getNumSyncedFolders()
 QString Preferences::getSyncName(int num)
 {
     mutex.lock();
-    assert(logged() && (syncNames.size()>num));
-    if (num >= syncNames.size())
+    assert(logged() && (syncRecords.size()>num));
+    if (num >= syncRecords.size())
     {
         mutex.unlock();
         return QString();
     }
-    QString value = syncNames.at(num);
+    QString value = syncRecords.at(num).name;
     mutex.unlock();
     return value;
 }
@@ -1461,20 +1516,17 @@ QString Preferences::getSyncName(int num)
 QString Preferences::getLocalFolder(int num)
 {
     mutex.lock();
-    assert(logged() && (localFolders.size()>num));
-    if (num >= localFolders.size())
+    assert(logged() && (syncRecords.size()>num));
+    if (num >= syncRecords.size())
     {
         mutex.unlock();
         return QString();
     }
-
-    QFileInfo fileInfo(localFolders.at(num));
-    QString value = QDir::toNativeSeparators(fileInfo.canonicalFilePath());
-    if (value.isEmpty())
+    if (!syncRecords.at(num).localFolderResolved)
     {
-        value = QDir::toNativeSeparators(localFolders.at(num));
+        resolveLocalFolders();
     }
-
+    QString value = syncRecords.at(num).canonicalLocalFolder;
     mutex.unlock();
     return value;
 }
@@ -1482,13 +1534,13 @@ QString Preferences::getLocalFolder(int num)
 QString Preferences::getMegaFolder(int num)
 {
     mutex.lock();
-    assert(logged() && (megaFolders.size()>num));
-    if (num >= megaFolders.size())
+    assert(logged() && (syncRecords.size()>num));
+    if (num >= syncRecords.size())
     {
         mutex.unlock();
         return QString();
     }
-    QString value = megaFolders.at(num);
+    QString value = syncRecords.at(num).megaFolder;
     mutex.unlock();
     return value;
 }
@@ -1496,13 +1548,13 @@ QString Preferences::getMegaFolder(int num)
 long long Preferences::getLocalFingerprint(int num)
 {
     mutex.lock();
-    assert(logged() && (localFingerprints.size()>num));
-    if (num >= localFingerprints.size())
+    assert(logged() && (syncRecords.size()>num));
+    if (num >= syncRecords.size())
     {
         mutex.unlock();
         return 0;
     }
-    long long value = localFingerprints.at(num);
+    long long value = syncRecords.at(num).localFingerprint;
     mutex.unlock();
     return value;
 }
@@ -1510,12 +1562,12 @@ long long Preferences::getLocalFingerprint(int num)
 void Preferences::setLocalFingerprint(int num, long long fingerprint)
 {
     mutex.lock();
-    if (num >= localFingerprints.size())
+    if (num >= syncRecords.size())
     {
         mutex.unlock();
         return;
     }
-    localFingerprints[num] = fingerprint;
+    syncRecords[num].localFingerprint = fingerprint;
     writeFolders();
     mutex.unlock();
 }
@@ -1523,13 +1575,13 @@ void Preferences::setLocalFingerprint(int num, long long fingerprint)
 MegaHandle Preferences::getMegaFolderHandle(int num)
 {
     mutex.lock();
-    assert(logged() && (megaFolderHandles.size()>num));
-    if (num >= megaFolderHandles.size())
+    assert(logged() && (syncRecords.size()>num));
+    if (num >= syncRecords.size())
     {
         mutex.unlock();
         return mega::INVALID_HANDLE;
     }
-    long long value = megaFolderHandles.at(num);
+    long long value = syncRecords.at(num).megaFolderHandle;
     mutex.unlock();
     return value;
 }
@@ -1537,12 +1589,12 @@ MegaHandle Preferences::getMegaFolderHandle(int num)
 bool Preferences::isFolderActive(int num)
 {
     mutex.lock();
-    if (num >= activeFolders.size())
+    if (num >= syncRecords.size())
     {
         mutex.unlock();
         return false;
     }
-    bool value = activeFolders.at(num);
+    bool value = syncRecords.at(num).active;
     mutex.unlock();
     return value;
 }
@@ -1550,12 +1602,12 @@ bool Preferences::isFolderActive(int num)
 bool Preferences::isTemporaryInactiveFolder(int num)
 {
     mutex.lock();
-    if (num >= temporaryInactiveFolders.size())
+    if (num >= syncRecords.size())
     {
         mutex.unlock();
         return false;
     }
-    bool value = temporaryInactiveFolders.at(num);
+    bool value = syncRecords.at(num).temporaryInactive;
     mutex.unlock();
     return value;
 }
@@ -1563,26 +1615,32 @@ bool Preferences::isTemporaryInactiveFolder(int num)
 void Preferences::setSyncState(int num, bool enabled, bool temporaryDisabled)
 {
     mutex.lock();
-    if (num >= activeFolders.size() || num >= temporaryInactiveFolders.size())
+    if (num >= syncRecords.size())
     {
         mutex.unlock();
         return;
     }
-    activeFolders[num] = enabled;
-    temporaryInactiveFolders[num] = temporaryDisabled;
+    syncRecords[num].active = enabled;
+    syncRecords[num].temporaryInactive = temporaryDisabled;
+    QString localFolder = syncRecords.at(num).localFolder;
+    QString syncName = syncRecords.at(num).name;
     writeFolders();
     mutex.unlock();
 
     if (enabled)
     {
-        Platform::syncFolderAdded(localFolders[num], syncNames[num]);
+        Platform::syncFolderAdded(localFolder, syncName);
     }
 }
 
 QStringList Preferences::getSyncNames()
 {
     mutex.lock();
-    QStringList value = syncNames;
+    QStringList value;
+    for (int i = 0; i < syncRecords.size(); i++)
+    {
+        value.append(syncRecords.at(i).name);
+    }
     mutex.unlock();
     return value;
 }
@@ -1590,7 +1648,11 @@ QStringList Preferences::getSyncNames()
 QStringList Preferences::getMegaFolders()
 {
     mutex.lock();
-    QStringList value = megaFolders;
+    QStringList value;
+    for (int i = 0; i < syncRecords.size(); i++)
+    {
+        value.append(syncRecords.at(i).megaFolder);
+    }
     mutex.unlock();
     return value;
 }
@@ -1598,7 +1660,11 @@ QStringList Preferences::getMegaFolders()
 QStringList Preferences::getLocalFolders()
 {
     mutex.lock();
-    QStringList value = localFolders;
+    QStringList value;
+    for (int i = 0; i < syncRecords.size(); i++)
+    {
+        value.append(syncRecords.at(i).localFolder);
+    }
     mutex.unlock();
     return value;
 }
@@ -1606,7 +1672,37 @@ QStringList Preferences::getLocalFolders()
 QList<long long> Preferences::getMegaFolderHandles()
 {
     mutex.lock();
-    QList<long long> value = megaFolderHandles;
+    QList<long long> value;
+    for (int i = 0; i < syncRecords.size(); i++)
+    {
+        value.append(syncRecords.at(i).megaFolderHandle);
+    }
+    mutex.unlock();
+    return value;
+}
+
+QVector<SyncRecord> Preferences::getSyncRecords(QHash<MegaHandle, QList<int> > *indexesByHandle)
+{
+    mutex.lock();
+    resolveLocalFolders();
+    QVector<SyncRecord> value = syncRecords;
+    if (indexesByHandle)
+    {
+        *indexesByHandle = syncIndexesByHandle;
+    }
+    mutex.unlock();
+    return value;
+}
+
+int Preferences::getSyncIndexByLocalPath(QString localPath)
+{
+    SyncRecord record;
+    record.localFolder = localPath;
+    resolveLocalFolder(record);
+
+    mutex.lock();
+    resolveLocalFolders();
+    int value = syncIndexByLocalPath.value(record.canonicalLocalFolder, -1);
     mutex.unlock();
     return value;
 }
@@ -1630,13 +1726,15 @@ void Preferences::addSyncedFolder(QString localFolder, QString megaFolder, mega:
     syncName.remove(QChar::fromAscii(':')).remove(QDir::separator());
 
     localFolder = QDir::toNativeSeparators(localFolderInfo.canonicalFilePath());
-    syncNames.append(syncName);
-    localFolders.append(localFolder);
-    megaFolders.append(megaFolder);
-    megaFolderHandles.append(megaFolderHandle);
-    activeFolders.append(active);
-    temporaryInactiveFolders.append(false);
-    localFingerprints.append(0);
+    SyncRecord record;
+    record.name = syncName;
+    record.localFolder = localFolder;
+    resolveLocalFolder(record);
+    record.megaFolder = megaFolder;
+    record.megaFolderHandle = megaFolderHandle;
+    record.active = active;
+    syncRecords.append(record);
+    rebuildSyncIndices();
     writeFolders();
     mutex.unlock();
     Platform::syncFolderAdded(localFolder, syncName);
@@ -1645,12 +1743,13 @@ void Preferences::addSyncedFolder(QString localFolder, QString megaFolder, mega:
 void Preferences::setMegaFolderHandle(int num, MegaHandle handle)
 {
     mutex.lock();
-    if (num >= megaFolderHandles.size())
+    if (num >= syncRecords.size())
     {
         mutex.unlock();
         return;
     }
-    megaFolderHandles[num] = handle;
+    syncRecords[num].megaFolderHandle = handle;
+    rebuildSyncIndices();
     writeFolders();
     mutex.unlock();
 }
@@ -1659,13 +1758,8 @@ void Preferences::removeSyncedFolder(int num)
 {
     mutex.lock();
     assert(logged());
-    syncNames.removeAt(num);
-    localFolders.removeAt(num);
-    megaFolders.removeAt(num);
-    megaFolderHandles.removeAt(num);
-    activeFolders.removeAt(num);
-    temporaryInactiveFolders.removeAt(num);
-    localFingerprints.removeAt(num);
+    syncRecords.remove(num);
+    rebuildSyncIndices();
     writeFolders();
     mutex.unlock();
 }
@@ -1675,18 +1769,12 @@ void Preferences::removeAllFolders()
     mutex.lock();
     assert(logged());
 
-    for (int i = 0; i < localFolders.size(); i++)
+    for (int i = 0; i < syncRecords.size(); i++)
     {
-        Platform::syncFolderRemoved(localFolders[i], syncNames[i]);
+        Platform::syncFolderRemoved(syncRecords.at(i).localFolder, syncRecords.at(i).name);
     }
 
-    syncNames.clear();
-    localFolders.clear();
-    megaFolders.clear();
-    megaFolderHandles.clear();
-    activeFolders.clear();
-    temporaryInactiveFolders.clear();
-    localFingerprints.clear();
+    clearFolders();
     writeFolders();
     mutex.unlock();
 }
@@ -1880,13 +1968,7 @@ void Preferences::leaveUser()
     assert(logged());
     settings->endGroup();
 
-    syncNames.clear();
-    localFolders.clear();
-    megaFolders.clear();
-    megaFolderHandles.clear();
-    activeFolders.clear();
-    temporaryInactiveFolders.clear();
-    localFingerprints.clear();
+    clearFolders();
     mutex.unlock();
 }
 
@@ -1900,13 +1982,7 @@ void Preferences::unlink()
     settings->endGroup();
 
     settings->remove(currentAccountKey);
-    syncNames.clear();
-    localFolders.clear();
-    megaFolders.clear();
-    megaFolderHandles.clear();
-    activeFolders.clear();
-    temporaryInactiveFolders.clear();
-    localFingerprints.clear();
+    clearFolders();
     settings->sync();
     mutex.unlock();
     emit stateChanged();
@@ -1960,6 +2036,245 @@ void Preferences::setLastStatsRequest(long long value)
     mutex.unlock();
 }
 
+QStringList Preferences::getLocalDebrisSizes()
+{
+    mutex.lock();
+    assert(logged());
+    QStringList value = settings->value(localDebrisSizesKey).toString().split(QString::fromAscii("\n"), QString::SkipEmptyParts);
+    mutex.unlock();
+    return value;
+}
+
+void Preferences::setLocalDebrisSizes(QStringList sizes)
+{
+    mutex.lock();
+    assert(logged());
+    if (!sizes.size())
+    {
+        settings->remove(localDebrisSizesKey);
+    }
+    else
+    {
+        settings->setValue(localDebrisSizesKey, sizes.join(QString::fromAscii("\n")));
+    }
+    mutex.unlock();
+}
+
+long long Preferences::remoteDebrisSize()
+{
+    mutex.lock();
+    assert(logged());
+    long long value = settings->value(remoteDebrisSizeKey, -1).toLongLong();
+    mutex.unlock();
+    return value;
+}
+
+void Preferences::setRemoteDebrisSize(long long value)
+{
+    mutex.lock();
+    assert(logged());
+    settings->setValue(remoteDebrisSizeKey, value);
+    mutex.unlock();
+}
+
+long long Preferences::lastDebrisScan()
+{
+    mutex.lock();
+    assert(logged());
+    long long value = settings->value(lastDebrisScanKey, 0).toLongLong();
+    mutex.unlock();
+    return value;
+}
+
+void Preferences::setLastDebrisScan(long long value)
+{
+    mutex.lock();
+    assert(logged());
+    settings->setValue(lastDebrisScanKey, value);
+    settings->sync();
+    mutex.unlock();
+}
+
+int Preferences::debrisMaxAgeDays()
+{
+    mutex.lock();
+    assert(logged());
+    int value = settings->value(debrisMaxAgeDaysKey, defaultDebrisMaxAgeDays).toInt();
+    mutex.unlock();
+    return value;
+}
+
+void Preferences::setDebrisMaxAgeDays(int value)
+{
+    mutex.lock();
+    assert(logged());
+    settings->setValue(debrisMaxAgeDaysKey, value);
+    settings->sync();
+    mutex.unlock();
+}
+
+long long Preferences::debrisMaxSizeMB()
+{
+    mutex.lock();
+    assert(logged());
+    long long value = settings->value(debrisMaxSizeMBKey, defaultDebrisMaxSizeMB).toLongLong();
+    mutex.unlock();
+    return value;
+}
+
+void Preferences::setDebrisMaxSizeMB(long long value)
+{
+    mutex.lock();
+    assert(logged());
+    settings->setValue(debrisMaxSizeMBKey, value);
+    settings->sync();
+    mutex.unlock();
+}
+
+long long Preferences::debrisMinFreeSpaceMB()
+{
+    mutex.lock();
+    assert(logged());
+    long long value = settings->value(debrisMinFreeSpaceMBKey, defaultDebrisMinFreeSpaceMB).toLongLong();
+    mutex.unlock();
+    return value;
+}
+
+void Preferences::setDebrisMinFreeSpaceMB(long long value)
+{
+    mutex.lock();
+    assert(logged());
+    settings->setValue(debrisMinFreeSpaceMBKey, value);
+    settings->sync();
+    mutex.unlock();
+}
+
+int Preferences::stallThresholdMs()
+{
+    mutex.lock();
+    QString currentAccount;
+    if (logged())
+    {
+        settings->endGroup();
+        currentAccount = settings->value(currentAccountKey).toString();
+    }
+
+    int value = settings->value(stallThresholdMsKey, defaultStallThresholdMs).toInt();
+
+    if (!currentAccount.isEmpty())
+    {
+        settings->beginGroup(currentAccount);
+    }
+
+    mutex.unlock();
+    return value;
+}
+
+void Preferences::setStallThresholdMs(int value)
+{
+    mutex.lock();
+    QString currentAccount;
+    if (logged())
+    {
+        settings->endGroup();
+        currentAccount = settings->value(currentAccountKey).toString();
+    }
+
+    settings->setValue(stallThresholdMsKey, value);
+
+    if (!currentAccount.isEmpty())
+    {
+        settings->beginGroup(currentAccount);
+    }
+
+    settings->sync();
+    mutex.unlock();
+}
+
+int Preferences::stallDumpThresholdMs()
+{
+    mutex.lock();
+    QString currentAccount;
+    if (logged())
+    {
+        settings->endGroup();
+        currentAccount = settings->value(currentAccountKey).toString();
+    }
+
+    int value = settings->value(stallDumpThresholdMsKey, defaultStallDumpThresholdMs).toInt();
+
+    if (!currentAccount.isEmpty())
+    {
+        settings->beginGroup(currentAccount);
+    }
+
+    mutex.unlock();
+    return value;
+}
+
+void Preferences::setStallDumpThresholdMs(int value)
+{
+    mutex.lock();
+    QString currentAccount;
+    if (logged())
+    {
+        settings->endGroup();
+        currentAccount = settings->value(currentAccountKey).toString();
+    }
+
+    settings->setValue(stallDumpThresholdMsKey, value);
+
+    if (!currentAccount.isEmpty())
+    {
+        settings->beginGroup(currentAccount);
+    }
+
+    settings->sync();
+    mutex.unlock();
+}
+
+int Preferences::profilerFrequencyHz()
+{
+    mutex.lock();
+    QString currentAccount;
+    if (logged())
+    {
+        settings->endGroup();
+        currentAccount = settings->value(currentAccountKey).toString();
+    }
+
+    int value = settings->value(profilerFrequencyHzKey, defaultProfilerFrequencyHz).toInt();
+
+    if (!currentAccount.isEmpty())
+    {
+        settings->beginGroup(currentAccount);
+    }
+
+    mutex.unlock();
+    return value;
+}
+
+void Preferences::setProfilerFrequencyHz(int value)
+{
+    mutex.lock();
+    QString currentAccount;
+    if (logged())
+    {
+        settings->endGroup();
+        currentAccount = settings->value(currentAccountKey).toString();
+    }
+
+    settings->setValue(profilerFrequencyHzKey, value);
+
+    if (!currentAccount.isEmpty())
+    {
+        settings->beginGroup(currentAccount);
+    }
+
+    settings->sync();
+    mutex.unlock();
+}
+
 bool Preferences::overlayIconsDisabled()
 {
     mutex.lock();
@@ -2055,13 +2370,7 @@ void Preferences::logout()
     {
         settings->endGroup();
     }
-    syncNames.clear();
-    localFolders.clear();
-    megaFolders.clear();
-    megaFolderHandles.clear();
-    activeFolders.clear();
-    temporaryInactiveFolders.clear();
-    localFingerprints.clear();
+    clearFolders();
     mutex.unlock();
 }
 
@@ -2104,31 +2413,30 @@ void Preferences::readFolders()
 {
     mutex.lock();
     assert(logged());
-    syncNames.clear();
-    localFolders.clear();
-    megaFolders.clear();
-    megaFolderHandles.clear();
-    activeFolders.clear();
-    temporaryInactiveFolders.clear();
-    localFingerprints.clear();
+    clearFolders();
 
     settings->beginGroup(syncsGroupKey);
     int numSyncs = settings->numChildGroups();
+    syncRecords.reserve(numSyncs);
     for (int i = 0; i < numSyncs; i++)
     {
         settings->beginGroup(QString::number(i));
 
-        syncNames.append(settings->value(syncNameKey).toString());
-        localFolders.append(settings->value(localFolderKey).toString());
-        megaFolders.append(settings->value(megaFolderKey).toString());
-        megaFolderHandles.append(settings->value(megaFolderHandleKey).toLongLong());
-        activeFolders.append(settings->value(folderActiveKey, true).toBool());
-        temporaryInactiveFolders.append(settings->value(temporaryInactiveKey, false).toBool());
-        localFingerprints.append(settings->value(localFingerprintKey, 0).toLongLong());
+        SyncRecord record;
+        record.name = settings->value(syncNameKey).toString();
+        record.localFolder = settings->value(localFolderKey).toString();
+        resolveLocalFolder(record);
+        record.megaFolder = settings->value(megaFolderKey).toString();
+        record.megaFolderHandle = settings->value(megaFolderHandleKey).toLongLong();
+        record.active = settings->value(folderActiveKey, true).toBool();
+        record.temporaryInactive = settings->value(temporaryInactiveKey, false).toBool();
+        record.localFingerprint = settings->value(localFingerprintKey, 0).toLongLong();
+        syncRecords.append(record);
 
         settings->endGroup();
     }
     settings->endGroup();
+    rebuildSyncIndices();
     mutex.unlock();
 }
 
@@ -2140,17 +2448,18 @@ void Preferences::writeFolders()
     settings->beginGroup(syncsGroupKey);
 
     settings->remove(QString::fromAscii(""));
-    for (int i = 0; i < localFolders.size(); i++)
+    for (int i = 0; i < syncRecords.size(); i++)
     {
+        const SyncRecord &record = syncRecords.at(i);
         settings->beginGroup(QString::number(i));
 
-        settings->setValue(syncNameKey, syncNames[i]);
-        settings->setValue(localFolderKey, localFolders[i]);
-        settings->setValue(megaFolderKey, megaFolders[i]);
-        settings->setValue(megaFolderHandleKey, megaFolderHandles[i]);
-        settings->setValue(folderActiveKey, activeFolders[i]);
-        settings->setValue(temporaryInactiveKey,temporaryInactiveFolders[i]);
-        settings->setValue(localFingerprintKey, localFingerprints[i]);
+        settings->setValue(syncNameKey, record.name);
+        settings->setValue(localFolderKey, record.localFolder);
+        settings->setValue(megaFolderKey, record.megaFolder);
+        settings->setValue(megaFolderHandleKey, record.megaFolderHandle);
+        settings->setValue(folderActiveKey, record.active);
+        settings->setValue(temporaryInactiveKey, record.temporaryInactive);
+        settings->setValue(localFingerprintKey, record.localFingerprint);
 
         settings->endGroup();
     }
@@ -2159,3 +2468,65 @@ void Preferences::writeFolders()
     settings->sync();
     mutex.unlock();
 }
+
+void Preferences::clearFolders()
+{
+    mutex.lock();
+    syncRecords.clear();
+    syncIndexesByHandle.clear();
+    syncIndexByLocalPath.clear();
+    mutex.unlock();
+}
+
+void Preferences::rebuildSyncIndices()
+{
+    mutex.lock();
+    syncIndexesByHandle.clear();
+    syncIndexByLocalPath.clear();
+    for (int i = 0; i < syncRecords.size(); i++)
+    {
+        //Several synced folders can have the same remote folder
+        syncIndexesByHandle[syncRecords.at(i).megaFolderHandle].append(i);
+        syncIndexByLocalPath.insert(syncRecords.at(i).canonicalLocalFolder, i);
+    }
+    mutex.unlock();
+}
+
+void Preferences::resolveLocalFolders()
+{
+    mutex.lock();
+    bool changed = false;
+    for (int i = 0; i < syncRecords.size(); i++)
+    {
+        if (syncRecords.at(i).localFolderResolved)
+        {
+            continue;
+        }
+
+        //The local folder didn't exist when it was loaded, check it again
+        QString previousFolder = syncRecords.at(i).canonicalLocalFolder;
+        resolveLocalFolder(syncRecords[i]);
+        if (syncRecords.at(i).canonicalLocalFolder != previousFolder)
+        {
+            changed = true;
+        }
+    }
+
+    if (changed)
+    {
+        rebuildSyncIndices();
+    }
+    mutex.unlock();
+}
+
+void Preferences::resolveLocalFolder(SyncRecord &record)
+{
+    QFileInfo fileInfo(record.localFolder);
+    QString value = QDir::toNativeSeparators(fileInfo.canonicalFilePath());
+    record.localFolderResolved = !value.isEmpty();
+    if (value.isEmpty())
+    {
+        value = QDir::toNativeSeparators(record.localFolder);
+    }
+    record.canonicalLocalFolder = value;
+}
@@ -6,12 +6,30 @@
 #include <QLocale>
 #include <QStringList>
 #include <QMutex>
+#include <QVector>
+#include <QHash>
 
 #include "control/EncryptedSettings.h"
 #include "megaapi.h"
 
 Q_DECLARE_METATYPE(QList<long long>)
 
+struct SyncRecord
+{
+    SyncRecord() : megaFolderHandle(mega::INVALID_HANDLE), localFingerprint(0), active(true), temporaryInactive(false), localFolderResolved(false) {}
+
+    QString name;
+    QString localFolder;
+    QString canonicalLocalFolder;
+    QString megaFolder;
+    mega::MegaHandle megaFolderHandle;
+    long long localFingerprint;
+    bool active;
+    bool temporaryInactive;
+    //False while the local folder couldn't be resolved (canonicalLocalFolder holds the stored path)
+    bool localFolderResolved;
+};
+
 class Preferences : public QObject
 {
     Q_OBJECT
@@ -151,6 +169,8 @@ public:
     void setFirstWebDownloadDone(bool value = true);
     QString lastCustomStreamingApp();
     void setLastCustomStreamingApp(const QString &value);
+    QString streamingCacheKey();
+    void setStreamingCacheKey(QString value);
 
     int transferDownloadMethod();
     void setTransferDownloadMethod(int value);
@@ -185,6 +205,12 @@ public:
     QStringList getLocalFolders();
     QList<long long> getMegaFolderHandles();
 
+    //Copy of all the synced folders taken with a single lock (implicitly shared),
+    //optionally with the indexes of the synced folders of each remote handle
+    QVector<SyncRecord> getSyncRecords(QHash<mega::MegaHandle, QList<int> > *indexesByHandle = NULL);
+    //Index of the synced folder with the given local path or -1
+    int getSyncIndexByLocalPath(QString localPath);
+
     void addSyncedFolder(QString localFolder, QString megaFolder, mega::MegaHandle megaFolderHandle, QString syncName = QString(), bool active = true);
     void setMegaFolderHandle(int num, mega::MegaHandle handle);
     void removeSyncedFolder(int num);
@@ -213,6 +239,25 @@ public:
     long long lastStatsRequest();
     void setLastStatsRequest(long long value);
 
+    QStringList getLocalDebrisSizes();
+    void setLocalDebrisSizes(QStringList sizes);
+    long long remoteDebrisSize();
+    void setRemoteDebrisSize(long long value);
+    long long lastDebrisScan();
+    void setLastDebrisScan(long long value);
+    int debrisMaxAgeDays();
+    void setDebrisMaxAgeDays(int value);
+    long long debrisMaxSizeMB();
+    void setDebrisMaxSizeMB(long long value);
+    long long debrisMinFreeSpaceMB();
+    void setDebrisMinFreeSpaceMB(long long value);
+    int stallThresholdMs();
+    void setStallThresholdMs(int value);
+    int stallDumpThresholdMs();
+    void setStallDumpThresholdMs(int value);
+    int profilerFrequencyHz();
+    void setProfilerFrequencyHz(int value);
+
     bool overlayIconsDisabled();
     void disableOverlayIcons(bool value);
     bool error();
@@ -253,11 +298,14 @@ public:
     static const unsigned int UPDATE_INITIAL_DELAY_SECS;
     static const unsigned int UPDATE_RETRY_INTERVAL_SECS;
     static const unsigned int UPDATE_TIMEOUT_SECS;
+    static const int MAX_UPDATE_DOWNLOADS;
+    static const int UPDATE_DOWNLOAD_CHUNK_SIZE;
     static const unsigned int MAX_LOGIN_TIME_MS;
     static const QString UPDATE_CHECK_URL;
     static const QString CRASH_REPORT_URL;
     static const QString UPDATE_FOLDER_NAME;
     static const QString UPDATE_BACKUP_FOLDER_NAME;
+    static const QString UPDATE_SIGNATURE_CACHE_NAME;
     static const QString PROXY_TEST_URL;
     static const QString PROXY_TEST_SUBSTRING;
     static const unsigned int PROXY_TEST_TIMEOUT_MS;
@@ -265,6 +313,24 @@ public:
     static const char UPDATE_PUBLIC_KEY[];
     static const long long MIN_REBOOT_INTERVAL_MS;
     static const long long MIN_EXTERNAL_NODES_WARNING_MS;
+    static const long long DEBRIS_FULL_SCAN_INTERVAL_MS;
+    static const int DEBRIS_CHANGE_DELAY_MS;
+    static const long long DEBRIS_PRUNE_INTERVAL_MS;
+    static const int NETWORK_CHANGE_DELAY_MS;
+    static const int STREAMING_CHUNK_SIZE;
+    static const long long STREAMING_CACHE_MAX_SIZE;
+    static const int STREAMING_PREFETCH_SECONDS;
+    static const int STREAMING_MAX_PREFETCH_CHUNKS;
+    static const int STREAMING_MAX_PENDING_CHUNKS;
+    static const int STREAMING_MAX_LOADED_CHUNKS;
+    static const int MAX_LINK_INFO_REQUESTS;
+    static const int MAX_EXPORT_REQUESTS;
+    static const int LINK_EXTRACTION_ASYNC_SIZE;
+    static const long long SEARCH_INDEX_MAX_MEMORY;
+    static const int MAX_SEARCH_RESULTS;
+    static const long long GUEST_API_IDLE_TIMEOUT_MS;
+    static const int EVENT_LOOP_HEARTBEAT_INTERVAL_MS;
+    static const int MAX_STALL_DUMPS;
     static const char CLIENT_KEY[];
     static const char USER_AGENT[];
     static const int VERSION_CODE;
@@ -287,15 +353,15 @@ protected:
     void loadExcludedSyncNames();
     void readFolders();
     void writeFolders();
+    void clearFolders();
+    void rebuildSyncIndices();
+    void resolveLocalFolders();
+    static void resolveLocalFolder(SyncRecord &record);
 
     EncryptedSettings *settings;
-    QStringList syncNames;
-    QStringList megaFolders;
-    QStringList localFolders;
-    QList<long long> megaFolderHandles;
-    QList<long long> localFingerprints;
-    QList<bool> activeFolders;
-    QList<bool> temporaryInactiveFolders;
+    QVector<SyncRecord> syncRecords;
+    QHash<mega::MegaHandle, QList<int> > syncIndexesByHandle;
+    QHash<QString, int> syncIndexByLocalPath;
     QStringList excludedSyncNames;
     bool errorFlag;
 
@@ -366,6 +432,12 @@ protected:
     static const QString lastVersionKey;
     static const QString isCrashedKey;
     static const QString lastStatsRequestKey;
+    static const QString localDebrisSizesKey;
+    static const QString remoteDebrisSizeKey;
+    static const QString lastDebrisScanKey;
+    static const QString debrisMaxAgeDaysKey;
+    static const QString debrisMaxSizeMBKey;
+    static const QString debrisMinFreeSpaceMBKey;
     static const QString wasPausedKey;
     static const QString lastUpdateTimeKey;
     static const QString lastUpdateVersionKey;
@@ -384,8 +456,12 @@ protected:
     static const QString transferDownloadMethodKey;
     static const QString transferUploadMethodKey;
     static const QString lastCustomStreamingAppKey;
+    static const QString streamingCacheKeyKey;
     static const QString useHttpsOnlyKey;
     static const QString SSLcertificateExceptionKey;
+    static const QString stallThresholdMsKey;
+    static const QString stallDumpThresholdMsKey;
+    static const QString profilerFrequencyHzKey;
 
     static const bool defaultShowNotifications;
     static const bool defaultStartOnStartup;
@@ -410,6 +486,12 @@ protected:
     static const int defaultFilePermissions;
     static const bool defaultUseHttpsOnly;
     static const bool defaultSSLcertificateException;
+    static const int defaultDebrisMaxAgeDays;
+    static const long long defaultDebrisMaxSizeMB;
+    static const long long defaultDebrisMinFreeSpaceMB;
+    static const int defaultStallThresholdMs;
+    static const int defaultStallDumpThresholdMs;
+    static const int defaultProfilerFrequencyHz;
 };
 
 #endif // PREFERENCES_H
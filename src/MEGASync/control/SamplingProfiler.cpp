@@ -0,0 +1,269 @@
+#include "SamplingProfiler.h"
+#include "megaapi.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QMap>
+#include <QStringList>
+#include <QTextStream>
+
+#ifndef WIN32
+#include <signal.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <execinfo.h>
+#include <dlfcn.h>
+#include <cxxabi.h>
+#include <sys/time.h>
+#include <stdlib.h>
+#include <string.h>
+#endif
+
+using namespace mega;
+
+SamplingProfiler *SamplingProfiler::profiler = NULL;
+
+#ifndef WIN32
+static pthread_t gui_thread;
+static QAtomicInt profiler_enabled;
+static QAtomicInt active_handlers;
+
+//The first two frames are this handler and the signal trampoline
+static void profile_handler(int)
+{
+    active_handlers.ref();
+    if (profiler_enabled.fetchAndAddRelaxed(0))
+    {
+        int savedErrno = errno;
+        void *frames[SamplingProfiler::MAX_STACK_DEPTH + 2];
+        int depth = backtrace(frames, SamplingProfiler::MAX_STACK_DEPTH + 2);
+        if (depth > 2)
+        {
+            SamplingProfiler::instance()->addSample(frames + 2, depth - 2, pthread_equal(pthread_self(), gui_thread));
+        }
+        errno = savedErrno;
+    }
+    active_handlers.deref();
+}
+#endif
+
+SamplingProfiler *SamplingProfiler::instance()
+{
+    if (!profiler)
+    {
+        profiler = new SamplingProfiler();
+    }
+    return profiler;
+}
+
+SamplingProfiler::SamplingProfiler()
+{
+    stacks = NULL;
+    running = false;
+}
+
+bool SamplingProfiler::isRunning()
+{
+    return running;
+}
+
+bool SamplingProfiler::start(int frequencyHz)
+{
+#ifdef WIN32
+    Q_UNUSED(frequencyHz);
+    return false;
+#else
+    if (running || frequencyHz <= 0)
+    {
+        return false;
+    }
+
+    if (!stacks)
+    {
+        stacks = new StackEntry[MAX_STACKS];
+    }
+
+    //The first call to backtrace() loads libgcc, it can't be done in the signal handler
+    void *frames[1];
+    backtrace(frames, 1);
+
+    gui_thread = pthread_self();
+    numSamples.fetchAndStoreRelaxed(0);
+    numDropped.fetchAndStoreRelaxed(0);
+    profiler_enabled.fetchAndStoreRelaxed(1);
+
+    struct sigaction action;
+    action.sa_handler = profile_handler;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    sigaction(SIGPROF, &action, NULL);
+
+    int intervalUs = 1000000 / frequencyHz;
+    struct itimerval timer;
+    timer.it_interval.tv_sec = intervalUs / 1000000;
+    timer.it_interval.tv_usec = intervalUs % 1000000;
+    timer.it_value = timer.it_interval;
+    if (setitimer(ITIMER_PROF, &timer, NULL))
+    {
+        profiler_enabled.fetchAndStoreRelaxed(0);
+        signal(SIGPROF, SIG_IGN);
+        return false;
+    }
+
+    running = true;
+    MegaApi::log(MegaApi::LOG_LEVEL_INFO, QString::fromUtf8("Sampling profiler started at %1 Hz")
+                 .arg(frequencyHz).toUtf8().constData());
+    return true;
+#endif
+}
+
+bool SamplingProfiler::stop(QString outputPath)
+{
+#ifdef WIN32
+    Q_UNUSED(outputPath);
+    return false;
+#else
+    if (!running)
+    {
+        return false;
+    }
+    running = false;
+
+    struct itimerval timer;
+    timerclear(&timer.it_interval);
+    timerclear(&timer.it_value);
+    setitimer(ITIMER_PROF, &timer, NULL);
+    profiler_enabled.fetchAndStoreRelaxed(0);
+    signal(SIGPROF, SIG_IGN);
+
+    //Wait for handlers that could still be running in other threads
+    usleep(10000);
+    while (active_handlers.fetchAndAddRelaxed(0))
+    {
+        usleep(1000);
+    }
+
+    //Slots with the same stack can be repeated if two threads added it at the same time
+    QMap<QString, long long> folded;
+    QHash<void *, QString> symbols;
+    for (int i = 0; i < MAX_STACKS; i++)
+    {
+        StackEntry &entry = stacks[i];
+        if (entry.state.fetchAndAddRelaxed(0) == 2)
+        {
+            QStringList frames;
+            frames.append(entry.guiThread ? QString::fromUtf8("[gui]") : QString::fromUtf8("[worker]"));
+            for (int j = entry.depth - 1; j >= 0; j--)
+            {
+                void *address = entry.frames[j];
+                QHash<void *, QString>::iterator it = symbols.find(address);
+                if (it == symbols.end())
+                {
+                    it = symbols.insert(address, symbolize(address));
+                }
+                frames.append(it.value());
+            }
+            folded[frames.join(QString::fromUtf8(";"))] += entry.count.fetchAndAddRelaxed(0);
+        }
+        entry.state.fetchAndStoreRelaxed(0);
+        entry.count.fetchAndStoreRelaxed(0);
+    }
+
+    int samples = numSamples.fetchAndAddRelaxed(0);
+    int dropped = numDropped.fetchAndAddRelaxed(0);
+    MegaApi::log(MegaApi::LOG_LEVEL_INFO, QString::fromUtf8("Sampling profiler stopped. Samples: %1  Dropped: %2  Stacks: %3")
+                 .arg(samples).arg(dropped).arg(folded.size()).toUtf8().constData());
+
+    QFile file(outputPath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+    {
+        MegaApi::log(MegaApi::LOG_LEVEL_ERROR, QString::fromUtf8("Unable to write the profile to %1")
+                     .arg(outputPath).toUtf8().constData());
+        return false;
+    }
+
+    QTextStream out(&file);
+    out.setCodec("UTF-8");
+    for (QMap<QString, long long>::const_iterator it = folded.begin(); it != folded.end(); ++it)
+    {
+        out << it.key() << " " << it.value() << "\n";
+    }
+    return true;
+#endif
+}
+
+//Lookups and insertions use open addressing. A slot is claimed by changing
+//its state from 0 to 1 and becomes visible when the stack is stored (state 2)
+void SamplingProfiler::addSample(void **frames, int depth, bool guiThread)
+{
+    numSamples.ref();
+
+    //FNV-1a
+    unsigned int hash = 2166136261u ^ (guiThread ? 1 : 0);
+    for (int i = 0; i < depth; i++)
+    {
+        hash = (hash ^ (unsigned int)((quintptr)frames[i] >> 2)) * 16777619u;
+    }
+
+    for (int probe = 0; probe < MAX_STACKS; probe++)
+    {
+        StackEntry &entry = stacks[(hash + probe) % MAX_STACKS];
+        int state = entry.state.fetchAndAddRelaxed(0);
+        if (state == 2)
+        {
+            if (entry.hash == hash && entry.depth == depth && entry.guiThread == (int)guiThread
+                    && !memcmp(entry.frames, frames, depth * sizeof(void *)))
+            {
+                entry.count.ref();
+                return;
+            }
+            continue;
+        }
+
+        if (state == 0 && entry.state.testAndSetAcquire(0, 1))
+        {
+            entry.hash = hash;
+            entry.depth = depth;
+            entry.guiThread = guiThread;
+            memcpy(entry.frames, frames, depth * sizeof(void *));
+            entry.count.fetchAndStoreRelaxed(1);
+            entry.state.fetchAndStoreRelease(2);
+            return;
+        }
+    }
+    numDropped.ref();
+}
+
+//Function name when it's exported, otherwise module+offset to be resolved offline
+QString SamplingProfiler::symbolize(void *address)
+{
+#ifdef WIN32
+    return QString::fromUtf8("0x%1").arg((quintptr)address, 0, 16);
+#else
+    Dl_info info;
+    if (!dladdr(address, &info) || !info.dli_fname)
+    {
+        return QString::fromUtf8("0x%1").arg((quintptr)address, 0, 16);
+    }
+
+    QString name;
+    if (info.dli_sname)
+    {
+        int status = -1;
+        char *demangled = abi::__cxa_demangle(info.dli_sname, NULL, NULL, &status);
+        name = QString::fromUtf8((status == 0 && demangled) ? demangled : info.dli_sname);
+        free(demangled);
+    }
+    else
+    {
+        name = QString::fromUtf8("%1+0x%2").arg(QFileInfo(QString::fromUtf8(info.dli_fname)).fileName())
+                .arg((quintptr)address - (quintptr)info.dli_fbase, 0, 16);
+    }
+
+    //Semicolons separate frames in the folded format
+    name.replace(QChar::fromAscii(';'), QChar::fromAscii(':'));
+    return name;
+#endif
+}
@@ -0,0 +1,57 @@
+#ifndef SAMPLINGPROFILER_H
+#define SAMPLINGPROFILER_H
+
+#include <QString>
+#include <QAtomicInt>
+
+// Opt-in CPU profiler for machines where external profilers aren't available.
+// A profiling timer (SIGPROF) interrupts the thread that is using the CPU at
+// the configured frequency, its stack is captured with backtrace() and added
+// to a fixed-size table that only uses atomic operations, so it's safe inside
+// the signal handler. Stacks are labelled with the thread that was running
+// (the GUI thread or any other thread, like the ones that run the SDK
+// callbacks). When the profiler is stopped, the table is symbolized and
+// written in the folded format of flamegraph.pl.
+// Not available on Windows.
+class SamplingProfiler
+{
+public:
+    static SamplingProfiler *instance();
+
+    // Must be called from the GUI thread
+    bool start(int frequencyHz);
+    bool stop(QString outputPath);
+    bool isRunning();
+
+    enum {
+        MAX_STACK_DEPTH = 64,
+        MAX_STACKS = 4096
+    };
+
+    struct StackEntry
+    {
+        QAtomicInt state;
+        QAtomicInt count;
+        unsigned int hash;
+        int guiThread;
+        int depth;
+        void *frames[MAX_STACK_DEPTH];
+    };
+
+    // Called from the signal handler
+    void addSample(void **frames, int depth, bool guiThread);
+
+private:
+    SamplingProfiler();
+
+    QString symbolize(void *address);
+
+    static SamplingProfiler *profiler;
+
+    StackEntry *stacks;
+    QAtomicInt numSamples;
+    QAtomicInt numDropped;
+    bool running;
+};
+
+#endif // SAMPLINGPROFILER_H
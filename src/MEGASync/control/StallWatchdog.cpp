@@ -0,0 +1,153 @@
+#include "StallWatchdog.h"
+#include "CrashHandler.h"
+#include "EventLoopHeartbeat.h"
+#include "Preferences.h"
+#include "megaapi.h"
+
+#include <QElapsedTimer>
+
+using namespace mega;
+
+StallWatchdog *StallWatchdog::watchdog = NULL;
+
+StallWatchdog *StallWatchdog::instance()
+{
+    if (!watchdog)
+    {
+        watchdog = new StallWatchdog();
+    }
+    return watchdog;
+}
+
+StallWatchdog::StallWatchdog() : QThread()
+{
+    thresholdMs = 0;
+    dumpThresholdMs = 0;
+    numStalls = 0;
+    numDumps = 0;
+    longestStallMs = 0;
+    totalStallMs = 0;
+}
+
+void StallWatchdog::startMonitoring(int thresholdMs, int dumpThresholdMs)
+{
+    if (isRunning() || thresholdMs <= 0)
+    {
+        return;
+    }
+
+    this->thresholdMs = thresholdMs;
+    this->dumpThresholdMs = dumpThresholdMs;
+    stopped.fetchAndStoreRelaxed(0);
+    EventLoopHeartbeat::instance()->start();
+    start(QThread::LowPriority);
+}
+
+void StallWatchdog::stopMonitoring()
+{
+    if (!isRunning())
+    {
+        return;
+    }
+
+    EventLoopHeartbeat::instance()->stop();
+    mutex.lock();
+    stopped.fetchAndStoreRelaxed(1);
+    stopCondition.wakeAll();
+    mutex.unlock();
+    wait();
+
+    MegaApi::log(MegaApi::LOG_LEVEL_INFO, QString::fromUtf8("GUI stall statistics: %1")
+                 .arg(getSummary()).toUtf8().constData());
+}
+
+QString StallWatchdog::getSummary()
+{
+    mutex.lock();
+    QString summary = QString::fromUtf8("%1 stalls, longest %2 ms, total %3 ms, %4 dumps")
+            .arg(numStalls).arg(longestStallMs).arg(totalStallMs).arg(numDumps);
+    mutex.unlock();
+    return summary;
+}
+
+void StallWatchdog::run()
+{
+    EventLoopHeartbeat *heartbeat = EventLoopHeartbeat::instance();
+    int lastHeartbeat = heartbeat->beats();
+    bool stalled = false;
+    bool dumped = false;
+    QElapsedTimer sinceHeartbeat;
+    QElapsedTimer sinceCheck;
+    sinceHeartbeat.start();
+    sinceCheck.start();
+
+    mutex.lock();
+    while (!stopped.fetchAndAddRelaxed(0))
+    {
+        stopCondition.wait(&mutex, Preferences::EVENT_LOOP_HEARTBEAT_INTERVAL_MS);
+        if (stopped.fetchAndAddRelaxed(0))
+        {
+            break;
+        }
+
+        //If this thread wasn't scheduled either, the computer was probably suspended
+        if (sinceCheck.restart() > (Preferences::EVENT_LOOP_HEARTBEAT_INTERVAL_MS + thresholdMs))
+        {
+            sinceHeartbeat.restart();
+            stalled = false;
+            dumped = false;
+        }
+
+        int currentHeartbeat = heartbeat->beats();
+        if (currentHeartbeat != lastHeartbeat)
+        {
+            if (stalled)
+            {
+                mutex.unlock();
+                stallFinished(sinceHeartbeat.elapsed());
+                mutex.lock();
+            }
+
+            lastHeartbeat = currentHeartbeat;
+            sinceHeartbeat.restart();
+            stalled = false;
+            dumped = false;
+            continue;
+        }
+
+        qint64 blockedMs = sinceHeartbeat.elapsed();
+        if (blockedMs > thresholdMs)
+        {
+            stalled = true;
+        }
+
+        if (!dumped && dumpThresholdMs > 0 && blockedMs > dumpThresholdMs)
+        {
+            dumped = true;
+            numDumps++;
+            mutex.unlock();
+            MegaApi::log(MegaApi::LOG_LEVEL_WARNING, QString::fromUtf8("The GUI thread has been blocked for %1 ms. Saving its state")
+                         .arg(blockedMs).toUtf8().constData());
+            CrashHandler::instance()->writeMinidump();
+            mutex.lock();
+        }
+    }
+    mutex.unlock();
+}
+
+void StallWatchdog::stallFinished(long long durationMs)
+{
+    mutex.lock();
+    numStalls++;
+    totalStallMs += durationMs;
+    if (durationMs > longestStallMs)
+    {
+        longestStallMs = durationMs;
+    }
+    mutex.unlock();
+
+    QString summary = getSummary();
+    CrashHandler::instance()->setStallSummary(summary);
+    MegaApi::log(MegaApi::LOG_LEVEL_WARNING, QString::fromUtf8("GUI thread stalled for %1 ms (%2)")
+                 .arg(durationMs).arg(summary).toUtf8().constData());
+}
@@ -0,0 +1,51 @@
+#ifndef STALLWATCHDOG_H
+#define STALLWATCHDOG_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QAtomicInt>
+#include <QString>
+
+// Detects stalls of the GUI event loop. A worker thread checks that the
+// counter of the EventLoopHeartbeat of the GUI thread keeps changing.
+// Stalls longer than a threshold are logged and counted. When a stall goes
+// past a second threshold, the state of the process is saved once with
+// CrashHandler::writeMinidump(), without terminating it.
+class StallWatchdog : public QThread
+{
+    Q_OBJECT
+
+public:
+    static StallWatchdog *instance();
+
+    // Must be called from the GUI thread
+    void startMonitoring(int thresholdMs, int dumpThresholdMs);
+    void stopMonitoring();
+
+    QString getSummary();
+
+protected:
+    void run();
+
+private:
+    StallWatchdog();
+
+    void stallFinished(long long durationMs);
+
+    static StallWatchdog *watchdog;
+
+    QAtomicInt stopped;
+    QMutex mutex;
+    QWaitCondition stopCondition;
+    int thresholdMs;
+    int dumpThresholdMs;
+
+    // Protected by mutex
+    int numStalls;
+    int numDumps;
+    long long longestStallMs;
+    long long totalStallMs;
+};
+
+#endif // STALLWATCHDOG_H
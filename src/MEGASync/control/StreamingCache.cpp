@@ -0,0 +1,856 @@
+#include "StreamingCache.h"
+#include "Preferences.h"
+#include "Utilities.h"
+#include "MegaApplication.h"
+#include "mega.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QMultiMap>
+#include <QRegExp>
+#include <QUrl>
+#include <QNetworkProxy>
+#include <QNetworkRequest>
+#include <QCryptographicHash>
+#include <QUuid>
+#include <QPair>
+#include <QtCore>
+
+#if QT_VERSION >= 0x050000
+#include <QtConcurrent/QtConcurrent>
+#endif
+
+#ifdef WIN32
+#include <sys/utime.h>
+#else
+#include <utime.h>
+#endif
+
+using namespace mega;
+
+typedef QList<QPair<QString, long long> > ChunkList;
+
+StreamingCache *StreamingCache::streamingCache = NULL;
+
+static const int CHUNK_NONCE_SIZE = sizeof(ctr_iv);
+
+//Chunks are encrypted with AES-128 in CTR mode (SymmCipher of the SDK).
+//Each file has its own random nonce
+static void cryptChunk(QByteArray *data, const QByteArray &cipherKey, const QByteArray &nonce)
+{
+    SymmCipher cipher;
+    cipher.setkey((const unsigned char *)cipherKey.constData());
+
+    ctr_iv iv;
+    memcpy(&iv, nonce.constData(), sizeof(iv));
+    unsigned char mac[SymmCipher::BLOCKSIZE];
+    cipher.ctr_crypt((unsigned char *)data->data(), data->size(), 0, iv, mac, true);
+}
+
+//The functions below run in the thread pool
+static QByteArray readChunkFile(QString path, QByteArray cipherKey, long long size)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return QByteArray();
+    }
+
+    QByteArray nonce = file.read(CHUNK_NONCE_SIZE);
+    QByteArray data = file.readAll();
+    if (nonce.size() != CHUNK_NONCE_SIZE || data.size() != size)
+    {
+        return QByteArray();
+    }
+
+    cryptChunk(&data, cipherKey, nonce);
+    return data;
+}
+
+static bool writeChunkFile(QString path, QByteArray cipherKey, QByteArray data)
+{
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QByteArray nonce = QUuid::createUuid().toRfc4122().left(CHUNK_NONCE_SIZE);
+    cryptChunk(&data, cipherKey, nonce);
+
+    QFile file(path);
+    bool success = file.open(QIODevice::WriteOnly)
+            && file.write(nonce) == nonce.size()
+            && file.write(data) == data.size();
+    file.close();
+    if (!success)
+    {
+        QFile::remove(path);
+    }
+    return success;
+}
+
+static void removeChunkFiles(QStringList paths)
+{
+    for (int i = 0; i < paths.size(); i++)
+    {
+        QFile::remove(paths[i]);
+    }
+}
+
+//The modification time keeps the LRU order between executions
+static void touchChunkFile(QString path)
+{
+#ifdef WIN32
+    _wutime((const wchar_t *)path.utf16(), NULL);
+#else
+    utime(QFile::encodeName(path).constData(), NULL);
+#endif
+}
+
+//Lists the chunks of the current key (oldest first) and removes the ones
+//encrypted with other keys
+static ChunkList scanCache(QString cacheRoot, QString keyFolder)
+{
+    QDir rootDir(cacheRoot);
+    QFileInfoList keyDirs = rootDir.entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot);
+    for (int i = 0; i < keyDirs.size(); i++)
+    {
+        if (keyDirs[i].fileName() != keyFolder)
+        {
+            Utilities::removeRecursively(keyDirs[i].absoluteFilePath());
+        }
+    }
+
+    QMultiMap<qint64, QPair<QString, long long> > chunksByTime;
+    QFileInfoList sourceDirs = QDir(rootDir.filePath(keyFolder)).entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot);
+    for (int i = 0; i < sourceDirs.size(); i++)
+    {
+        QFileInfoList chunks = QDir(sourceDirs[i].absoluteFilePath()).entryInfoList(QDir::Files);
+        for (int j = 0; j < chunks.size(); j++)
+        {
+            if (chunks[j].size() <= CHUNK_NONCE_SIZE)
+            {
+                QFile::remove(chunks[j].absoluteFilePath());
+                continue;
+            }
+
+            QString key = sourceDirs[i].fileName() + QString::fromAscii("/") + QString::number(chunks[j].fileName().toLongLong());
+            chunksByTime.insert(chunks[j].lastModified().toMSecsSinceEpoch(),
+                                qMakePair(key, chunks[j].size() - CHUNK_NONCE_SIZE));
+        }
+    }
+    return chunksByTime.values();
+}
+
+void sendStreamingResponse(QTcpSocket *socket, QString status, QString extraHeaders = QString())
+{
+    QString response = QString::fromUtf8("HTTP/1.1 %1\r\n"
+                                         "Content-Length: 0\r\n"
+                                         "Connection: close\r\n"
+                                         "%2\r\n").arg(status).arg(extraHeaders);
+    socket->write(response.toUtf8());
+    socket->disconnectFromHost();
+}
+
+StreamingCache *StreamingCache::instance()
+{
+    if (!streamingCache)
+    {
+        streamingCache = new StreamingCache();
+    }
+    return StreamingCache::streamingCache;
+}
+
+StreamingCache::StreamingCache() : QTcpServer()
+{
+    cacheRoot = MegaApplication::applicationDataPath() + QDir::separator() + QString::fromAscii("streaming");
+    cacheSize = 0;
+    cacheLoaded = false;
+    generation = 0;
+
+    chunkHits = 0;
+    chunkMisses = 0;
+    bytesFromCache = 0;
+    bytesFromNetwork = 0;
+    firstByteTimeTotal = 0;
+    firstByteCount = 0;
+    lastFirstByteTime = 0;
+
+    //The streaming server of the SDK is always local
+    networkAccess = new QNetworkAccessManager(this);
+    networkAccess->setProxy(QNetworkProxy(QNetworkProxy::NoProxy));
+    connect(networkAccess, SIGNAL(finished(QNetworkReply*)), this, SLOT(onChunkFinished(QNetworkReply*)));
+}
+
+bool StreamingCache::start()
+{
+    if (!cacheLoaded)
+    {
+        //The cache belongs to the account that is logged in
+        Preferences *preferences = Preferences::instance();
+        if (!preferences->logged())
+        {
+            return false;
+        }
+
+        QString key = preferences->streamingCacheKey();
+        if (key.isEmpty())
+        {
+            key = QString::fromAscii((QUuid::createUuid().toRfc4122() + QUuid::createUuid().toRfc4122()).toHex().constData());
+            preferences->setStreamingCacheKey(key);
+        }
+        //The folder depends on the key and the format of the chunks, so the
+        //chunks of other accounts or formats are removed by scanCache
+        QByteArray accountKey = QByteArray::fromHex(key.toUtf8());
+        cipherKey = accountKey.left(SymmCipher::KEYLENGTH);
+        cachePath = cacheRoot + QDir::separator()
+                + QString::fromAscii(QCryptographicHash::hash(accountKey + QByteArray("AES-CTR"), QCryptographicHash::Sha1)
+                                     .toHex().left(16).constData());
+        loadCache();
+        cacheLoaded = true;
+    }
+
+    if (isListening())
+    {
+        return true;
+    }
+
+    if (!listen(QHostAddress::LocalHost, 0))
+    {
+        MegaApi::log(MegaApi::LOG_LEVEL_WARNING, QString::fromUtf8("Unable to start the streaming cache: %1")
+                     .arg(errorString()).toUtf8().constData());
+        return false;
+    }
+    return true;
+}
+
+void StreamingCache::stop()
+{
+    close();
+
+    QList<QNetworkReply *> replies = pendingChunks.values();
+    pendingChunks.clear();
+    for (int i = 0; i < replies.size(); i++)
+    {
+        replies[i]->abort();
+    }
+
+    QList<QTcpSocket *> sockets = requests.keys();
+    for (int i = 0; i < sockets.size(); i++)
+    {
+        delete requests.take(sockets[i]);
+        sockets[i]->disconnect(this);
+        sockets[i]->abort();
+        sockets[i]->deleteLater();
+    }
+
+    sources.clear();
+    loadedChunks.clear();
+    loadedOrder.clear();
+    MegaApi::log(MegaApi::LOG_LEVEL_INFO, getStatistics().toUtf8().constData());
+}
+
+//Stops the cache at exit. The chunks are kept for the next execution
+void StreamingCache::shutdown()
+{
+    stop();
+    generation++;
+    waitForTasks();
+}
+
+//Removes the cache of the account. The results of the file operations
+//that are still running are ignored (see generation)
+void StreamingCache::clear()
+{
+    stop();
+    generation++;
+    waitForTasks();
+
+    readingChunks.clear();
+    writingChunks.clear();
+    cachedChunks.clear();
+    lruChunks.clear();
+    cacheSize = 0;
+    cipherKey.clear();
+    cachePath.clear();
+    cacheLoaded = false;
+    Utilities::removeRecursively(cacheRoot);
+}
+
+QString StreamingCache::getCachedLink(QString link, MegaHandle handle, long long size)
+{
+    if (handle == INVALID_HANDLE || size <= 0 || !start())
+    {
+        return link;
+    }
+
+    QString token = QString::number(handle);
+    StreamingSource &source = sources[token];
+    source.link = link;
+    source.handle = handle;
+    source.size = size;
+
+    QString name = link.mid(link.lastIndexOf(QChar::fromAscii('/')) + 1);
+    return QString::fromUtf8("http://127.0.0.1:%1/%2/%3").arg(serverPort()).arg(token).arg(name);
+}
+
+QString StreamingCache::getStatistics()
+{
+    long long chunks = chunkHits + chunkMisses;
+    return QString::fromUtf8("Streaming cache: %1 hits, %2 misses (hit rate %3%). %4 served from cache, %5 from the network. "
+                             "Time to first byte: %6 ms (average %7 ms)")
+            .arg(chunkHits).arg(chunkMisses).arg(chunks ? (chunkHits * 100 / chunks) : 0)
+            .arg(Utilities::getSizeString(bytesFromCache)).arg(Utilities::getSizeString(bytesFromNetwork))
+            .arg(lastFirstByteTime).arg(firstByteCount ? (firstByteTimeTotal / firstByteCount) : 0);
+}
+
+#if QT_VERSION >= 0x050000
+void StreamingCache::incomingConnection(qintptr socket)
+#else
+void StreamingCache::incomingConnection(int socket)
+#endif
+{
+    QTcpSocket *s = new QTcpSocket(this);
+    connect(s, SIGNAL(readyRead()), this, SLOT(readClient()));
+    connect(s, SIGNAL(disconnected()), this, SLOT(discardClient()));
+    connect(s, SIGNAL(bytesWritten(qint64)), this, SLOT(writeClient()));
+    s->setSocketDescriptor(socket);
+    requests.insert(s, new StreamingRequest());
+}
+
+void StreamingCache::readClient()
+{
+    QTcpSocket *socket = (QTcpSocket *)sender();
+    StreamingRequest *request = requests.value(socket);
+    if (!request || request->headerSent)
+    {
+        socket->readAll();
+        return;
+    }
+
+    request->data.append(socket->readAll());
+    if (request->data.size() > 16384)
+    {
+        sendStreamingResponse(socket, QString::fromUtf8("400 Bad Request"));
+        return;
+    }
+
+    if (request->data.contains("\r\n\r\n"))
+    {
+        processRequest(socket, request);
+    }
+}
+
+void StreamingCache::discardClient()
+{
+    QTcpSocket *socket = (QTcpSocket *)sender();
+    delete requests.take(socket);
+    socket->deleteLater();
+    MegaApi::log(MegaApi::LOG_LEVEL_DEBUG, getStatistics().toUtf8().constData());
+}
+
+void StreamingCache::writeClient()
+{
+    serveClient((QTcpSocket *)sender());
+}
+
+void StreamingCache::processRequest(QTcpSocket *socket, StreamingRequest *request)
+{
+    QStringList lines = QString::fromUtf8(request->data).split(QString::fromAscii("\r\n"));
+    QStringList requestLine = lines.at(0).split(QChar::fromAscii(' '));
+    if (requestLine.size() < 2
+            || (requestLine.at(0) != QString::fromAscii("GET") && requestLine.at(0) != QString::fromAscii("HEAD")))
+    {
+        sendStreamingResponse(socket, QString::fromUtf8("405 Method Not Allowed"));
+        return;
+    }
+
+    QStringList path = requestLine.at(1).split(QChar::fromAscii('/'), QString::SkipEmptyParts);
+    if (path.isEmpty() || !sources.contains(path.at(0)))
+    {
+        sendStreamingResponse(socket, QString::fromUtf8("404 Not Found"));
+        return;
+    }
+
+    request->token = path.at(0);
+    request->headOnly = (requestLine.at(0) == QString::fromAscii("HEAD"));
+    long long size = sources.value(request->token).size;
+    long long start = 0;
+    long long end = size - 1;
+    bool partial = false;
+
+    QRegExp rangeRegExp(QString::fromUtf8("^range:\\s*bytes=(\\d*)-(\\d*)"), Qt::CaseInsensitive);
+    for (int i = 1; i < lines.size(); i++)
+    {
+        if (rangeRegExp.indexIn(lines.at(i)) == 0)
+        {
+            partial = true;
+            if (rangeRegExp.cap(1).isEmpty())
+            {
+                //Suffix range (last N bytes)
+                start = size - rangeRegExp.cap(2).toLongLong();
+            }
+            else
+            {
+                start = rangeRegExp.cap(1).toLongLong();
+                if (!rangeRegExp.cap(2).isEmpty())
+                {
+                    end = qMin(end, rangeRegExp.cap(2).toLongLong());
+                }
+            }
+            break;
+        }
+    }
+
+    if (start < 0)
+    {
+        start = 0;
+    }
+
+    if (start > end)
+    {
+        sendStreamingResponse(socket, QString::fromUtf8("416 Requested Range Not Satisfiable"),
+                              QString::fromUtf8("Content-Range: bytes */%1\r\n").arg(size));
+        return;
+    }
+
+    request->offset = start;
+    request->end = end;
+    request->startTime = QDateTime::currentMSecsSinceEpoch();
+
+    QString response;
+    if (partial)
+    {
+        response = QString::fromUtf8("HTTP/1.1 206 Partial Content\r\n"
+                                     "Content-Range: bytes %1-%2/%3\r\n").arg(start).arg(end).arg(size);
+    }
+    else
+    {
+        response = QString::fromUtf8("HTTP/1.1 200 OK\r\n");
+    }
+
+    response += QString::fromUtf8("Content-Type: application/octet-stream\r\n"
+                                  "Accept-Ranges: bytes\r\n"
+                                  "Content-Length: %1\r\n"
+                                  "Connection: close\r\n\r\n").arg(end - start + 1);
+    socket->write(response.toUtf8());
+    request->headerSent = true;
+
+    if (request->headOnly)
+    {
+        socket->disconnectFromHost();
+        return;
+    }
+
+    serveClient(socket);
+}
+
+void StreamingCache::serveClient(QTcpSocket *socket)
+{
+    StreamingRequest *request = requests.value(socket);
+    if (!request || !request->headerSent || request->headOnly || !sources.contains(request->token))
+    {
+        return;
+    }
+
+    StreamingSource &source = sources[request->token];
+    while (request->offset <= request->end && socket->bytesToWrite() < Preferences::STREAMING_CHUNK_SIZE)
+    {
+        long long index = request->offset / Preferences::STREAMING_CHUNK_SIZE;
+        QString key = chunkKey(request->token, index);
+        if (!loadedChunks.contains(key))
+        {
+            bool cached = cachedChunks.contains(key);
+            if (request->lastChunk != index)
+            {
+                if (cached)
+                {
+                    chunkHits++;
+                }
+                else
+                {
+                    chunkMisses++;
+                }
+                request->lastChunk = index;
+                request->lastChunkMissed = !cached;
+            }
+
+            //Resumed from onChunkRead or onChunkFinished
+            if (cached)
+            {
+                readChunk(request->token, index);
+            }
+            else
+            {
+                fetchChunk(request->token, index);
+            }
+            prefetch(request->token, index);
+            return;
+        }
+
+        if (request->lastChunk != index)
+        {
+            chunkHits++;
+            request->lastChunk = index;
+            request->lastChunkMissed = false;
+        }
+
+        long long chunkOffset = request->offset - index * Preferences::STREAMING_CHUNK_SIZE;
+        QByteArray data = loadedChunks.value(key).mid(chunkOffset, request->end - request->offset + 1);
+        if (data.isEmpty())
+        {
+            loadedChunks.remove(key);
+            loadedOrder.removeOne(key);
+            continue;
+        }
+        long long length = data.size();
+
+        touchChunk(key);
+        socket->write(data);
+        request->offset += length;
+
+        long long now = QDateTime::currentMSecsSinceEpoch();
+        if (!request->firstByteSent)
+        {
+            request->firstByteSent = true;
+            lastFirstByteTime = now - request->startTime;
+            firstByteTimeTotal += lastFirstByteTime;
+            firstByteCount++;
+        }
+
+        if (request->lastChunkMissed)
+        {
+            bytesFromNetwork += length;
+        }
+        else
+        {
+            bytesFromCache += length;
+        }
+
+        if (!source.firstServeTime)
+        {
+            source.firstServeTime = now;
+        }
+        source.bytesServed += length;
+        prefetch(request->token, index);
+    }
+
+    if (request->offset > request->end && socket->state() == QAbstractSocket::ConnectedState)
+    {
+        socket->disconnectFromHost();
+    }
+}
+
+void StreamingCache::fetchChunk(QString token, long long index)
+{
+    QString key = chunkKey(token, index);
+    if (loadedChunks.contains(key) || cachedChunks.contains(key) || pendingChunks.contains(key)
+            || !sources.contains(token))
+    {
+        return;
+    }
+
+    long long start = index * Preferences::STREAMING_CHUNK_SIZE;
+    long long end = start + chunkSize(token, index) - 1;
+    QNetworkRequest request(QUrl::fromEncoded(sources.value(token).link.toUtf8()));
+    request.setRawHeader("Range", QString::fromUtf8("bytes=%1-%2").arg(start).arg(end).toUtf8());
+
+    QNetworkReply *reply = networkAccess->get(request);
+    reply->setProperty("key", key);
+    reply->setProperty("token", token);
+    reply->setProperty("index", index);
+    pendingChunks.insert(key, reply);
+}
+
+void StreamingCache::readChunk(QString token, long long index)
+{
+    QString key = chunkKey(token, index);
+    if (readingChunks.contains(key))
+    {
+        return;
+    }
+    readingChunks.insert(key);
+
+    QFutureWatcher<QByteArray> *watcher = new QFutureWatcher<QByteArray>(this);
+    watcher->setProperty("key", key);
+    watcher->setProperty("token", token);
+    watcher->setProperty("index", index);
+    watcher->setProperty("generation", generation);
+    connect(watcher, SIGNAL(finished()), this, SLOT(onChunkRead()));
+    QFuture<QByteArray> future = QtConcurrent::run(readChunkFile, chunkPath(key), cipherKey, cachedChunks.value(key));
+    watcher->setFuture(future);
+    addTask(future);
+}
+
+//Keeps the chunks that will be needed in the next seconds (depending on the read rate) downloaded
+void StreamingCache::prefetch(QString token, long long index)
+{
+    const StreamingSource &source = sources[token];
+    long long numChunks = (source.size + Preferences::STREAMING_CHUNK_SIZE - 1) / Preferences::STREAMING_CHUNK_SIZE;
+    long long elapsed = QDateTime::currentMSecsSinceEpoch() - source.firstServeTime;
+
+    int chunks = 1;
+    if (source.firstServeTime && elapsed > 0)
+    {
+        double rate = source.bytesServed * 1000.0 / elapsed;
+        chunks = (int)(rate * Preferences::STREAMING_PREFETCH_SECONDS / Preferences::STREAMING_CHUNK_SIZE) + 1;
+    }
+    chunks = qMin(chunks, Preferences::STREAMING_MAX_PREFETCH_CHUNKS);
+
+    for (int i = 1; i <= chunks && (index + i) < numChunks; i++)
+    {
+        if (pendingChunks.size() >= Preferences::STREAMING_MAX_PENDING_CHUNKS)
+        {
+            break;
+        }
+        fetchChunk(token, index + i);
+    }
+}
+
+void StreamingCache::onChunkFinished(QNetworkReply *reply)
+{
+    reply->deleteLater();
+    QString key = reply->property("key").toString();
+    if (pendingChunks.value(key) != reply)
+    {
+        return;
+    }
+    pendingChunks.remove(key);
+
+    QString token = reply->property("token").toString();
+    long long index = reply->property("index").toLongLong();
+    QByteArray data;
+    if (reply->error() == QNetworkReply::NoError)
+    {
+        data = reply->readAll();
+    }
+
+    bool success = sources.contains(token) && data.size() == chunkSize(token, index);
+    if (success)
+    {
+        addLoadedChunk(key, data);
+        if (!cipherKey.isEmpty() && !writingChunks.contains(key))
+        {
+            writingChunks.insert(key);
+            QFutureWatcher<bool> *watcher = new QFutureWatcher<bool>(this);
+            watcher->setProperty("key", key);
+            watcher->setProperty("size", data.size());
+            watcher->setProperty("generation", generation);
+            connect(watcher, SIGNAL(finished()), this, SLOT(onChunkWritten()));
+            QFuture<bool> future = QtConcurrent::run(writeChunkFile, chunkPath(key), cipherKey, data);
+            watcher->setFuture(future);
+            addTask(future);
+        }
+    }
+    else
+    {
+        MegaApi::log(MegaApi::LOG_LEVEL_WARNING, QString::fromUtf8("Unable to download streaming chunk %1: %2")
+                     .arg(key).arg(reply->errorString()).toUtf8().constData());
+    }
+
+    resumeClients(token, index, success);
+}
+
+void StreamingCache::onChunkRead()
+{
+    QFutureWatcher<QByteArray> *watcher = (QFutureWatcher<QByteArray> *)sender();
+    watcher->deleteLater();
+    if (watcher->property("generation").toInt() != generation)
+    {
+        return;
+    }
+
+    QString key = watcher->property("key").toString();
+    QString token = watcher->property("token").toString();
+    long long index = watcher->property("index").toLongLong();
+    QByteArray data = watcher->result();
+    readingChunks.remove(key);
+
+    //Damaged chunks are downloaded again
+    if (data.isEmpty())
+    {
+        if (cachedChunks.contains(key))
+        {
+            cacheSize -= cachedChunks.take(key);
+            lruChunks.removeOne(key);
+            addTask(QtConcurrent::run(removeChunkFiles, QStringList(chunkPath(key))));
+        }
+    }
+    else
+    {
+        addLoadedChunk(key, data);
+    }
+
+    resumeClients(token, index, true);
+}
+
+void StreamingCache::onChunkWritten()
+{
+    QFutureWatcher<bool> *watcher = (QFutureWatcher<bool> *)sender();
+    watcher->deleteLater();
+    if (watcher->property("generation").toInt() != generation)
+    {
+        return;
+    }
+
+    QString key = watcher->property("key").toString();
+    writingChunks.remove(key);
+    if (!watcher->result())
+    {
+        MegaApi::log(MegaApi::LOG_LEVEL_WARNING, QString::fromUtf8("Unable to cache streaming chunk %1")
+                     .arg(key).toUtf8().constData());
+        return;
+    }
+
+    if (!cachedChunks.contains(key))
+    {
+        long long size = watcher->property("size").toLongLong();
+        cachedChunks.insert(key, size);
+        lruChunks.append(key);
+        cacheSize += size;
+        evictChunks();
+    }
+}
+
+void StreamingCache::onCacheScanned()
+{
+    QFutureWatcher<ChunkList> *watcher = (QFutureWatcher<ChunkList> *)sender();
+    watcher->deleteLater();
+    if (watcher->property("generation").toInt() != generation)
+    {
+        return;
+    }
+
+    //Chunks cached since the start are newer
+    ChunkList chunks = watcher->result();
+    QStringList scannedChunks;
+    for (int i = 0; i < chunks.size(); i++)
+    {
+        QString key = chunks[i].first;
+        if (!cachedChunks.contains(key))
+        {
+            cachedChunks.insert(key, chunks[i].second);
+            cacheSize += chunks[i].second;
+            scannedChunks.append(key);
+        }
+    }
+    lruChunks = scannedChunks + lruChunks;
+    evictChunks();
+}
+
+//Serves the connections waiting for a chunk, or closes them if it can't be downloaded
+void StreamingCache::resumeClients(QString token, long long index, bool success)
+{
+    QList<QTcpSocket *> sockets = requests.keys();
+    for (int i = 0; i < sockets.size(); i++)
+    {
+        StreamingRequest *request = requests.value(sockets[i]);
+        if (!request || !request->headerSent || request->token != token || request->offset > request->end
+                || (request->offset / Preferences::STREAMING_CHUNK_SIZE) != index)
+        {
+            continue;
+        }
+
+        if (success)
+        {
+            serveClient(sockets[i]);
+        }
+        else
+        {
+            sockets[i]->abort();
+        }
+    }
+}
+
+void StreamingCache::addLoadedChunk(QString key, QByteArray data)
+{
+    if (!loadedChunks.contains(key))
+    {
+        loadedOrder.append(key);
+    }
+    loadedChunks.insert(key, data);
+
+    while (loadedOrder.size() > Preferences::STREAMING_MAX_LOADED_CHUNKS)
+    {
+        loadedChunks.remove(loadedOrder.takeFirst());
+    }
+}
+
+void StreamingCache::touchChunk(QString key)
+{
+    if (loadedOrder.last() != key)
+    {
+        loadedOrder.removeOne(key);
+        loadedOrder.append(key);
+    }
+
+    if (cachedChunks.contains(key) && lruChunks.last() != key)
+    {
+        lruChunks.removeOne(key);
+        lruChunks.append(key);
+        addTask(QtConcurrent::run(touchChunkFile, chunkPath(key)));
+    }
+}
+
+void StreamingCache::evictChunks()
+{
+    QStringList paths;
+    while (cacheSize > Preferences::STREAMING_CACHE_MAX_SIZE && lruChunks.size() > 1)
+    {
+        QString key = lruChunks.takeFirst();
+        cacheSize -= cachedChunks.take(key);
+        paths.append(chunkPath(key));
+    }
+
+    if (paths.size())
+    {
+        addTask(QtConcurrent::run(removeChunkFiles, paths));
+    }
+}
+
+//Rebuilds the index of the chunks stored by previous executions of this account
+void StreamingCache::loadCache()
+{
+    QFutureWatcher<ChunkList> *watcher = new QFutureWatcher<ChunkList>(this);
+    watcher->setProperty("generation", generation);
+    connect(watcher, SIGNAL(finished()), this, SLOT(onCacheScanned()));
+    QFuture<ChunkList> future = QtConcurrent::run(scanCache, cacheRoot, QFileInfo(cachePath).fileName());
+    watcher->setFuture(future);
+    addTask(future);
+}
+
+void StreamingCache::waitForTasks()
+{
+    for (int i = 0; i < tasks.size(); i++)
+    {
+        tasks[i].waitForFinished();
+    }
+    tasks.clear();
+}
+
+//Pending file operations, to wait for them before removing the cache
+void StreamingCache::addTask(QFuture<void> task)
+{
+    for (int i = tasks.size() - 1; i >= 0; i--)
+    {
+        if (tasks[i].isFinished())
+        {
+            tasks.removeAt(i);
+        }
+    }
+    tasks.append(task);
+}
+
+QString StreamingCache::chunkKey(QString token, long long index)
+{
+    return token + QString::fromAscii("/") + QString::number(index);
+}
+
+QString StreamingCache::chunkPath(QString key)
+{
+    return QDir::toNativeSeparators(cachePath + QString::fromAscii("/") + key);
+}
+
+long long StreamingCache::chunkSize(QString token, long long index)
+{
+    long long size = sources.value(token).size - index * Preferences::STREAMING_CHUNK_SIZE;
+    return qMin((long long)Preferences::STREAMING_CHUNK_SIZE, size);
+}
@@ -0,0 +1,129 @@
+#ifndef STREAMINGCACHE_H
+#define STREAMINGCACHE_H
+
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QStringList>
+#include <QHash>
+#include <QSet>
+#include <QFuture>
+#include <QFutureWatcher>
+
+#include <megaapi.h>
+
+class StreamingSource
+{
+public:
+    StreamingSource() : handle(mega::INVALID_HANDLE), size(0), bytesServed(0), firstServeTime(0) {}
+    QString link;
+    mega::MegaHandle handle;
+    long long size;
+    long long bytesServed;
+    long long firstServeTime;
+};
+
+class StreamingRequest
+{
+public:
+    StreamingRequest() : offset(0), end(-1), headerSent(false), headOnly(false),
+        firstByteSent(false), lastChunkMissed(false), lastChunk(-1), startTime(0) {}
+    QByteArray data;
+    QString token;
+    long long offset;
+    long long end;
+    bool headerSent;
+    bool headOnly;
+    bool firstByteSent;
+    bool lastChunkMissed;
+    long long lastChunk;
+    long long startTime;
+};
+
+// Local HTTP proxy in front of the streaming server of the SDK.
+// Ranges read by media players are stored in an on-disk chunk cache
+// (LRU, bounded), overlapping ranges are served from it and the chunks
+// ahead of the playback position are prefetched depending on the read rate.
+// Chunks are encrypted on disk (AES-CTR) with a key of the current account
+// and all file operations run in the thread pool. The chunks being served
+// are kept in memory. The cache is kept between executions, in LRU order by
+// modification time, and removed when the account is logged out.
+class StreamingCache: public QTcpServer
+{
+    Q_OBJECT
+
+    public:
+        static StreamingCache *instance();
+
+        bool start();
+        void stop();
+        void shutdown();
+        void clear();
+        QString getCachedLink(QString link, mega::MegaHandle handle, long long size);
+        QString getStatistics();
+
+#if QT_VERSION >= 0x050000
+        void incomingConnection(qintptr socket);
+#else
+        void incomingConnection(int socket);
+#endif
+
+    private slots:
+        void readClient();
+        void discardClient();
+        void writeClient();
+        void onChunkFinished(QNetworkReply *reply);
+        void onChunkRead();
+        void onChunkWritten();
+        void onCacheScanned();
+
+    private:
+        StreamingCache();
+
+        void processRequest(QTcpSocket *socket, StreamingRequest *request);
+        void serveClient(QTcpSocket *socket);
+        void fetchChunk(QString token, long long index);
+        void readChunk(QString token, long long index);
+        void prefetch(QString token, long long index);
+        void resumeClients(QString token, long long index, bool success);
+        void addLoadedChunk(QString key, QByteArray data);
+        void touchChunk(QString key);
+        void evictChunks();
+        void loadCache();
+        void addTask(QFuture<void> task);
+        void waitForTasks();
+        QString chunkKey(QString token, long long index);
+        QString chunkPath(QString key);
+        long long chunkSize(QString token, long long index);
+
+        static StreamingCache *streamingCache;
+
+        QString cacheRoot;
+        QString cachePath;
+        QByteArray cipherKey;
+        QNetworkAccessManager *networkAccess;
+        QHash<QString, StreamingSource> sources;
+        QHash<QTcpSocket *, StreamingRequest *> requests;
+        QHash<QString, QNetworkReply *> pendingChunks;
+        QSet<QString> readingChunks;
+        QSet<QString> writingChunks;
+        QHash<QString, QByteArray> loadedChunks;
+        QStringList loadedOrder;
+        QStringList lruChunks;
+        QHash<QString, long long> cachedChunks;
+        QList<QFuture<void> > tasks;
+        long long cacheSize;
+        bool cacheLoaded;
+        int generation;
+
+        long long chunkHits;
+        long long chunkMisses;
+        long long bytesFromCache;
+        long long bytesFromNetwork;
+        long long firstByteTimeTotal;
+        long long firstByteCount;
+        long long lastFirstByteTime;
+};
+
+#endif // STREAMINGCACHE_H
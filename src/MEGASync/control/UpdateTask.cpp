@@ -3,6 +3,7 @@
 #include <iostream>
 #include <QAuthenticator>
 #include <QDesktopServices>
+#include <QDataStream>
 
 using namespace mega;
 using namespace std;
@@ -17,12 +18,15 @@ UpdateTask::UpdateTask(MegaApi *megaApi, QString appFolder, QObject *parent) :
     forceCheck = false;
     updateTimer = NULL;
     timeoutTimer = NULL;
+    signatureCacheLoaded = false;
+    signatureCacheChanged = false;
     this->megaApi = megaApi;
     this->appFolder = QDir(appFolder);
 }
 
 UpdateTask::~UpdateTask()
 {
+    abortDownloads();
     delete m_WebCtrl;
     delete signatureChecker;
     delete updateTimer;
@@ -101,6 +105,7 @@ void UpdateTask::tryUpdate()
 void UpdateTask::onTimeout()
 {
     timeoutTimer->stop();
+    abortDownloads();
     delete m_WebCtrl;
     m_WebCtrl = new QNetworkAccessManager();
     connect(m_WebCtrl, SIGNAL(finished(QNetworkReply*)), this, SLOT(downloadFinished(QNetworkReply*)));
@@ -142,7 +147,9 @@ void UpdateTask::initialCleanup()
     downloadURLs.clear();
     localPaths.clear();
     fileSignatures.clear();
-    currentFile = -1;
+    patchURLs.clear();
+    patchSignatures.clear();
+    pendingFiles.clear();
 }
 
 //Called after a successful update
@@ -159,6 +166,7 @@ void UpdateTask::finalCleanup()
 
 void UpdateTask::postponeUpdate()
 {
+    saveSignatureCache();
     MegaApi::log(MegaApi::LOG_LEVEL_INFO, "Update task finished. No updates available");
 
     if (forceInstall)
@@ -270,6 +278,8 @@ bool UpdateTask::processUpdateFile(QNetworkReply *reply)
         downloadURLs.append(url);
         localPaths.append(localPath);
         fileSignatures.append(fileSignature);
+        patchURLs.append(QString());
+        patchSignatures.append(QString());
     }
 
     if (!downloadURLs.size())
@@ -284,67 +294,429 @@ bool UpdateTask::processUpdateFile(QNetworkReply *reply)
         return false;
     }
 
+    //Optional binary patches, after an empty line. A patch is used if the installed
+    //file matches its base. The result is verified with the signature of the full file
+    while (true)
+    {
+        QString localPath = readNextLine(reply);
+        if (!localPath.size())
+        {
+            break;
+        }
+
+        QString baseSignature = readNextLine(reply);
+        QString patchURL = readNextLine(reply);
+        QString patchSignature = readNextLine(reply);
+        if (!baseSignature.size() || !patchURL.size() || !patchSignature.size())
+        {
+            MegaApi::log(MegaApi::LOG_LEVEL_WARNING, "Invalid patch info");
+            break;
+        }
+
+        int fileNum = localPaths.indexOf(localPath);
+        if (fileNum < 0 || patchURLs[fileNum].size() || !alreadyInstalled(localPath, baseSignature))
+        {
+            continue;
+        }
+
+        MegaApi::log(MegaApi::LOG_LEVEL_INFO, QString::fromUtf8("Patch available for %1").arg(localPath).toUtf8().constData());
+        patchURLs[fileNum] = patchURL;
+        patchSignatures[fileNum] = patchSignature;
+    }
+
+    return true;
+}
+
+void UpdateTask::startDownloads()
+{
+    while (pendingFiles.size() && activeDownloads.size() < Preferences::MAX_UPDATE_DOWNLOADS)
+    {
+        int fileNum = pendingFiles.takeFirst();
+        if (!startFileDownload(fileNum))
+        {
+            MegaApi::log(MegaApi::LOG_LEVEL_ERROR, QString::fromUtf8("Update failed processing file: %1")
+                         .arg(downloadURLs[fileNum]).toUtf8().constData());
+            abortDownloads();
+            postponeUpdate();
+            return;
+        }
+    }
+}
+
+//Files are written to a partial file while they are downloaded. If a previous
+//download was interrupted, it's resumed after adding the existing data to the signature
+bool UpdateTask::startFileDownload(int fileNum)
+{
+    QString path = partialFilePath(fileNum);
+    QFileInfo info(path);
+    info.absoluteDir().mkpath(QString::fromAscii("."));
+
+    UpdateDownload *download = new UpdateDownload();
+    download->fileNum = fileNum;
+    download->offset = 0;
+    download->started = false;
+    download->failed = false;
+    download->signature = new MegaHashSignature((const char *)Preferences::UPDATE_PUBLIC_KEY);
+    download->signature->init();
+    download->file = new QFile(path);
+    if (!download->file->open(QIODevice::ReadWrite))
+    {
+        MegaApi::log(MegaApi::LOG_LEVEL_ERROR, QString::fromUtf8("Error opening local file from writting: %1").arg(path).toUtf8().constData());
+        closeDownload(download);
+        return false;
+    }
+
+    while (true)
+    {
+        QByteArray data = download->file->read(Preferences::UPDATE_DOWNLOAD_CHUNK_SIZE);
+        if (data.isEmpty())
+        {
+            break;
+        }
+        download->signature->add(data.constData(), data.size());
+        download->offset += data.size();
+    }
+
+    QString url = patchURLs[fileNum].size() ? patchURLs[fileNum] : downloadURLs[fileNum];
+    MegaApi::log(MegaApi::LOG_LEVEL_INFO, QString::fromAscii("Downloading file: %1").arg(url).toUtf8().constData());
+
+    QNetworkRequest request(url);
+    request.setAttribute(QNetworkRequest::CacheLoadControlAttribute,
+                         QVariant(int(QNetworkRequest::AlwaysNetwork)));
+    request.setRawHeader("User-Agent", megaApi->getUserAgent());
+    if (download->offset)
+    {
+        MegaApi::log(MegaApi::LOG_LEVEL_INFO, QString::fromUtf8("Resuming download of %1 at %2")
+                     .arg(localPaths[fileNum]).arg(download->offset).toUtf8().constData());
+        request.setRawHeader("Range", QString::fromUtf8("bytes=%1-").arg(download->offset).toUtf8());
+    }
+
+    QNetworkReply *reply = m_WebCtrl->get(request);
+    reply->setReadBufferSize(Preferences::UPDATE_DOWNLOAD_CHUNK_SIZE);
+    reply->setProperty("fileNum", fileNum);
+    connect(reply, SIGNAL(readyRead()), this, SLOT(onDownloadReadyRead()));
+    activeDownloads.insert(reply, download);
+    timeoutTimer->start(Preferences::UPDATE_TIMEOUT_SECS*1000);
+    return true;
+}
+
+void UpdateTask::onDownloadReadyRead()
+{
+    QNetworkReply *reply = (QNetworkReply *)sender();
+    UpdateDownload *download = activeDownloads.value(reply);
+    if (!download)
+    {
+        return;
+    }
+
+    timeoutTimer->start(Preferences::UPDATE_TIMEOUT_SECS*1000);
+    if (!writeFileData(reply, download))
+    {
+        reply->abort();
+    }
+}
+
+//Writes the received data to disk in chunks and adds it to the signature
+bool UpdateTask::writeFileData(QNetworkReply *reply, UpdateDownload *download)
+{
+    if (download->failed)
+    {
+        return false;
+    }
+
+    if (!download->started)
+    {
+        int statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+        if (statusCode != 200 && statusCode != 206)
+        {
+            return true;
+        }
+
+        if (statusCode == 200 && download->offset)
+        {
+            //The server doesn't support ranges, start again
+            download->offset = 0;
+            download->signature->init();
+            download->file->resize(0);
+            download->file->seek(0);
+        }
+        download->started = true;
+    }
+
+    while (reply->bytesAvailable())
+    {
+        QByteArray data = reply->read(Preferences::UPDATE_DOWNLOAD_CHUNK_SIZE);
+        if (download->file->write(data) != data.size())
+        {
+            MegaApi::log(MegaApi::LOG_LEVEL_ERROR, QString::fromUtf8("Error writting file: %1")
+                         .arg(download->file->fileName()).toUtf8().constData());
+            download->failed = true;
+            return false;
+        }
+        download->signature->add(data.constData(), data.size());
+    }
     return true;
 }
 
-bool UpdateTask::processFile(QNetworkReply *reply)
+bool UpdateTask::processFile(UpdateDownload *download)
 {
-    QByteArray data = reply->readAll();
+    int fileNum = download->fileNum;
+    QString path = updateFolder.absoluteFilePath(localPaths[fileNum]);
+
+    //Save the new file
+    if (!download->file->flush())
+    {
+        MegaApi::log(MegaApi::LOG_LEVEL_ERROR, QString::fromUtf8("Error flushing file: %1").arg(path).toUtf8().constData());
+        return false;
+    }
+    download->file->close();
 
     //Check signature
-    initSignature();
-    addToSignature(data);
-    if (!checkSignature(fileSignatures[currentFile]))
+    bool patch = patchURLs[fileNum].size();
+    QString signature = patch ? patchSignatures[fileNum] : fileSignatures[fileNum];
+    if (!download->signature->checkSignature(signature.toAscii().constData()))
     {
         MegaApi::log(MegaApi::LOG_LEVEL_ERROR, QString::fromUtf8("Invalid or corrupt file: %1")
-                     .arg(updateFolder.absoluteFilePath(localPaths[currentFile])).toUtf8().constData());
+                     .arg(download->file->fileName()).toUtf8().constData());
+        download->file->remove();
         return false;
     }
 
-    //Create the folder for the new file
-    QFile localFile(updateFolder.absoluteFilePath(localPaths[currentFile]));
-    QFileInfo info(localFile);
-    info.absoluteDir().mkpath(QString::fromAscii("."));
+    if (patch)
+    {
+        bool result = applyPatch(fileNum, download->file->fileName());
+        download->file->remove();
+        return result;
+    }
 
     //Delete the file if it exists.
-    localFile.remove();
+    QFile::remove(path);
+    if (!download->file->rename(path))
+    {
+        MegaApi::log(MegaApi::LOG_LEVEL_ERROR, QString::fromUtf8("Error renaming file: %1").arg(path).toUtf8().constData());
+        return false;
+    }
 
-    //Open the new file
-    if (!localFile.open(QIODevice::WriteOnly))
+    cacheSignature(path, fileSignatures[fileNum], true);
+    return true;
+}
+
+//Rebuilds a file from the installed version and a patch generated by MEGAUpdater:
+//"MEGAPATCH1" | target size | ('C' offset length | 'I' length data)* | 'E'
+bool UpdateTask::applyPatch(int fileNum, QString patchPath)
+{
+    QString path = updateFolder.absoluteFilePath(localPaths[fileNum]);
+    QFile patch(patchPath);
+    QFile base(appFolder.absoluteFilePath(localPaths[fileNum]));
+    QFile output(path + QString::fromAscii(".%1.tmp").arg(updateVersion));
+    if (!patch.open(QIODevice::ReadOnly) || !base.open(QIODevice::ReadOnly)
+            || !output.open(QIODevice::WriteOnly | QIODevice::Truncate))
     {
-        MegaApi::log(MegaApi::LOG_LEVEL_ERROR, QString::fromUtf8("Error opening local file from writting: %1").arg(info.absoluteFilePath()).toUtf8().constData());
+        MegaApi::log(MegaApi::LOG_LEVEL_ERROR, QString::fromUtf8("Unable to apply patch to %1").arg(path).toUtf8().constData());
         return false;
     }
 
-    //Write the new file
-    int remainingSize = data.size();
-    int position = 0;
-    while (remainingSize)
+    MegaHashSignature tmpHash((const char *)Preferences::UPDATE_PUBLIC_KEY);
+    tmpHash.init();
+
+    QDataStream stream(&patch);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    quint64 targetSize = 0;
+    quint64 written = 0;
+    bool valid = (patch.read(10) == "MEGAPATCH1");
+    stream >> targetSize;
+    while (valid && stream.status() == QDataStream::Ok)
     {
-        int written = localFile.write(data.constData()+position, remainingSize);
-        if (written == -1)
+        quint8 operation = 0;
+        quint32 length = 0;
+        QFile *source = &patch;
+        stream >> operation;
+        if (operation == 'E')
         {
-            MegaApi::log(MegaApi::LOG_LEVEL_ERROR, QString::fromUtf8("Error writting file: %1").arg(info.absoluteFilePath()).toUtf8().constData());
-            localFile.close();
-            return false;
+            break;
+        }
+        else if (operation == 'C')
+        {
+            quint64 offset = 0;
+            stream >> offset >> length;
+            valid = base.seek(offset);
+            source = &base;
+        }
+        else if (operation == 'I')
+        {
+            stream >> length;
+        }
+        else
+        {
+            valid = false;
+        }
+
+        while (valid && length)
+        {
+            QByteArray data = source->read(qMin(length, (quint32)Preferences::UPDATE_DOWNLOAD_CHUNK_SIZE));
+            if (data.isEmpty() || output.write(data) != data.size())
+            {
+                valid = false;
+                break;
+            }
+            tmpHash.add(data.constData(), data.size());
+            length -= data.size();
+            written += data.size();
         }
-        remainingSize -= written;
-        position += written;
     }
 
+    valid = valid && (stream.status() == QDataStream::Ok) && (written == targetSize) && output.flush();
+    output.close();
+    if (!valid || !tmpHash.checkSignature(fileSignatures[fileNum].toAscii().constData()))
+    {
+        MegaApi::log(MegaApi::LOG_LEVEL_ERROR, QString::fromUtf8("Invalid patch for %1").arg(path).toUtf8().constData());
+        output.remove();
+        return false;
+    }
 
-    //Save the new file
-    if (!localFile.flush())
+    QFile::remove(path);
+    if (!output.rename(path))
     {
-        MegaApi::log(MegaApi::LOG_LEVEL_ERROR, QString::fromUtf8("Error flushing file: %1").arg(info.absoluteFilePath()).toUtf8().constData());
-        localFile.close();
+        MegaApi::log(MegaApi::LOG_LEVEL_ERROR, QString::fromUtf8("Error renaming file: %1").arg(path).toUtf8().constData());
+        output.remove();
         return false;
     }
-    localFile.close();
 
+    MegaApi::log(MegaApi::LOG_LEVEL_INFO, QString::fromUtf8("Patch applied: %1").arg(localPaths[fileNum]).toUtf8().constData());
+    cacheSignature(path, fileSignatures[fileNum], true);
     return true;
 }
 
+void UpdateTask::fileDownloadFinished(QNetworkReply *reply)
+{
+    UpdateDownload *download = activeDownloads.take(reply);
+    if (!download)
+    {
+        //Aborted download
+        return;
+    }
+
+    if (activeDownloads.isEmpty())
+    {
+        timeoutTimer->stop();
+    }
+
+    int fileNum = download->fileNum;
+    QVariant statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute);
+    bool success;
+    if (statusCode.toInt() == 416 && download->offset && !download->started)
+    {
+        //The requested range starts at the end of the file: the partial file could be complete already.
+        //It's checked like a finished download and downloaded again from the start if it isn't valid
+        MegaApi::log(MegaApi::LOG_LEVEL_INFO, QString::fromUtf8("Checking the partial file of %1")
+                     .arg(localPaths[fileNum]).toUtf8().constData());
+        success = processFile(download);
+        if (!success)
+        {
+            download->file->remove();
+            closeDownload(download);
+            pendingFiles.append(fileNum);
+            startDownloads();
+            return;
+        }
+    }
+    else
+    {
+        success = statusCode.isValid() && (statusCode.toInt() == 200 || statusCode.toInt() == 206)
+                && (reply->error() == QNetworkReply::NoError)
+                && writeFileData(reply, download) && processFile(download);
+    }
+
+    if (!success && (statusCode.toInt() == 416 || download->failed))
+    {
+        //Unusable partial file
+        download->file->remove();
+    }
+    closeDownload(download);
+
+    if (!success && patchURLs[fileNum].size())
+    {
+        //Fall back to the full file
+        MegaApi::log(MegaApi::LOG_LEVEL_WARNING, QString::fromUtf8("Unable to patch %1, downloading the full file")
+                     .arg(localPaths[fileNum]).toUtf8().constData());
+        QFile::remove(partialFilePath(fileNum));
+        patchURLs[fileNum].clear();
+        pendingFiles.append(fileNum);
+        startDownloads();
+        return;
+    }
+
+    if (!success)
+    {
+        MegaApi::log(MegaApi::LOG_LEVEL_ERROR, QString::fromUtf8("Update failed processing file: %1")
+                     .arg(downloadURLs[fileNum]).toUtf8().constData());
+        abortDownloads();
+        postponeUpdate();
+        return;
+    }
+
+    if (pendingFiles.isEmpty() && activeDownloads.isEmpty())
+    {
+        applyUpdate();
+        return;
+    }
+
+    startDownloads();
+}
+
+void UpdateTask::closeDownload(UpdateDownload *download)
+{
+    delete download->file;
+    delete download->signature;
+    delete download;
+}
+
+//Partial files are kept to resume the downloads in the next attempt (of the same version)
+void UpdateTask::abortDownloads()
+{
+    pendingFiles.clear();
+    QList<QNetworkReply *> replies = activeDownloads.keys();
+    for (int i = 0; i < replies.size(); i++)
+    {
+        closeDownload(activeDownloads.take(replies[i]));
+        replies[i]->abort();
+    }
+}
+
+QString UpdateTask::partialFilePath(int fileNum)
+{
+    return updateFolder.absoluteFilePath(localPaths[fileNum])
+            + QString::fromAscii(patchURLs[fileNum].size() ? ".%1.patch.part" : ".%1.part").arg(updateVersion);
+}
+
+void UpdateTask::applyUpdate()
+{
+    //All files have been processed. Apply update
+    if (preferences->updateAutomatically() || forceInstall)
+    {
+        if (!performUpdate())
+        {
+            postponeUpdate();
+            return;
+        }
+
+        saveSignatureCache();
+        finalCleanup();
+    }
+    else
+    {
+        saveSignatureCache();
+        MegaApi::log(MegaApi::LOG_LEVEL_INFO, "Update installed");
+        emit updateAvailable(forceCheck);
+        preferences->setLastUpdateTime(QDateTime::currentMSecsSinceEpoch());
+        preferences->setLastUpdateVersion(updateVersion);
+    }
+
+    forceInstall = false;
+    forceCheck = false;
+    running = false;
+}
+
 bool UpdateTask::performUpdate()
 {
     MegaApi::log(MegaApi::LOG_LEVEL_INFO, "Applying update...");
@@ -376,6 +748,7 @@ bool UpdateTask::performUpdate()
         }
 
         MegaApi::log(MegaApi::LOG_LEVEL_INFO, QString::fromUtf8("File installed: %1").arg(file).toUtf8().constData());
+        cacheSignature(appFolder.absoluteFilePath(file), fileSignatures[i], true);
     }
 
     MegaApi::log(MegaApi::LOG_LEVEL_INFO, "Update successfully installed");
@@ -434,6 +807,23 @@ bool UpdateTask::alreadyDownloaded(QString relativePath, QString fileSignature)
 
 bool UpdateTask::alreadyExists(QString absolutePath, QString fileSignature)
 {
+    QFileInfo info(absolutePath);
+    if (!info.isFile())
+    {
+        return false;
+    }
+
+    //Files that haven't changed since the last check aren't read again
+    loadSignatureCache();
+    QHash<QString, UpdateSignatureEntry>::const_iterator it = signatureCache.constFind(absolutePath);
+    if (it != signatureCache.constEnd()
+            && it->size == info.size()
+            && it->modificationTime == info.lastModified().toMSecsSinceEpoch()
+            && it->signature == fileSignature)
+    {
+        return it->valid;
+    }
+
     MegaHashSignature tmpHash((const char *)Preferences::UPDATE_PUBLIC_KEY);
     QFile file(absolutePath);
     if (!file.open(QIODevice::ReadOnly))
@@ -441,87 +831,152 @@ bool UpdateTask::alreadyExists(QString absolutePath, QString fileSignature)
         return false;
     }
 
-    QByteArray bytes = file.readAll();
-    tmpHash.add(bytes.constData(), bytes.size());
+    while (true)
+    {
+        QByteArray bytes = file.read(Preferences::UPDATE_DOWNLOAD_CHUNK_SIZE);
+        if (bytes.isEmpty())
+        {
+            break;
+        }
+        tmpHash.add(bytes.constData(), bytes.size());
+    }
     file.close();
 
-    return tmpHash.checkSignature(fileSignature.toAscii().constData());
+    bool valid = tmpHash.checkSignature(fileSignature.toAscii().constData());
+    cacheSignature(absolutePath, fileSignature, valid);
+    return valid;
 }
 
-void UpdateTask::downloadFinished(QNetworkReply *reply)
+void UpdateTask::cacheSignature(QString absolutePath, QString fileSignature, bool valid)
 {
-    timeoutTimer->stop();
-    reply->deleteLater();
+    QFileInfo info(absolutePath);
+    UpdateSignatureEntry entry;
+    entry.size = info.size();
+    entry.modificationTime = info.lastModified().toMSecsSinceEpoch();
+    entry.signature = fileSignature;
+    entry.valid = valid;
+
+    loadSignatureCache();
+    signatureCache.insert(absolutePath, entry);
+    signatureCacheChanged = true;
+}
 
-    //Check if the request has been successful
-    QVariant statusCode = reply->attribute( QNetworkRequest::HttpStatusCodeAttribute );
-    if (!statusCode.isValid() || (statusCode.toInt() != 200) || (reply->error() != QNetworkReply::NoError))
+void UpdateTask::loadSignatureCache()
+{
+    if (signatureCacheLoaded)
     {
-        MegaApi::log(MegaApi::LOG_LEVEL_ERROR, "Unable to download file");
-        postponeUpdate();
         return;
     }
+    signatureCacheLoaded = true;
 
-    //Process the received data
-    if (currentFile <  0)
+    QFile file(QDir(basePath).absoluteFilePath(Preferences::UPDATE_SIGNATURE_CACHE_NAME));
+    if (!file.open(QIODevice::ReadOnly))
     {
-        //Process the update file
-        if (!processUpdateFile(reply))
-        {
-            postponeUpdate();
-            return;
-        }
-        emit installingUpdate(forceCheck);
+        return;
     }
-    else
+
+    QDataStream stream(&file);
+    quint32 count = 0;
+    stream >> count;
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; i++)
     {
-        //Process the file
-        if (!processFile(reply))
+        QString path;
+        qint64 size, modificationTime;
+        UpdateSignatureEntry entry;
+        stream >> path >> size >> modificationTime >> entry.signature >> entry.valid;
+        entry.size = size;
+        entry.modificationTime = modificationTime;
+        if (stream.status() == QDataStream::Ok)
         {
-            MegaApi::log(MegaApi::LOG_LEVEL_ERROR, QString::fromUtf8("Update failed processing file: %1")
-                         .arg(downloadURLs[currentFile]).toUtf8().constData());
-            postponeUpdate();
-            return;
+            signatureCache.insert(path, entry);
         }
     }
+}
+
+//Entries of files that don't exist anymore are discarded
+void UpdateTask::saveSignatureCache()
+{
+    if (!signatureCacheChanged)
+    {
+        return;
+    }
+    signatureCacheChanged = false;
 
-    //File processed. Download the next file
-    currentFile++;
-    while (currentFile < downloadURLs.size())
+    QHash<QString, UpdateSignatureEntry>::iterator it = signatureCache.begin();
+    while (it != signatureCache.end())
     {
-        if (!alreadyDownloaded(localPaths[currentFile], fileSignatures[currentFile]))
+        if (!QFileInfo(it.key()).isFile())
         {
-            MegaApi::log(MegaApi::LOG_LEVEL_INFO, QString::fromAscii("Downloading file: %1").arg(downloadURLs[currentFile]).toUtf8().constData());
-            downloadFile(downloadURLs[currentFile]);
-            return;
+            it = signatureCache.erase(it);
+        }
+        else
+        {
+            it++;
         }
+    }
 
-        MegaApi::log(MegaApi::LOG_LEVEL_INFO, QString::fromAscii("File already downloaded: %1").arg(localPaths[currentFile]).toUtf8().constData());
-        currentFile++;
+    QFile file(QDir(basePath).absoluteFilePath(Preferences::UPDATE_SIGNATURE_CACHE_NAME));
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        MegaApi::log(MegaApi::LOG_LEVEL_WARNING, "Unable to save the update signature cache");
+        return;
     }
 
-    //All files have been processed. Apply update
-    if (preferences->updateAutomatically() || forceInstall)
+    QDataStream stream(&file);
+    stream << (quint32)signatureCache.size();
+    for (it = signatureCache.begin(); it != signatureCache.end(); it++)
     {
-        if (!performUpdate())
+        stream << it.key() << (qint64)it->size << (qint64)it->modificationTime << it->signature << it->valid;
+    }
+}
+
+void UpdateTask::downloadFinished(QNetworkReply *reply)
+{
+    reply->deleteLater();
+    if (reply->property("fileNum").isValid())
+    {
+        fileDownloadFinished(reply);
+        return;
+    }
+
+    timeoutTimer->stop();
+
+    //Check if the request has been successful
+    QVariant statusCode = reply->attribute( QNetworkRequest::HttpStatusCodeAttribute );
+    if (!statusCode.isValid() || (statusCode.toInt() != 200) || (reply->error() != QNetworkReply::NoError))
+    {
+        MegaApi::log(MegaApi::LOG_LEVEL_ERROR, "Unable to download file");
+        postponeUpdate();
+        return;
+    }
+
+    //Process the update file
+    if (!processUpdateFile(reply))
+    {
+        postponeUpdate();
+        return;
+    }
+    emit installingUpdate(forceCheck);
+
+    for (int i = 0; i < downloadURLs.size(); i++)
+    {
+        if (alreadyDownloaded(localPaths[i], fileSignatures[i]))
         {
-            postponeUpdate();
-            return;
+            MegaApi::log(MegaApi::LOG_LEVEL_INFO, QString::fromAscii("File already downloaded: %1").arg(localPaths[i]).toUtf8().constData());
+            continue;
         }
-
-        finalCleanup();
+        pendingFiles.append(i);
     }
-    else
+
+    saveSignatureCache();
+    if (pendingFiles.isEmpty())
     {
-        MegaApi::log(MegaApi::LOG_LEVEL_INFO, "Update installed");
-        emit updateAvailable(forceCheck);
-        preferences->setLastUpdateTime(QDateTime::currentMSecsSinceEpoch());
-        preferences->setLastUpdateVersion(updateVersion);
+        applyUpdate();
+        return;
     }
 
-    forceInstall = false;
-    forceCheck = false;
-    running = false;
+    //Files are downloaded in parallel
+    startDownloads();
 }
 
 void UpdateTask::onProxyAuthenticationRequired(const QNetworkProxy &, QAuthenticator *auth)
@@ -13,10 +13,30 @@
 #include <QDir>
 #include <QDirIterator>
 #include <QDateTime>
+#include <QFile>
+#include <QHash>
 
 #include "megaapi.h"
 #include "control/Preferences.h"
 
+struct UpdateDownload
+{
+    int fileNum;
+    QFile *file;
+    mega::MegaHashSignature *signature;
+    long long offset;
+    bool started;
+    bool failed;
+};
+
+struct UpdateSignatureEntry
+{
+    long long size;
+    long long modificationTime;
+    QString signature;
+    bool valid;
+};
+
 class UpdateTask : public QObject
 {
     Q_OBJECT
@@ -32,7 +52,16 @@ protected:
    void downloadFile(QString url);
    QString readNextLine(QNetworkReply *reply);
    bool processUpdateFile(QNetworkReply *reply);
-   bool processFile(QNetworkReply *reply);
+   void startDownloads();
+   bool startFileDownload(int fileNum);
+   bool writeFileData(QNetworkReply *reply, UpdateDownload *download);
+   bool processFile(UpdateDownload *download);
+   bool applyPatch(int fileNum, QString patchPath);
+   void fileDownloadFinished(QNetworkReply *reply);
+   void closeDownload(UpdateDownload *download);
+   void abortDownloads();
+   QString partialFilePath(int fileNum);
+   void applyUpdate();
    bool performUpdate();
    void rollbackUpdate(int fileNum);
    void addToSignature(QString value);
@@ -42,16 +71,25 @@ protected:
    bool alreadyInstalled(QString relativePath, QString fileSignature);
    bool alreadyDownloaded(QString relativePath, QString fileSignature);
    bool alreadyExists(QString absolutePath, QString fileSignature);
+   void cacheSignature(QString absolutePath, QString fileSignature, bool valid);
+   void loadSignatureCache();
+   void saveSignatureCache();
 
    Preferences *preferences;
    QStringList downloadURLs;
    QStringList localPaths;
    QStringList fileSignatures;
+   QStringList patchURLs;
+   QStringList patchSignatures;
+   QList<int> pendingFiles;
+   QHash<QNetworkReply *, UpdateDownload *> activeDownloads;
+   QHash<QString, UpdateSignatureEntry> signatureCache;
+   bool signatureCacheLoaded;
+   bool signatureCacheChanged;
    QNetworkAccessManager *m_WebCtrl;
    mega::MegaHashSignature *signatureChecker;
    char signature[512];
    int updateVersion;
-   int currentFile;
    QDir updateFolder;
    QDir backupFolder;
    QDir appFolder;
@@ -72,6 +110,7 @@ signals:
 
 private slots:
    void downloadFinished(QNetworkReply* reply);
+   void onDownloadReadyRead();
    void onProxyAuthenticationRequired(const QNetworkProxy&, QAuthenticator*);
 
 public slots:
@@ -7,10 +7,17 @@
 #include <QDesktopServices>
 #include <QTextStream>
 #include <QDateTime>
+#include <QLocalServer>
+#include <QFile>
 #include <iostream>
 
 #ifndef WIN32
 #include "megaapi.h"
+#include <sys/types.h>
+#include <sys/stat.h>
+#else
+#include <windows.h>
+#include <Lmcons.h>
 #endif
 
 using namespace std;
@@ -493,3 +500,38 @@ long long Utilities::extractJSONNumber(QString json, QString name)
 
     return json.mid(pos + pattern.size(), count).toLongLong();
 }
+
+//Named pipes are global on Windows, so the name of the user is added to
+//the ones of each instance. Elsewhere, sockets are in the data folder
+QString Utilities::getUserPipeName(QString name)
+{
+#ifdef WIN32
+    WCHAR userName[UNLEN + 1];
+    DWORD size = UNLEN + 1;
+    if (GetUserNameW(userName, &size))
+    {
+        return name + QString::fromAscii(".") + QString::fromWCharArray(userName);
+    }
+    return name + QString::fromAscii(".") + QString::fromLocal8Bit(qgetenv("USERNAME").constData());
+#else
+    return name;
+#endif
+}
+
+//Only the current user is allowed to connect
+bool Utilities::listenForCurrentUser(QLocalServer *server, QString name)
+{
+#if QT_VERSION >= 0x050000
+    server->setSocketOptions(QLocalServer::UserAccessOption);
+    return server->listen(name);
+#elif defined(WIN32)
+    return server->listen(name);
+#else
+    //The socket file is created with permissions for the current user only,
+    //instead of restricting them after listen()
+    mode_t previousMask = umask(S_IRWXG | S_IRWXO);
+    bool result = server->listen(name);
+    umask(previousMask);
+    return result;
+#endif
+}
@@ -6,6 +6,8 @@
 #include <QPixmap>
 #include <QDir>
 
+class QLocalServer;
+
 class Utilities
 {
 public:
@@ -31,6 +33,8 @@ public:
     static bool removeRecursively(QString path);
     static void copyRecursively(QString srcPath, QString dstPath);
     static void getFolderSize(QString folderPath, long long *size);
+    static QString getUserPipeName(QString name);
+    static bool listenForCurrentUser(QLocalServer *server, QString name);
 };
 
 #endif // UTILITIES_H
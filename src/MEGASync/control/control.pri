@@ -14,7 +14,17 @@ SOURCES += $$PWD/HTTPServer.cpp \
     $$PWD/Utilities.cpp \
     $$PWD/MegaDownloader.cpp \
     $$PWD/MegaSyncLogger.cpp \
-    $$PWD/ConnectivityChecker.cpp
+    $$PWD/ConnectivityChecker.cpp \
+    $$PWD/DebrisAccountant.cpp \
+    $$PWD/DebrisPruner.cpp \
+    $$PWD/StreamingCache.cpp \
+    $$PWD/LinkExtractor.cpp \
+    $$PWD/NodeSearchIndex.cpp \
+    $$PWD/MetricsCollector.cpp \
+    $$PWD/EventLoopHeartbeat.cpp \
+    $$PWD/StallWatchdog.cpp \
+    $$PWD/SamplingProfiler.cpp \
+    $$PWD/CallbackTrace.cpp
 
 HEADERS  +=  $$PWD/HTTPServer.h \
     $$PWD/Preferences.h \
@@ -27,5 +37,15 @@ HEADERS  +=  $$PWD/HTTPServer.h \
     $$PWD/Utilities.h \
     $$PWD/MegaDownloader.h \
     $$PWD/MegaSyncLogger.h \
-    $$PWD/ConnectivityChecker.h
+    $$PWD/ConnectivityChecker.h \
+    $$PWD/DebrisAccountant.h \
+    $$PWD/DebrisPruner.h \
+    $$PWD/StreamingCache.h \
+    $$PWD/LinkExtractor.h \
+    $$PWD/NodeSearchIndex.h \
+    $$PWD/MetricsCollector.h \
+    $$PWD/EventLoopHeartbeat.h \
+    $$PWD/StallWatchdog.h \
+    $$PWD/SamplingProfiler.h \
+    $$PWD/CallbackTrace.h
 
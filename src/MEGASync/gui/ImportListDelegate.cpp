@@ -0,0 +1,157 @@
+#include "ImportListDelegate.h"
+#include "ImportListModel.h"
+#include "control/Utilities.h"
+
+#include <QApplication>
+#include <QPainter>
+#include <QMouseEvent>
+#include <QKeyEvent>
+
+static const int ROW_HEIGHT = 32;
+static const int MARGIN = 9;
+static const int CHECKBOX_WIDTH = 18;
+static const int ICON_SIZE = 24;
+static const int NAME_WIDTH = 290;
+
+ImportListDelegate::ImportListDelegate(QObject *parent) :
+    QStyledItemDelegate(parent)
+{
+    okIcon.addFile(QString::fromUtf8(":/images/import_ok_icon.png"), QSize(), QIcon::Normal, QIcon::Off);
+    warningIcon.addFile(QString::fromUtf8(":/images/import_warning_ico.png"), QSize(), QIcon::Normal, QIcon::Off);
+    errorIcon.addFile(QString::fromUtf8(":/images/import_error_ico.png"), QSize(), QIcon::Normal, QIcon::Off);
+}
+
+void ImportListDelegate::paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const
+{
+#if QT_VERSION >= 0x050000
+    QStyleOptionViewItem opt = option;
+#else
+    QStyleOptionViewItemV4 opt = option;
+#endif
+    QStyle *style = opt.widget ? opt.widget->style() : QApplication::style();
+    style->drawPrimitive(QStyle::PE_PanelItemViewItem, &opt, painter, opt.widget);
+
+    painter->save();
+    QRect rect = option.rect;
+
+    QStyleOptionButton checkBox;
+    checkBox.rect = checkBoxRect(rect);
+    checkBox.state = (index.data(Qt::CheckStateRole).toInt() == Qt::Checked) ? QStyle::State_On : QStyle::State_Off;
+    if (index.flags() & Qt::ItemIsUserCheckable)
+    {
+        checkBox.state |= QStyle::State_Enabled;
+    }
+    style->drawControl(QStyle::CE_CheckBox, &checkBox, painter, opt.widget);
+
+    QString fileName = index.data(Qt::DisplayRole).toString();
+    int top = rect.top() + (rect.height() - ICON_SIZE) / 2;
+    int x = rect.left() + MARGIN + CHECKBOX_WIDTH;
+    typeIcon(fileName).paint(painter, QRect(x, top, ICON_SIZE, ICON_SIZE));
+    x += ICON_SIZE;
+
+    long long fileSize = index.data(ImportListModel::SizeRole).toLongLong();
+    QString name = fileName;
+    if (fileSize)
+    {
+        name += QString::fromAscii(" (") + Utilities::getSizeString(fileSize) + QString::fromAscii(")");
+    }
+
+    QFont font = option.font;
+    font.setPixelSize(12);
+    painter->setFont(font);
+    if (option.state & QStyle::State_Selected)
+    {
+        painter->setPen(option.palette.color(QPalette::HighlightedText));
+    }
+    else
+    {
+        painter->setPen(option.palette.color(QPalette::Text));
+    }
+
+    int stateLeft = rect.right() - MARGIN - ICON_SIZE + 1;
+    QRect nameRect(x, rect.top(), qMin(NAME_WIDTH, stateLeft - x), rect.height());
+    painter->drawText(nameRect, Qt::AlignLeft | Qt::AlignVCenter,
+                      QFontMetrics(font).elidedText(name, Qt::ElideMiddle, nameRect.width()));
+
+    QIcon statusIcon;
+    switch (index.data(ImportListModel::StatusRole).toInt())
+    {
+        case ImportListModel::CORRECT:
+            statusIcon = okIcon;
+            break;
+        case ImportListModel::WARNING:
+            statusIcon = warningIcon;
+            break;
+        case ImportListModel::FAILED:
+            statusIcon = errorIcon;
+            break;
+        default:
+            break;
+    }
+
+    if (!statusIcon.isNull())
+    {
+        statusIcon.paint(painter, QRect(stateLeft, top, ICON_SIZE, ICON_SIZE));
+    }
+    painter->restore();
+}
+
+QSize ImportListDelegate::sizeHint(const QStyleOptionViewItem &, const QModelIndex &) const
+{
+    return QSize(MARGIN * 2 + CHECKBOX_WIDTH + ICON_SIZE * 2 + NAME_WIDTH, ROW_HEIGHT);
+}
+
+bool ImportListDelegate::editorEvent(QEvent *event, QAbstractItemModel *model,
+                                     const QStyleOptionViewItem &option, const QModelIndex &index)
+{
+    if (!(index.flags() & Qt::ItemIsUserCheckable))
+    {
+        return false;
+    }
+
+    if (event->type() == QEvent::MouseButtonRelease)
+    {
+        QMouseEvent *mouseEvent = (QMouseEvent *)event;
+        if (mouseEvent->button() != Qt::LeftButton || !checkBoxRect(option.rect).contains(mouseEvent->pos()))
+        {
+            return false;
+        }
+    }
+    else if (event->type() == QEvent::MouseButtonDblClick)
+    {
+        //Avoid toggling the row twice
+        return checkBoxRect(option.rect).contains(((QMouseEvent *)event)->pos());
+    }
+    else if (event->type() == QEvent::KeyPress)
+    {
+        if (((QKeyEvent *)event)->key() != Qt::Key_Space)
+        {
+            return false;
+        }
+    }
+    else
+    {
+        return false;
+    }
+
+    bool checked = (index.data(Qt::CheckStateRole).toInt() == Qt::Checked);
+    return model->setData(index, checked ? Qt::Unchecked : Qt::Checked, Qt::CheckStateRole);
+}
+
+QRect ImportListDelegate::checkBoxRect(const QRect &rowRect) const
+{
+    return QRect(rowRect.left() + MARGIN, rowRect.top() + (rowRect.height() - 16) / 2, 16, 16);
+}
+
+QIcon ImportListDelegate::typeIcon(QString fileName) const
+{
+    QString path = Utilities::getExtensionPixmapSmall(fileName);
+    QHash<QString, QIcon>::iterator it = typeIcons.find(path);
+    if (it == typeIcons.end())
+    {
+        QIcon icon;
+        icon.addFile(path, QSize(), QIcon::Normal, QIcon::Off);
+        it = typeIcons.insert(path, icon);
+    }
+    return it.value();
+}
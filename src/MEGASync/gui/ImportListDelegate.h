@@ -0,0 +1,33 @@
+#ifndef IMPORTLISTDELEGATE_H
+#define IMPORTLISTDELEGATE_H
+
+#include <QStyledItemDelegate>
+#include <QHash>
+#include <QIcon>
+
+// Paints the rows of ImportListModel (checkbox, file type icon, name and
+// size, status icon) without creating a widget per link
+class ImportListDelegate : public QStyledItemDelegate
+{
+    Q_OBJECT
+
+public:
+    explicit ImportListDelegate(QObject *parent = 0);
+
+    virtual void paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const;
+    virtual QSize sizeHint(const QStyleOptionViewItem &option, const QModelIndex &index) const;
+
+protected:
+    virtual bool editorEvent(QEvent *event, QAbstractItemModel *model,
+                             const QStyleOptionViewItem &option, const QModelIndex &index);
+
+    QRect checkBoxRect(const QRect &rowRect) const;
+    QIcon typeIcon(QString fileName) const;
+
+    mutable QHash<QString, QIcon> typeIcons;
+    QIcon okIcon;
+    QIcon warningIcon;
+    QIcon errorIcon;
+};
+
+#endif // IMPORTLISTDELEGATE_H
@@ -0,0 +1,108 @@
+#include "ImportListModel.h"
+
+ImportListModel::ImportListModel(QStringList links, QObject *parent) :
+    QAbstractListModel(parent)
+{
+    this->links.resize(links.size());
+    for (int i = 0; i < links.size(); i++)
+    {
+        LinkData &link = this->links[i];
+        link.fileName = links[i];
+        link.fileSize = 0;
+        link.status = LOADING;
+        link.selected = true;
+    }
+}
+
+int ImportListModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.isValid())
+    {
+        return 0;
+    }
+    return links.size();
+}
+
+QVariant ImportListModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= links.size())
+    {
+        return QVariant();
+    }
+
+    const LinkData &link = links[index.row()];
+    switch (role)
+    {
+        case Qt::DisplayRole:
+            return link.fileName;
+        case Qt::CheckStateRole:
+            return link.selected ? Qt::Checked : Qt::Unchecked;
+        case StatusRole:
+            return (int)link.status;
+        case SizeRole:
+            return link.fileSize;
+        default:
+            return QVariant();
+    }
+}
+
+bool ImportListModel::setData(const QModelIndex &index, const QVariant &value, int role)
+{
+    if (!index.isValid() || role != Qt::CheckStateRole || !(flags(index) & Qt::ItemIsUserCheckable))
+    {
+        return false;
+    }
+
+    LinkData &link = links[index.row()];
+    bool selected = (value.toInt() == Qt::Checked);
+    if (link.selected != selected)
+    {
+        link.selected = selected;
+        emit dataChanged(index, index);
+        emit stateChanged(index.row(), selected ? Qt::Checked : Qt::Unchecked);
+    }
+    return true;
+}
+
+Qt::ItemFlags ImportListModel::flags(const QModelIndex &index) const
+{
+    if (!index.isValid())
+    {
+        return Qt::NoItemFlags;
+    }
+
+    Qt::ItemFlags flags = Qt::ItemIsEnabled | Qt::ItemIsSelectable;
+    if (links[index.row()].status == LOADING || links[index.row()].status == CORRECT)
+    {
+        flags |= Qt::ItemIsUserCheckable;
+    }
+    return flags;
+}
+
+void ImportListModel::setLinkData(int id, QString fileName, linkstatus status, long long size)
+{
+    LinkData &link = links[id];
+    link.fileName = fileName;
+    link.status = status;
+    link.fileSize = size;
+
+    //Links with warnings or errors can't be selected
+    bool deselected = false;
+    if (status != LOADING && status != CORRECT && link.selected)
+    {
+        link.selected = false;
+        deselected = true;
+    }
+
+    QModelIndex modelIndex = index(id);
+    emit dataChanged(modelIndex, modelIndex);
+    if (deselected)
+    {
+        emit stateChanged(id, Qt::Unchecked);
+    }
+}
+
+bool ImportListModel::isSelected(int id)
+{
+    return links[id].selected;
+}
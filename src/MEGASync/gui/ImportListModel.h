@@ -0,0 +1,43 @@
+#ifndef IMPORTLISTMODEL_H
+#define IMPORTLISTMODEL_H
+
+#include <QAbstractListModel>
+#include <QVector>
+#include <QStringList>
+
+// Compact per-link state of ImportMegaLinksDialog. Rows are painted
+// on demand by ImportListDelegate
+class ImportListModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    enum linkstatus {LOADING, CORRECT, WARNING, FAILED};
+    enum {StatusRole = Qt::UserRole, SizeRole};
+
+    explicit ImportListModel(QStringList links, QObject *parent = 0);
+
+    virtual int rowCount(const QModelIndex &parent = QModelIndex()) const;
+    virtual QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
+    virtual bool setData(const QModelIndex &index, const QVariant &value, int role = Qt::EditRole);
+    virtual Qt::ItemFlags flags(const QModelIndex &index) const;
+
+    void setLinkData(int id, QString fileName, linkstatus status, long long size = 0);
+    bool isSelected(int id);
+
+signals:
+    void stateChanged(int id, int state);
+
+protected:
+    struct LinkData
+    {
+        QString fileName;
+        long long fileSize;
+        char status;
+        bool selected;
+    };
+
+    QVector<LinkData> links;
+};
+
+#endif // IMPORTLISTMODEL_H
@@ -1,6 +1,7 @@
 #include "ImportMegaLinksDialog.h"
 #include "ui_ImportMegaLinksDialog.h"
-#include "gui/ImportListWidgetItem.h"
+#include "gui/ImportListModel.h"
+#include "gui/ImportListDelegate.h"
 #include "gui/NodeSelector.h"
 #include "gui/MultiQFileDialog.h"
 
@@ -24,16 +25,19 @@ ImportMegaLinksDialog::ImportMegaLinksDialog(MegaApi *megaApi, Preferences *pref
     this->megaApi = megaApi;
     this->linkProcessor = processor;
 
+    QStringList links;
     for (int i = 0; i < linkProcessor->size(); i++)
     {
-        ImportListWidgetItem *customItem = new ImportListWidgetItem(linkProcessor->getLink(i), i, ui->linkList);
-        connect(customItem, SIGNAL(stateChanged(int,int)), this, SLOT(onLinkStateChanged(int, int)));
-        QListWidgetItem *item = new QListWidgetItem(ui->linkList);
-        ui->linkList->addItem(item);
-        item->setSizeHint(customItem->size());
-        ui->linkList->setItemWidget(item, customItem);
+        links.append(linkProcessor->getLink(i));
     }
 
+    //Rows are painted on demand, no widgets are created per link
+    linkModel = new ImportListModel(links, this);
+    connect(linkModel, SIGNAL(stateChanged(int,int)), this, SLOT(onLinkStateChanged(int, int)));
+    ui->linkList->setUniformItemSizes(true);
+    ui->linkList->setItemDelegate(new ImportListDelegate(ui->linkList));
+    ui->linkList->setModel(linkModel);
+
     int extraSlots = linkProcessor->size() - 1;
     if (extraSlots > 7)
     {
@@ -326,7 +330,6 @@ void ImportMegaLinksDialog::on_bMegaFolder_clicked()
 
 void ImportMegaLinksDialog::onLinkInfoAvailable(int id)
 {
-    ImportListWidgetItem *item = (ImportListWidgetItem *)ui->linkList->itemWidget(ui->linkList->item(id));
     MegaNode *node = linkProcessor->getNode(id);
 
     int e = linkProcessor->getError(id);
@@ -335,30 +338,29 @@ void ImportMegaLinksDialog::onLinkInfoAvailable(int id)
         QString name = QString::fromUtf8(node->getName());
         if (!name.compare(QString::fromAscii("NO_KEY")) || !name.compare(QString::fromAscii("CRYPTO_ERROR")))
         {
-            item->setData(tr("Decryption error"), ImportListWidgetItem::WARNING, node->getSize());
+            linkModel->setLinkData(id, tr("Decryption error"), ImportListModel::WARNING, node->getSize());
         }
         else
         {
-            item->setData(name, ImportListWidgetItem::CORRECT, node->getSize());
+            linkModel->setLinkData(id, name, ImportListModel::CORRECT, node->getSize());
         }
     }
     else
     {
         if ((e != MegaError::API_OK) && (e != MegaError::API_ETOOMANY))
         {
-            ImportListWidgetItem::linkstatus status = ImportListWidgetItem::FAILED;
+            ImportListModel::linkstatus status = ImportListModel::FAILED;
             if (e == MegaError::API_ETEMPUNAVAIL)
             {
-                status = ImportListWidgetItem::WARNING;
+                status = ImportListModel::WARNING;
             }
-            item->setData(QCoreApplication::translate("MegaError", MegaError::getErrorString(e)), status);
+            linkModel->setLinkData(id, QCoreApplication::translate("MegaError", MegaError::getErrorString(e)), status);
         }
         else
         {
-            item->setData(tr("Not found"), ImportListWidgetItem::FAILED);
+            linkModel->setLinkData(id, tr("Not found"), ImportListModel::FAILED);
         }
     }
-    item->updateGui();
 }
 
 void ImportMegaLinksDialog::onLinkInfoRequestFinish()
@@ -380,9 +382,13 @@ void ImportMegaLinksDialog::changeEvent(QEvent *event)
     if (event->type() == QEvent::LanguageChange)
     {
         ui->retranslateUi(this);
-        int totalImports = linkProcessor->getCurrentIndex();
-        for (int i = 0; i < totalImports; i++)
-            this->onLinkInfoAvailable(i);
+        for (int i = 0; i < linkProcessor->size(); i++)
+        {
+            if (linkProcessor->isLinkInfoAvailable(i))
+            {
+                this->onLinkInfoAvailable(i);
+            }
+        }
     }
     QDialog::changeEvent(event);
 }
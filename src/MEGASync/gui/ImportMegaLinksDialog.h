@@ -6,6 +6,7 @@
 #include "megaapi.h"
 #include "control/LinkProcessor.h"
 #include "control/Preferences.h"
+#include "ImportListModel.h"
 
 namespace Ui {
 class ImportMegaLinksDialog;
@@ -42,6 +43,7 @@ private:
     Ui::ImportMegaLinksDialog *ui;
     mega::MegaApi *megaApi;
     LinkProcessor *linkProcessor;
+    ImportListModel *linkModel;
     bool finished;
 };
 
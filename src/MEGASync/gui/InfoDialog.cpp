@@ -66,7 +66,6 @@ InfoDialog::InfoDialog(MegaApplication *app, QWidget *parent) :
     ui->wTransfer2->hideTransfer();
 
     megaApi = app->getMegaApi();
-    megaApiGuest = app->getMegaApiGuest();
     preferences = Preferences::instance();
     scanningTimer.setSingleShot(false);
     scanningTimer.setInterval(60);
@@ -273,10 +272,20 @@ void InfoDialog::clearRecentFiles()
 
 void InfoDialog::updateTransfers()
 {
-    remainingUploads = megaApi->getNumPendingUploads() + megaApiGuest->getNumPendingUploads();
-    remainingDownloads = megaApi->getNumPendingDownloads() + megaApiGuest->getNumPendingDownloads();
-    totalUploads = megaApi->getTotalUploads() + megaApiGuest->getTotalUploads();
-    totalDownloads = megaApi->getTotalDownloads() + megaApiGuest->getTotalDownloads();
+    remainingUploads = megaApi->getNumPendingUploads();
+    remainingDownloads = megaApi->getNumPendingDownloads();
+    totalUploads = megaApi->getTotalUploads();
+    totalDownloads = megaApi->getTotalDownloads();
+
+    //The guest MegaApi only exists while public links are being used
+    MegaApi *megaApiGuest = app->getActiveMegaApiGuest();
+    if (megaApiGuest)
+    {
+        remainingUploads += megaApiGuest->getNumPendingUploads();
+        remainingDownloads += megaApiGuest->getNumPendingDownloads();
+        totalUploads += megaApiGuest->getTotalUploads();
+        totalDownloads += megaApiGuest->getTotalDownloads();
+    }
 
     if (totalUploads < remainingUploads)
     {
@@ -498,8 +507,14 @@ void InfoDialog::updateTransfers()
 
 void InfoDialog::transferFinished(int error)
 {
-    remainingUploads = megaApi->getNumPendingUploads() + megaApiGuest->getNumPendingUploads();
-    remainingDownloads = megaApi->getNumPendingDownloads() + megaApiGuest->getNumPendingDownloads();
+    remainingUploads = megaApi->getNumPendingUploads();
+    remainingDownloads = megaApi->getNumPendingDownloads();
+    MegaApi *megaApiGuest = app->getActiveMegaApiGuest();
+    if (megaApiGuest)
+    {
+        remainingUploads += megaApiGuest->getNumPendingUploads();
+        remainingDownloads += megaApiGuest->getNumPendingDownloads();
+    }
 
     if (!remainingDownloads && ui->wTransfer1->isActive())
     {
@@ -888,13 +903,21 @@ void InfoDialog::onTransfer2Cancel(int x, int y)
 void InfoDialog::cancelAllUploads()
 {
     megaApi->cancelTransfers(MegaTransfer::TYPE_UPLOAD);
-    megaApiGuest->cancelTransfers(MegaTransfer::TYPE_UPLOAD);
+    MegaApi *megaApiGuest = app->getActiveMegaApiGuest();
+    if (megaApiGuest)
+    {
+        megaApiGuest->cancelTransfers(MegaTransfer::TYPE_UPLOAD);
+    }
 }
 
 void InfoDialog::cancelAllDownloads()
 {
     megaApi->cancelTransfers(MegaTransfer::TYPE_DOWNLOAD);
-    megaApiGuest->cancelTransfers(MegaTransfer::TYPE_DOWNLOAD);
+    MegaApi *megaApiGuest = app->getActiveMegaApiGuest();
+    if (megaApiGuest)
+    {
+        megaApiGuest->cancelTransfers(MegaTransfer::TYPE_DOWNLOAD);
+    }
 }
 
 void InfoDialog::cancelCurrentUpload()
@@ -904,7 +927,8 @@ void InfoDialog::cancelCurrentUpload()
 
 void InfoDialog::cancelCurrentDownload()
 {
-    if (activeDownload->getPublicMegaNode())
+    MegaApi *megaApiGuest = app->getActiveMegaApiGuest();
+    if (activeDownload->getPublicMegaNode() && megaApiGuest)
     {
         megaApiGuest->cancelTransfer(activeDownload);
     }
@@ -916,7 +940,8 @@ void InfoDialog::cancelCurrentDownload()
 
 void InfoDialog::onAllUploadsFinished()
 {
-    remainingUploads = megaApi->getNumPendingUploads() + megaApiGuest->getNumPendingUploads();
+    MegaApi *megaApiGuest = app->getActiveMegaApiGuest();
+    remainingUploads = megaApi->getNumPendingUploads() + (megaApiGuest ? megaApiGuest->getNumPendingUploads() : 0);
     if (!remainingUploads)
     {
         ui->wTransfer2->hideTransfer();
@@ -929,13 +954,17 @@ void InfoDialog::onAllUploadsFinished()
         totalUploadedSize = 0;
         totalUploadSize = 0;
         megaApi->resetTotalUploads();
-        megaApiGuest->resetTotalUploads();
+        if (megaApiGuest)
+        {
+            megaApiGuest->resetTotalUploads();
+        }
     }
 }
 
 void InfoDialog::onAllDownloadsFinished()
 {
-    remainingDownloads = megaApi->getNumPendingDownloads() + megaApiGuest->getNumPendingDownloads();
+    MegaApi *megaApiGuest = app->getActiveMegaApiGuest();
+    remainingDownloads = megaApi->getNumPendingDownloads() + (megaApiGuest ? megaApiGuest->getNumPendingDownloads() : 0);
     if (!remainingDownloads)
     {
         if (!preferences->logged())
@@ -957,7 +986,10 @@ void InfoDialog::onAllDownloadsFinished()
         totalDownloadedSize = 0;
         totalDownloadSize = 0;
         megaApi->resetTotalDownloads();
-        megaApiGuest->resetTotalDownloads();
+        if (megaApiGuest)
+        {
+            megaApiGuest->resetTotalDownloads();
+        }
     }
 }
 
@@ -1,6 +1,9 @@
 #include "MegaItem.h"
 
 #include <QByteArray>
+#include <QPair>
+
+#include <algorithm>
 
 using namespace mega;
 
@@ -10,6 +13,7 @@ MegaItem::MegaItem(MegaNode *node, MegaItem *parentItem, bool showFiles)
     this->children = NULL;
     this->parent = parentItem;
     this->showFiles = showFiles;
+    this->childRowsValid = false;
 }
 
 mega::MegaNode *MegaItem::getNode()
@@ -17,18 +21,36 @@ mega::MegaNode *MegaItem::getNode()
     return node;
 }
 
+static bool keyLessThan(const QPair<QByteArray, MegaItem *> &a, const QPair<QByteArray, MegaItem *> &b)
+{
+    return a.first < b.first;
+}
+
+//Children are sorted by their keys, the order of the SDK can be different
 void MegaItem::setChildren(MegaNodeList *children)
 {
     this->children = children;
+
+    QList<QPair<QByteArray, MegaItem *> > items;
     for (int i = 0; i < children->size(); i++)
     {
         MegaNode *node = children->get(i);
         if (!showFiles && node->getType() == MegaNode::TYPE_FILE)
         {
-            break;
+            continue;
         }
-        childItems.append(new MegaItem(children->get(i), this, showFiles));
+        items.append(qMakePair(collationKey(node), new MegaItem(node, this, showFiles)));
+    }
+    std::stable_sort(items.begin(), items.end(), keyLessThan);
+
+    childItems.reserve(items.size());
+    childKeys.reserve(items.size());
+    for (int i = 0; i < items.size(); i++)
+    {
+        childKeys.append(items.at(i).first);
+        childItems.append(items.at(i).second);
     }
+    childRowsValid = false;
 }
 
 bool MegaItem::areChildrenSet()
@@ -53,36 +75,93 @@ int MegaItem::getNumChildren()
 
 int MegaItem::indexOf(MegaItem *item)
 {
+    if (!item || !item->getNode())
+    {
+        return childItems.indexOf(item);
+    }
+
+    int row = rowOf(item->getNode()->getHandle());
+    if (row >= 0 && childItems.at(row) == item)
+    {
+        return row;
+    }
     return childItems.indexOf(item);
 }
 
-int MegaItem::insertPosition(MegaNode *node)
+int MegaItem::rowOf(MegaHandle handle)
 {
-    int type = node->getType();
-
-    int i;
-    for (i = 0; i < childItems.size(); i++)
+    if (!childRowsValid)
     {
-        MegaNode *n = childItems.at(i)->getNode();
-        int nodeType = n->getType();
-        if (type < nodeType)
-        {
-            continue;
-        }
-
-        if (qstricmp(node->getName(), n->getName()) <= 0)
-        {
-            break;
-        }
+        updateChildRows();
     }
+    return childRows.value(handle, -1);
+}
 
-    return i;
+int MegaItem::insertPosition(MegaNode *node)
+{
+    QByteArray key = collationKey(node);
+    return std::lower_bound(childKeys.begin(), childKeys.end(), key) - childKeys.begin();
 }
 
 void MegaItem::insertNode(MegaNode *node, int index)
 {
     childItems.insert(index, new MegaItem(node, this, showFiles));
+    childKeys.insert(index, collationKey(node));
     insertedNodes.append(node);
+
+    //Appending doesn't move other rows
+    if (childRowsValid && index == (childItems.size() - 1))
+    {
+        childRows.insert(node->getHandle(), index);
+    }
+    else
+    {
+        childRowsValid = false;
+    }
+}
+
+//New nodes are sorted and merged with the current children in a single pass
+void MegaItem::insertNodes(QList<MegaNode *> nodes)
+{
+    if (nodes.isEmpty())
+    {
+        return;
+    }
+
+    QList<QPair<QByteArray, MegaItem *> > newItems;
+    for (int i = 0; i < nodes.size(); i++)
+    {
+        newItems.append(qMakePair(collationKey(nodes[i]), new MegaItem(nodes[i], this, showFiles)));
+        insertedNodes.append(nodes[i]);
+    }
+    std::stable_sort(newItems.begin(), newItems.end(), keyLessThan);
+
+    QList<MegaItem *> mergedItems;
+    QList<QByteArray> mergedKeys;
+    mergedItems.reserve(childItems.size() + newItems.size());
+    mergedKeys.reserve(childItems.size() + newItems.size());
+    int i = 0;
+    int j = 0;
+    while (i < childItems.size() || j < newItems.size())
+    {
+        //New nodes go before existing ones with the same key, like insertPosition
+        if (j < newItems.size() && (i >= childItems.size() || !(childKeys.at(i) < newItems.at(j).first)))
+        {
+            mergedKeys.append(newItems.at(j).first);
+            mergedItems.append(newItems.at(j).second);
+            j++;
+        }
+        else
+        {
+            mergedKeys.append(childKeys.at(i));
+            mergedItems.append(childItems.at(i));
+            i++;
+        }
+    }
+
+    childItems = mergedItems;
+    childKeys = mergedKeys;
+    childRowsValid = false;
 }
 
 void MegaItem::removeNode(MegaNode *node)
@@ -92,13 +171,15 @@ void MegaItem::removeNode(MegaNode *node)
         return;
     }
 
-    for (int i = 0; i < childItems.size(); i++)
+    int row = rowOf(node->getHandle());
+    if (row >= 0)
     {
-        if (childItems[i]->getNode()->getHandle() == node->getHandle())
+        delete childItems.takeAt(row);
+        childKeys.removeAt(row);
+        childRows.remove(node->getHandle());
+        if (row != childItems.size())
         {
-            delete childItems[i];
-            childItems.removeAt(i);
-            break;
+            childRowsValid = false;
         }
     }
 
@@ -113,6 +194,34 @@ void MegaItem::removeNode(MegaNode *node)
     }
 }
 
+//Folders go before files, names are compared like the strcasecmp of the SDK,
+//that only folds ASCII letters. QByteArray::toLower() also folds Latin-1 ones
+QByteArray MegaItem::collationKey(MegaNode *node)
+{
+    QByteArray key(node->getName());
+    char *data = key.data();
+    for (int i = 0; i < key.size(); i++)
+    {
+        if (data[i] >= 'A' && data[i] <= 'Z')
+        {
+            data[i] += 'a' - 'A';
+        }
+    }
+    key.prepend((char)(127 - node->getType()));
+    return key;
+}
+
+void MegaItem::updateChildRows()
+{
+    childRows.clear();
+    childRows.reserve(childItems.size());
+    for (int i = 0; i < childItems.size(); i++)
+    {
+        childRows.insert(childItems.at(i)->getNode()->getHandle(), i);
+    }
+    childRowsValid = true;
+}
+
 void MegaItem::displayFiles(bool enable)
 {
     this->showFiles = enable;
@@ -2,6 +2,8 @@
 #define MEGAITEM_H
 
 #include <QList>
+#include <QHash>
+#include <QByteArray>
 #include <megaapi.h>
 
 class MegaItem
@@ -17,9 +19,11 @@ public:
     MegaItem *getChild(int i);
     int getNumChildren();
     int indexOf(MegaItem *item);
+    int rowOf(mega::MegaHandle handle);
 
     int insertPosition(mega::MegaNode *node);
     void insertNode(mega::MegaNode *node, int index);
+    void insertNodes(QList<mega::MegaNode *> nodes);
     void removeNode(mega::MegaNode *node);
     void displayFiles(bool enable);
 
@@ -32,6 +36,15 @@ protected:
     mega::MegaNodeList *children;
     QList<MegaItem *> childItems;
     QList<mega::MegaNode *> insertedNodes;
+
+    //Sort keys of childItems (folders first, then case-insensitive names)
+    //and a handle -> row cache that is rebuilt after moving rows
+    QList<QByteArray> childKeys;
+    QHash<mega::MegaHandle, int> childRows;
+    bool childRowsValid;
+
+    static QByteArray collationKey(mega::MegaNode *node);
+    void updateChildRows();
 };
 
 #endif // MEGAITEM_H
@@ -5,6 +5,8 @@
 #include <QPointer>
 #include <QMenu>
 #include "control/Utilities.h"
+#include "control/NodeSearchIndex.h"
+#include "control/Preferences.h"
 
 
 using namespace mega;
@@ -19,7 +21,10 @@ NodeSelector::NodeSelector(MegaApi *megaApi, int selectMode, QWidget *parent) :
     selectedFolder = mega::INVALID_HANDLE;
     selectedItem = QModelIndex();
     this->selectMode = selectMode;
+    model = NULL;
     delegateListener = new QTMegaRequestListener(megaApi, this);
+    globalDelegateListener = new QTMegaGlobalListener(megaApi, this);
+    megaApi->addGlobalListener(globalDelegateListener);
     ui->cbAlwaysUploadToLocation->hide();
     ui->bOk->setDefault(true);
 
@@ -33,10 +38,13 @@ NodeSelector::NodeSelector(MegaApi *megaApi, int selectMode, QWidget *parent) :
 
     ui->tMegaFolders->setContextMenuPolicy(Qt::CustomContextMenu);
     connect(ui->tMegaFolders, SIGNAL(customContextMenuRequested(const QPoint &)), this, SLOT(onCustomContextMenu(const QPoint &)));
+    connect(NodeSearchIndex::instance(), SIGNAL(indexReady()), this, SLOT(onSearchIndexReady()));
 }
 
 NodeSelector::~NodeSelector()
 {
+    megaApi->removeGlobalListener(globalDelegateListener);
+    delete globalDelegateListener;
     delete delegateListener;
     delete ui;
     delete model;
@@ -219,7 +227,7 @@ void NodeSelector::onRequestFinish(MegaApi *, MegaRequest *request, MegaError *e
             if (node)
             {
                 QModelIndex row = model->insertNode(node, selectedItem);
-                setSelectedFolderHandle(node->getHandle());
+                setSelectedFolderHandle(request->getNodeHandle());
                 ui->tMegaFolders->selectionModel()->select(row, QItemSelectionModel::ClearAndSelect);
                 ui->tMegaFolders->selectionModel()->setCurrentIndex(row, QItemSelectionModel::ClearAndSelect);
             }
@@ -245,6 +253,21 @@ void NodeSelector::onRequestFinish(MegaApi *, MegaRequest *request, MegaError *e
     ui->tMegaFolders->setEnabled(true);
 }
 
+//New nodes are merged into the loaded folders, the selection keeps its node
+void NodeSelector::onNodesUpdate(MegaApi *, MegaNodeList *nodes)
+{
+    if (!model || !nodes)
+    {
+        return;
+    }
+
+    model->addNewNodes(nodes);
+    if (ui->tMegaFolders->selectionModel()->selectedIndexes().size())
+    {
+        selectedItem = ui->tMegaFolders->selectionModel()->selectedIndexes().at(0);
+    }
+}
+
 void NodeSelector::onCustomContextMenu(const QPoint &point)
 {
     MegaNode *node = megaApi->getNodeByHandle(selectedFolder);
@@ -448,3 +471,52 @@ bool NodeSelector::getDefaultUploadOption()
 {
    return ui->cbAlwaysUploadToLocation->isChecked();
 }
+
+void NodeSelector::on_eSearch_textChanged(const QString &text)
+{
+    ui->lSearchResults->clear();
+    NodeSearchIndex *searchIndex = NodeSearchIndex::instance();
+    if (text.trimmed().isEmpty() || !searchIndex->isReady())
+    {
+        ui->lSearchResults->hide();
+        return;
+    }
+
+    //Files can't be selected for uploads or syncs
+    bool foldersOnly = (selectMode == NodeSelector::UPLOAD_SELECT || selectMode == NodeSelector::SYNC_SELECT);
+    QList<NodeSearchResult> results = searchIndex->search(text, Preferences::MAX_SEARCH_RESULTS, foldersOnly);
+    for (int i = 0; i < results.size(); i++)
+    {
+        const NodeSearchResult &result = results[i];
+        QListWidgetItem *item = new QListWidgetItem(result.name);
+        item->setToolTip(result.path);
+        item->setData(Qt::UserRole, (qulonglong)result.handle);
+        if (result.type == MegaNode::TYPE_FOLDER)
+        {
+            item->setIcon(folderIcon);
+        }
+        else
+        {
+            item->setIcon(QIcon(Utilities::getExtensionPixmapSmall(result.name)));
+        }
+        ui->lSearchResults->addItem(item);
+    }
+    ui->lSearchResults->setVisible(results.size() > 0);
+}
+
+void NodeSelector::on_lSearchResults_itemActivated(QListWidgetItem *item)
+{
+    on_lSearchResults_itemClicked(item);
+}
+
+void NodeSelector::on_lSearchResults_itemClicked(QListWidgetItem *item)
+{
+    setSelectedFolderHandle(item->data(Qt::UserRole).toULongLong());
+    ui->lSearchResults->hide();
+    ui->tMegaFolders->setFocus();
+}
+
+void NodeSelector::onSearchIndexReady()
+{
+    on_eSearch_textChanged(ui->eSearch->text());
+}
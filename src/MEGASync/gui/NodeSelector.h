@@ -4,17 +4,19 @@
 #include <QDialog>
 #include <QInputDialog>
 #include <QTreeWidgetItem>
+#include <QListWidgetItem>
 #include <QDir>
 
 #include "megaapi.h"
 #include "QTMegaRequestListener.h"
+#include "QTMegaGlobalListener.h"
 #include "QMegaModel.h"
 
 namespace Ui {
 class NodeSelector;
 }
 
-class NodeSelector : public QDialog, public mega::MegaRequestListener
+class NodeSelector : public QDialog, public mega::MegaRequestListener, public mega::MegaGlobalListener
 {
     Q_OBJECT
 
@@ -42,9 +44,11 @@ private:
 protected:
     void nodesReady();
     mega::QTMegaRequestListener *delegateListener;
+    mega::QTMegaGlobalListener *globalDelegateListener;
 
 public slots:
     virtual void onRequestFinish(mega::MegaApi* api, mega::MegaRequest *request, mega::MegaError* e);
+    virtual void onNodesUpdate(mega::MegaApi* api, mega::MegaNodeList *nodes);
     void onCustomContextMenu(const QPoint &);
     void onDeleteClicked();
 
@@ -55,6 +59,10 @@ private slots:
     void onSelectionChanged(QItemSelection,QItemSelection);
     void on_bNewFolder_clicked();
     void on_bOk_clicked();
+    void on_eSearch_textChanged(const QString &text);
+    void on_lSearchResults_itemActivated(QListWidgetItem *item);
+    void on_lSearchResults_itemClicked(QListWidgetItem *item);
+    void onSearchIndexReady();
 };
 
 #endif // NODESELECTOR_H
@@ -1,9 +1,16 @@
 #include "PasteMegaLinksDialog.h"
 #include "ui_PasteMegaLinksDialog.h"
 
+#include "control/LinkExtractor.h"
+#include "control/Preferences.h"
+
 #include <QClipboard>
-#include <QUrl>
 #include <QMessageBox>
+#include <QtCore>
+
+#if QT_VERSION >= 0x050000
+#include <QtConcurrent/QtConcurrent>
+#endif
 
 #include<iostream>
 using namespace std;
@@ -17,16 +24,19 @@ PasteMegaLinksDialog::PasteMegaLinksDialog(QWidget *parent) :
 
     const QClipboard *clipboard = QApplication::clipboard();
     QString text = clipboard->text();
-    if (extractLinks(text).size() != 0)
+    //Folder links aren't accepted by the dialog, so they aren't pasted either
+    if (LinkExtractor::containsLinks(text.toUtf8(), true))
     {
         ui->eLinks->setPlainText(text);
     }
 
     ui->bSubmit->setDefault(true);
+    connect(&extractionWatcher, SIGNAL(finished()), this, SLOT(onLinksExtracted()));
 }
 
 PasteMegaLinksDialog::~PasteMegaLinksDialog()
 {
+    extractionWatcher.waitForFinished();
     delete ui;
 }
 
@@ -38,74 +48,61 @@ QStringList PasteMegaLinksDialog::getLinks()
 void PasteMegaLinksDialog::on_bSubmit_clicked()
 {
     QString text = ui->eLinks->toPlainText();
-    links = extractLinks(text);
-    links = links.toSet().toList();
-    if (links.size() == 0)
+    if (text.size() < Preferences::LINK_EXTRACTION_ASYNC_SIZE)
     {
-        if (!text.trimmed().size())
-        {
-            QMessageBox::warning(this, tr("Warning"), tr("Enter one or more MEGA file links"));
-        }
-        else
-        {
-            QMessageBox::warning(this, tr("Warning"), tr("No valid MEGA links found. (Folder links aren't yet supported)"));
-        }
+        processLinks(LinkExtractor::extractLinks(text));
         return;
     }
 
-    accept();
+    //Big texts are scanned in a worker thread to keep the dialog responsive
+    ui->bSubmit->setEnabled(false);
+    ui->eLinks->setReadOnly(true);
+    extractionWatcher.setFuture(QtConcurrent::run(LinkExtractor::extractLinks, text));
 }
 
-void PasteMegaLinksDialog::changeEvent(QEvent *event)
+void PasteMegaLinksDialog::onLinksExtracted()
 {
-    if (event->type() == QEvent::LanguageChange)
+    ui->bSubmit->setEnabled(true);
+    ui->eLinks->setReadOnly(false);
+    if (isVisible())
     {
-        ui->retranslateUi(this);
+        processLinks(extractionWatcher.result());
     }
-
-    QDialog::changeEvent(event);
 }
 
-QStringList PasteMegaLinksDialog::extractLinks(QString text)
+void PasteMegaLinksDialog::processLinks(QStringList extractedLinks)
 {
-    QStringList tempLinks = text.split(QString::fromAscii("https://mega.co.nz/#!"), QString::KeepEmptyParts, Qt::CaseInsensitive);
-    tempLinks.removeAt(0);
-    QStringList tempLinks2 = text.split(QString::fromAscii("mega://#!"), QString::KeepEmptyParts, Qt::CaseInsensitive);
-    tempLinks2.removeAt(0);
-    tempLinks.append(tempLinks2);
-    QStringList tempLinksNewSite = text.split(QString::fromAscii("https://mega.nz/#!"), QString::KeepEmptyParts, Qt::CaseInsensitive);
-    tempLinksNewSite.removeAt(0);
-    tempLinks.append(tempLinksNewSite);
-
-    QStringList finalLinks;
-    for (int i = 0; i < tempLinks.size(); i++)
+    links.clear();
+    for (int i = 0; i < extractedLinks.size(); i++)
     {
-        QString link = checkLink(tempLinks[i].insert(0, QString::fromAscii("https://mega.nz/#!")));
-        if (!link.isNull())
+        if (!LinkExtractor::isFolderLink(extractedLinks[i]))
         {
-            finalLinks.append(link);
+            links.append(extractedLinks[i]);
         }
     }
 
-    return finalLinks;
-}
-
-QString PasteMegaLinksDialog::checkLink(QString link)
-{
-    link = QUrl::fromPercentEncoding(link.toUtf8());
-    link.replace(QChar::fromAscii(' '), QChar::fromAscii('+'));
-
-    if (link.length() < 70)
+    if (links.size() == 0)
     {
-        return QString();
+        if (!ui->eLinks->toPlainText().trimmed().size())
+        {
+            QMessageBox::warning(this, tr("Warning"), tr("Enter one or more MEGA file links"));
+        }
+        else
+        {
+            QMessageBox::warning(this, tr("Warning"), tr("No valid MEGA links found. (Folder links aren't yet supported)"));
+        }
+        return;
     }
 
-    link.truncate(73);
-    QByteArray data = link.toUtf8();
-    if (data.constData()[26] == '!')
+    accept();
+}
+
+void PasteMegaLinksDialog::changeEvent(QEvent *event)
+{
+    if (event->type() == QEvent::LanguageChange)
     {
-        return link;
+        ui->retranslateUi(this);
     }
 
-    return QString();
+    QDialog::changeEvent(event);
 }
@@ -2,6 +2,8 @@
 #define PASTEMEGALINKSDIALOG_H
 
 #include <QDialog>
+#include <QFutureWatcher>
+#include <QStringList>
 
 namespace Ui {
 class PasteMegaLinksDialog;
@@ -18,6 +20,7 @@ public:
 
 private slots:
     void on_bSubmit_clicked();
+    void onLinksExtracted();
 
 protected:
     void changeEvent(QEvent * event);
@@ -25,9 +28,9 @@ protected:
 private:
     Ui::PasteMegaLinksDialog *ui;
     QStringList links;
+    QFutureWatcher<QStringList> extractionWatcher;
 
-    QStringList extractLinks(QString text);
-    QString checkLink(QString link);
+    void processLinks(QStringList extractedLinks);
 };
 
 #endif // PASTEMEGALINKSDIALOG_H
@@ -173,7 +173,16 @@ void QMegaModel::showFiles(bool show)
 QModelIndex QMegaModel::insertNode(MegaNode *node, const QModelIndex &parent)
 {
     MegaItem *item = (MegaItem *)parent.internalPointer();
-    int index = item->insertPosition(node);
+
+    //The node could have been added by an update already
+    int index = item->rowOf(node->getHandle());
+    if (index >= 0)
+    {
+        delete node;
+        return this->index(index, 0, parent);
+    }
+
+    index = item->insertPosition(node);
 
     beginInsertRows(parent, index, index);
     item->insertNode(node, index);
@@ -182,6 +191,103 @@ QModelIndex QMegaModel::insertNode(MegaNode *node, const QModelIndex &parent)
     return this->index(index, 0, parent);
 }
 
+//Several nodes are merged at once, existing children only change their rows
+void QMegaModel::insertNodes(QList<MegaNode *> nodes, const QModelIndex &parent)
+{
+    MegaItem *item = (MegaItem *)parent.internalPointer();
+    if (!item || nodes.isEmpty())
+    {
+        return;
+    }
+
+    emit layoutAboutToBeChanged();
+    item->insertNodes(nodes);
+
+    QModelIndexList oldIndexes = persistentIndexList();
+    QModelIndexList newIndexes;
+    for (int i = 0; i < oldIndexes.size(); i++)
+    {
+        MegaItem *child = (MegaItem *)oldIndexes[i].internalPointer();
+        if (child && child->getParent() == item)
+        {
+            newIndexes.append(createIndex(item->indexOf(child), oldIndexes[i].column(), child));
+        }
+        else
+        {
+            newIndexes.append(oldIndexes[i]);
+        }
+    }
+    changePersistentIndexList(oldIndexes, newIndexes);
+    emit layoutChanged();
+}
+
+//Folders that haven't been expanded get their children from the SDK when they are
+//loaded, so only the new nodes of loaded folders are inserted (one merge per folder)
+void QMegaModel::addNewNodes(MegaNodeList *nodes)
+{
+    if (!nodes)
+    {
+        return;
+    }
+
+    QHash<MegaHandle, MegaItem *> loadedItems;
+    getLoadedItems(rootItem, &loadedItems);
+    for (int i = 0; i < inshareItems.size(); i++)
+    {
+        getLoadedItems(inshareItems.at(i), &loadedItems);
+    }
+
+    QHash<MegaItem *, QList<MegaNode *> > newNodes;
+    for (int i = 0; i < nodes->size(); i++)
+    {
+        MegaNode *node = nodes->get(i);
+        if (node->isRemoved() || (!displayFiles && node->getType() == MegaNode::TYPE_FILE))
+        {
+            continue;
+        }
+
+        MegaItem *parent = loadedItems.value(node->getParentHandle());
+        if (parent && parent->rowOf(node->getHandle()) < 0)
+        {
+            newNodes[parent].append(node->copy());
+        }
+    }
+
+    for (QHash<MegaItem *, QList<MegaNode *> >::iterator it = newNodes.begin(); it != newNodes.end(); ++it)
+    {
+        insertNodes(it.value(), indexOfItem(it.key()));
+    }
+}
+
+void QMegaModel::getLoadedItems(MegaItem *item, QHash<MegaHandle, MegaItem *> *items)
+{
+    if (!item->areChildrenSet() || !item->getNode())
+    {
+        return;
+    }
+
+    items->insert(item->getNode()->getHandle(), item);
+    for (int i = 0; i < item->getNumChildren(); i++)
+    {
+        getLoadedItems(item->getChild(i), items);
+    }
+}
+
+QModelIndex QMegaModel::indexOfItem(MegaItem *item)
+{
+    MegaItem *parent = item->getParent();
+    if (parent)
+    {
+        return createIndex(parent->indexOf(item), 0, item);
+    }
+
+    if (item == rootItem)
+    {
+        return createIndex(0, 0, rootItem);
+    }
+    return createIndex(inshareItems.indexOf(item) + 1, 0, item);
+}
+
 void QMegaModel::removeNode(QModelIndex &item)
 {
     MegaNode *node = ((MegaItem *)item.internalPointer())->getNode();
@@ -3,6 +3,7 @@
 
 #include <QAbstractItemModel>
 #include <QList>
+#include <QHash>
 #include <QIcon>
 #include "MegaItem.h"
 #include <megaapi.h>
@@ -23,6 +24,9 @@ public:
     void setDisableFolders(bool option);
     void showFiles(bool show);
     QModelIndex insertNode(mega::MegaNode *node, const QModelIndex &parent);
+    void insertNodes(QList<mega::MegaNode *> nodes, const QModelIndex &parent);
+    //Adds the new nodes of an update to the folders that are already loaded
+    void addNewNodes(mega::MegaNodeList *nodes);
     void removeNode(QModelIndex &item);
 
     mega::MegaNode *getNode(const QModelIndex &index);
@@ -40,6 +44,9 @@ protected:
     int requiredRights;
     bool displayFiles;
     bool disableFolders;
+
+    void getLoadedItems(MegaItem *item, QHash<mega::MegaHandle, MegaItem *> *items);
+    QModelIndex indexOfItem(MegaItem *item);
 };
 
 #endif // QMEGAMODEL_H
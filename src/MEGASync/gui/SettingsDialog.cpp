@@ -14,6 +14,7 @@
 #include "SettingsDialog.h"
 #include "ui_SettingsDialog.h"
 #include "control/Utilities.h"
+#include "control/DebrisAccountant.h"
 #include "platform/Platform.h"
 
 #ifdef __APPLE__
@@ -127,13 +128,23 @@ SettingsDialog::SettingsDialog(MegaApplication *app, bool proxyOnly, QWidget *pa
 
     if (!proxyOnly && preferences->logged())
     {
-        connect(&cacheSizeWatcher, SIGNAL(finished()), this, SLOT(onLocalCacheSizeAvailable()));
-        QFuture<long long> futureCacheSize = QtConcurrent::run(calculateCacheSize);
-        cacheSizeWatcher.setFuture(futureCacheSize);
+        //Use the running totals if they are available, walk the caches otherwise
+        cacheSize = DebrisAccountant::instance()->localDebrisSize();
+        remoteCacheSize = DebrisAccountant::instance()->remoteDebrisSize();
 
-        connect(&remoteCacheSizeWatcher, SIGNAL(finished()), this, SLOT(onRemoteCacheSizeAvailable()));
-        QFuture<long long> futureRemoteCacheSize = QtConcurrent::run(calculateRemoteCacheSize,megaApi);
-        remoteCacheSizeWatcher.setFuture(futureRemoteCacheSize);
+        if (cacheSize == -1)
+        {
+            connect(&cacheSizeWatcher, SIGNAL(finished()), this, SLOT(onLocalCacheSizeAvailable()));
+            QFuture<long long> futureCacheSize = QtConcurrent::run(calculateCacheSize);
+            cacheSizeWatcher.setFuture(futureCacheSize);
+        }
+
+        if (remoteCacheSize == -1)
+        {
+            connect(&remoteCacheSizeWatcher, SIGNAL(finished()), this, SLOT(onRemoteCacheSizeAvailable()));
+            QFuture<long long> futureRemoteCacheSize = QtConcurrent::run(calculateRemoteCacheSize,megaApi);
+            remoteCacheSizeWatcher.setFuture(futureRemoteCacheSize);
+        }
     }
 
 #ifdef __APPLE__
@@ -202,6 +213,11 @@ SettingsDialog::SettingsDialog(MegaApplication *app, bool proxyOnly, QWidget *pa
         ui->bApply->hide();
     }
 #endif
+
+    if (cacheSize != -1 && remoteCacheSize != -1)
+    {
+        onCacheSizeAvailable();
+    }
 }
 
 SettingsDialog::~SettingsDialog()
@@ -1867,6 +1883,7 @@ void SettingsDialog::on_bClearCache_clicked()
     delete warningDel;
 
     QtConcurrent::run(deleteCache);
+    DebrisAccountant::instance()->localDebrisCleared();
 
     cacheSize = 0;
     ui->bClearCache->hide();
@@ -1915,6 +1932,7 @@ void SettingsDialog::on_bClearRemoteCache_clicked()
     delete syncDebris;
 
     QtConcurrent::run(deleteRemoteCache, megaApi);
+    DebrisAccountant::instance()->remoteDebrisCleared();
     remoteCacheSize = 0;
     ui->bClearRemoteCache->hide();
     ui->lRemoteCacheSize->hide();
@@ -2108,7 +2126,15 @@ void SettingsDialog::on_lAccountImage_clicked()
     debugCounter++;
     if (debugCounter == 5)
     {
-        app->toggleLogging();
+        //The same gesture with Shift pressed toggles the profiler
+        if (QApplication::keyboardModifiers().testFlag(Qt::ShiftModifier))
+        {
+            app->toggleProfiling();
+        }
+        else
+        {
+            app->toggleLogging();
+        }
         debugCounter = 0;
     }
 }
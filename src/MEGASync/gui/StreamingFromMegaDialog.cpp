@@ -4,6 +4,7 @@
 
 #include "platform/Platform.h"
 #include "control/Utilities.h"
+#include "control/StreamingCache.h"
 
 #if QT_VERSION >= 0x050000
 #include <QtConcurrent/QtConcurrent>
@@ -35,6 +36,7 @@ StreamingFromMegaDialog::StreamingFromMegaDialog(mega::MegaApi *megaApi, QWidget
 
 StreamingFromMegaDialog::~StreamingFromMegaDialog()
 {
+    StreamingCache::instance()->stop();
     megaApi->httpServerStop();
     delete ui;
     delete delegateListener;
@@ -231,7 +233,9 @@ bool StreamingFromMegaDialog::generateStreamURL()
         QMessageBox::warning(this, tr("Error"), tr("Error generating streaming link"), QMessageBox::Ok);
         return false;
     }
-    streamURL = QString::fromUtf8(link);
+    streamURL = StreamingCache::instance()->getCachedLink(QString::fromUtf8(link),
+                                                          selectedMegaNode->getHandle(),
+                                                          selectedMegaNode->getSize());
     delete [] link;
     return true;
 }
@@ -13,7 +13,8 @@ SOURCES += $$PWD/SettingsDialog.cpp \
     $$PWD/UploadToMegaDialog.cpp \
     $$PWD/PasteMegaLinksDialog.cpp \
     $$PWD/ImportMegaLinksDialog.cpp \
-    $$PWD/ImportListWidgetItem.cpp \
+    $$PWD/ImportListModel.cpp \
+    $$PWD/ImportListDelegate.cpp \
     $$PWD/CrashReportDialog.cpp \
     $$PWD/MultiQFileDialog.cpp \
     $$PWD/MegaProxyStyle.cpp \
@@ -45,7 +46,8 @@ HEADERS  += $$PWD/SettingsDialog.h \
     $$PWD/UploadToMegaDialog.h \
     $$PWD/PasteMegaLinksDialog.h \
     $$PWD/ImportMegaLinksDialog.h \
-    $$PWD/ImportListWidgetItem.h \
+    $$PWD/ImportListModel.h \
+    $$PWD/ImportListDelegate.h \
     $$PWD/CrashReportDialog.h \
     $$PWD/MultiQFileDialog.h \
     $$PWD/MegaProxyStyle.h \
@@ -84,7 +86,6 @@ win32 {
                 $$PWD/win/UploadToMegaDialog.ui \
                 $$PWD/win/PasteMegaLinksDialog.ui \
                 $$PWD/win/ImportMegaLinksDialog.ui \
-                $$PWD/win/ImportListWidgetItem.ui \
                 $$PWD/win/CrashReportDialog.ui \
                 $$PWD/win/SetupWizard.ui \
                 $$PWD/win/SettingsDialog.ui \
@@ -115,7 +116,6 @@ macx {
                 $$PWD/macx/UploadToMegaDialog.ui \
                 $$PWD/macx/PasteMegaLinksDialog.ui \
                 $$PWD/macx/ImportMegaLinksDialog.ui \
-                $$PWD/macx/ImportListWidgetItem.ui \
                 $$PWD/macx/CrashReportDialog.ui \
                 $$PWD/macx/SetupWizard.ui \
                 $$PWD/macx/SettingsDialog.ui \
@@ -157,7 +157,6 @@ unix:!macx {
                 $$PWD/linux/UploadToMegaDialog.ui \
                 $$PWD/linux/PasteMegaLinksDialog.ui \
                 $$PWD/linux/ImportMegaLinksDialog.ui \
-                $$PWD/linux/ImportListWidgetItem.ui \
                 $$PWD/linux/CrashReportDialog.ui \
                 $$PWD/linux/SetupWizard.ui \
                 $$PWD/linux/SettingsDialog.ui \
@@ -1,20 +1,27 @@
 #include "ExtServer.h"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QDir>
+#include <QStringList>
 #include <sys/types.h>
 #include <pwd.h>
 #include <unistd.h>
 #include "control/Utilities.h"
+#include "control/MetricsCollector.h"
 
 using namespace mega;
 using namespace std;
 
-ExtServer::ExtServer(MegaApplication *app): QObject(),
+ExtServer::ExtServer(QObject *receiver, MegaApi *megaApi, QString dataPath): QObject(),
     m_localServer(0)
 {
-    connect(this, SIGNAL(newUploadQueue(QQueue<QString>)), app, SLOT(shellUpload(QQueue<QString>)));
-    connect(this, SIGNAL(newExportQueue(QQueue<QString>)), app, SLOT(shellExport(QQueue<QString>)));
+    this->megaApi = megaApi;
+    connect(this, SIGNAL(newUploadQueue(QQueue<QString>)), receiver, SLOT(shellUpload(QQueue<QString>)));
+    connect(this, SIGNAL(newExportQueue(QQueue<QString>)), receiver, SLOT(shellExport(QQueue<QString>)));
 
     // construct local socket path
-    sockPath = MegaApplication::applicationDataPath() + QDir::separator() + QString::fromAscii("mega.socket");
+    sockPath = dataPath + QDir::separator() + QString::fromAscii("mega.socket");
 
     //LOG_info << "Starting Ext server";
 
@@ -24,7 +31,7 @@ ExtServer::ExtServer(MegaApplication *app): QObject(),
     m_localServer = new QLocalServer(this);
 
     // start listening for new connections
-    if (!m_localServer->listen(sockPath)) {
+    if (!Utilities::listenForCurrentUser(m_localServer, sockPath)) {
         // XXX: failed to open local socket, retry ?
         //LOG_err << "Failed to listen()";
         return;
@@ -84,8 +91,15 @@ void ExtServer::onClientData()
 
     qint64 len;
     char buf[1024];
+    QElapsedTimer requestTimer;
     while ((len = client->readLine(buf, sizeof(buf))) > 0) {
-        const char *out = GetAnswerToRequest(buf);
+        requestTimer.start();
+        const char *out = GetAnswerToRequest(buf, megaApi, &uploadQueue, &exportQueue);
+        if (buf[0] == 'E')
+        {
+            flushQueues();
+        }
+        MetricsCollector::instance()->extRequestProcessed(buf[0], requestTimer.nsecsElapsed());
         if (out) {
             qint64 len = client->write(out);
             client->write("\n");
@@ -100,7 +114,8 @@ void ExtServer::onClientData()
 #define RESPONSE_PENDING    "2"
 #define RESPONSE_SYNCING    "3"
 // parse incoming request and send response back to client
-const char *ExtServer::GetAnswerToRequest(const char *buf)
+const char *ExtServer::GetAnswerToRequest(const char *buf, MegaApi *megaApi,
+                                          QQueue<QString> *uploadQueue, QQueue<QString> *exportQueue)
 {
     char c = buf[0];
     const char *content = buf+2;
@@ -206,7 +221,7 @@ const char *ExtServer::GetAnswerToRequest(const char *buf)
             if (file.exists())
             {
                 //LOG_debug << "Adding file to upload queue";
-                uploadQueue.enqueue(QDir::toNativeSeparators(file.absoluteFilePath()));
+                uploadQueue->enqueue(QDir::toNativeSeparators(file.absoluteFilePath()));
             }
             break;
         }
@@ -216,7 +231,7 @@ const char *ExtServer::GetAnswerToRequest(const char *buf)
             QFileInfo file(filePath);
             if (file.exists())
             {
-                exportQueue.enqueue(QDir::toNativeSeparators(file.absoluteFilePath()));
+                exportQueue->enqueue(QDir::toNativeSeparators(file.absoluteFilePath()));
             }
             break;
         }
@@ -227,7 +242,7 @@ const char *ExtServer::GetAnswerToRequest(const char *buf)
             if (!Preferences::instance()->overlayIconsDisabled())
             {
                 string tmpPath(content);
-                state = ((MegaApplication *)qApp)->getMegaApi()->syncPathState(&tmpPath);
+                state = megaApi->syncPathState(&tmpPath);
             }
 
             switch(state)
@@ -249,19 +264,6 @@ const char *ExtServer::GetAnswerToRequest(const char *buf)
             break;
         }
         case 'E':
-        {
-            if (!uploadQueue.isEmpty())
-            {
-                emit newUploadQueue(uploadQueue);
-                uploadQueue.clear();
-            }
-
-            if (!exportQueue.isEmpty())
-            {
-                emit newExportQueue(exportQueue);
-                exportQueue.clear();
-            }
-        }
         case 'I':
         default:
             break;
@@ -269,3 +271,19 @@ const char *ExtServer::GetAnswerToRequest(const char *buf)
 
     return out;
 }
+
+// send the queued files to the receiver
+void ExtServer::flushQueues()
+{
+    if (!uploadQueue.isEmpty())
+    {
+        emit newUploadQueue(uploadQueue);
+        uploadQueue.clear();
+    }
+
+    if (!exportQueue.isEmpty())
+    {
+        emit newExportQueue(exportQueue);
+        exportQueue.clear();
+    }
+}
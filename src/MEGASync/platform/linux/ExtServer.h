@@ -1,7 +1,9 @@
 #ifndef EXTSERVER_H
 #define EXTSERVER_H
 
-#include "MegaApplication.h"
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QQueue>
 #include "megaapi.h"
 #include "control/Preferences.h"
 
@@ -17,9 +19,16 @@ class ExtServer: public QObject
     Q_OBJECT
 
  public:
-    ExtServer(MegaApplication *app);
+    //The receiver gets the upload and export queues in its slots
+    //shellUpload(QQueue<QString>) and shellExport(QQueue<QString>)
+    ExtServer(QObject *receiver, mega::MegaApi *megaApi, QString dataPath);
     virtual ~ExtServer();
 
+    //Answers a request of the shell extension. Files to upload or export are
+    //added to the queues, request 'E' has to be handled by the caller
+    static const char *GetAnswerToRequest(const char *buf, mega::MegaApi *megaApi,
+                                          QQueue<QString> *uploadQueue, QQueue<QString> *exportQueue);
+
  protected:
     QLocalServer *m_localServer;
     QQueue<QString> uploadQueue;
@@ -32,7 +41,8 @@ class ExtServer: public QObject
  private:
     QString sockPath;
     QList<QLocalSocket *> m_clients;
-    const char *GetAnswerToRequest(const char *buf);
+    mega::MegaApi *megaApi;
+    void flushQueues();
 
  signals:
     void newUploadQueue(QQueue<QString> uploadQueue);
@@ -1,11 +1,16 @@
 #include "LinuxPlatform.h"
 #include <map>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
 
 using namespace std;
 using namespace mega;
 
 ExtServer *LinuxPlatform::ext_server = NULL;
 NotifyServer *LinuxPlatform::notify_server = NULL;
+NetworkMonitor *LinuxPlatform::network_monitor = NULL;
 
 static QString autostart_dir = QDir::homePath() + QString::fromAscii("/.config/autostart/");
 QString LinuxPlatform::desktop_file = autostart_dir + QString::fromAscii("megasync.desktop");
@@ -86,15 +91,20 @@ void LinuxPlatform::showInFolder(QString pathIn)
 }
 
 void LinuxPlatform::startShellDispatcher(MegaApplication *receiver)
+{
+    startShellDispatcher(receiver, receiver->getMegaApi(), MegaApplication::applicationDataPath());
+}
+
+void LinuxPlatform::startShellDispatcher(QObject *receiver, MegaApi *megaApi, QString dataPath)
 {
     if (!ext_server)
     {
-        ext_server = new ExtServer(receiver);
+        ext_server = new ExtServer(receiver, megaApi, dataPath);
     }
 
     if (!notify_server)
     {
-        notify_server = new NotifyServer();
+        notify_server = new NotifyServer(dataPath);
     }
 }
 
@@ -113,6 +123,31 @@ void LinuxPlatform::stopShellDispatcher()
     }
 }
 
+bool LinuxPlatform::startNetworkMonitor(MegaApplication *receiver)
+{
+    if (!network_monitor)
+    {
+        network_monitor = new NetworkMonitor();
+        if (!network_monitor->isActive())
+        {
+            delete network_monitor;
+            network_monitor = NULL;
+            return false;
+        }
+        QObject::connect(network_monitor, SIGNAL(networkChanged()), receiver, SLOT(onNetworkChanged()));
+    }
+    return true;
+}
+
+void LinuxPlatform::stopNetworkMonitor()
+{
+    if (network_monitor)
+    {
+        delete network_monitor;
+        network_monitor = NULL;
+    }
+}
+
 void LinuxPlatform::syncFolderAdded(QString syncPath, QString syncName)
 {
     if (QFile(custom_icon).exists())
@@ -213,3 +248,50 @@ QString LinuxPlatform::getDefaultOpenApp(QString extension)
 
     return line.mid(5, size);
 }
+
+void LinuxPlatform::setBackgroundIOPriority(bool enable)
+{
+#ifdef SYS_ioprio_set
+    //ioprio_set isn't wrapped by glibc. IOPRIO_CLASS_IDLE = 3, IOPRIO_CLASS_NONE = 0
+    //IOPRIO_WHO_PROCESS = 1 with id 0 applies to the calling thread
+    int ioprio = enable ? (3 << 13) : 0;
+    syscall(SYS_ioprio_set, 1, 0, ioprio);
+#endif
+}
+
+long long LinuxPlatform::getAvailableSpace(QString path)
+{
+    struct statvfs info;
+    if (statvfs(path.toUtf8().constData(), &info))
+    {
+        return -1;
+    }
+    return (long long)info.f_bavail * info.f_frsize;
+}
+
+QString LinuxPlatform::getVolumeId(QString path)
+{
+    struct stat info;
+    if (stat(path.toUtf8().constData(), &info))
+    {
+        return QString();
+    }
+    return QString::number((qulonglong)info.st_dev);
+}
+
+long long LinuxPlatform::getResidentMemory()
+{
+    //The second field of statm is the resident set size in pages
+    QFile statm(QString::fromAscii("/proc/self/statm"));
+    if (!statm.open(QIODevice::ReadOnly))
+    {
+        return -1;
+    }
+
+    QList<QByteArray> fields = statm.readAll().split(' ');
+    if (fields.size() < 2)
+    {
+        return -1;
+    }
+    return fields[1].toLongLong() * sysconf(_SC_PAGESIZE);
+}
@@ -13,6 +13,7 @@
 #include "MegaApplication.h"
 #include "ExtServer.h"
 #include "NotifyServer.h"
+#include "NetworkMonitor.h"
 
 class LinuxPlatform
 {
@@ -20,6 +21,7 @@ class LinuxPlatform
 private:
     static ExtServer *ext_server;
     static NotifyServer *notify_server;
+    static NetworkMonitor *network_monitor;
     static QString set_icon;
     static QString custom_icon;
     static QString remove_icon;
@@ -34,13 +36,21 @@ public:
     static bool isStartOnStartupActive();
     static void showInFolder(QString pathIn);
     static void startShellDispatcher(MegaApplication *receiver);
+    //Shell extension servers for receivers other than MegaApplication (headless mode)
+    static void startShellDispatcher(QObject *receiver, mega::MegaApi *megaApi, QString dataPath);
     static void stopShellDispatcher();
+    static bool startNetworkMonitor(MegaApplication *receiver);
+    static void stopNetworkMonitor();
     static void syncFolderAdded(QString syncPath, QString syncName);
     static void syncFolderRemoved(QString syncPath, QString syncName);
     static QByteArray encrypt(QByteArray data, QByteArray key);
     static QByteArray decrypt(QByteArray data, QByteArray key);
     static QByteArray getLocalStorageKey();
     static QString getDefaultOpenApp(QString extension);
+    static void setBackgroundIOPriority(bool enable);
+    static long long getAvailableSpace(QString path);
+    static QString getVolumeId(QString path);
+    static long long getResidentMemory();
 };
 
 #endif // LINUXPLATFORM_H
@@ -0,0 +1,122 @@
+#include "NetworkMonitor.h"
+#include "control/Preferences.h"
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <string.h>
+#include <net/if.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+
+#ifndef IFF_LOWER_UP
+#define IFF_LOWER_UP 0x10000
+#endif
+
+using namespace mega;
+
+NetworkMonitor::NetworkMonitor(): QObject(),
+    fd(-1), notifier(NULL)
+{
+    debounceTimer = new QTimer(this);
+    debounceTimer->setSingleShot(true);
+    debounceTimer->setInterval(Preferences::NETWORK_CHANGE_DELAY_MS);
+    connect(debounceTimer, SIGNAL(timeout()), this, SIGNAL(networkChanged()));
+
+    fd = socket(AF_NETLINK, SOCK_RAW, NETLINK_ROUTE);
+    if (fd < 0)
+    {
+        MegaApi::log(MegaApi::LOG_LEVEL_WARNING, QString::fromUtf8("Unable to open the netlink socket: %1")
+                     .arg(QString::fromUtf8(strerror(errno))).toUtf8().constData());
+        return;
+    }
+
+    struct sockaddr_nl address;
+    memset(&address, 0, sizeof(address));
+    address.nl_family = AF_NETLINK;
+    address.nl_groups = RTMGRP_LINK | RTMGRP_IPV4_IFADDR | RTMGRP_IPV6_IFADDR;
+    if (bind(fd, (struct sockaddr *)&address, sizeof(address)) < 0)
+    {
+        MegaApi::log(MegaApi::LOG_LEVEL_WARNING, QString::fromUtf8("Unable to bind the netlink socket: %1")
+                     .arg(QString::fromUtf8(strerror(errno))).toUtf8().constData());
+        close(fd);
+        fd = -1;
+        return;
+    }
+
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    notifier = new QSocketNotifier(fd, QSocketNotifier::Read, this);
+    connect(notifier, SIGNAL(activated(int)), this, SLOT(onSocketActivated(int)));
+    MegaApi::log(MegaApi::LOG_LEVEL_DEBUG, "Listening to network changes using netlink");
+}
+
+NetworkMonitor::~NetworkMonitor()
+{
+    delete notifier;
+    if (fd >= 0)
+    {
+        close(fd);
+    }
+}
+
+bool NetworkMonitor::isActive()
+{
+    return fd >= 0;
+}
+
+void NetworkMonitor::onSocketActivated(int socket)
+{
+    bool changed = false;
+    char buffer[8192];
+    ssize_t len;
+    while ((len = recv(socket, buffer, sizeof(buffer), 0)) > 0)
+    {
+        int remaining = len;
+        for (struct nlmsghdr *header = (struct nlmsghdr *)buffer;
+             NLMSG_OK(header, remaining) && header->nlmsg_type != NLMSG_DONE;
+             header = NLMSG_NEXT(header, remaining))
+        {
+            switch (header->nlmsg_type)
+            {
+                case RTM_NEWLINK:
+                case RTM_DELLINK:
+                {
+                    //Ignore the loopback and notifications that don't change the state of the link
+                    struct ifinfomsg *info = (struct ifinfomsg *)NLMSG_DATA(header);
+                    if (!(info->ifi_flags & IFF_LOOPBACK)
+                            && (header->nlmsg_type == RTM_DELLINK
+                                || (info->ifi_change & (IFF_UP | IFF_RUNNING | IFF_LOWER_UP))))
+                    {
+                        changed = true;
+                    }
+                    break;
+                }
+                case RTM_NEWADDR:
+                case RTM_DELADDR:
+                {
+                    //Ignore loopback and link-local addresses
+                    struct ifaddrmsg *info = (struct ifaddrmsg *)NLMSG_DATA(header);
+                    if (info->ifa_scope != RT_SCOPE_HOST && info->ifa_scope != RT_SCOPE_LINK)
+                    {
+                        changed = true;
+                    }
+                    break;
+                }
+                default:
+                    break;
+            }
+        }
+    }
+
+    if (len < 0 && errno == ENOBUFS)
+    {
+        //Some notifications were lost, assume that something changed
+        changed = true;
+    }
+
+    if (changed)
+    {
+        debounceTimer->start();
+    }
+}
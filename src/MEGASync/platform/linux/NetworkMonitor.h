@@ -0,0 +1,31 @@
+#ifndef NETWORKMONITOR_H
+#define NETWORKMONITOR_H
+
+#include <QObject>
+#include <QSocketNotifier>
+#include <QTimer>
+
+// Listens to RTNETLINK link and address notifications and emits
+// networkChanged() once the changes settle down
+class NetworkMonitor: public QObject
+{
+    Q_OBJECT
+
+ public:
+    NetworkMonitor();
+    virtual ~NetworkMonitor();
+    bool isActive();
+
+ signals:
+    void networkChanged();
+
+ private slots:
+    void onSocketActivated(int socket);
+
+ private:
+    int fd;
+    QSocketNotifier *notifier;
+    QTimer *debounceTimer;
+};
+
+#endif
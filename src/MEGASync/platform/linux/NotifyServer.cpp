@@ -1,16 +1,18 @@
 #include "NotifyServer.h"
+#include <QDir>
 #include <sys/types.h>
 #include <pwd.h>
 #include <unistd.h>
 #include "control/Utilities.h"
+#include "control/MetricsCollector.h"
 
 using namespace mega;
 
-NotifyServer::NotifyServer(): QObject(),
+NotifyServer::NotifyServer(QString dataPath): QObject(),
     m_localServer(0)
 {
     // construct local socket path
-    sockPath = MegaApplication::applicationDataPath() + QDir::separator() + QString::fromAscii("notify.socket");
+    sockPath = dataPath + QDir::separator() + QString::fromAscii("notify.socket");
 
     //LOG_info << "Starting Notify server";
 
@@ -20,7 +22,7 @@ NotifyServer::NotifyServer(): QObject(),
     m_localServer = new QLocalServer(this);
 
     // start listening for new connections
-    if (!m_localServer->listen(sockPath)) {
+    if (!Utilities::listenForCurrentUser(m_localServer, sockPath)) {
         // XXX: failed to open local socket, retry ?
         //LOG_err << "Failed to listen()";
         return;
@@ -54,11 +56,11 @@ void NotifyServer::acceptConnection()
 
         // send the list of current synced folders to the new client
         int localFolders = 0;
-        Preferences *preferences = Preferences::instance();
-        for (int i = 0; i < preferences->getNumSyncedFolders(); i++)
+        QVector<SyncRecord> syncRecords = Preferences::instance()->getSyncRecords();
+        for (int i = 0; i < syncRecords.size(); i++)
         {
-            QString c = QDir::toNativeSeparators(QDir(preferences->getLocalFolder(i)).canonicalPath());
-            if (!c.size() || !preferences->isFolderActive(i))
+            QString c = syncRecords.at(i).canonicalLocalFolder;
+            if (!c.size() || !syncRecords.at(i).active)
             {
                 continue;
             }
@@ -96,13 +98,16 @@ void NotifyServer::onClientDisconnected()
 // send string to all connected clients
 void NotifyServer::doSendToAll(const char *type, QString str)
 {
+    int numClients = 0;
     foreach(QLocalSocket *socket, m_clients)
         if (socket && socket->state() == QLocalSocket::ConnectedState) {
             socket->write(type);
             socket->write(str.toUtf8().constData());
             socket->write("\n");
             socket->flush();
+            numClients++;
         }
+    MetricsCollector::instance()->notificationSent(type, numClients);
 }
 
 void NotifyServer::notifyItemChange(QString path)
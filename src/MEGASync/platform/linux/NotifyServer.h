@@ -1,7 +1,8 @@
 #ifndef NOTIFYSERVER_H
 #define NOTIFYSERVER_H
 
-#include "MegaApplication.h"
+#include <QLocalServer>
+#include <QLocalSocket>
 #include "megaapi.h"
 #include "control/Preferences.h"
 
@@ -10,7 +11,7 @@ class NotifyServer: public QObject
     Q_OBJECT
 
  public:
-    NotifyServer();
+    NotifyServer(QString dataPath);
     virtual ~NotifyServer();
     void notifyItemChange(QString path);
     void notifySyncAdd(QString path);
@@ -25,7 +26,6 @@ class NotifyServer: public QObject
     void doSendToAll(const char *type, QString str);
 
  private:
-    MegaApplication *app;
     QString sockPath;
     QList<QLocalSocket *> m_clients;
 
@@ -1,4 +1,8 @@
 #include "MacXPlatform.h"
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+#include <mach/mach.h>
 
 int MacXPlatform::fd = -1;
 MacXSystemServiceTask* MacXPlatform::systemServiceTask = NULL;
@@ -95,6 +99,16 @@ void MacXPlatform::stopShellDispatcher()
 
 }
 
+bool MacXPlatform::startNetworkMonitor(MegaApplication *)
+{
+    return false;
+}
+
+void MacXPlatform::stopNetworkMonitor()
+{
+
+}
+
 void MacXPlatform::syncFolderAdded(QString syncPath, QString syncName)
 {
     addPathToPlaces(syncPath,syncName);
@@ -139,3 +153,39 @@ bool MacXPlatform::enableSetuidBit()
     delete response;
     return result;
 }
+
+void MacXPlatform::setBackgroundIOPriority(bool enable)
+{
+    setiopolicy_np(IOPOL_TYPE_DISK, IOPOL_SCOPE_THREAD, enable ? IOPOL_THROTTLE : IOPOL_DEFAULT);
+}
+
+long long MacXPlatform::getAvailableSpace(QString path)
+{
+    struct statvfs info;
+    if (statvfs(path.toUtf8().constData(), &info))
+    {
+        return -1;
+    }
+    return (long long)info.f_bavail * info.f_frsize;
+}
+
+QString MacXPlatform::getVolumeId(QString path)
+{
+    struct stat info;
+    if (stat(path.toUtf8().constData(), &info))
+    {
+        return QString();
+    }
+    return QString::number((qulonglong)info.st_dev);
+}
+
+long long MacXPlatform::getResidentMemory()
+{
+    mach_task_basic_info_data_t info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t)&info, &count) != KERN_SUCCESS)
+    {
+        return -1;
+    }
+    return info.resident_size;
+}
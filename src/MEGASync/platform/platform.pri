@@ -13,7 +13,7 @@ win32 {
 		$$PWD/win/WinShellDispatcherTask.h \
 		$$PWD/win/WinTrayReceiver.h
 
-    LIBS += -lole32 -lShell32 -lcrypt32
+    LIBS += -lole32 -lShell32 -lcrypt32 -lPsapi
     DEFINES += -DUNICODE -DNTDDI_VERSION=0x05010000 -D_WIN32_WINNT=0x0501 -DWIN32_LEAN_AND_MEAN
 }
 
@@ -21,12 +21,14 @@ unix:!macx {
     QT += dbus
     SOURCES += $$PWD/linux/LinuxPlatform.cpp \
         $$PWD/linux/ExtServer.cpp \
-        $$PWD/linux/NotifyServer.cpp
+        $$PWD/linux/NotifyServer.cpp \
+        $$PWD/linux/NetworkMonitor.cpp
     HEADERS += $$PWD/linux/LinuxPlatform.h \
         $$PWD/linux/ExtServer.h \
-        $$PWD/linux/NotifyServer.h
+        $$PWD/linux/NotifyServer.h \
+        $$PWD/linux/NetworkMonitor.h
 
-    LIBS += -lssl -lcrypto
+    LIBS += -lssl -lcrypto -ldl
     DEFINES += USE_DBUS
 
     # do not install desktop files if no_desktop is defined,
@@ -1,6 +1,7 @@
 #include "WindowsPlatform.h"
 #include <Shlobj.h>
 #include <Shlwapi.h>
+#include <Psapi.h>
 
 WinShellDispatcherTask* WindowsPlatform::shellDispatcherTask = NULL;
 
@@ -203,6 +204,16 @@ void WindowsPlatform::stopShellDispatcher()
     }
 }
 
+bool WindowsPlatform::startNetworkMonitor(MegaApplication *)
+{
+    return false;
+}
+
+void WindowsPlatform::stopNetworkMonitor()
+{
+
+}
+
 void WindowsPlatform::syncFolderAdded(QString syncPath, QString syncName)
 {
     if (syncPath.startsWith(QString::fromAscii("\\\\?\\")))
@@ -445,3 +456,38 @@ QString WindowsPlatform::getDefaultOpenApp(QString extension)
     }
     return QString();
 }
+
+void WindowsPlatform::setBackgroundIOPriority(bool enable)
+{
+    SetThreadPriority(GetCurrentThread(), enable ? THREAD_MODE_BACKGROUND_BEGIN : THREAD_MODE_BACKGROUND_END);
+}
+
+long long WindowsPlatform::getAvailableSpace(QString path)
+{
+    ULARGE_INTEGER freeBytes;
+    if (!GetDiskFreeSpaceExW((LPCWSTR)path.utf16(), &freeBytes, NULL, NULL))
+    {
+        return -1;
+    }
+    return freeBytes.QuadPart;
+}
+
+QString WindowsPlatform::getVolumeId(QString path)
+{
+    WCHAR volumePath[MAX_PATH];
+    if (!GetVolumePathNameW((LPCWSTR)path.utf16(), volumePath, MAX_PATH))
+    {
+        return QString();
+    }
+    return QString::fromWCharArray(volumePath).toLower();
+}
+
+long long WindowsPlatform::getResidentMemory()
+{
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+    {
+        return -1;
+    }
+    return counters.WorkingSetSize;
+}
@@ -32,12 +32,18 @@ public:
     static void showInFolder(QString pathIn);
     static void startShellDispatcher(MegaApplication *receiver);
     static void stopShellDispatcher();
+    static bool startNetworkMonitor(MegaApplication *receiver);
+    static void stopNetworkMonitor();
     static void syncFolderAdded(QString syncPath, QString syncName);
     static void syncFolderRemoved(QString syncPath, QString syncName);
     static QByteArray encrypt(QByteArray data, QByteArray key);
     static QByteArray decrypt(QByteArray data, QByteArray key);
     static QByteArray getLocalStorageKey();
     static QString getDefaultOpenApp(QString extension);
+    static void setBackgroundIOPriority(bool enable);
+    static long long getAvailableSpace(QString path);
+    static QString getVolumeId(QString path);
+    static long long getResidentMemory();
 };
 
 #endif // WINDOWSPLATFORM_H
@@ -2,6 +2,21 @@
 #include <fstream>
 #include <vector>
 #include <string>
+#include <map>
+#include <iterator>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <stdint.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#endif
+
+#include <QThread>
+#include <QThreadPool>
+#include <QRunnable>
 
 #include "mega/types.h"
 #include "mega/crypto/cryptopp.h"
@@ -10,6 +25,16 @@
 #define KEY_LENGTH 4096
 #define SIGNATURE_LENGTH 512
 
+//Binary patch format (applied by UpdateTask::applyPatch):
+//  "MEGAPATCH1" | target size (8 bytes, little endian) | operations | 'E'
+//  'C' | base offset (8 bytes) | length (4 bytes)  -> copy from the installed file
+//  'I' | length (4 bytes) | data                   -> insert new data
+#define PATCH_MAGIC "MEGAPATCH1"
+#define PATCH_MAGIC_LENGTH 10
+#define PATCH_BLOCK_SIZE 32
+#define PATCH_HASH_BASE 257
+#define HASH_BUFFER_SIZE 65536
+
 using namespace mega;
 using namespace std;
 
@@ -167,30 +192,36 @@ char (&static_sizeof_array( T(&)[N] ))[N];
 void printUsage(const char* appname)
 {
     cerr << "Usage: " << endl;
-    cerr << "Sign an update:" << endl;
-    cerr << "    " << appname << " -s <win|osx> <update folder> <keyfile> <version_code>" << endl;
+    cerr << "Sign an update (with optional patches against previous versions):" << endl;
+    cerr << "    " << appname << " [-j <workers>] -s <win|osx> <update folder> <keyfile> <version_code> [<previous update folder> ...]" << endl;
+    cerr << "Verify an update file against an installation folder:" << endl;
+    cerr << "    " << appname << " [-j <workers>] -v <update file> <installation folder> <keyfile>" << endl;
     cerr << "Generate a keypair" << endl;
     cerr << "    " << appname << " -g" << endl;
 }
 
-unsigned signFile(const char * filePath, AsymmCipher* key, byte* signature, unsigned signbuflen)
+bool hashFile(const char *filePath, HashSignature *signatureGenerator)
 {
-    HashSignature signatureGenerator(new Hash());
-    char buffer[1024];
-
+    vector<char> buffer(HASH_BUFFER_SIZE);
     ifstream input(filePath, std::ios::in | std::ios::binary);
     if (input.fail())
     {
-        return 0;
+        return false;
     }
 
     while (input.good())
     {
-        input.read(buffer, sizeof(buffer));
-        signatureGenerator.add((byte *)buffer, (unsigned)input.gcount());
+        input.read(&buffer[0], buffer.size());
+        signatureGenerator->add((byte *)&buffer[0], (unsigned)input.gcount());
     }
 
-    if (input.bad())
+    return !input.bad();
+}
+
+unsigned signFile(const char * filePath, AsymmCipher* key, byte* signature, unsigned signbuflen)
+{
+    HashSignature signatureGenerator(new Hash());
+    if (!hashFile(filePath, &signatureGenerator))
     {
         return 0;
     }
@@ -204,6 +235,348 @@ unsigned signFile(const char * filePath, AsymmCipher* key, byte* signature, unsi
     return signatureSize;
 }
 
+bool readFile(string path, string *data)
+{
+    ifstream input(path.c_str(), std::ios::in | std::ios::binary);
+    if (input.fail())
+    {
+        return false;
+    }
+
+    data->assign((istreambuf_iterator<char>(input)), istreambuf_iterator<char>());
+    return !input.bad();
+}
+
+void appendInteger(string *output, unsigned long long value, int bytes)
+{
+    for (int i = 0; i < bytes; i++)
+    {
+        output->push_back((char)((value >> (8 * i)) & 0xFF));
+    }
+}
+
+void appendInsert(string *patch, const string &data)
+{
+    if (data.size())
+    {
+        patch->push_back('I');
+        appendInteger(patch, data.size(), 4);
+        patch->append(data);
+    }
+}
+
+uint32_t blockHash(const unsigned char *data)
+{
+    uint32_t hash = 0;
+    for (int i = 0; i < PATCH_BLOCK_SIZE; i++)
+    {
+        hash = hash * PATCH_HASH_BASE + data[i];
+    }
+    return hash;
+}
+
+//Creates a patch that rebuilds target from base. Blocks of the base file are
+//indexed by a rolling hash, matches are extended in both directions
+void createPatch(const string &base, const string &target, string *patch)
+{
+    const unsigned char *b = (const unsigned char *)base.data();
+    const unsigned char *t = (const unsigned char *)target.data();
+    size_t baseSize = base.size();
+    size_t targetSize = target.size();
+
+    patch->assign(PATCH_MAGIC, PATCH_MAGIC_LENGTH);
+    appendInteger(patch, targetSize, 8);
+
+    map<uint32_t, size_t> blocks;
+    for (size_t offset = 0; offset + PATCH_BLOCK_SIZE <= baseSize; offset += PATCH_BLOCK_SIZE)
+    {
+        blocks.insert(make_pair(blockHash(b + offset), offset));
+    }
+
+    uint32_t power = 1;
+    for (int i = 1; i < PATCH_BLOCK_SIZE; i++)
+    {
+        power *= PATCH_HASH_BASE;
+    }
+
+    string literal;
+    size_t position = 0;
+    uint32_t hash = (targetSize >= PATCH_BLOCK_SIZE) ? blockHash(t) : 0;
+    while (position + PATCH_BLOCK_SIZE <= targetSize)
+    {
+        map<uint32_t, size_t>::iterator it = blocks.find(hash);
+        if (it != blocks.end() && !memcmp(b + it->second, t + position, PATCH_BLOCK_SIZE))
+        {
+            size_t baseStart = it->second;
+            size_t targetStart = position;
+            while (literal.size() && baseStart && b[baseStart - 1] == t[targetStart - 1])
+            {
+                literal.resize(literal.size() - 1);
+                baseStart--;
+                targetStart--;
+            }
+
+            size_t length = position + PATCH_BLOCK_SIZE - targetStart;
+            while (targetStart + length < targetSize && baseStart + length < baseSize
+                   && length < 0xFFFFFFFF && b[baseStart + length] == t[targetStart + length])
+            {
+                length++;
+            }
+
+            appendInsert(patch, literal);
+            literal.clear();
+            patch->push_back('C');
+            appendInteger(patch, baseStart, 8);
+            appendInteger(patch, length, 4);
+
+            position = targetStart + length;
+            if (position + PATCH_BLOCK_SIZE <= targetSize)
+            {
+                hash = blockHash(t + position);
+            }
+            continue;
+        }
+
+        literal.push_back(t[position]);
+        if (position + PATCH_BLOCK_SIZE < targetSize)
+        {
+            hash = (hash - t[position] * power) * PATCH_HASH_BASE + t[position + PATCH_BLOCK_SIZE];
+        }
+        position++;
+    }
+
+    literal.append(target, position, string::npos);
+    appendInsert(patch, literal);
+    patch->push_back('E');
+}
+
+string base64Signature(byte *signature, unsigned signatureSize)
+{
+    string s;
+    s.resize((signatureSize*4)/3+4);
+    s.resize(Base64::btoa((byte *)signature, signatureSize, (char *)s.data()));
+    return s;
+}
+
+string decodeKey(const string &key)
+{
+    string keys;
+    keys.resize(key.size()/4*3+3);
+    keys.resize(Base64::atob(key.data(), (byte *)keys.data(), keys.size()));
+    return keys;
+}
+
+//Signature and patches of an updated file, computed by a worker thread
+struct SignJob
+{
+    string fileName;
+    string targetPath;
+    string baseUrl;
+    string updateFolder;
+    vector<string> previousFolders;
+    string privks;
+
+    string signature;
+    vector<string> patchBaseSignatures;
+    vector<string> patchURLs;
+    vector<string> patchSignatures;
+    string error;
+    int errorCode;
+};
+
+void processSignJob(SignJob *job)
+{
+    //Each worker uses its own copy of the key
+    AsymmCipher aprivk;
+    aprivk.setkey(AsymmCipher::PRIVKEY, (byte*)job->privks.data(), job->privks.size());
+    byte signature[SIGNATURE_LENGTH];
+    job->errorCode = 0;
+
+    string filePath = job->updateFolder + job->fileName;
+    unsigned signatureSize = signFile(filePath.data(), &aprivk, signature, sizeof(signature));
+    if (!signatureSize)
+    {
+        job->error = "Error signing file: " + filePath;
+        job->errorCode = 4;
+        return;
+    }
+    job->signature = base64Signature(signature, signatureSize);
+
+    string target;
+    for (unsigned int j = 0; j < job->previousFolders.size(); j++)
+    {
+        string basePath = job->previousFolders[j] + job->fileName;
+        string base;
+        if ((!target.size() && !readFile(filePath, &target)) || !readFile(basePath, &base) || base == target)
+        {
+            continue;
+        }
+
+        //Patches are only useful if they are much smaller than the file
+        string patch;
+        createPatch(base, target, &patch);
+        if (patch.size() >= target.size() / 2)
+        {
+            continue;
+        }
+
+        string patchName(job->fileName);
+        for (unsigned int k = 0; k < patchName.size(); k++)
+        {
+            if (patchName[k] == '/')
+            {
+                patchName[k] = '_';
+            }
+        }
+        //Patches are named after the contents of their base file, so the names don't
+        //depend on the order of the previous folders in the command line
+        Hash baseHash;
+        baseHash.add((const byte *)base.data(), base.size());
+        string baseDigest;
+        baseHash.get(&baseDigest);
+        string baseId;
+        baseId.resize((baseDigest.size() * 4) / 3 + 4);
+        baseId.resize(Base64::btoa((const byte *)baseDigest.data(), baseDigest.size(), (char *)baseId.data()));
+        patchName = "patches/" + patchName + "." + baseId.substr(0, 16) + ".patch";
+
+        string patchPath = job->updateFolder + patchName;
+        ofstream output(patchPath.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+        output.write(patch.data(), patch.size());
+        output.close();
+        if (output.fail())
+        {
+            job->error = "Error writing patch: " + patchPath;
+            job->errorCode = 8;
+            return;
+        }
+
+        signatureSize = signFile(basePath.data(), &aprivk, signature, sizeof(signature));
+        if (!signatureSize)
+        {
+            job->error = "Error signing file: " + basePath;
+            job->errorCode = 4;
+            return;
+        }
+        job->patchBaseSignatures.push_back(base64Signature(signature, signatureSize));
+
+        signatureSize = signFile(patchPath.data(), &aprivk, signature, sizeof(signature));
+        if (!signatureSize)
+        {
+            job->error = "Error signing file: " + patchPath;
+            job->errorCode = 4;
+            return;
+        }
+        job->patchSignatures.push_back(base64Signature(signature, signatureSize));
+        job->patchURLs.push_back(job->baseUrl + patchName);
+    }
+}
+
+//Check of an installed file against the signature of the update file
+struct VerifyJob
+{
+    string filePath;
+    string signature;
+    string pubks;
+    bool valid;
+};
+
+void processVerifyJob(VerifyJob *job)
+{
+    AsymmCipher apubk;
+    apubk.setkey(AsymmCipher::PUBKEY, (byte*)job->pubks.data(), job->pubks.size());
+
+    string signature = decodeKey(job->signature);
+    HashSignature signatureChecker(new Hash());
+    job->valid = hashFile(job->filePath.c_str(), &signatureChecker)
+            && signatureChecker.checksignature(&apubk, (const byte *)signature.data(), signature.size());
+}
+
+template <typename T>
+class JobTask : public QRunnable
+{
+public:
+    JobTask(T *job, void (*function)(T *)) : job(job), function(function) {}
+    void run()
+    {
+        function(job);
+    }
+
+private:
+    T *job;
+    void (*function)(T *);
+};
+
+int verifyUpdate(const char *updateFilePath, string folder, const string &pubks, int workers)
+{
+    ifstream updateFile(updateFilePath, std::ios::in);
+    if (updateFile.fail())
+    {
+        cerr << "Unable to open the update file" << endl;
+        return 2;
+    }
+
+    if (folder[folder.size()-1] != '/')
+    {
+        folder.append("/");
+    }
+
+    string version, updateSignature;
+    getline(updateFile, version);
+    getline(updateFile, updateSignature);
+
+    AsymmCipher apubk;
+    apubk.setkey(AsymmCipher::PUBKEY, (byte*)pubks.data(), pubks.size());
+    HashSignature signatureChecker(new Hash());
+    signatureChecker.add((const byte *)version.data(), version.size());
+
+    vector<VerifyJob> jobs;
+    vector<string> targetPaths;
+    string url;
+    while (getline(updateFile, url) && url.size())
+    {
+        string targetPath, fileSignature;
+        getline(updateFile, targetPath);
+        getline(updateFile, fileSignature);
+        signatureChecker.add((const byte *)url.data(), url.size());
+        signatureChecker.add((const byte *)targetPath.data(), targetPath.size());
+        signatureChecker.add((const byte *)fileSignature.data(), fileSignature.size());
+
+        VerifyJob job;
+        job.filePath = folder + targetPath;
+        job.signature = fileSignature;
+        job.pubks = pubks;
+        job.valid = false;
+        jobs.push_back(job);
+        targetPaths.push_back(targetPath);
+    }
+
+    string signature = decodeKey(updateSignature);
+    if (!version.size() || !signatureChecker.checksignature(&apubk, (const byte *)signature.data(), signature.size()))
+    {
+        cerr << "Invalid update file signature" << endl;
+        return 9;
+    }
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(workers);
+    for (unsigned int i = 0; i < jobs.size(); i++)
+    {
+        pool.start(new JobTask<VerifyJob>(&jobs[i], processVerifyJob));
+    }
+    pool.waitForDone();
+
+    int result = 0;
+    for (unsigned int i = 0; i < jobs.size(); i++)
+    {
+        cout << (jobs[i].valid ? "OK " : "FAILED ") << targetPaths[i] << endl;
+        if (!jobs[i].valid)
+        {
+            result = 10;
+        }
+    }
+    return result;
+}
+
 int main(int argc, char *argv[])
 {
     HashSignature signatureGenerator(new Hash());
@@ -215,6 +588,21 @@ int main(int argc, char *argv[])
     string pubk;
     string privk;
     bool win = true;
+    const char *appname = argv[0];
+
+    //Number of files hashed in parallel
+    int workers = QThread::idealThreadCount();
+    if ((argc >= 3) && !strcmp(argv[1], "-j"))
+    {
+        workers = atoi(argv[2]);
+        if (workers <= 0)
+        {
+            printUsage(appname);
+            return 1;
+        }
+        argv += 2;
+        argc -= 2;
+    }
 
     if ((argc == 2) && !strcmp(argv[1], "-g"))
     {
@@ -243,7 +631,19 @@ int main(int argc, char *argv[])
         delete privkstr;
         return 0;
     }
-    else if ((argc == 6) && !strcmp(argv[1], "-s")
+    else if ((argc == 5) && !strcmp(argv[1], "-v"))
+    {
+        //Verify an update
+        ifstream keyFile(argv[4], std::ios::in);
+        getline(keyFile, pubk);
+        if (!pubk.size())
+        {
+            cerr << "Invalid key file" << endl;
+            return 3;
+        }
+        return verifyUpdate(argv[2], argv[3], decodeKey(pubk), workers);
+    }
+    else if ((argc >= 6) && !strcmp(argv[1], "-s")
              && (!strcmp(argv[2], "win") || !strcmp(argv[2], "osx")))
     {
         //Sign an update
@@ -260,7 +660,7 @@ int main(int argc, char *argv[])
         ifstream keyFile(argv[4], std::ios::in);
         if (keyFile.bad())
         {
-            printUsage(argv[0]);
+            printUsage(appname);
             return 2;
         }
         getline(keyFile, pubk);
@@ -281,9 +681,7 @@ int main(int argc, char *argv[])
         }
 
         //Initialize AsymmCypher
-        string privks;
-        privks.resize(privk.size()/4*3+3);
-        privks.resize(Base64::atob(privk.data(), (byte *)privks.data(), privks.size()));
+        string privks = decodeKey(privk);
         aprivk.setkey(AsymmCipher::PRIVKEY,(byte*)privks.data(), privks.size());
 
         //Generate update file signature
@@ -299,29 +697,63 @@ int main(int argc, char *argv[])
             numFiles = SIZEOF_ARRAY(UPDATE_FILES_OSX);
         }
 
-        for (unsigned int i = 0; i < numFiles; i++)
+        //Previous versions to generate patches against
+        vector<string> previousFolders;
+        for (int i = 6; i < argc; i++)
         {
-            string filePath = updateFolder + (win ? UPDATE_FILES_WIN : UPDATE_FILES_OSX)[i];
-            signatureSize = signFile(filePath.data(), &aprivk, signature, sizeof(signature));
-            if (!signatureSize)
+            string previousFolder(argv[i]);
+            if (previousFolder[previousFolder.size()-1] != '/')
             {
-                cerr << "Error signing file: " << filePath << endl;
-                return 4;
+                previousFolder.append("/");
             }
+            previousFolders.push_back(previousFolder);
+        }
 
-            string s;
-            s.resize((signatureSize*4)/3+4);
-            s.resize(Base64::btoa((byte *)signature, signatureSize, (char *)s.data()));
-            signatures.push_back(s);
+        if (previousFolders.size())
+        {
+            string patchFolder = updateFolder + "patches";
+#ifdef _WIN32
+            _mkdir(patchFolder.c_str());
+#else
+            mkdir(patchFolder.c_str(), 0755);
+#endif
+        }
+
+        //Files are hashed and patched in parallel, the results are used in order
+        vector<SignJob> jobs(numFiles);
+        for (unsigned int i = 0; i < numFiles; i++)
+        {
+            jobs[i].fileName = (win ? UPDATE_FILES_WIN : UPDATE_FILES_OSX)[i];
+            jobs[i].targetPath = (win ? TARGET_PATHS_WIN : TARGET_PATHS_OSX)[i];
+            jobs[i].baseUrl = (win ? SERVER_BASE_URL_WIN : SERVER_BASE_URL_OSX);
+            jobs[i].updateFolder = updateFolder;
+            jobs[i].previousFolders = previousFolders;
+            jobs[i].privks = privks;
+        }
 
-            string fileUrl((win ? SERVER_BASE_URL_WIN : SERVER_BASE_URL_OSX));
-            fileUrl.append((win ? UPDATE_FILES_WIN : UPDATE_FILES_OSX)[i]);
+        QThreadPool pool;
+        pool.setMaxThreadCount(workers);
+        for (unsigned int i = 0; i < numFiles; i++)
+        {
+            pool.start(new JobTask<SignJob>(&jobs[i], processSignJob));
+        }
+        pool.waitForDone();
+
+        for (unsigned int i = 0; i < numFiles; i++)
+        {
+            if (jobs[i].errorCode)
+            {
+                cerr << jobs[i].error << endl;
+                return jobs[i].errorCode;
+            }
+
+            string fileUrl(jobs[i].baseUrl + jobs[i].fileName);
             downloadURLs.push_back(fileUrl);
+            signatures.push_back(jobs[i].signature);
 
             signatureGenerator.add((const byte*)fileUrl.data(), fileUrl.size());
-            signatureGenerator.add((const byte*)(win ? TARGET_PATHS_WIN : TARGET_PATHS_OSX)[i],
-                                   strlen((win ? TARGET_PATHS_WIN : TARGET_PATHS_OSX)[i]));
-            signatureGenerator.add((const byte*)s.data(), s.length());
+            signatureGenerator.add((const byte*)jobs[i].targetPath.data(), jobs[i].targetPath.size());
+            signatureGenerator.add((const byte*)jobs[i].signature.data(), jobs[i].signature.length());
         }
 
         signatureSize = signatureGenerator.get(&aprivk, signature, sizeof(signature));
@@ -351,9 +783,28 @@ int main(int argc, char *argv[])
             cout << signatures[i] << endl;
         }
 
+        //Patches go after an empty line, older versions stop reading there.
+        //Patched files are verified with the signature of the full file
+        bool patchesHeader = false;
+        for (unsigned int i = 0; i < numFiles; i++)
+        {
+            for (unsigned int j = 0; j < jobs[i].patchURLs.size(); j++)
+            {
+                if (!patchesHeader)
+                {
+                    cout << endl;
+                    patchesHeader = true;
+                }
+                cout << jobs[i].targetPath << endl;
+                cout << jobs[i].patchBaseSignatures[j] << endl;
+                cout << jobs[i].patchURLs[j] << endl;
+                cout << jobs[i].patchSignatures[j] << endl;
+            }
+        }
+
         return 0;
     }
 
-    printUsage(argv[0]);
+    printUsage(appname);
     return 1;
 }